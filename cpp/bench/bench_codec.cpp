@@ -0,0 +1,101 @@
+#include "microbench.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "synthetic_trace.h"
+#include "telemetry/codec/batch_codec.h"
+#include "telemetry/codec/delta_stream.h"
+#include "telemetry/codec/snapshot_codec.h"
+
+namespace {
+
+constexpr std::size_t kBatch = 64;
+
+std::vector<telemetry::codec::BatchSample> batch_samples() {
+  std::vector<telemetry::codec::BatchSample> out;
+  for (const auto& s : telemetry::bench::synthetic_trace(kBatch)) out.push_back({s, telemetry::StatusCode::kOk});
+  return out;
+}
+
+}  // namespace
+
+TELEMETRY_BENCH("codec/encode_snapshot") {
+  const auto trace = telemetry::bench::synthetic_trace(256);
+  std::uint8_t buf[128];
+  std::size_t i = 0;
+  std::size_t n = 0;
+  while (st.keep_running()) {
+    n = telemetry::codec::encode_snapshot(trace[i++ & 255], telemetry::StatusCode::kOk, buf, sizeof(buf));
+    telemetry::bench::do_not_optimize(buf);
+  }
+  st.set_counter("bytes", static_cast<double>(n));
+}
+
+TELEMETRY_BENCH("codec/decode_snapshot") {
+  const auto trace = telemetry::bench::synthetic_trace(1);
+  std::uint8_t buf[128];
+  const std::size_t n = telemetry::codec::encode_snapshot(trace[0], telemetry::StatusCode::kOk, buf, sizeof(buf));
+  telemetry::MetricsSnapshot out{};
+  telemetry::StatusCode code{};
+  while (st.keep_running()) {
+    const telemetry::Status s = telemetry::codec::decode_snapshot(buf, n, out, &code);
+    telemetry::bench::do_not_optimize(s);
+    telemetry::bench::do_not_optimize(out);
+  }
+}
+
+// One exporter batch of kBatch samples; items/s is samples/s, batches/s is 1e9 / ns_per_op.
+TELEMETRY_BENCH("codec/encode_batch/64") {
+  const auto samples = batch_samples();
+  std::vector<std::uint8_t> out;
+  out.reserve(4096);
+  std::uint64_t seq = 0;
+  std::size_t n = 0;
+  while (st.keep_running()) {
+    out.clear();
+    n = telemetry::codec::encode_batch(++seq, "edge-0042", samples.data(), samples.size(), out);
+    telemetry::bench::do_not_optimize(out.data());
+  }
+  st.set_items_per_iteration(kBatch);
+  st.set_counter("bytes_per_sample", static_cast<double>(n) / kBatch);
+}
+
+TELEMETRY_BENCH("codec/decode_batch/64") {
+  const auto samples = batch_samples();
+  std::vector<std::uint8_t> frame;
+  const std::size_t n = telemetry::codec::encode_batch(1, "edge-0042", samples.data(), samples.size(), frame);
+  std::vector<telemetry::codec::BatchSample> decoded;
+  std::uint64_t seq = 0;
+  std::string_view id;
+  while (st.keep_running()) {
+    const telemetry::Status s = telemetry::codec::decode_batch(frame.data(), n, seq, id, decoded);
+    telemetry::bench::do_not_optimize(s);
+  }
+  st.set_items_per_iteration(kBatch);
+}
+
+// SUBSCRIBE DELTA 2 0.01 240 over the synthetic trace (cf. the README figure).
+TELEMETRY_BENCH("delta_stream/update") {
+  const auto trace = telemetry::bench::synthetic_trace(4096);
+  telemetry::codec::DeadbandConfig cfg{};
+  cfg.abs = 2.0;
+  cfg.rel = 0.01;
+  cfg.keyframe_every = 240;
+  telemetry::codec::DeltaStream stream(cfg);
+  std::string line;
+  line.reserve(256);
+  std::size_t i = 0;
+  std::uint64_t bytes = 0;
+  std::uint64_t samples = 0;
+  while (st.keep_running()) {
+    telemetry::MetricsSnapshot s = trace[i & 4095];
+    s.ts_ms += (i / 4096) * 4096 * 250;
+    ++i;
+    if (stream.update(s, telemetry::Status::Ok(), line)) bytes += line.size();
+    ++samples;
+  }
+  st.set_counter("bytes_per_sample", samples ? static_cast<double>(bytes) / static_cast<double>(samples) : 0.0);
+}
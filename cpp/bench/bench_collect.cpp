@@ -0,0 +1,113 @@
+#include "microbench.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "bench_util.h"
+#include "telemetry/metrics/collector.h"
+#include "telemetry/metrics/static_collector.h"
+#if defined(__linux__)
+#include "telemetry/metrics/linux_interrupts_source.h"
+#include "telemetry/metrics/linux_io_sources.h"
+#include "telemetry/metrics/linux_numa_source.h"
+#include "telemetry/metrics/linux_pressure_source.h"
+#include "telemetry/metrics/linux_sources.h"
+#endif
+
+namespace {
+
+using telemetry::bench::FakeSource;
+
+void bench_collect_fake(telemetry::bench::State& st) {
+  telemetry::metrics::Collector collector;
+  for (std::int64_t i = 0; i < st.arg(); ++i) collector.add_source(std::make_unique<FakeSource>(1));
+  telemetry::MetricsSnapshot snap{};
+  while (st.keep_running()) {
+    const telemetry::Status s = collector.collect(snap);
+    telemetry::bench::do_not_optimize(s);
+  }
+  st.set_items_per_iteration(static_cast<std::uint64_t>(st.arg()));
+}
+
+const telemetry::bench::Register kCollect1("collector/collect/sources=1", &bench_collect_fake, 1);
+const telemetry::bench::Register kCollect4("collector/collect/sources=4", &bench_collect_fake, 4);
+const telemetry::bench::Register kCollect16("collector/collect/sources=16", &bench_collect_fake, 16);
+const telemetry::bench::Register kCollect64("collector/collect/sources=64", &bench_collect_fake, 64);
+
+template <class T, std::size_t>
+using Repeat = T;
+constexpr std::uint64_t one(std::size_t) { return 1; }
+
+// The same sources composed at compile time: no vtable calls, FakeSource::collect inlined.
+template <std::size_t... I>
+void run_collect_static(telemetry::bench::State& st, std::index_sequence<I...>) {
+  telemetry::metrics::StaticCollector<Repeat<FakeSource, I>...> collector(one(I)...);
+  telemetry::MetricsSnapshot snap{};
+  while (st.keep_running()) {
+    const telemetry::Status s = collector.collect(snap);
+    telemetry::bench::do_not_optimize(s);
+  }
+  st.set_items_per_iteration(sizeof...(I));
+}
+
+template <std::size_t N>
+void bench_collect_static(telemetry::bench::State& st) {
+  run_collect_static(st, std::make_index_sequence<N>{});
+}
+
+const telemetry::bench::Register kStatic1("collector/collect_static/sources=1", &bench_collect_static<1>);
+const telemetry::bench::Register kStatic4("collector/collect_static/sources=4", &bench_collect_static<4>);
+const telemetry::bench::Register kStatic16("collector/collect_static/sources=16", &bench_collect_static<16>);
+const telemetry::bench::Register kStatic64("collector/collect_static/sources=64", &bench_collect_static<64>);
+
+}  // namespace
+
+#if defined(__linux__)
+// The /proc and /sys parsers against a fixed fixture tree (one pread + parse per file).
+TELEMETRY_BENCH("linux/collect/fixtures") {
+  const std::string root = telemetry::bench::fixtures_dir() + "/linux";
+  telemetry::metrics::Collector collector;
+  telemetry::metrics::add_linux_sources(collector, root.c_str());
+  telemetry::MetricsSnapshot snap{};
+  while (st.keep_running()) {
+    const telemetry::Status s = collector.collect(snap);
+    telemetry::bench::do_not_optimize(s);
+    telemetry::bench::do_not_optimize(snap);
+  }
+}
+
+// The per-device detail sources over the same tree, dynamic and composed at compile time;
+// each sample is five reads, so dispatch is a rounding error next to the parsing.
+TELEMETRY_BENCH("linux/collect/fixtures/detail_sources") {
+  const std::string root = telemetry::bench::fixtures_dir() + "/linux";
+  telemetry::metrics::Collector collector;
+  collector.add_source(std::make_unique<telemetry::metrics::DiskStatsSource>(root.c_str()));
+  collector.add_source(std::make_unique<telemetry::metrics::NetDevSource>(root.c_str()));
+  collector.add_source(std::make_unique<telemetry::metrics::PressureSource>(root.c_str()));
+  collector.add_source(std::make_unique<telemetry::metrics::NumaSource>(root.c_str()));
+  telemetry::metrics::InterruptsConfig interrupts_cfg{};
+  interrupts_cfg.root = root.c_str();
+  collector.add_source(std::make_unique<telemetry::metrics::InterruptsSource>(interrupts_cfg));
+  telemetry::MetricsSnapshot snap{};
+  while (st.keep_running()) {
+    const telemetry::Status s = collector.collect(snap);
+    telemetry::bench::do_not_optimize(s);
+  }
+}
+
+TELEMETRY_BENCH("linux/collect_static/fixtures/detail_sources") {
+  const std::string root = telemetry::bench::fixtures_dir() + "/linux";
+  telemetry::metrics::InterruptsConfig interrupts_cfg{};
+  interrupts_cfg.root = root.c_str();
+  telemetry::metrics::StaticCollector<telemetry::metrics::DiskStatsSource, telemetry::metrics::NetDevSource,
+                                      telemetry::metrics::PressureSource, telemetry::metrics::NumaSource,
+                                      telemetry::metrics::InterruptsSource>
+      collector(root.c_str(), root.c_str(), root.c_str(), root.c_str(), interrupts_cfg);
+  telemetry::MetricsSnapshot snap{};
+  while (st.keep_running()) {
+    const telemetry::Status s = collector.collect(snap);
+    telemetry::bench::do_not_optimize(s);
+  }
+}
+#endif
@@ -0,0 +1,139 @@
+#include "microbench.h"
+
+#if defined(__linux__)
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "telemetry/metrics/linux_declared_source.h"
+
+namespace {
+
+// A synthetic /proc and /sys under a temp root, built once and removed at exit, and 200
+// declarations over it: 50 meminfo keys, 80 vmstat counters, 8 columns of 8 /proc/net/dev
+// interfaces and 6 single-value sysfs files, so 9 files in all.
+class SyntheticDeclared final {
+ public:
+  SyntheticDeclared() {
+    for (const char* dir : {"/proc", "/proc/net", "/sys", "/sys/power"}) (void)::mkdir((root() + dir).c_str(), 0700);
+
+    std::string text;
+    char row[256];
+    char decl[256];
+    for (int i = 0; i < 60; ++i) {
+      std::snprintf(row, sizeof(row), "MemKey%02d:      %8d kB\n", i, 1000 + i * 37);
+      text += row;
+      if (i < 50) {
+        std::snprintf(decl, sizeof(decl), "mem_key%02d_bytes /proc/meminfo key MemKey%02d scale 1024", i, i);
+        decls_.push_back(decl);
+      }
+    }
+    write("/proc/meminfo", text);
+
+    text.clear();
+    for (int i = 0; i < 120; ++i) {
+      std::snprintf(row, sizeof(row), "vm_counter_%03d %d\n", i, 100000 + i * 1234);
+      text += row;
+      if (i % 3 != 2 && decls_.size() < 130) {
+        std::snprintf(decl, sizeof(decl), "vm_counter_%03d_per_second /proc/vmstat key vm_counter_%03d rate", i, i);
+        decls_.push_back(decl);
+      }
+    }
+    write("/proc/vmstat", text);
+
+    text = "Inter-|   Receive                                                |  Transmit\n"
+           " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo "
+           "colls carrier compressed\n";
+    for (int i = 0; i < 8; ++i) {
+      std::snprintf(row, sizeof(row), "  eth%d: %llu %d 0 0 0 0 0 0 %llu %d 0 0 0 0 0 0\n", i,
+                    1000000ULL * (i + 1), 9000 + i, 2000000ULL * (i + 1), 7000 + i);
+      text += row;
+      for (int col : {2, 3, 4, 5, 10, 11, 12, 13}) {
+        std::snprintf(decl, sizeof(decl), "net_eth%d_col%d_per_second /proc/net/dev column %d row eth%d rate", i, col,
+                      col, i);
+        decls_.push_back(decl);
+      }
+    }
+    write("/proc/net/dev", text);
+
+    for (int i = 0; i < 6; ++i) {
+      std::snprintf(row, sizeof(row), "/sys/power/value%d", i);
+      write(row, std::to_string(i * 11) + "\n");
+      std::snprintf(decl, sizeof(decl), "power_value%d %s value", i, row);
+      decls_.push_back(decl);
+    }
+  }
+  const std::string& root() const { return tmp_.path(); }
+  const std::vector<std::string>& decls() const { return decls_; }
+
+ private:
+  void write(const char* rel, const std::string& text) {
+    std::FILE* f = std::fopen((root() + rel).c_str(), "w");
+    if (!f || std::fwrite(text.data(), 1, text.size(), f) != text.size()) {
+      std::fprintf(stderr, "synthetic /proc write failed\n");
+      std::exit(1);
+    }
+    std::fclose(f);
+  }
+
+  telemetry::bench::TempDir tmp_{"declared"};
+  std::vector<std::string> decls_;
+};
+
+const SyntheticDeclared& synthetic() {
+  static const SyntheticDeclared tree;
+  return tree;
+}
+
+// One iteration = one collect() of all 200 metrics: each of the 9 files read and parsed once.
+TELEMETRY_BENCH("declared/sample/metrics=200") {
+  const SyntheticDeclared& tree = synthetic();
+  telemetry::metrics::DeclaredSource src(tree.root().c_str());
+  for (const std::string& d : tree.decls()) {
+    if (!src.add_metric(d).ok()) {
+      std::fprintf(stderr, "bad declaration: %s\n", d.c_str());
+      std::exit(1);
+    }
+  }
+  std::uint64_t now_ns = 1'000'000'000ULL;
+  (void)src.sample(now_ns);  // primes the rates
+  while (st.keep_running()) {
+    now_ns += 1'000'000'000ULL;
+    const telemetry::Status s = src.sample(now_ns);
+    telemetry::bench::do_not_optimize(s);
+  }
+  st.set_items_per_iteration(src.size());
+  st.set_counter("files", static_cast<double>(src.files()));
+}
+
+// The same 200 metrics as one source each, as hand-written per-metric sources would read
+// them: one read and parse per metric.
+TELEMETRY_BENCH("declared/sample/metrics=200/file_per_metric") {
+  const SyntheticDeclared& tree = synthetic();
+  std::vector<std::unique_ptr<telemetry::metrics::DeclaredSource>> sources;
+  for (const std::string& d : tree.decls()) {
+    sources.push_back(std::make_unique<telemetry::metrics::DeclaredSource>(tree.root().c_str()));
+    (void)sources.back()->add_metric(d);
+  }
+  std::uint64_t now_ns = 1'000'000'000ULL;
+  for (auto& s : sources) (void)s->sample(now_ns);
+  while (st.keep_running()) {
+    now_ns += 1'000'000'000ULL;
+    for (auto& s : sources) {
+      const telemetry::Status status = s->sample(now_ns);
+      telemetry::bench::do_not_optimize(status);
+    }
+  }
+  st.set_items_per_iteration(sources.size());
+  st.set_counter("files", static_cast<double>(sources.size()));
+}
+
+}  // namespace
+
+#endif
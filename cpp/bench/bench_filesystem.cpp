@@ -0,0 +1,88 @@
+#include "microbench.h"
+
+#if defined(__linux__)
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+#include "bench_util.h"
+#include "telemetry/metrics/linux_filesystem_source.h"
+
+namespace {
+
+// A container host's mount table under a temp root, built once and removed at exit: the
+// host's own filesystems and pseudo mounts, then an overlay root, shm and a few bind mounts
+// for each of 400 containers, about 2000 lines in all.
+class SyntheticMounts final {
+ public:
+  SyntheticMounts() {
+    for (const char* dir : {"/proc", "/proc/self", "/boot", "/var"}) (void)::mkdir((root() + dir).c_str(), 0700);
+
+    std::string text = "22 1 8:1 / / rw,relatime shared:1 - ext4 /dev/sda1 rw\n"
+                       "23 22 0:21 / /proc rw,nosuid shared:12 - proc proc rw\n"
+                       "24 22 0:22 / /sys rw,nosuid shared:7 - sysfs sysfs rw\n"
+                       "25 24 0:26 / /sys/fs/cgroup rw,nosuid shared:9 - cgroup2 cgroup2 rw\n"
+                       "26 22 8:2 / /boot rw,relatime shared:30 - ext4 /dev/sda2 rw\n"
+                       "27 22 8:3 / /var rw,relatime shared:31 - xfs /dev/sdb1 rw\n";
+    char row[1024];
+    int id = 100;
+    for (int c = 0; c < 400; ++c) {
+      std::snprintf(row, sizeof(row),
+                    "%d 27 0:%d / /var/lib/docker/overlay2/%08x/merged rw,relatime - overlay overlay "
+                    "rw,lowerdir=/var/lib/docker/overlay2/l/A:/var/lib/docker/overlay2/l/B\n"
+                    "%d 27 0:%d / /var/lib/docker/containers/%08x/mounts/shm rw,nosuid - tmpfs shm rw,size=65536k\n"
+                    "%d 27 0:%d / /run/docker/netns/%08x rw - nsfs nsfs rw\n"
+                    "%d 27 8:3 /lib/docker/volumes/v%d/_data /var/lib/docker/volumes/v%d rw - xfs /dev/sdb1 rw\n"
+                    "%d 27 8:3 /lib/docker/containers/%08x/hosts /var/lib/docker/hosts/%08x rw - xfs /dev/sdb1 rw\n",
+                    id, 100 + c, c * 2654435761u, id + 1, 600 + c, c * 2654435761u, id + 2, 1000 + c, c * 40503u,
+                    id + 3, c, c, id + 4, c * 2654435761u, c * 2654435761u);
+      text += row;
+      std::snprintf(row, sizeof(row), "%s/var/lib/docker/containers/%08x/mounts/shm", root().c_str(), c * 2654435761u);
+      std::filesystem::create_directories(row);
+      id += 5;
+    }
+    std::FILE* f = std::fopen((root() + "/proc/self/mountinfo").c_str(), "w");
+    if (!f || std::fwrite(text.data(), 1, text.size(), f) != text.size()) {
+      std::fprintf(stderr, "synthetic mountinfo write failed\n");
+      std::exit(1);
+    }
+    std::fclose(f);
+  }
+  const std::string& root() const { return tmp_.path(); }
+
+ private:
+  telemetry::bench::TempDir tmp_{"mounts"};
+};
+
+const SyntheticMounts& synthetic() {
+  static const SyntheticMounts tree;
+  return tree;
+}
+
+// One iteration = one collect() with an unchanged mount table: statvfs() on the 403 kept
+// mounts (host filesystems and each container's shm).
+// With the argument set, every sample also re-parses mountinfo, as polling it would.
+void bench_sample(telemetry::bench::State& st) {
+  telemetry::metrics::FilesystemSource src(synthetic().root().c_str());
+  std::uint64_t now_ns = 1'000'000'000ULL;
+  (void)src.sample(now_ns);
+  while (st.keep_running()) {
+    if (st.arg() != 0) src.mounts_changed();
+    now_ns += 1'000'000'000ULL;
+    const telemetry::Status s = src.sample(now_ns);
+    telemetry::bench::do_not_optimize(s);
+  }
+  st.set_counter("filesystems", static_cast<double>(src.filesystems().size()));
+  st.set_counter("parses", static_cast<double>(src.mount_table_parses()));
+}
+
+const telemetry::bench::Register kSteady("fs/sample/mounts=2006", &bench_sample, 0);
+const telemetry::bench::Register kReparse("fs/sample/mounts=2006/reparse", &bench_sample, 1);
+
+}  // namespace
+
+#endif
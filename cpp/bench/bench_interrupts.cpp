@@ -0,0 +1,195 @@
+#include "microbench.h"
+
+#if defined(__linux__)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "telemetry/metrics/counter_scan.h"
+#include "telemetry/metrics/linux_interrupts_source.h"
+
+namespace {
+
+// Synthetic /proc/interrupts and /proc/softirqs for a `cpus`-CPU host under a temp root, in
+// the kernel's layout (a " %10u" cell per online CPU) and built once per size: ~300 MSI-X
+// IRQs counting on the one CPU each is pinned to and 0 elsewhere, the architecture rows
+// (NMI, LOC, ...) counting everywhere, the ERR/MIS totals and the ten softirq types. No
+// many-core host is at hand to capture from, so these are generated, not recorded. tick()
+// advances the counters that move on a busy host between samples, in place through a
+// shared mapping as procfs content changes: each device IRQ on its CPU, the NMI, LOC, PMI,
+// RES, CAL and TLB rows and every softirq on every CPU.
+class SyntheticIrqs final {
+ public:
+  explicit SyntheticIrqs(int cpus) {
+    (void)::mkdir((root() + "/proc").c_str(), 0700);
+
+    char cell[96];
+    std::string text(11, ' ');
+    for (int c = 0; c < cpus; ++c) {
+      std::snprintf(cell, sizeof(cell), "CPU%-8d", c);
+      text += cell;
+    }
+    text += '\n';
+    std::uint32_t seed = 1;
+    // pinned < 0: every CPU counts. Counting cells that `ticks` is given move every interval.
+    const auto counters = [&](std::string& out, int pinned, std::vector<std::size_t>* ticks) {
+      for (int c = 0; c < cpus; ++c) {
+        seed = seed * 1664525u + 1013904223u;
+        const bool counts = pinned < 0 || c == pinned;
+        std::snprintf(cell, sizeof(cell), " %10u", counts ? seed >> (seed % 16 + 4) : 0u);
+        out += cell;
+        if (counts && ticks) ticks->push_back(out.size() - 1);
+      }
+    };
+    for (int irq = 0; irq < 300; ++irq) {
+      std::snprintf(cell, sizeof(cell), "%3d:", irq);
+      text += cell;
+      counters(text, irq % cpus, &irq_ticks_);
+      std::snprintf(cell, sizeof(cell), "  IR-PCI-MSIX-0000:3b:00.0 %4d-edge      mlx5_comp%d@pci:0000:3b:00.0\n", irq,
+                    irq);
+      text += cell;
+    }
+    for (const char* arch : {"NMI", "LOC", "SPU", "PMI", "IWI", "RTR", "RES", "CAL", "TLB", "TRM", "THR",
+                             "DFR", "MCE", "MCP"}) {
+      const bool moves = std::strstr("NMI LOC PMI RES CAL TLB", arch) != nullptr;
+      std::snprintf(cell, sizeof(cell), "%s:", arch);
+      text += cell;
+      counters(text, -1, moves ? &irq_ticks_ : nullptr);
+      text += "   Architecture specific interrupts\n";
+    }
+    text += "ERR:          0\nMIS:          0\n";
+    interrupts_ = text;
+    irq_map_ = write("/proc/interrupts", text);
+
+    text.assign(20, ' ');
+    for (int c = 0; c < cpus; ++c) {
+      std::snprintf(cell, sizeof(cell), "CPU%-8d", c);
+      text += cell;
+    }
+    text += '\n';
+    for (const char* type : {"HI", "TIMER", "NET_TX", "NET_RX", "BLOCK", "IRQ_POLL", "TASKLET", "SCHED",
+                             "HRTIMER", "RCU"}) {
+      std::snprintf(cell, sizeof(cell), "%12s:", type);
+      text += cell;
+      counters(text, -1, &softirq_ticks_);
+      text += '\n';
+    }
+    softirq_map_ = write("/proc/softirqs", text);
+  }
+
+  // One interval: every moving counter goes up by one, right-aligned in its cell.
+  void tick() {
+    for (std::size_t off : irq_ticks_) bump(irq_map_ + off);
+    for (std::size_t off : softirq_ticks_) bump(softirq_map_ + off);
+  }
+  std::size_t ticks() const { return irq_ticks_.size() + softirq_ticks_.size(); }
+
+  const std::string& root() const { return tmp_.path(); }
+  const std::string& interrupts() const { return interrupts_; }
+
+ private:
+  static void bump(char* last) {
+    char* d = last;
+    while (*d == '9') *d-- = '0';
+    *d = *d == ' ' ? '1' : static_cast<char>(*d + 1);
+  }
+
+  // Writes `text` and maps it shared, so tick() changes what the next read sees.
+  char* write(const char* rel, const std::string& text) {
+    const std::string path = root() + rel;
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    if (!f || std::fwrite(text.data(), 1, text.size(), f) != text.size()) {
+      std::fprintf(stderr, "synthetic /proc write failed\n");
+      std::exit(1);
+    }
+    std::fclose(f);
+    const int fd = ::open(path.c_str(), O_RDWR);
+    void* m = fd < 0 ? MAP_FAILED : ::mmap(nullptr, text.size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (fd >= 0) ::close(fd);
+    if (m == MAP_FAILED) {
+      std::fprintf(stderr, "synthetic /proc mmap failed\n");
+      std::exit(1);
+    }
+    return static_cast<char*>(m);
+  }
+
+  telemetry::bench::TempDir tmp_{"irq"};
+  std::string interrupts_;
+  std::vector<std::size_t> irq_ticks_;
+  std::vector<std::size_t> softirq_ticks_;
+  char* irq_map_{nullptr};
+  char* softirq_map_{nullptr};
+};
+
+SyntheticIrqs& synthetic(int cpus) {
+  if (cpus <= 128) {
+    static SyntheticIrqs small(128);
+    return small;
+  }
+  static SyntheticIrqs large(256);
+  return large;
+}
+
+// One iteration = one interval's counter updates (tick(), a few microseconds, counted in)
+// and one collect(): read and parse both files, rank the top 10 IRQs.
+void bench_sample(telemetry::bench::State& st) {
+  SyntheticIrqs& irqs = synthetic(static_cast<int>(st.arg()));
+  telemetry::metrics::InterruptsConfig cfg{};
+  cfg.root = irqs.root().c_str();
+  telemetry::metrics::InterruptsSource src(cfg);
+  std::uint64_t now_ns = 1'000'000'000ULL;
+  (void)src.sample(now_ns);  // primes the counter arrays
+  while (st.keep_running()) {
+    irqs.tick();
+    now_ns += 1'000'000'000ULL;
+    const telemetry::Status s = src.sample(now_ns);
+    telemetry::bench::do_not_optimize(s);
+  }
+  st.set_items_per_iteration(irqs.interrupts().size());
+  st.set_counter("cpus", static_cast<double>(src.cpus().size()));
+  st.set_counter("moving", static_cast<double>(irqs.ticks()));
+}
+
+// The row scan alone over the in-memory /proc/interrupts text, SIMD against the scalar
+// reference; items are bytes.
+template <bool kSimd>
+void bench_scan(telemetry::bench::State& st) {
+  const SyntheticIrqs& irqs = synthetic(static_cast<int>(st.arg()));
+  std::string text = irqs.interrupts();
+  text.append(16, '\0');
+  std::uint64_t counters[telemetry::metrics::InterruptsSource::kMaxCpus];
+  while (st.keep_running()) {
+    const char* p = text.c_str();
+    std::size_t total = 0;
+    while (*p != '\0') {
+      while (*p != '\0' && *p != ':' && *p != '\n') ++p;
+      if (*p == ':') {
+        ++p;
+        total += kSimd ? telemetry::metrics::scan_counters(p, counters, std::size(counters))
+                       : telemetry::metrics::scan_counters_scalar(p, counters, std::size(counters));
+      }
+      while (*p != '\0' && *p != '\n') ++p;
+      if (*p == '\n') ++p;
+    }
+    telemetry::bench::do_not_optimize(total);
+  }
+  st.set_items_per_iteration(irqs.interrupts().size());
+}
+
+const telemetry::bench::Register kSample128("proc/interrupts/sample/cpus=128", &bench_sample, 128);
+const telemetry::bench::Register kSample256("proc/interrupts/sample/cpus=256", &bench_sample, 256);
+const telemetry::bench::Register kScan256("proc/interrupts/scan/cpus=256", &bench_scan<true>, 256);
+const telemetry::bench::Register kScalar256("proc/interrupts/scan_scalar/cpus=256", &bench_scan<false>, 256);
+
+}  // namespace
+
+#endif
@@ -0,0 +1,66 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "microbench.h"
+
+#ifndef TELEMETRY_BENCH_FIXTURES
+#define TELEMETRY_BENCH_FIXTURES "fixtures"
+#endif
+
+namespace {
+
+void print_usage(const char* argv0) {
+  std::fprintf(stderr,
+               "Usage: %s [--filter <substr>] [--reps <n>] [--warmup-reps <n>] [--min-time-ms <ms>]\n"
+               "          [--fixtures <dir>] [--json] [--list]\n"
+               "Defaults: --reps 10 --warmup-reps 1 --min-time-ms 20 --fixtures %s\n"
+               "Each benchmark is calibrated to run at least --min-time-ms per repetition; the median\n"
+               "ns/op and its median absolute deviation go to stderr, --json also writes one JSON\n"
+               "document to stdout.\n",
+               argv0, TELEMETRY_BENCH_FIXTURES);
+}
+
+bool parse_int(const char* s, int& out) {
+  if (!s || !*s) return false;
+  char* end = nullptr;
+  const long v = std::strtol(s, &end, 10);
+  if (*end != '\0' || v < 0 || v > 1000000) return false;
+  out = static_cast<int>(v);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  telemetry::bench::Options opt{};
+  telemetry::bench::fixtures_dir() = TELEMETRY_BENCH_FIXTURES;
+  for (int i = 1; i < argc; ++i) {
+    const char* a = argv[i];
+    const bool has_value = i + 1 < argc;
+    int v = 0;
+    if (std::strcmp(a, "--help") == 0 || std::strcmp(a, "-h") == 0) {
+      print_usage(argv[0]);
+      return 0;
+    } else if (std::strcmp(a, "--filter") == 0 && has_value) {
+      opt.filter = argv[++i];
+    } else if (std::strcmp(a, "--reps") == 0 && has_value && parse_int(argv[++i], v) && v > 0) {
+      opt.repetitions = v;
+    } else if (std::strcmp(a, "--warmup-reps") == 0 && has_value && parse_int(argv[++i], v)) {
+      opt.warmup_reps = v;
+    } else if (std::strcmp(a, "--min-time-ms") == 0 && has_value && parse_int(argv[++i], v) && v > 0) {
+      opt.min_time_ms = static_cast<double>(v);
+    } else if (std::strcmp(a, "--fixtures") == 0 && has_value) {
+      telemetry::bench::fixtures_dir() = argv[++i];
+    } else if (std::strcmp(a, "--json") == 0) {
+      opt.json = true;
+    } else if (std::strcmp(a, "--list") == 0) {
+      opt.list = true;
+    } else {
+      std::fprintf(stderr, "Invalid or unknown arg: %s\n", a);
+      print_usage(argv[0]);
+      return 2;
+    }
+  }
+  return telemetry::bench::run_all(opt);
+}
@@ -0,0 +1,150 @@
+#include "microbench.h"
+
+#ifndef _WIN32
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include "telemetry/metrics/collector.h"
+#include "telemetry/net/tcp_server.h"
+
+namespace {
+
+class ConstSource final : public telemetry::metrics::MetricSource {
+ public:
+  const char* name() const override { return "const"; }
+  telemetry::Status collect(telemetry::MetricsSnapshot& out) override {
+    out.cpu_usage_pct = 12.5;
+    out.mem_total_kb = 8000000;
+    out.mem_available_kb = 4000000;
+    out.uptime_s = 1000;
+    return telemetry::Status::Ok();
+  }
+};
+
+// One in-process agent per bench run, listening on both loopback TCP and a unix socket so
+// the two transports are measured against the same event loop.
+class BenchServer final {
+ public:
+  static BenchServer& get() {
+    static BenchServer s;
+    return s;
+  }
+
+  int connect_tcp() const {
+    for (int attempt = 0; attempt < 100; ++attempt) {
+      const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+      sockaddr_in addr{};
+      addr.sin_family = AF_INET;
+      addr.sin_port = htons(port_);
+      addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+        int one = 1;
+        (void)::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        return fd;
+      }
+      ::close(fd);
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return -1;
+  }
+
+  int connect_unix() const {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path_, std::strlen(path_) + 1);
+    for (int attempt = 0; attempt < 100; ++attempt) {
+      const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+      if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+      ::close(fd);
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return -1;
+  }
+
+ private:
+  BenchServer() : path_{} {
+    port_ = static_cast<std::uint16_t>(30000 + (::getpid() % 20000));
+    std::snprintf(path_, sizeof(path_), "/tmp/telemetry_bench_%d.sock", static_cast<int>(::getpid()));
+    collector_.add_source(std::make_unique<ConstSource>());
+    telemetry::net::TcpServerConfig cfg{};
+    cfg.host = "127.0.0.1";
+    cfg.port = port_;
+    cfg.unix_path = path_;
+    cfg.throttle_ms = 0;  // every GET collects, as a cold scrape would
+    server_ = std::make_unique<telemetry::net::TcpServer>(collector_, cfg);
+    thread_ = std::thread([this] {
+      const telemetry::Status st = server_->run_forever();
+      if (!st.ok()) std::fprintf(stderr, "bench server failed: %s\n", st.message ? st.message : "(none)");
+    });
+  }
+
+  ~BenchServer() {
+    server_->stop();
+    thread_.join();
+  }
+
+  std::uint16_t port_{0};
+  char path_[64];
+  telemetry::metrics::Collector collector_;
+  std::unique_ptr<telemetry::net::TcpServer> server_;
+  std::thread thread_;
+};
+
+// Blocking request/response; returns false once the connection is gone.
+bool round_trip(int fd, const char* req, std::size_t len) {
+  if (::send(fd, req, len, MSG_NOSIGNAL) != static_cast<ssize_t>(len)) return false;
+  char buf[1024];
+  while (true) {
+    const ssize_t n = ::read(fd, buf, sizeof(buf));
+    if (n <= 0) return false;
+    if (buf[n - 1] == '\n') return true;
+  }
+}
+
+void run_round_trips(telemetry::bench::State& st, int fd, const char* req) {
+  if (fd < 0) {
+    std::fprintf(stderr, "bench server connect failed\n");
+    while (st.keep_running()) {
+    }
+    return;
+  }
+  const std::size_t len = std::strlen(req);
+  while (st.keep_running()) {
+    if (!round_trip(fd, req, len)) break;
+  }
+  ::close(fd);
+}
+
+}  // namespace
+
+// Full GET round trip (request, collect, JSON, reply) over loopback TCP with TCP_NODELAY.
+TELEMETRY_BENCH("net/get_round_trip/tcp") {
+  run_round_trips(st, BenchServer::get().connect_tcp(), "GET\n");
+}
+
+// The same GET over the AF_UNIX listener: no TCP/IP stack, checksums or ACK processing.
+TELEMETRY_BENCH("net/get_round_trip/unix") {
+  run_round_trips(st, BenchServer::get().connect_unix(), "GET\n");
+}
+
+// PING isolates the transport plus event-loop cost from collection.
+TELEMETRY_BENCH("net/ping_round_trip/tcp") {
+  run_round_trips(st, BenchServer::get().connect_tcp(), "PING\n");
+}
+
+TELEMETRY_BENCH("net/ping_round_trip/unix") {
+  run_round_trips(st, BenchServer::get().connect_unix(), "PING\n");
+}
+
+#endif  // !_WIN32
@@ -0,0 +1,83 @@
+#include "microbench.h"
+
+#if defined(__linux__)
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "bench_util.h"
+#include "telemetry/metrics/process_source.h"
+
+namespace {
+
+// A synthetic /proc of `procs` processes under a temp root, built once per size and removed
+// at exit: /proc/<pid>/stat only, plus the non-process entries a real /proc lists first.
+class SyntheticProc final {
+ public:
+  explicit SyntheticProc(int procs) {
+    const std::string proc = root() + "/proc";
+    (void)::mkdir(proc.c_str(), 0700);
+    for (const char* dir : {"/self", "/net", "/sys", "/irq"}) (void)::mkdir((proc + dir).c_str(), 0700);
+    char path[256];
+    for (int pid = 1; pid <= procs; ++pid) {
+      std::snprintf(path, sizeof(path), "%s/%d", proc.c_str(), pid);
+      (void)::mkdir(path, 0700);
+      std::snprintf(path, sizeof(path), "%s/%d/stat", proc.c_str(), pid);
+      std::FILE* f = std::fopen(path, "w");
+      if (!f) {
+        std::fprintf(stderr, "synthetic /proc write failed\n");
+        std::exit(1);
+      }
+      std::fprintf(f,
+                   "%d (worker-%d) S 1 %d %d 0 -1 4194560 1200 0 3 0 %d %d 0 0 20 0 4 0 %d 104857600 %d "
+                   "18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 0 17 %d 0 0 0 0 0\n",
+                   pid, pid % 1000, pid, pid, pid * 7 % 5000, pid * 3 % 2000, 1000 + pid, 256 + pid % 4096, pid % 8);
+      std::fclose(f);
+    }
+  }
+  const std::string& root() const { return tmp_.path(); }
+
+ private:
+  telemetry::bench::TempDir tmp_{"proc"};
+};
+
+const std::string& synthetic_root(int procs) {
+  if (procs <= 1000) {
+    static const SyntheticProc small(1000);
+    return small.root();
+  }
+  static const SyntheticProc large(50000);
+  return large.root();
+}
+
+// One iteration = one collect(). Without a per-tick budget that is a full pass over /proc;
+// with one (the second argument) it is the bounded slice the event loop pays per sample.
+void run_scan(telemetry::bench::State& st, int procs, std::size_t per_tick) {
+  telemetry::metrics::ProcessSourceConfig cfg{};
+  cfg.root = synthetic_root(procs).c_str();
+  cfg.max_per_tick = per_tick;
+  telemetry::metrics::ProcessSource src(cfg);
+  std::uint64_t now_ns = 1'000'000'000ULL;
+  (void)src.sample(now_ns);  // primes the counter table
+  while (st.keep_running()) {
+    now_ns += 1'000'000'000ULL;
+    const telemetry::Status s = src.sample(now_ns);
+    telemetry::bench::do_not_optimize(s);
+  }
+  st.set_items_per_iteration(per_tick != 0 ? per_tick : static_cast<std::uint64_t>(procs));
+  st.set_counter("processes", static_cast<double>(src.processes()));
+}
+
+void bench_full_pass(telemetry::bench::State& st) { run_scan(st, static_cast<int>(st.arg()), 0); }
+void bench_per_tick(telemetry::bench::State& st) { run_scan(st, 50000, static_cast<std::size_t>(st.arg())); }
+
+const telemetry::bench::Register kScan1k("proc/top_scan/procs=1000", &bench_full_pass, 1000);
+const telemetry::bench::Register kScan50k("proc/top_scan/procs=50000", &bench_full_pass, 50000);
+const telemetry::bench::Register kTick("proc/top_scan/procs=50000/per_tick=2000", &bench_per_tick, 2000);
+
+}  // namespace
+
+#endif
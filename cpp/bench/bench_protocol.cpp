@@ -0,0 +1,77 @@
+#include "microbench.h"
+
+#include <string>
+#include <string_view>
+
+#include "telemetry/net/http.h"
+#include "telemetry/net/openmetrics.h"
+#include "telemetry/net/protocol.h"
+
+namespace {
+
+telemetry::MetricsSnapshot sample_snapshot() {
+  telemetry::MetricsSnapshot s{};
+  s.ts_ms = 1700000000123ULL;
+  s.cpu_usage_pct = 37.25;
+  s.mem_total_kb = 8041320;
+  s.mem_available_kb = 4302116;
+  s.temperature_c = 47.25;
+  s.uptime_s = 183245;
+  return s;
+}
+
+}  // namespace
+
+TELEMETRY_BENCH("protocol/parse_command/mix") {
+  // Roughly what a dashboard plus a few operators send.
+  constexpr std::string_view kLines[] = {
+      "GET", "GET", "GET", "PING", "THROTTLE 500", "FLEET TOP 10", "SUBSCRIBE DELTA 2 0.01 240", "DRAIN 123456",
+  };
+  std::size_t i = 0;
+  while (st.keep_running()) {
+    const telemetry::net::ParsedCommand pc = telemetry::net::parse_command(kLines[i++ & 7]);
+    telemetry::bench::do_not_optimize(pc);
+  }
+}
+
+TELEMETRY_BENCH("protocol/format_metrics_json") {
+  telemetry::MetricsSnapshot snap = sample_snapshot();
+  char out[512];
+  std::size_t n = 0;
+  while (st.keep_running()) {
+    ++snap.ts_ms;
+    n = telemetry::net::format_metrics_json(out, sizeof(out), snap, telemetry::Status::Ok(), 250);
+    telemetry::bench::do_not_optimize(out);
+  }
+  st.set_counter("bytes", static_cast<double>(n));
+}
+
+TELEMETRY_BENCH("http/parse_request/scrape") {
+  constexpr std::string_view kRequest =
+      "GET /metrics HTTP/1.1\r\n"
+      "Host: 10.0.0.12:9100\r\n"
+      "User-Agent: Prometheus/2.48.0\r\n"
+      "Accept: application/openmetrics-text;version=1.0.0,text/plain;version=0.0.4;q=0.5,*/*;q=0.1\r\n"
+      "Accept-Encoding: gzip\r\n"
+      "X-Prometheus-Scrape-Timeout-Seconds: 10\r\n"
+      "\r\n";
+  telemetry::net::HttpRequestParser parser;
+  telemetry::net::HttpRequest req{};
+  while (st.keep_running()) {
+    parser.reset();
+    const telemetry::net::HttpParseResult r = parser.parse(kRequest, req);
+    telemetry::bench::do_not_optimize(r);
+    telemetry::bench::do_not_optimize(req);
+  }
+}
+
+TELEMETRY_BENCH("openmetrics/render") {
+  telemetry::MetricsSnapshot snap = sample_snapshot();
+  std::string out;
+  while (st.keep_running()) {
+    ++snap.ts_ms;
+    (void)telemetry::net::render_openmetrics(snap, telemetry::Status::Ok(), out);
+    telemetry::bench::do_not_optimize(out.data());
+  }
+  st.set_counter("bytes", static_cast<double>(out.size()));
+}
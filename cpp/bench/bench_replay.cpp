@@ -0,0 +1,97 @@
+#include "microbench.h"
+
+#ifndef _WIN32
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "bench_util.h"
+#include "synthetic_trace.h"
+#include "telemetry/metrics/collector.h"
+#include "telemetry/metrics/replay_source.h"
+#include "telemetry/storage/spool.h"
+
+namespace {
+
+constexpr std::size_t kRecords = 86400;
+
+// Six hours of the synthetic 250 ms trace spooled to a temp dir in 4 MiB segments, as an
+// agent's --spool-dir would hold it; built once and removed at exit.
+class SyntheticSpool final {
+ public:
+  SyntheticSpool() {
+    telemetry::storage::SpoolConfig cfg{};
+    cfg.dir = dir().c_str();
+    cfg.flush_bytes = 1024U * 1024U;
+    telemetry::storage::Spool spool(cfg);
+    bool ok = spool.open().ok();
+    for (const telemetry::MetricsSnapshot& s : telemetry::bench::synthetic_trace(kRecords)) {
+      ok = ok && spool.append(s, telemetry::Status::Ok(), 0).ok();
+    }
+    if (!ok || !spool.flush(false).ok()) {
+      std::fprintf(stderr, "synthetic spool write failed\n");
+      std::exit(1);
+    }
+  }
+  const std::string& dir() const { return tmp_.path(); }
+
+ private:
+  telemetry::bench::TempDir tmp_{"replay"};
+};
+
+const SyntheticSpool& synthetic() {
+  static const SyntheticSpool spool;
+  return spool;
+}
+
+telemetry::metrics::ReplayConfig max_speed() {
+  telemetry::metrics::ReplayConfig cfg{};
+  cfg.path = synthetic().dir().c_str();
+  cfg.speed = 0.0;
+  return cfg;
+}
+
+// One iteration = one record decoded straight from the mapping, as fast as possible.
+TELEMETRY_BENCH("replay/collect/max_speed") {
+  telemetry::metrics::ReplaySource replay(max_speed());
+  if (!replay.open().ok()) std::exit(1);
+  telemetry::MetricsSnapshot snap{};
+  while (st.keep_running()) {
+    const telemetry::Status s = replay.collect(snap);
+    telemetry::bench::do_not_optimize(s);
+    telemetry::bench::do_not_optimize(snap);
+  }
+  st.set_counter("records", static_cast<double>(replay.records()));
+}
+
+// The same through Collector::collect, as the server's sampler sees it.
+TELEMETRY_BENCH("replay/collector/max_speed") {
+  auto replay = std::make_unique<telemetry::metrics::ReplaySource>(max_speed());
+  if (!replay->open().ok()) std::exit(1);
+  telemetry::metrics::Collector collector;
+  collector.add_source(std::move(replay));
+  telemetry::MetricsSnapshot snap{};
+  while (st.keep_running()) {
+    const telemetry::Status s = collector.collect(snap);
+    telemetry::bench::do_not_optimize(s);
+    telemetry::bench::do_not_optimize(snap);
+  }
+}
+
+// One iteration = mapping the spool and indexing all 86400 records (CRC and decode each).
+TELEMETRY_BENCH("replay/open/records=86400") {
+  telemetry::metrics::ReplaySource replay(max_speed());
+  std::size_t records = 0;
+  while (st.keep_running()) {
+    const telemetry::Status s = replay.open();
+    telemetry::bench::do_not_optimize(s);
+    records = replay.records();
+  }
+  st.set_items_per_iteration(records);
+}
+
+}  // namespace
+
+#endif
@@ -0,0 +1,46 @@
+#include "microbench.h"
+
+#include <cstdio>
+
+#include "synthetic_trace.h"
+#include "telemetry/rules/rule_engine.h"
+
+namespace {
+
+constexpr int kRules = 1000;
+
+}  // namespace
+
+// One evaluate() of kRules rules mixing plain thresholds, ratios, `for` and hysteresis.
+TELEMETRY_BENCH("rules/evaluate/1000") {
+  telemetry::rules::RuleEngine engine;
+  char text[128];
+  for (int i = 0; i < kRules; ++i) {
+    switch (i % 4) {
+      case 0:
+        std::snprintf(text, sizeof(text), "cpu%d: cpu_usage_pct > %d", i, 10 + i % 80);
+        break;
+      case 1:
+        std::snprintf(text, sizeof(text), "mem%d: mem_available_kb / mem_total_kb < 0.%02d", i, 5 + i % 50);
+        break;
+      case 2:
+        std::snprintf(text, sizeof(text), "temp%d: temperature_c >= %d for 5s hysteresis 2", i, 40 + i % 20);
+        break;
+      default:
+        std::snprintf(text, sizeof(text), "mix%d: (cpu_usage_pct * 2 + temperature_c) / 3 > %d", i, 20 + i % 60);
+        break;
+    }
+    if (!engine.add_rule(text).ok()) std::fprintf(stderr, "bad bench rule: %s\n", text);
+  }
+
+  const auto trace = telemetry::bench::synthetic_trace(1024);
+  std::size_t i = 0;
+  std::uint64_t now = 1700000000000ULL;
+  while (st.keep_running()) {
+    now += 250;
+    engine.evaluate(trace[i++ & 1023], now);
+    engine.clear_events();
+  }
+  st.set_items_per_iteration(kRules);
+  st.set_counter("firing", static_cast<double>(engine.firing_count()));
+}
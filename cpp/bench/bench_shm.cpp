@@ -0,0 +1,71 @@
+#include "microbench.h"
+
+#ifndef _WIN32
+
+#include <unistd.h>
+
+#include <cstdio>
+
+#include "synthetic_trace.h"
+#include "telemetry/shm/shm_publisher.h"
+#include "telemetry/shm/shm_reader.h"
+
+namespace {
+
+struct BenchSegment final {
+  char name[64];
+  telemetry::shm::ShmPublisher pub;
+
+  static telemetry::shm::ShmConfig config(char* name, std::size_t cap) {
+    std::snprintf(name, cap, "/telemetry_bench_%d", static_cast<int>(::getpid()));
+    telemetry::shm::ShmConfig cfg{};
+    cfg.name = name;
+    cfg.history = 256;
+    return cfg;
+  }
+
+  BenchSegment() : name{}, pub(config(name, sizeof(name))) {
+    if (!pub.open().ok()) std::fprintf(stderr, "bench shm segment %s failed to open\n", name);
+  }
+};
+
+}  // namespace
+
+// One sampler-side publish: seqlock slot write plus the published counter.
+TELEMETRY_BENCH("shm/publish") {
+  BenchSegment seg;
+  const auto trace = telemetry::bench::synthetic_trace(1024);
+  std::size_t i = 0;
+  while (st.keep_running()) seg.pub.on_snapshot(trace[i++ & 1023], telemetry::Status::Ok());
+}
+
+// What a local consumer pays per poll instead of a loopback GET round trip.
+TELEMETRY_BENCH("shm/read_latest") {
+  BenchSegment seg;
+  const auto trace = telemetry::bench::synthetic_trace(1024);
+  for (const auto& s : trace) seg.pub.on_snapshot(s, telemetry::Status::Ok());
+  telemetry::shm::ShmReader reader;
+  if (!reader.open(seg.name).ok()) std::fprintf(stderr, "bench shm reader failed to open %s\n", seg.name);
+  telemetry::shm::ShmSample s{};
+  while (st.keep_running()) {
+    reader.latest(s);
+    telemetry::bench::do_not_optimize(s);
+  }
+}
+
+// The newest 64 samples of the history ring.
+TELEMETRY_BENCH("shm/read_history/64") {
+  BenchSegment seg;
+  const auto trace = telemetry::bench::synthetic_trace(1024);
+  for (const auto& s : trace) seg.pub.on_snapshot(s, telemetry::Status::Ok());
+  telemetry::shm::ShmReader reader;
+  if (!reader.open(seg.name).ok()) std::fprintf(stderr, "bench shm reader failed to open %s\n", seg.name);
+  telemetry::shm::ShmSample hist[64];
+  while (st.keep_running()) {
+    const std::size_t n = reader.history(hist, 64);
+    telemetry::bench::do_not_optimize(n);
+  }
+  st.set_items_per_iteration(64);
+}
+
+#endif  // !_WIN32
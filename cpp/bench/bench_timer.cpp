@@ -0,0 +1,54 @@
+#include "microbench.h"
+
+#include <cstdint>
+#include <memory>
+
+#include "telemetry/util/timer_wheel.h"
+
+namespace {
+
+// Re-arming one of `arg` armed timers, as the event loop does for a connection's idle timer,
+// at delays spread over the lower three levels.
+void bench_schedule(telemetry::bench::State& st) {
+  const auto n = static_cast<std::size_t>(st.arg());
+  auto timers = std::make_unique<telemetry::util::WheelTimer[]>(n);
+  telemetry::util::TimerWheel wheel(1000);
+  for (std::size_t i = 0; i < n; ++i) wheel.schedule(timers[i], 1000 + 1 + (i * 7919) % 200000);
+  std::size_t i = 0;
+  std::uint64_t delay = 1;
+  while (st.keep_running()) {
+    delay = (delay * 48271) % 200000 + 1;
+    wheel.schedule(timers[i], 1000 + delay);
+    if (++i == n) i = 0;
+  }
+  telemetry::bench::do_not_optimize(wheel.size());
+  wheel.reset(0);
+}
+
+// One loop pass of bookkeeping: advance by 1 ms (firing and re-arming whatever is due) and
+// compute the poll timeout, with `arg` timers spread over the next 300 s.
+void bench_advance(telemetry::bench::State& st) {
+  const auto n = static_cast<std::size_t>(st.arg());
+  auto timers = std::make_unique<telemetry::util::WheelTimer[]>(n);
+  telemetry::util::TimerWheel wheel(0);
+  for (std::size_t i = 0; i < n; ++i) wheel.schedule(timers[i], 1 + (i * 7919) % 300000);
+  std::uint64_t now = 0;
+  std::uint64_t fired = 0;
+  auto rearm = [&](telemetry::util::WheelTimer& t) {
+    ++fired;
+    wheel.schedule(t, wheel.now_ms() + 300000);
+  };
+  while (st.keep_running()) {
+    wheel.advance(++now, rearm);
+    telemetry::bench::do_not_optimize(wheel.poll_timeout_ms(now));
+  }
+  st.set_counter("fired/op", now ? static_cast<double>(fired) / static_cast<double>(now) : 0.0);
+  wheel.reset(0);
+}
+
+const telemetry::bench::Register kSchedule64("timer/schedule/64", &bench_schedule, 64);
+const telemetry::bench::Register kSchedule64k("timer/schedule/65536", &bench_schedule, 65536);
+const telemetry::bench::Register kAdvance64("timer/advance_1ms/64", &bench_advance, 64);
+const telemetry::bench::Register kAdvance64k("timer/advance_1ms/65536", &bench_advance, 65536);
+
+}  // namespace
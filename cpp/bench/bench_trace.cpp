@@ -0,0 +1,52 @@
+#include "microbench.h"
+
+#include <memory>
+
+#include "bench_util.h"
+#include "telemetry/metrics/collector.h"
+#include "telemetry/net/protocol.h"
+#include "telemetry/trace/trace.h"
+
+namespace {
+
+void bench_span(telemetry::bench::State& st) {
+  telemetry::trace::set_enabled(st.arg() != 0);
+  while (st.keep_running()) {
+    telemetry::trace::Span span("bench");
+    telemetry::bench::do_not_optimize(span);
+  }
+  telemetry::trace::set_enabled(false);
+  telemetry::trace::clear();
+}
+
+// The server's GET work minus the socket: parse, collect four sources, format the reply.
+// Spans fire as in TcpServer (parse, handle, write) and Collector (collect + one per source).
+void bench_get_path(telemetry::bench::State& st) {
+  telemetry::metrics::Collector collector;
+  for (int i = 0; i < 4; ++i) collector.add_source(std::make_unique<telemetry::bench::FakeSource>());
+  telemetry::MetricsSnapshot snap{};
+  char out[512];
+  telemetry::trace::set_enabled(st.arg() != 0);
+  while (st.keep_running()) {
+    telemetry::net::ParsedCommand pc{};
+    {
+      telemetry::trace::Span span("parse");
+      pc = telemetry::net::parse_command("GET");
+    }
+    telemetry::trace::Span handle("handle", static_cast<std::uint64_t>(pc.type));
+    const telemetry::Status s = collector.collect(snap);
+    telemetry::trace::Span write("write");
+    const std::size_t n = telemetry::net::format_metrics_json(out, sizeof(out), snap, s, 250);
+    write.set_arg(n);
+    telemetry::bench::do_not_optimize(out);
+  }
+  telemetry::trace::set_enabled(false);
+  telemetry::trace::clear();
+}
+
+const telemetry::bench::Register kSpanOff("trace/span/disabled", &bench_span, 0);
+const telemetry::bench::Register kSpanOn("trace/span/enabled", &bench_span, 1);
+const telemetry::bench::Register kGetOff("trace/get_path/disabled", &bench_get_path, 0);
+const telemetry::bench::Register kGetOn("trace/get_path/enabled", &bench_get_path, 1);
+
+}  // namespace
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "telemetry/metrics/metric_source.h"
+
+namespace telemetry::bench {
+
+// Stand-in for a cheap in-memory source, so the numbers isolate collector dispatch and
+// tracing rather than any parsing.
+class FakeSource final : public metrics::MetricSource {
+ public:
+  explicit FakeSource(std::uint64_t v = 1) : v_(v) {}
+  const char* name() const override { return "fake"; }
+  Status collect(MetricsSnapshot& out) override {
+    out.uptime_s += v_;
+    return Status::Ok();
+  }
+
+ private:
+  std::uint64_t v_;
+};
+
+#ifndef _WIN32
+
+// A fresh `telemetry_bench_<name>_XXXXXX` directory for a synthetic tree, removed with its
+// contents on destruction. It is made on tmpfs when /dev/shm exists: thousands of small files
+// on a disk-backed /tmp make the setup, not the code under test, dominate the run.
+class TempDir final {
+ public:
+  explicit TempDir(const char* name) {
+    char tmpl[128];
+    struct stat shm {};
+    std::snprintf(tmpl, sizeof(tmpl), "%s/telemetry_bench_%s_XXXXXX",
+                  ::stat("/dev/shm", &shm) == 0 && S_ISDIR(shm.st_mode) ? "/dev/shm" : "/tmp", name);
+    if (!::mkdtemp(tmpl)) {
+      std::fprintf(stderr, "mkdtemp failed\n");
+      std::exit(1);
+    }
+    path_ = tmpl;
+  }
+  ~TempDir() {
+    std::error_code ec;
+    std::filesystem::remove_all(path_, ec);
+  }
+
+  TempDir(const TempDir&) = delete;
+  TempDir& operator=(const TempDir&) = delete;
+
+  const std::string& path() const { return path_; }
+
+ private:
+  std::string path_;
+};
+
+#endif  // !_WIN32
+
+}  // namespace telemetry::bench
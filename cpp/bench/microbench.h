@@ -0,0 +1,243 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "telemetry/util/time.h"
+
+namespace telemetry::bench {
+
+// Passed to every benchmark. The body does its setup, then loops `while (st.keep_running())`
+// around the measured operation; only the loop is timed.
+class State final {
+ public:
+  State(std::uint64_t iterations, std::int64_t arg) : iterations_(iterations), remaining_(iterations), arg_(arg) {}
+
+  bool keep_running() {
+    if (remaining_ == 0) {
+      if (end_ns_ == 0) end_ns_ = telemetry::util::monotonic_ns();
+      return false;
+    }
+    if (remaining_ == iterations_) start_ns_ = telemetry::util::monotonic_ns();
+    --remaining_;
+    return true;
+  }
+
+  std::int64_t arg() const { return arg_; }
+  std::uint64_t iterations() const { return iterations_; }
+
+  // Work items per iteration (e.g. samples in a batch); reported as items/s.
+  void set_items_per_iteration(std::uint64_t n) { items_ = n; }
+  // Free-form result reported next to the timings (e.g. bytes per sample).
+  void set_counter(std::string_view name, double value) {
+    for (auto& c : counters_) {
+      if (c.first == name) {
+        c.second = value;
+        return;
+      }
+    }
+    counters_.emplace_back(std::string(name), value);
+  }
+
+  std::uint64_t elapsed_ns() const { return end_ns_ > start_ns_ ? end_ns_ - start_ns_ : 0; }
+  std::uint64_t items() const { return items_; }
+  const std::vector<std::pair<std::string, double>>& counters() const { return counters_; }
+
+ private:
+  std::uint64_t iterations_;
+  std::uint64_t remaining_;
+  std::int64_t arg_;
+  std::uint64_t start_ns_{0};
+  std::uint64_t end_ns_{0};
+  std::uint64_t items_{1};
+  std::vector<std::pair<std::string, double>> counters_;
+};
+
+struct Benchmark final {
+  std::string_view name;
+  void (*fn)(State&);
+  std::int64_t arg;
+};
+
+inline std::vector<Benchmark>& registry() {
+  static std::vector<Benchmark> r;
+  return r;
+}
+
+struct Register final {
+  Register(std::string_view name, void (*fn)(State&), std::int64_t arg = 0) {
+    registry().push_back(Benchmark{name, fn, arg});
+  }
+};
+
+// Keeps the optimizer from discarding a computed value or hoisting it out of the loop.
+template <class T>
+inline void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const void* sink;
+  sink = &value;
+#endif
+}
+
+struct Options final {
+  std::string_view filter;     // substring match on the name; empty = all
+  int warmup_reps = 1;         // timed runs discarded after calibration
+  int repetitions = 10;
+  double min_time_ms = 20.0;   // each repetition runs at least this long
+  bool json = false;
+  bool list = false;
+};
+
+// Robust summary of one benchmark's per-repetition ns/op.
+struct Result final {
+  std::string_view name;
+  std::uint64_t iterations{0};
+  int repetitions{0};
+  double median{0.0};
+  double mad{0.0};  // median absolute deviation
+  double min{0.0};
+  double max{0.0};
+  double mean{0.0};
+  int outliers{0};  // repetitions further than 3 scaled MADs from the median
+  double items_per_s{0.0};
+  std::vector<std::pair<std::string, double>> counters;
+};
+
+inline double median_of(std::vector<double> v) {
+  if (v.empty()) return 0.0;
+  std::sort(v.begin(), v.end());
+  const std::size_t mid = v.size() / 2;
+  return (v.size() % 2) ? v[mid] : (v[mid - 1] + v[mid]) / 2.0;
+}
+
+inline Result summarize(std::string_view name, std::uint64_t iterations, const std::vector<double>& ns_per_op,
+                        std::uint64_t items, std::vector<std::pair<std::string, double>> counters) {
+  Result r{};
+  r.name = name;
+  r.iterations = iterations;
+  r.repetitions = static_cast<int>(ns_per_op.size());
+  r.counters = std::move(counters);
+  if (ns_per_op.empty()) return r;
+
+  r.median = median_of(ns_per_op);
+  std::vector<double> dev;
+  dev.reserve(ns_per_op.size());
+  double sum = 0.0;
+  r.min = ns_per_op.front();
+  r.max = ns_per_op.front();
+  for (double x : ns_per_op) {
+    dev.push_back(std::fabs(x - r.median));
+    sum += x;
+    r.min = std::min(r.min, x);
+    r.max = std::max(r.max, x);
+  }
+  r.mad = median_of(dev);
+  r.mean = sum / static_cast<double>(ns_per_op.size());
+  // 1.4826 scales the MAD to a standard deviation for normally distributed noise.
+  const double limit = 3.0 * 1.4826 * r.mad;
+  for (double d : dev) {
+    if (limit > 0.0 && d > limit) ++r.outliers;
+  }
+  if (r.median > 0.0) r.items_per_s = static_cast<double>(items) * 1e9 / r.median;
+  return r;
+}
+
+// Grows the iteration count until one run takes at least min_time_ms; doubles as warmup.
+inline std::uint64_t calibrate(const Benchmark& b, double min_time_ms) {
+  const double target_ns = min_time_ms * 1e6;
+  std::uint64_t iterations = 1;
+  while (true) {
+    State st(iterations, b.arg);
+    b.fn(st);
+    const double ns = static_cast<double>(st.elapsed_ns());
+    if (ns >= target_ns || iterations >= (1ULL << 32)) return iterations;
+    double factor = ns > 0.0 ? (target_ns * 1.2) / ns : 10.0;
+    factor = std::clamp(factor, 2.0, 10.0);
+    iterations = static_cast<std::uint64_t>(static_cast<double>(iterations) * factor);
+  }
+}
+
+inline Result run_one(const Benchmark& b, const Options& opt) {
+  const std::uint64_t iterations = calibrate(b, opt.min_time_ms);
+  for (int i = 0; i < opt.warmup_reps; ++i) {
+    State st(iterations, b.arg);
+    b.fn(st);
+  }
+
+  std::vector<double> ns_per_op;
+  std::uint64_t items = 1;
+  std::vector<std::pair<std::string, double>> counters;
+  for (int i = 0; i < opt.repetitions; ++i) {
+    State st(iterations, b.arg);
+    b.fn(st);
+    ns_per_op.push_back(static_cast<double>(st.elapsed_ns()) / static_cast<double>(iterations));
+    items = st.items();
+    counters = st.counters();
+  }
+  return summarize(b.name, iterations, ns_per_op, items, std::move(counters));
+}
+
+inline void print_human(const Result& r) {
+  std::fprintf(stderr, "%-44s %11.1f ns/op  ±%-9.1f min %-10.1f max %-10.1f", std::string(r.name).c_str(), r.median,
+               r.mad, r.min, r.max);
+  if (r.items_per_s > 0.0) std::fprintf(stderr, " %12.0f items/s", r.items_per_s);
+  for (const auto& c : r.counters) std::fprintf(stderr, " %s=%.4g", c.first.c_str(), c.second);
+  if (r.outliers > 0) std::fprintf(stderr, " (%d outliers)", r.outliers);
+  std::fprintf(stderr, "\n");
+}
+
+inline void print_json(const std::vector<Result>& results, const Options& opt) {
+  std::printf("{\"repetitions\":%d,\"min_time_ms\":%.3f,\"benchmarks\":[", opt.repetitions, opt.min_time_ms);
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    std::printf("%s{\"name\":\"%s\",\"iterations\":%llu,\"repetitions\":%d,\"ns_per_op\":{\"median\":%.3f,\"mad\":%.3f,"
+                "\"min\":%.3f,\"max\":%.3f,\"mean\":%.3f},\"outliers\":%d,\"items_per_s\":%.1f,\"counters\":{",
+                i ? "," : "", std::string(r.name).c_str(), static_cast<unsigned long long>(r.iterations),
+                r.repetitions, r.median, r.mad, r.min, r.max, r.mean, r.outliers, r.items_per_s);
+    for (std::size_t j = 0; j < r.counters.size(); ++j) {
+      std::printf("%s\"%s\":%.6g", j ? "," : "", r.counters[j].first.c_str(), r.counters[j].second);
+    }
+    std::printf("}}");
+  }
+  std::printf("]}\n");
+}
+
+inline int run_all(const Options& opt) {
+  std::vector<Result> results;
+  for (const auto& b : registry()) {
+    if (!opt.filter.empty() && b.name.find(opt.filter) == std::string_view::npos) continue;
+    if (opt.list) {
+      std::printf("%s\n", std::string(b.name).c_str());
+      continue;
+    }
+    results.push_back(run_one(b, opt));
+    print_human(results.back());
+  }
+  if (opt.json && !opt.list) print_json(results, opt);
+  return 0;
+}
+
+// Directory holding the /proc and /sys fixture trees (set from --fixtures).
+inline std::string& fixtures_dir() {
+  static std::string dir;
+  return dir;
+}
+
+}  // namespace telemetry::bench
+
+#define TELEMETRY_BENCH_CONCAT2(a, b) a##b
+#define TELEMETRY_BENCH_CONCAT(a, b) TELEMETRY_BENCH_CONCAT2(a, b)
+
+#define TELEMETRY_BENCH(name)                                                                   \
+  static void TELEMETRY_BENCH_CONCAT(telemetry_bench_fn_, __LINE__)(::telemetry::bench::State&); \
+  static ::telemetry::bench::Register TELEMETRY_BENCH_CONCAT(telemetry_bench_reg_, __LINE__)(     \
+      name, &TELEMETRY_BENCH_CONCAT(telemetry_bench_fn_, __LINE__));                              \
+  static void TELEMETRY_BENCH_CONCAT(telemetry_bench_fn_, __LINE__)(::telemetry::bench::State & st)
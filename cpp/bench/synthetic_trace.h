@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "telemetry/metrics_snapshot.h"
+
+namespace telemetry::bench {
+
+// Deterministic 250 ms trace: noisy CPU, slow memory churn, slow thermal drift, 1 Hz uptime.
+// Same shape as the DeltaStream bytes-per-sample test, so the numbers are comparable.
+inline std::vector<MetricsSnapshot> synthetic_trace(std::size_t samples) {
+  std::vector<MetricsSnapshot> out;
+  out.reserve(samples);
+  std::uint64_t rng = 0x9E3779B97F4A7C15ULL;
+  auto noise = [&rng] {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return static_cast<double>(rng % 1000) / 1000.0 - 0.5;
+  };
+  double cpu = 20.0;
+  double avail = 4000000.0;
+  for (std::size_t i = 0; i < samples; ++i) {
+    cpu = std::fmin(100.0, std::fmax(0.0, cpu + noise() * 3.0));
+    avail += noise() * 2000.0;
+    MetricsSnapshot s{};
+    s.ts_ms = 1700000000000ULL + static_cast<std::uint64_t>(i) * 250ULL;
+    s.cpu_usage_pct = cpu;
+    s.mem_total_kb = 8000000;
+    s.mem_available_kb = static_cast<std::uint64_t>(avail);
+    s.temperature_c = 45.0 + 5.0 * std::sin(static_cast<double>(i) / 2000.0) + noise() * 0.2;
+    s.uptime_s = 100000ULL + static_cast<std::uint64_t>(i) / 4ULL;
+    out.push_back(s);
+  }
+  return out;
+}
+
+}  // namespace telemetry::bench
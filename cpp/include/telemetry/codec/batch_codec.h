@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "telemetry/metrics_snapshot.h"
+#include "telemetry/status.h"
+
+namespace telemetry::codec {
+
+struct BatchSample final {
+  MetricsSnapshot snap{};
+  StatusCode status{StatusCode::kOk};
+};
+
+// Framed, delta-encoded batch of snapshots used by the push exporter.
+//
+// Frame:   u32 LE payload length | u32 LE CRC-32 of payload | payload
+// Payload: u8 version | varint seq | varint id_len | id bytes | varint count | samples
+// Sample:  u8 status | zigzag deltas against the previous sample (the first against zero)
+//          of ts_ms, cpu*100, mem_total_kb, mem_available_kb, temperature*100, uptime_s
+//
+// Steady signals collapse to about one byte per field. The receiver acknowledges each frame
+// with the u64 LE sequence number of the newest batch it has accepted.
+constexpr std::uint8_t kBatchCodecVersion = 1;
+constexpr std::size_t kBatchFrameHeaderSize = 8;
+constexpr std::size_t kBatchAckSize = 8;
+constexpr std::uint32_t kMaxBatchPayload = 4U * 1024U * 1024U;
+
+// Appends one frame to `out` and returns its size.
+std::size_t encode_batch(std::uint64_t seq, std::string_view agent_id, const BatchSample* samples, std::size_t count,
+                         std::vector<std::uint8_t>& out);
+
+// Inspects the start of `data`. Returns Ok with `frame_len` set when a whole frame is
+// present, Unavailable when more bytes are needed, and InvalidArgument on corruption.
+Status peek_batch_frame(const std::uint8_t* data, std::size_t len, std::size_t& frame_len);
+
+// Decodes one whole frame (as sized by peek_batch_frame). `samples` is replaced.
+Status decode_batch(const std::uint8_t* frame, std::size_t frame_len, std::uint64_t& seq, std::string_view& agent_id,
+                    std::vector<BatchSample>& samples);
+
+}  // namespace telemetry::codec
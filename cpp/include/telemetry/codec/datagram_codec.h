@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "telemetry/codec/snapshot_codec.h"
+#include "telemetry/metrics_snapshot.h"
+#include "telemetry/status.h"
+
+namespace telemetry::codec {
+
+// One snapshot per UDP datagram, as broadcast to a multicast group.
+//
+// Datagram: u32 LE magic "TLMD" | u8 version | varint seq | varint id_len | id bytes |
+//           snapshot (snapshot_codec.h)
+//
+// `seq` counts snapshots per sender from 0, so a receiver spots loss as a gap and a restarted
+// agent as a sequence number going backwards.
+constexpr std::uint32_t kDatagramMagic = 0x444D4C54;  // "TLMD"
+constexpr std::uint8_t kDatagramCodecVersion = 1;
+constexpr std::size_t kMaxDatagramHostId = 64;
+constexpr std::size_t kMaxDatagramSize = 5 + 10 + 1 + kMaxDatagramHostId + kMaxEncodedSnapshotSize;
+
+struct SnapshotDatagram final {
+  std::uint64_t seq{0};
+  std::string_view host_id;  // points into the decoded buffer
+  MetricsSnapshot snap{};
+  StatusCode status{StatusCode::kOk};
+};
+
+// Returns the number of bytes written, or 0 if `cap` is too small. Host ids longer than
+// kMaxDatagramHostId are truncated.
+std::size_t encode_datagram(std::uint64_t seq, std::string_view host_id, const MetricsSnapshot& snap,
+                            StatusCode collect_status, std::uint8_t* out, std::size_t cap);
+
+// Decodes exactly `len` bytes; InvalidArgument for anything that is not a v1 datagram.
+Status decode_datagram(const std::uint8_t* data, std::size_t len, SnapshotDatagram& out);
+
+}  // namespace telemetry::codec
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "telemetry/metrics_snapshot.h"
+#include "telemetry/status.h"
+
+namespace telemetry::codec {
+
+struct DeadbandConfig final {
+  // A field is resent only when |value - last sent| > max(abs, rel * |last sent|).
+  double abs = 0.0;
+  double rel = 0.0;
+  // Samples between full keyframes; 1 sends every sample in full.
+  std::uint32_t keyframe_every = 60;
+
+  bool operator==(const DeadbandConfig&) const = default;
+};
+
+// Deadband-filtered JSON line stream for SUBSCRIBE.
+//
+// Keyframe: {"key":true,"ts_ms":T,"status_code":S,"cpu_usage_pct":...,...all fields}
+// Delta:    {"ts_ms":T,<only the fields that moved past the deadband>}
+//
+// The reference state is what was last *sent* per field, so suppressed drift accumulates
+// until it crosses the deadband instead of being lost. status_code is sent on any change.
+// A sample where nothing moved produces no line at all.
+class DeltaStream final {
+ public:
+  explicit DeltaStream(DeadbandConfig cfg) : cfg_(cfg) {}
+
+  // Renders this sample's line into `out` (replacing it). Returns false, with `out` empty,
+  // when nothing is worth sending.
+  bool update(const MetricsSnapshot& snap, Status collect_status, std::string& out);
+
+  // Renders the reference state as a keyframe for a subscriber joining mid-stream, so it
+  // applies later deltas to exactly what the other subscribers hold. False before any sample.
+  bool keyframe(std::string& out) const;
+
+  const DeadbandConfig& config() const { return cfg_; }
+
+ private:
+  static constexpr int kFields = 6;
+
+  void render(bool key, const bool* changed, std::string& out) const;
+
+  DeadbandConfig cfg_;
+  double sent_[kFields]{};
+  bool has_state_{false};
+  std::uint32_t since_key_{0};
+  std::uint64_t ts_ms_{0};
+};
+
+}  // namespace telemetry::codec
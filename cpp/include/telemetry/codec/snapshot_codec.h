@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "telemetry/metrics_snapshot.h"
+#include "telemetry/status.h"
+
+namespace telemetry::codec {
+
+// Compact binary encoding of a MetricsSnapshot, shared by everything that stores or ships
+// snapshots in binary form.
+//
+// Layout (v1):
+//   u8      version
+//   u8      collect status code
+//   varint  ts_ms
+//   varint  cpu_usage_pct * 100 (rounded)
+//   varint  mem_total_kb
+//   varint  mem_available_kb
+//   zigzag  temperature_c * 100 (rounded)
+//   varint  uptime_s
+//
+// Fractional fields keep two decimals, matching the precision of the JSON protocol.
+constexpr std::uint8_t kSnapshotCodecVersion = 1;
+constexpr std::size_t kMaxEncodedSnapshotSize = 2 + 6 * 10;
+
+// Returns the number of bytes written, or 0 if `cap` is too small.
+std::size_t encode_snapshot(const MetricsSnapshot& snap, StatusCode collect_status, std::uint8_t* out, std::size_t cap);
+
+// Decodes exactly `len` bytes. `collect_status` may be null.
+Status decode_snapshot(const std::uint8_t* data, std::size_t len, MetricsSnapshot& out, StatusCode* collect_status);
+
+// LEB128 helpers, exposed for the other binary encoders.
+std::size_t put_varint(std::uint64_t v, std::uint8_t* out, std::size_t cap);
+bool get_varint(const std::uint8_t*& p, const std::uint8_t* end, std::uint64_t& out);
+
+inline std::uint64_t zigzag_encode(std::int64_t v) {
+  return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+inline std::int64_t zigzag_decode(std::uint64_t v) {
+  return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1U);
+}
+
+}  // namespace telemetry::codec
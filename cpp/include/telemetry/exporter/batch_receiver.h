@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "telemetry/codec/batch_codec.h"
+#include "telemetry/status.h"
+
+namespace telemetry::exporter {
+
+// Minimal stand-in for a remote collector: accepts PushExporter connections on loopback,
+// validates and decodes batch frames, acknowledges them and keeps what it received.
+// Replayed batches (seq already seen) are acknowledged but not counted twice. POSIX only.
+class BatchReceiver final {
+ public:
+  // Port 0 picks an ephemeral port; see port().
+  explicit BatchReceiver(std::uint16_t port = 0);
+  ~BatchReceiver();
+
+  BatchReceiver(const BatchReceiver&) = delete;
+  BatchReceiver& operator=(const BatchReceiver&) = delete;
+
+  Status start();
+  void stop();
+
+  std::uint16_t port() const { return port_; }
+  std::uint64_t batches() const { return batches_.load(std::memory_order_relaxed); }
+  std::uint64_t samples() const { return samples_.load(std::memory_order_relaxed); }
+  std::uint64_t bytes() const { return bytes_.load(std::memory_order_relaxed); }
+  std::uint64_t bad_frames() const { return bad_frames_.load(std::memory_order_relaxed); }
+
+  // Moves out everything received so far, in arrival order.
+  std::vector<codec::BatchSample> take_samples();
+  std::string last_agent_id() const;
+
+ private:
+  void run();
+  bool on_readable(int fd, std::vector<std::uint8_t>& buf);
+
+  std::uint16_t port_;
+  int listen_fd_{-1};
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+
+  std::uint64_t last_seq_{0};
+  std::vector<codec::BatchSample> scratch_;
+
+  mutable std::mutex mu_;
+  std::vector<codec::BatchSample> received_;
+  std::string agent_id_;
+
+  std::atomic<std::uint64_t> batches_{0};
+  std::atomic<std::uint64_t> samples_{0};
+  std::atomic<std::uint64_t> bytes_{0};
+  std::atomic<std::uint64_t> bad_frames_{0};
+};
+
+}  // namespace telemetry::exporter
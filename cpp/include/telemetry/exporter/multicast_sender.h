@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "telemetry/codec/datagram_codec.h"
+#include "telemetry/metrics/snapshot_sink.h"
+#include "telemetry/status.h"
+
+namespace telemetry::exporter {
+
+struct MulticastConfig final {
+  const char* group = nullptr;  // IPv4 multicast address, e.g. 239.255.70.1
+  std::uint16_t port = 0;
+  // Local IPv4 address of the interface to send on; nullptr lets the routing table pick.
+  const char* interface = nullptr;
+  std::uint8_t ttl = 1;  // 1 keeps datagrams on the local subnet
+  bool loopback = true;  // also deliver to receivers on this host
+  const char* host_id = "telemetryd";
+};
+
+struct MulticastStats final {
+  std::uint64_t sent{0};
+  std::uint64_t send_errors{0};  // datagrams the kernel refused (buffer full, no route)
+};
+
+// Broadcasts every snapshot as one datagram (codec/datagram_codec.h) to a multicast group,
+// so the agent's cost per sample is one sendto() however many dashboards are listening.
+// Delivery is best effort; receivers detect loss from gaps in the sequence number. Sends
+// never block: a datagram the socket cannot take right away is counted and dropped. POSIX only.
+class MulticastSender final : public metrics::SnapshotSink {
+ public:
+  explicit MulticastSender(MulticastConfig cfg);
+  ~MulticastSender() override;
+
+  MulticastSender(const MulticastSender&) = delete;
+  MulticastSender& operator=(const MulticastSender&) = delete;
+
+  Status open();
+
+  const char* name() const override { return "multicast_sender"; }
+  void on_snapshot(const MetricsSnapshot& snap, Status collect_status) override;
+
+  // Read on the sampling thread, or after the server has stopped.
+  MulticastStats stats() const { return stats_; }
+
+ private:
+  MulticastConfig cfg_;
+  int fd_{-1};
+  std::uint64_t next_seq_{0};
+  MulticastStats stats_{};
+  std::uint8_t buf_[codec::kMaxDatagramSize]{};
+};
+
+}  // namespace telemetry::exporter
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "telemetry/codec/batch_codec.h"
+#include "telemetry/metrics/snapshot_sink.h"
+#include "telemetry/status.h"
+#include "telemetry/util/backoff.h"
+#include "telemetry/util/spsc_queue.h"
+
+namespace telemetry::exporter {
+
+struct ExporterConfig final {
+  const char* host = nullptr;  // numeric IPv4
+  std::uint16_t port = 0;
+  const char* agent_id = "telemetryd";
+  // Rounded up to a power of two and to at least twice batch_max_samples.
+  std::uint32_t queue_capacity = 1024;
+  std::uint32_t batch_max_samples = 64;
+  std::uint32_t batch_max_ms = 1000;
+  // Encoded batches kept until acknowledged; the oldest are dropped beyond this.
+  std::uint32_t retry_buffer_bytes = 1024U * 1024U;
+  std::uint32_t backoff_min_ms = 250;
+  std::uint32_t backoff_max_ms = 30000;
+};
+
+struct ExporterStats final {
+  std::uint64_t enqueued{0};
+  std::uint64_t dropped_queue_full{0};
+  std::uint64_t dropped_retry_overflow{0};  // samples
+  std::uint64_t batches_sealed{0};
+  std::uint64_t batches_acked{0};
+  std::uint64_t bytes_sent{0};
+  std::uint64_t connects{0};
+};
+
+// Pushes snapshots to a remote collector in delta-encoded batches (codec/batch_codec.h).
+//
+// The sampler hands snapshots over through a lock-free SPSC queue and never blocks; the
+// queue doubles as the open batch. An exporter thread seals a batch once it holds
+// batch_max_samples or is batch_max_ms old, keeps it in a bounded retry buffer until the
+// collector acknowledges it, and resends unacknowledged batches after reconnecting.
+// POSIX only.
+class PushExporter final : public metrics::SnapshotSink {
+ public:
+  explicit PushExporter(ExporterConfig cfg);
+  ~PushExporter() override;
+
+  PushExporter(const PushExporter&) = delete;
+  PushExporter& operator=(const PushExporter&) = delete;
+
+  const char* name() const override { return "push_exporter"; }
+  void on_snapshot(const MetricsSnapshot& snap, Status collect_status) override;
+
+  Status start();
+  // Seals the open batch and, if connected, writes what the socket takes without blocking,
+  // then returns. Best effort: nothing waits for a connect or an ack, and batches not
+  // written or not yet acknowledged are dropped.
+  void stop();
+
+  ExporterStats stats() const;
+
+ private:
+  void run();
+  void wake();
+  void seal_batch(std::size_t max_samples);
+  void enforce_retry_budget();
+  void start_connect(std::uint64_t now_ms);
+  void disconnect(std::uint64_t now_ms);
+  bool send_pending();
+  bool read_acks();
+
+  struct FrameInfo final {
+    std::uint64_t seq{0};
+    std::uint32_t bytes{0};
+    std::uint32_t samples{0};
+  };
+
+  ExporterConfig cfg_;
+  util::SpscQueue<codec::BatchSample> queue_;
+  int wake_fds_[2]{-1, -1};
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+
+  // Producer-side counters.
+  std::atomic<std::uint64_t> enqueued_{0};
+  std::atomic<std::uint64_t> dropped_queue_full_{0};
+
+  // Exporter-thread state.
+  std::vector<codec::BatchSample> batch_;
+  std::vector<std::uint8_t> retry_;  // encoded, unacknowledged frames in seq order
+  std::vector<FrameInfo> frames_;
+  std::size_t send_off_{0};          // bytes of retry_ written on the current connection
+  std::uint64_t next_seq_{1};
+  std::uint64_t batch_open_ms_{0};
+  int fd_{-1};
+  bool connecting_{false};
+  std::uint64_t retry_at_ms_{0};
+  std::uint32_t attempt_{0};
+  util::JitteredBackoff backoff_;
+  std::uint8_t ack_buf_[codec::kBatchAckSize]{};
+  std::size_t ack_len_{0};
+
+  std::atomic<std::uint64_t> dropped_retry_overflow_{0};
+  std::atomic<std::uint64_t> batches_sealed_{0};
+  std::atomic<std::uint64_t> batches_acked_{0};
+  std::atomic<std::uint64_t> bytes_sent_{0};
+  std::atomic<std::uint64_t> connects_{0};
+};
+
+}  // namespace telemetry::exporter
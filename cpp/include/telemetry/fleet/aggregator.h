@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "telemetry/fleet/fleet_table.h"
+#include "telemetry/status.h"
+#include "telemetry/util/backoff.h"
+
+namespace telemetry::fleet {
+
+struct AggregatorConfig final {
+  // All peers are polled together once per interval.
+  std::uint32_t interval_ms = 1000;
+  // GETs sent before earlier replies arrive; a peer this far behind is not sent more.
+  std::uint32_t pipeline_depth = 2;
+  // A connected peer with an outstanding GET and no reply for this long is reconnected.
+  std::uint32_t reply_timeout_ms = 5000;
+  // Reconnect delay bounds for util::JitteredBackoff.
+  std::uint32_t backoff_min_ms = 250;
+  std::uint32_t backoff_max_ms = 30000;
+};
+
+// Fans out to many downstream telemetryd agents over persistent non-blocking connections,
+// polling each with pipelined GETs and merging replies into a FleetTable. Runs on its own
+// thread between start() and stop(). POSIX only.
+class FleetAggregator final {
+ public:
+  FleetAggregator(FleetTable& table, AggregatorConfig cfg);
+  ~FleetAggregator();
+
+  FleetAggregator(const FleetAggregator&) = delete;
+  FleetAggregator& operator=(const FleetAggregator&) = delete;
+
+  // `host` must be a numeric IPv4 address. `name` defaults to "host:port".
+  Status add_target(const char* host, std::uint16_t port, std::string_view name = {});
+
+  // One target per line: `<ipv4>:<port> [name]`. Blank lines and `#` comments are skipped.
+  // Names (default `<ipv4>:<port>`) must be unique.
+  Status load_targets_file(const char* path);
+
+  std::size_t target_count() const;
+
+  Status start();
+  void stop();
+
+ private:
+  struct Peer;
+
+  void run();
+  void start_connect(Peer& p, std::uint64_t now_ms);
+  void on_connected(Peer& p, std::uint64_t now_ms);
+  void fail(Peer& p, std::uint64_t now_ms);
+  bool read_replies(Peer& p, std::uint64_t now_ms);
+
+  FleetTable& table_;
+  AggregatorConfig cfg_;
+  std::vector<Peer> peers_;
+  util::JitteredBackoff backoff_;
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+};
+
+}  // namespace telemetry::fleet
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "telemetry/metrics_snapshot.h"
+#include "telemetry/status.h"
+
+namespace telemetry::fleet {
+
+constexpr std::size_t kMaxHostName = 64;
+
+struct FleetHost final {
+  char name[kMaxHostName]{};
+  bool up{false};
+  bool has_snapshot{false};
+  StatusCode status_code{StatusCode::kOk};
+  std::uint64_t last_update_ms{0};
+  std::uint64_t updates{0};
+  std::uint32_t reconnects{0};
+  MetricsSnapshot snap{};
+};
+
+// In-memory table of the latest snapshot per downstream agent.
+//
+// Hosts are registered once at startup and addressed by a dense id afterwards, so updates
+// are an index plus a copy. Queries are served from a CPU-ordered index of live hosts
+// that is rebuilt lazily, at most once per batch of updates. Thread-safe: the aggregator
+// thread writes while the server thread queries.
+class FleetTable final {
+ public:
+  FleetTable() = default;
+
+  // Returns the host id; registering an existing name returns its id.
+  std::size_t add_host(std::string_view name);
+
+  void update(std::size_t id, const MetricsSnapshot& snap, StatusCode status_code, std::uint64_t now_ms);
+  void set_up(std::size_t id, bool up);
+
+  std::size_t size() const;
+  std::size_t up_count() const;
+  bool find(std::string_view name, FleetHost& out) const;
+
+  // Each query replaces `out`. all() keeps registration order; top_cpu() and over_cpu()
+  // return live hosts by descending CPU usage.
+  void all(std::vector<FleetHost>& out) const;
+  void top_cpu(std::size_t n, std::vector<FleetHost>& out) const;
+  void over_cpu(double pct, std::vector<FleetHost>& out) const;
+
+ private:
+  void rebuild_cpu_index_locked() const;
+
+  mutable std::mutex mu_;
+  std::vector<FleetHost> hosts_;
+  std::unordered_map<std::string, std::size_t> by_name_;
+  std::size_t up_count_{0};
+
+  mutable std::vector<std::uint32_t> by_cpu_;
+  mutable bool cpu_index_dirty_{true};
+};
+
+}  // namespace telemetry::fleet
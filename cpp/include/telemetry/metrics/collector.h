@@ -1,20 +1,27 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include "telemetry/metrics/metric_source.h"
+#include "telemetry/metrics/snapshot_collector.h"
 #include "telemetry/metrics_snapshot.h"
 #include "telemetry/status.h"
 
 namespace telemetry::metrics {
 
-class Collector final {
+// Sources added at run time, each called through MetricSource.
+class Collector final : public SnapshotCollector {
  public:
   Collector() = default;
 
   void add_source(std::unique_ptr<MetricSource> src);
-  Status collect(MetricsSnapshot& out);
+  Status collect(MetricsSnapshot& out) override;
+  std::size_t append_detail_json(std::string& out, std::string_view only = {}) const override;
+  void append_openmetrics(std::string& out) const override;
 
  private:
   std::vector<std::unique_ptr<MetricSource>> sources_;
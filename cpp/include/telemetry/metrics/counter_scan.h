@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Blank-separated counter rows as in /proc/interrupts and /proc/softirqs (Linux only).
+
+namespace telemetry::metrics {
+
+// Parses up to `max` blank-separated unsigned decimals starting at `p` into `out`. Scanning
+// stops after the `max`th number, or at the first byte that is neither a digit nor a blank
+// (the row's trailing description, '\n' or the terminating NUL); `p` is left there. Returns
+// the count parsed. The byte-at-a-time reference implementation; scan_counters() must agree
+// with it on every input.
+inline std::size_t scan_counters_scalar(const char*& p, std::uint64_t* out, std::size_t max) {
+  std::size_t n = 0;
+  while (n < max) {
+    while (*p == ' ' || *p == '\t') ++p;
+    if (*p < '0' || *p > '9') break;
+    std::uint64_t v = 0;
+    while (*p >= '0' && *p <= '9') v = v * 10 + static_cast<std::uint64_t>(*p++ - '0');
+    out[n++] = v;
+  }
+  return n;
+}
+
+#if defined(__SSE2__)
+namespace detail {
+
+// The value of the `len` (1-8) ASCII digits at `p`, eight bytes at a time: the digits are
+// moved to the top of a little-endian word (zeros shifted in act as leading '0's), then
+// pairs, quads and octets are combined with one multiply each.
+inline std::uint64_t parse_digits8(const char* p, unsigned len) {
+  std::uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  v <<= 8 * (8 - len);
+  v = ((v & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+  v = ((v & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+  return ((v & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+}
+
+// The value of a run of `len` (1-16) digits at `p`. Most cells of a many-CPU host are "0"
+// (an MSI vector fires on the one CPU it is pinned to), so that case skips the multiplies.
+inline std::uint64_t parse_digits16(const char* p, unsigned len) {
+  if (len == 1) return static_cast<std::uint64_t>(*p - '0');
+  if (len <= 8) return parse_digits8(p, len);
+  return parse_digits8(p, len - 8) * 100000000ULL + parse_digits8(p + len - 8, 8);
+}
+
+inline constexpr std::uint64_t kPow10[17] = {1ULL,
+                                             10ULL,
+                                             100ULL,
+                                             1000ULL,
+                                             10000ULL,
+                                             100000ULL,
+                                             1000000ULL,
+                                             10000000ULL,
+                                             100000000ULL,
+                                             1000000000ULL,
+                                             10000000000ULL,
+                                             100000000000ULL,
+                                             1000000000000ULL,
+                                             10000000000000ULL,
+                                             100000000000000ULL,
+                                             1000000000000000ULL,
+                                             10000000000000000ULL};
+
+}  // namespace detail
+
+// Same contract, classifying 16 bytes per step: one compare each for digits and blanks gives
+// a bitmask per block, and runs of digit bits are the numbers, converted eight digits per
+// step. A /proc/interrupts row on a
+// 256-CPU host is 2-3 KiB of mostly padding, which the masks skip without a branch per
+// byte. `p` must be readable up to 15 bytes past the first stop byte (the NUL of a
+// ProcFile buffer with that much slack).
+inline std::size_t scan_counters(const char*& p, std::uint64_t* out, std::size_t max) {
+  const __m128i zero = _mm_set1_epi8('0');
+  const __m128i nine = _mm_set1_epi8(9);
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  std::size_t n = 0;
+  std::uint64_t v = 0;
+  bool carry = false;  // `v` holds digits that ran up to the end of the previous block
+  if (max == 0) return 0;
+  for (;;) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    // c - '0' <= 9 as unsigned bytes: min(x, 9) == x.
+    const __m128i offset = _mm_sub_epi8(bytes, zero);
+    const unsigned digits =
+        static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(offset, nine), offset)));
+    const unsigned blanks = static_cast<unsigned>(
+        _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, space), _mm_cmpeq_epi8(bytes, tab))));
+    const unsigned stops = ~(digits | blanks) & 0xFFFFu;
+    const unsigned limit = stops ? static_cast<unsigned>(__builtin_ctz(stops)) : 16u;
+    unsigned runs = digits & ((1u << limit) - 1u);
+
+    if (carry && (runs & 1u) == 0) {
+      carry = false;
+      out[n++] = v;
+      if (n == max) return n;
+    }
+    while (runs != 0) {
+      const unsigned start = static_cast<unsigned>(__builtin_ctz(runs));
+      const unsigned len = static_cast<unsigned>(__builtin_ctz(~(runs >> start)));
+      // A number longer than one block continues `v`; wrapping matches the scalar loop.
+      v = (carry ? v * detail::kPow10[len] : 0) + detail::parse_digits16(p + start, len);
+      carry = false;
+      const unsigned end = start + len;
+      if (end == 16) {
+        carry = true;
+        break;
+      }
+      runs &= ~0u << end;
+      out[n++] = v;
+      if (n == max) {
+        p += end;
+        return n;
+      }
+    }
+    if (limit < 16) {
+      p += limit;
+      return n;
+    }
+    p += 16;
+  }
+}
+#else
+inline std::size_t scan_counters(const char*& p, std::uint64_t* out, std::size_t max) {
+  return scan_counters_scalar(p, out, max);
+}
+#endif
+
+}  // namespace telemetry::metrics
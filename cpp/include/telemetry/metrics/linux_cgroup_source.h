@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "telemetry/metrics/metric_source.h"
+#include "telemetry/metrics/proc_file.h"
+
+// cgroup v2 resource accounting (Linux only).
+
+namespace telemetry::metrics {
+
+struct CgroupConfig final {
+  // Prepended to every path, as for add_linux_sources ("" = the live system).
+  const char* root = "";
+  // cgroup to report, relative to the cgroup2 mount as in /proc/self/cgroup (e.g.
+  // "/system.slice"); nullptr = the agent's own.
+  const char* path = nullptr;
+  // Also report each direct child cgroup: per-container breakdowns when run on the host.
+  bool children = false;
+};
+
+struct CgroupStats final {
+  // Path below the cgroup2 mount, sanitized for JSON and OpenMetrics labels.
+  char name[128]{};
+  // CPU used over the last interval as a share of cpu_limit_cores.
+  double cpu_pct{0.0};
+  // cpu.max quota / period, or the CPUs the group may run on when it has no quota.
+  double cpu_limit_cores{0.0};
+  // Share of quota enforcement periods in which the group was throttled.
+  double cpu_throttled_pct{0.0};
+  std::uint64_t memory_current_bytes{0};
+  std::uint64_t memory_max_bytes{0};  // 0 = unlimited
+  // memory.current less reclaimable inactive file cache (the agent's own group only; children
+  // report memory.current).
+  std::uint64_t memory_working_set_bytes{0};
+  // Summed over devices in io.stat; the agent's own group only.
+  double io_read_bytes_per_s{0.0};
+  double io_write_bytes_per_s{0.0};
+  double io_reads_per_s{0.0};
+  double io_writes_per_s{0.0};
+};
+
+// CPU, memory and I/O of one cgroup v2 group. Inside a container /proc/stat and /proc/meminfo
+// describe the host, so when registered after the /proc sources this overrides the snapshot:
+// cpu_usage_pct becomes usage relative to the group's CPU limit, and with a memory.max the
+// memory fields describe that limit and the group's working set. The control files are
+// opened once and re-read in place; child groups, when enabled, are listed with getdents64
+// into fixed slots, so sampling does not allocate.
+class CgroupSource final : public MetricSource {
+ public:
+  static constexpr std::size_t kMaxChildren = 64;
+
+  explicit CgroupSource(const CgroupConfig& cfg);
+  ~CgroupSource() override;
+  CgroupSource(const CgroupSource&) = delete;
+  CgroupSource& operator=(const CgroupSource&) = delete;
+
+  const char* name() const override { return "linux_cgroup"; }
+  Status collect(MetricsSnapshot& out) override;
+  bool append_detail_json(std::string& out) const override;
+  void append_openmetrics(std::string& out) const override;
+
+  // collect() at an explicit monotonic time.
+  Status sample(MetricsSnapshot& out, std::uint64_t now_ns);
+
+  // Directory of the group, including the root prefix; empty if none was found.
+  const std::string& dir() const { return dir_; }
+  const CgroupStats& stats() const { return self_.stats; }
+  // Children in the last sample, with rates over the interval before it.
+  const std::vector<CgroupStats>& children() const { return child_stats_; }
+  std::size_t untracked_children() const { return untracked_children_; }
+
+ private:
+  struct Group final {
+    CgroupStats stats;
+    ProcFile cpu_stat;
+    ProcFile cpu_max;
+    ProcFile memory_current;
+    ProcFile memory_max;
+    char dir_name[128]{};  // unsanitized, for children
+    bool used{false};
+    bool seen{false};
+    bool primed{false};
+    // usage_usec, nr_periods, nr_throttled
+    std::array<std::uint64_t, 3> prev{};
+  };
+
+  void open_group(Group& g, const char* dir);
+  bool sample_group(Group& g, double seconds, double cpus);
+  void sample_children(double seconds, double cpus);
+  double online_cpus();
+
+  CgroupConfig cfg_;
+  std::string dir_;
+  const char* setup_error_{nullptr};
+  Group self_;
+  ProcFile memory_stat_;
+  ProcFile io_stat_;
+  ProcFile cpuset_;
+  // rbytes, wbytes, rios, wios
+  std::array<std::uint64_t, 4> prev_io_{};
+  bool io_primed_{false};
+  std::uint64_t prev_ns_{0};
+
+  int dir_fd_{-1};
+  std::vector<Group> children_;
+  std::vector<CgroupStats> child_stats_;
+  std::size_t untracked_children_{0};
+  std::vector<char> text_;
+};
+
+}  // namespace telemetry::metrics
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "telemetry/metrics/metric_source.h"
+#include "telemetry/metrics/proc_file.h"
+
+// Metrics declared in a config file instead of code (Linux only).
+
+namespace telemetry::metrics {
+
+// Extra /proc and /sys metrics from a config file, one per line:
+//
+//   <name> <path> value                                [scale <k>] [rate]
+//   <name> <path> key <key> [<n>]                      [scale <k>] [rate]
+//   <name> <path> column <n> row <key> [keycol <k>]    [scale <k>] [rate]
+//
+// `value` is the file's first field (/proc/sys/fs/file-nr, sysfs attributes). `key` is the
+// n-th field (default 1) after the line whose first field is <key> (/proc/meminfo "Dirty",
+// /proc/vmstat "pgfault"). `column` is field <n> of the line whose field <k> (default 1) is
+// <key>, for tables such as /proc/net/dev or /proc/diskstats. Fields are 1-based and split on
+// blanks and ':'. Values are multiplied by `scale`; `rate` turns a counter into a per-second
+// rate. Exported as the OpenMetrics gauge telemetry_<name> and in DETAIL.
+//
+// Metrics are compiled at load time into a table grouped by file: each file is opened once
+// and read and parsed once per sample however many metrics reference it, and keyed lines
+// are matched with a binary search over the file's sorted keys.
+class DeclaredSource final : public MetricSource {
+ public:
+  static constexpr std::size_t kMaxMetrics = 4096;
+  static constexpr std::size_t kMaxFields = 64;
+
+  // `root` is prepended to every declared path, as for add_linux_sources.
+  explicit DeclaredSource(const char* root = "");
+
+  const char* name() const override { return "declared"; }
+  Status collect(MetricsSnapshot& out) override;
+  bool append_detail_json(std::string& out) const override;
+  void append_openmetrics(std::string& out) const override;
+
+  // Compiles and appends one declaration.
+  Status add_metric(std::string_view text);
+
+  // Blank lines and `#` comments are skipped; a line over 510 characters is an error. On an
+  // error, `error_line` (if given) receives the 1-based line number.
+  Status load_file(const char* path, std::size_t* error_line = nullptr);
+
+  // collect() at an explicit monotonic time.
+  Status sample(std::uint64_t now_ns);
+
+  std::size_t size() const { return metrics_.size(); }
+  // Distinct files behind the declared metrics: the reads one sample costs.
+  std::size_t files() const { return files_.size(); }
+  // The metric's last value; false until it has one (rates need two samples, and a key or
+  // row missing from the file leaves it without one).
+  bool value(std::size_t metric, double& out) const;
+
+ private:
+  enum class Mode : std::uint8_t { kValue, kKey, kColumn };
+
+  struct Metric final {
+    char name[64]{};
+    char key[64]{};
+    std::uint32_t file{0};
+    Mode mode{Mode::kValue};
+    std::uint8_t keycol{1};
+    std::uint8_t col{1};
+    bool rate{false};
+    double scale{1.0};
+    // Per sample: whether the field was found, its raw value, and for rates the previous one.
+    bool found{false};
+    bool primed{false};
+    bool valid{false};
+    std::uint64_t prev{0};
+    double value{0.0};
+  };
+
+  struct File final {
+    ProcFile file;
+    std::string path;
+    std::vector<char> text;
+    // Metrics reading the file's first field.
+    std::vector<std::uint32_t> whole;
+    // Keyed metrics sorted by (keycol, key), and the distinct key columns in use.
+    std::vector<std::uint32_t> keyed;
+    std::vector<std::uint8_t> keycols;
+  };
+
+  void parse_file(File& f);
+  void store(Metric& m, const char* field);
+
+  std::string root_;
+  std::vector<Metric> metrics_;
+  std::vector<std::unique_ptr<File>> files_;
+  std::uint64_t prev_ns_{0};
+  double seconds_{0.0};
+};
+
+}  // namespace telemetry::metrics
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "telemetry/metrics/metric_source.h"
+#include "telemetry/metrics/proc_file.h"
+#include "telemetry/metrics/sample_trigger.h"
+
+// Filesystem capacity per mount (Linux only).
+
+namespace telemetry::metrics {
+
+struct FilesystemStats final {
+  // Mount point, filesystem type and mount source, sanitized for JSON and OpenMetrics labels.
+  char mount[128]{};
+  char fstype[32]{};
+  char device[96]{};
+  // False if statvfs() failed on the last sample.
+  bool ok{false};
+  std::uint64_t size_bytes{0};
+  std::uint64_t used_bytes{0};
+  // Free space available to unprivileged users (excludes the root reserve).
+  std::uint64_t avail_bytes{0};
+  // Used share of the space available to users, as df reports it.
+  double used_pct{0.0};
+  std::uint64_t inodes{0};
+  std::uint64_t inodes_free{0};
+};
+
+// Size, used and available bytes and inodes of every real filesystem, from statvfs() on the
+// mount points listed in /proc/self/mountinfo. Pseudo filesystems (proc, sysfs, cgroup,
+// devpts, ...), container overlay mounts other than "/", read-only images (squashfs,
+// iso9660) and network, cluster and FUSE filesystems (or any mount whose source names a
+// server), whose statvfs() can block the event loop on an unreachable server, are skipped,
+// as are further mounts of a device already listed (bind mounts). A mount stacked on an
+// earlier one at the same path replaces it.
+//
+// The mount table is parsed once and then only when it changes: the kernel raises POLLPRI
+// on an open mountinfo descriptor after every mount or unmount in the namespace, and
+// mount_watch() is a SampleTrigger polling for it next to the server's sockets. Container
+// hosts list thousands of mounts; a sample costs one statvfs() per kept mount, not a parse.
+class FilesystemSource final : public MetricSource {
+ public:
+  static constexpr std::size_t kMaxMounts = 1024;
+
+  // `root` is prepended to /proc/self/mountinfo and to each mount point, as for
+  // add_linux_sources.
+  explicit FilesystemSource(const char* root = "");
+
+  const char* name() const override { return "linux_filesystems"; }
+  Status collect(MetricsSnapshot& out) override;
+  bool append_detail_json(std::string& out) const override;
+  void append_openmetrics(std::string& out) const override;
+
+  // collect() at an explicit monotonic time.
+  Status sample(std::uint64_t now_ns);
+
+  // Re-reads the mount table on the next sample.
+  void mounts_changed() { reparse_ = true; }
+  // Register with TcpServer::add_trigger(); on_ready() calls mounts_changed() and does not
+  // ask for a sample of its own.
+  SampleTrigger& mount_watch() { return watch_; }
+
+  const std::vector<FilesystemStats>& filesystems() const { return stats_; }
+  // Mount table parses so far; stays at 1 while no mount changes.
+  std::uint64_t mount_table_parses() const { return parses_; }
+
+ private:
+  class MountWatch final : public SampleTrigger {
+   public:
+    explicit MountWatch(FilesystemSource& src) : src_(src) {}
+    const char* name() const override { return "mountinfo"; }
+    int fd() const override { return src_.mountinfo_.fd(); }
+    short events() const override;
+    bool on_ready(short revents) override;
+
+   private:
+    FilesystemSource& src_;
+  };
+
+  bool parse_mounts();
+
+  std::string root_;
+  ProcFile mountinfo_;
+  std::vector<char> text_;
+  // statvfs() paths, root-prefixed, parallel to stats_.
+  std::vector<std::string> paths_;
+  std::vector<FilesystemStats> stats_;
+  MountWatch watch_{*this};
+  bool reparse_{true};
+  bool available_{false};
+  std::uint64_t parses_{0};
+};
+
+}  // namespace telemetry::metrics
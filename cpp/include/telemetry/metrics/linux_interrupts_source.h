@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "telemetry/metrics/metric_source.h"
+#include "telemetry/metrics/proc_file.h"
+
+// Hardware and software interrupt rates (Linux only).
+
+namespace telemetry::metrics {
+
+struct IrqStats final {
+  // The row label ("24", "NMI", "LOC") and its description ("PCI-MSIX-0000:00:05.0 2-edge
+  // virtio4-tx"), sanitized for JSON and OpenMetrics labels.
+  char irq[16]{};
+  char desc[64]{};
+  double per_s{0.0};
+  // The CPU taking most of this IRQ over the interval, and its share: near 100 for an IRQ
+  // pinned to one CPU, which is what an imbalance looks like.
+  std::int32_t top_cpu{-1};
+  double top_cpu_pct{0.0};
+};
+
+struct CpuIrqStats final {
+  std::int32_t cpu{0};
+  double irq_per_s{0.0};
+  double softirq_per_s{0.0};
+  double net_rx_per_s{0.0};
+};
+
+struct InterruptsConfig final {
+  // Prepended to /proc, as for add_linux_sources ("" = the live system).
+  const char* root = "";
+  // Hottest IRQs kept per sample.
+  std::size_t top_k = 10;
+};
+
+// /proc/interrupts and /proc/softirqs. Both are IRQ x CPU matrices that grow to hundreds of
+// KiB on many-core hosts, so rows are parsed with scan_counters() into counter arrays sized
+// at construction from the CPU columns and rows present then; rows that appear later reuse
+// the slots of rows that went away, and the buffers only grow if the files do. The kernel
+// prints every per-CPU counter in a fixed-width cell and most cells do not move between
+// samples, so a row found at the same offset as last time is compared with the previous
+// text 16 bytes at a time and only the cells that differ are parsed again. Reports the
+// top_k IRQs by rate, per-CPU hard and soft interrupt rates, and per-softirq-type rates.
+class InterruptsSource final : public MetricSource {
+ public:
+  static constexpr std::size_t kMaxCpus = 4096;
+  static constexpr std::size_t kMaxTopK = 64;
+
+  explicit InterruptsSource(const InterruptsConfig& cfg = {});
+
+  const char* name() const override { return "linux_interrupts"; }
+  Status collect(MetricsSnapshot& out) override;
+  bool append_detail_json(std::string& out) const override;
+  void append_openmetrics(std::string& out) const override;
+
+  // collect() at an explicit monotonic time.
+  Status sample(std::uint64_t now_ns);
+
+  // Busiest first, rates over the last interval.
+  const std::vector<IrqStats>& top() const { return top_; }
+  const std::vector<CpuIrqStats>& cpus() const { return cpu_stats_; }
+  // Per softirq type ("NET_RX", "TIMER", ...), in file order.
+  const std::vector<IrqStats>& softirqs() const { return softirq_stats_; }
+  // Interrupts per second over all IRQs and CPUs.
+  double irq_per_s() const { return irq_per_s_; }
+  // Rows dropped because every slot was taken.
+  std::size_t untracked() const { return interrupts_.untracked; }
+
+ private:
+  // One parsed matrix: slots of previous counters keyed by row label.
+  struct Matrix final {
+    ProcFile file;
+    std::vector<char> text;
+    // The previous sample's text, its length, and where each row was in it.
+    std::vector<char> prev_text;
+    std::size_t prev_len{0};
+    std::vector<std::uint32_t> row_off;
+    std::vector<std::uint32_t> row_len;
+    // Bytes per counter cell of a fixed-width per-CPU row; 0 if the row must be scanned.
+    std::vector<std::uint8_t> cell_width;
+    std::vector<std::uint32_t> changed;  // columns that differ in one row
+    // CPU number of each column, from the header line.
+    std::vector<std::int32_t> columns;
+    std::vector<IrqStats> rows;
+    std::vector<std::uint8_t> used;
+    std::vector<std::uint8_t> seen;
+    std::vector<std::uint8_t> primed;
+    std::vector<std::uint64_t> prev;  // rows x columns
+    std::vector<std::uint64_t> cur;   // one row
+    std::vector<std::uint64_t> cpu_delta;
+    std::size_t hint{0};
+    std::size_t untracked{0};
+  };
+
+  void init_matrix(Matrix& m, const char* path);
+  // Parses `m`; calls on_row(slot, total_delta, top_column, top_delta) for each primed row and
+  // leaves per-column sums of the deltas in m.cpu_delta. False if the file could not be read.
+  template <class F>
+  bool parse_matrix(Matrix& m, F on_row);
+  std::size_t find_slot(Matrix& m, const char* label, std::size_t len);
+
+  InterruptsConfig cfg_;
+  Matrix interrupts_;
+  Matrix softirqs_;
+  std::vector<IrqStats> heap_;
+  std::vector<IrqStats> top_;
+  std::vector<CpuIrqStats> cpu_stats_;
+  std::vector<IrqStats> softirq_stats_;
+  double irq_per_s_{0.0};
+  std::uint64_t prev_ns_{0};
+  bool available_{false};
+};
+
+}  // namespace telemetry::metrics
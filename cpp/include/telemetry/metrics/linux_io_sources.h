@@ -0,0 +1,161 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "telemetry/metrics/metric_source.h"
+#include "telemetry/metrics/proc_file.h"
+
+// Per-device I/O rate sources (Linux only).
+
+namespace telemetry::metrics {
+
+struct DiskDeviceStats final {
+  char name[32]{};
+  double read_bytes_per_s{0.0};
+  double write_bytes_per_s{0.0};
+  double reads_per_s{0.0};
+  double writes_per_s{0.0};
+  // Share of the interval with at least one request in flight (iostat's %util).
+  double util_pct{0.0};
+};
+
+struct NetDeviceStats final {
+  char name[32]{};
+  double rx_bytes_per_s{0.0};
+  double tx_bytes_per_s{0.0};
+  double rx_packets_per_s{0.0};
+  double tx_packets_per_s{0.0};
+  double rx_drops_per_s{0.0};
+  double tx_drops_per_s{0.0};
+};
+
+// Name -> slot index for the devices listed in a /proc table, with the previous raw counters
+// of each. Slots live in one array sized at construction; a device that disappears frees its
+// slot for the next one to be hot-plugged, and devices beyond the capacity are counted in
+// untracked() instead of allocating.
+template <std::size_t kCounters>
+class DeviceIndex final {
+ public:
+  struct Slot final {
+    char name[32]{};
+    bool used{false};
+    bool seen{false};    // listed in the current sample
+    bool hidden{false};  // recognised but not reported (partitions, loop devices)
+    bool primed{false};  // `prev` holds the previous sample
+    std::array<std::uint64_t, kCounters> prev{};
+  };
+
+  explicit DeviceIndex(std::size_t capacity) : slots_(capacity) {}
+
+  void begin_sample() {
+    for (Slot& s : slots_) s.seen = false;
+    untracked_ = 0;
+  }
+
+  // Slot for `name` (already sanitized); claims a free one for a new device. Lines come in
+  // the same order every sample, so the slot after the previous hit is tried first.
+  Slot* lookup(std::string_view name) {
+    if (hint_ < slots_.size() && slots_[hint_].used && name == slots_[hint_].name) return hit(hint_);
+    Slot* free_slot = nullptr;
+    for (std::size_t i = 0; i < slots_.size(); ++i) {
+      if (slots_[i].used) {
+        if (name == slots_[i].name) return hit(i);
+      } else if (!free_slot) {
+        free_slot = &slots_[i];
+      }
+    }
+    if (!free_slot) {
+      ++untracked_;
+      return nullptr;
+    }
+    *free_slot = Slot{};
+    free_slot->used = true;
+    name.copy(free_slot->name, sizeof(free_slot->name) - 1);
+    hint_ = static_cast<std::size_t>(free_slot - slots_.data()) + 1;
+    free_slot->seen = true;
+    return free_slot;
+  }
+
+  // Frees the slots of devices missing from this sample.
+  void end_sample() {
+    for (Slot& s : slots_) {
+      if (s.used && !s.seen) s.used = false;
+    }
+  }
+
+  std::size_t untracked() const { return untracked_; }
+
+ private:
+  Slot* hit(std::size_t i) {
+    hint_ = i + 1;
+    slots_[i].seen = true;
+    return &slots_[i];
+  }
+
+  std::vector<Slot> slots_;
+  std::size_t hint_{0};
+  std::size_t untracked_{0};
+};
+
+// Per-disk throughput, IOPS and utilization from /proc/diskstats. Whole disks only:
+// partitions and loop/ram devices are skipped.
+class DiskStatsSource final : public MetricSource {
+ public:
+  static constexpr std::size_t kMaxDevices = 256;
+
+  explicit DiskStatsSource(const char* root = "");
+
+  const char* name() const override { return "linux_diskstats"; }
+  Status collect(MetricsSnapshot& out) override;
+  bool append_detail_json(std::string& out) const override;
+  void append_openmetrics(std::string& out) const override;
+
+  // collect() at an explicit monotonic time.
+  Status sample(std::uint64_t now_ns);
+
+  // Devices in the last sample, with rates over the interval before it (0 on a device's
+  // first sample).
+  const std::vector<DiskDeviceStats>& devices() const { return devices_; }
+  std::size_t untracked() const { return index_.untracked(); }
+
+ private:
+  // reads, sectors read, writes, sectors written, ms doing I/O
+  DeviceIndex<5> index_{kMaxDevices};
+  ProcFile file_;
+  std::vector<char> text_;
+  std::vector<DiskDeviceStats> devices_;
+  std::uint64_t prev_ns_{0};
+};
+
+// Per-interface throughput, packet and drop rates from /proc/net/dev.
+class NetDevSource final : public MetricSource {
+ public:
+  static constexpr std::size_t kMaxDevices = 256;
+
+  explicit NetDevSource(const char* root = "");
+
+  const char* name() const override { return "linux_net_dev"; }
+  Status collect(MetricsSnapshot& out) override;
+  bool append_detail_json(std::string& out) const override;
+  void append_openmetrics(std::string& out) const override;
+
+  Status sample(std::uint64_t now_ns);
+
+  const std::vector<NetDeviceStats>& devices() const { return devices_; }
+  std::size_t untracked() const { return index_.untracked(); }
+
+ private:
+  // rx bytes, rx packets, rx drops, tx bytes, tx packets, tx drops
+  DeviceIndex<6> index_{kMaxDevices};
+  ProcFile file_;
+  std::vector<char> text_;
+  std::vector<NetDeviceStats> devices_;
+  std::uint64_t prev_ns_{0};
+};
+
+}  // namespace telemetry::metrics
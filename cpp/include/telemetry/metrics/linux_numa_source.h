@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "telemetry/metrics/metric_source.h"
+#include "telemetry/metrics/proc_file.h"
+
+// Per-NUMA-node memory and CPU (Linux only).
+
+namespace telemetry::metrics {
+
+struct NumaNodeStats final {
+  std::int32_t node{0};
+  // CPUs of the node that /proc/stat lists, and their busy share over the last interval.
+  std::uint32_t cpus{0};
+  double cpu_pct{0.0};
+  std::uint64_t mem_total_kb{0};
+  std::uint64_t mem_free_kb{0};
+  // Page cache (FilePages) and anonymous memory (AnonPages) resident on the node.
+  std::uint64_t file_pages_kb{0};
+  std::uint64_t anon_pages_kb{0};
+  // From numastat, in pages/s: allocations satisfied on the intended node (hit), placed here
+  // although another node was intended (miss), intended here but placed elsewhere (foreign),
+  // and made by a process running on this node (local) or on another one (remote).
+  bool has_numastat{false};
+  double numa_hit_per_s{0.0};
+  double numa_miss_per_s{0.0};
+  double numa_foreign_per_s{0.0};
+  double local_node_per_s{0.0};
+  double other_node_per_s{0.0};
+};
+
+// Memory and allocation locality per node from /sys/devices/system/node/node<N>/{meminfo,
+// numastat}, and per-CPU busy time from /proc/stat grouped by node via each node's cpulist.
+// The topology is read once at construction and every file stays open; hosts without
+// /sys/devices/system/node report a single node 0 holding every CPU, with its memory from
+// /proc/meminfo. A busy host can run short on one node while MemAvailable looks healthy.
+class NumaSource final : public MetricSource {
+ public:
+  static constexpr std::size_t kMaxNodes = 64;
+  static constexpr std::size_t kMaxCpus = 4096;
+
+  explicit NumaSource(const char* root = "");
+
+  const char* name() const override { return "linux_numa"; }
+  Status collect(MetricsSnapshot& out) override;
+  bool append_detail_json(std::string& out) const override;
+  void append_openmetrics(std::string& out) const override;
+
+  // collect() at an explicit monotonic time.
+  Status sample(std::uint64_t now_ns);
+
+  // False when the host has no NUMA topology in sysfs and one node 0 stands in for it.
+  bool numa() const { return numa_; }
+  const std::vector<NumaNodeStats>& nodes() const { return stats_; }
+  // Node of `cpu` (-1 = not in any node's cpulist), and its busy share over the last interval.
+  int cpu_node(std::size_t cpu) const {
+    return cpu < cpu_node_.size() && cpu_node_[cpu] >= 0 ? stats_[static_cast<std::size_t>(cpu_node_[cpu])].node : -1;
+  }
+  double cpu_pct(std::size_t cpu) const { return cpu < cpus_.size() ? cpus_[cpu].pct : 0.0; }
+
+ private:
+  struct Node final {
+    ProcFile meminfo;
+    ProcFile numastat;
+    bool primed{false};
+    // numa_hit, numa_miss, numa_foreign, local_node, other_node
+    std::uint64_t prev[5]{};
+    // This sample's CPU time of the node's CPUs, summed while /proc/stat is walked.
+    std::uint64_t total_delta{0};
+    std::uint64_t idle_delta{0};
+  };
+  struct Cpu final {
+    bool seen{false};
+    bool primed{false};
+    std::uint64_t prev_total{0};
+    std::uint64_t prev_idle{0};
+    double pct{0.0};
+  };
+
+  bool sample_cpus();
+  bool sample_node(std::size_t i, double seconds);
+
+  bool numa_{false};
+  // Node index into nodes_/stats_ per CPU number; -1 for CPUs in no cpulist.
+  std::vector<std::int16_t> cpu_node_;
+  std::vector<Cpu> cpus_;
+  std::vector<std::unique_ptr<Node>> nodes_;
+  std::vector<NumaNodeStats> stats_;
+  ProcFile stat_;
+  std::vector<char> text_;
+  std::uint64_t prev_ns_{0};
+  bool available_{false};
+};
+
+}  // namespace telemetry::metrics
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "telemetry/metrics/metric_source.h"
+#include "telemetry/metrics/proc_file.h"
+#include "telemetry/metrics/sample_trigger.h"
+
+// Pressure Stall Information (Linux 4.20 and later only).
+
+namespace telemetry::metrics {
+
+enum class PressureResource : std::uint8_t { kCpu = 0, kMemory = 1, kIo = 2 };
+
+const char* pressure_resource_name(PressureResource r);
+
+struct PressureStats final {
+  // False if the kernel has no pressure file for this resource.
+  bool available{false};
+  // Share of time at least one task ("some") or every non-idle task ("full") was stalled
+  // on the resource, as the kernel's 10 s, 60 s and 300 s running averages.
+  double some_avg10{0.0};
+  double some_avg60{0.0};
+  double some_avg300{0.0};
+  double full_avg10{0.0};
+  double full_avg60{0.0};
+  double full_avg300{0.0};
+  // The same over the last sampling interval, from the stall time totals (0 on the first).
+  double some_stalled_pct{0.0};
+  double full_stalled_pct{0.0};
+};
+
+// /proc/pressure/{cpu,memory,io}, reported as detail and OpenMetrics families.
+class PressureSource final : public MetricSource {
+ public:
+  explicit PressureSource(const char* root = "");
+
+  const char* name() const override { return "linux_pressure"; }
+  Status collect(MetricsSnapshot& out) override;
+  bool append_detail_json(std::string& out) const override;
+  void append_openmetrics(std::string& out) const override;
+
+  // collect() at an explicit monotonic time.
+  Status sample(std::uint64_t now_ns);
+
+  const PressureStats& stats(PressureResource r) const { return resources_[static_cast<std::size_t>(r)].stats; }
+
+ private:
+  struct Resource final {
+    ProcFile file;
+    PressureStats stats;
+    bool primed{false};
+    std::uint64_t prev_some_us{0};
+    std::uint64_t prev_full_us{0};
+  };
+
+  std::array<Resource, 3> resources_;
+  std::uint64_t prev_ns_{0};
+};
+
+struct PressureTriggerConfig final {
+  PressureResource resource{PressureResource::kMemory};
+  bool full{false};
+  // Fire when stall time within a `window_us` window exceeds `stall_us`. The kernel accepts
+  // windows of 500 ms to 10 s; unprivileged processes need a multiple of 2 s.
+  std::uint32_t stall_us{150000};
+  std::uint32_t window_us{1000000};
+};
+
+// Parses "<cpu|memory|io>:<some|full>:<stall_ms>/<window_ms>", e.g. "memory:some:150/1000".
+Status parse_pressure_trigger(const char* spec, PressureTriggerConfig& out);
+
+// A PSI trigger: the threshold is written to the pressure file, which then polls POLLPRI
+// whenever the stall threshold is crossed, at most once per window.
+class PressureTrigger final : public SampleTrigger {
+ public:
+  explicit PressureTrigger(const PressureTriggerConfig& cfg, const char* root = "");
+  ~PressureTrigger() override;
+  PressureTrigger(const PressureTrigger&) = delete;
+  PressureTrigger& operator=(const PressureTrigger&) = delete;
+
+  // Opens the pressure file and registers the trigger.
+  Status open();
+
+  const char* name() const override { return name_; }
+  int fd() const override { return fd_; }
+  short events() const override;
+  bool on_ready(short revents) override;
+
+  const PressureTriggerConfig& config() const { return cfg_; }
+  std::uint64_t fired() const { return fired_; }
+
+ private:
+  PressureTriggerConfig cfg_;
+  char path_[512]{};
+  char name_[32]{};
+  int fd_{-1};
+  std::uint64_t fired_{0};
+};
+
+}  // namespace telemetry::metrics
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "telemetry/metrics/collector.h"
+
+namespace telemetry::metrics {
+
+// Adds the /proc and /sys backed sources (Linux only): CPU, memory, uptime and temperature
+// for the snapshot, and per-disk and per-interface I/O rates, pressure stall figures, the
+// per-NUMA-node breakdown and interrupt rates as detail. `root` is prepended
+// to every path, so benchmarks and tests can point the parsers at a fixture tree; "" reads
+// the live system.
+void add_linux_sources(Collector& collector, const char* root = "");
+
+}  // namespace telemetry::metrics
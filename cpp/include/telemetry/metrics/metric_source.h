@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 #include "telemetry/metrics_snapshot.h"
 #include "telemetry/status.h"
 
@@ -10,6 +12,15 @@ class MetricSource {
   virtual ~MetricSource() = default;
   virtual const char* name() const = 0;
   virtual Status collect(MetricsSnapshot& out) = 0;
+
+  // Per-entity detail the fixed snapshot has no room for (per disk, per interface, ...), as of
+  // the last collect(). Appends one JSON value for DETAIL; false if the source has none.
+  virtual bool append_detail_json(std::string& out) const {
+    (void)out;
+    return false;
+  }
+  // Appends complete OpenMetrics families (TYPE, HELP and samples) for GET /metrics.
+  virtual void append_openmetrics(std::string& out) const { (void)out; }
 };
 
 }  // namespace telemetry::metrics
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Helpers shared by the /proc and /sys sources (Linux only).
+
+namespace telemetry::metrics {
+
+// A /proc or /sys file under `root` ("" = the live system), opened once and re-read from
+// offset 0 on every sample. fopen() would malloc a FILE and its buffer per collect; this
+// costs one pread() into the caller's buffer.
+class ProcFile final {
+ public:
+  ProcFile() = default;
+  ProcFile(const char* root, const char* path) { assign(root, path); }
+  ~ProcFile() { close(); }
+  ProcFile(const ProcFile&) = delete;
+  ProcFile& operator=(const ProcFile&) = delete;
+
+  // Points at another file; the current one is closed.
+  void assign(const char* root, const char* path) {
+    close();
+    std::snprintf(path_, sizeof(path_), "%s%s", root ? root : "", path);
+  }
+
+  void close() {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+  }
+
+  bool open() {
+    if (fd_ < 0) fd_ = ::open(path_, O_RDONLY | O_CLOEXEC);
+    return fd_ >= 0;
+  }
+
+  // -1 while closed; for polling files that signal changes (mountinfo, PSI triggers).
+  int fd() const { return fd_; }
+
+  // Reads up to cap - 1 bytes and NUL-terminates them. A failed read closes the file so the
+  // next sample reopens it.
+  bool read(char* buf, std::size_t cap) { return read_all(buf, cap) != 0; }
+
+  // Like read(), but keeps reading until EOF for files larger than one pread() returns
+  // (/proc/diskstats with many devices). Returns the length, 0 on failure; a result of
+  // cap - 1 means the file may have been cut short.
+  std::size_t read_all(char* buf, std::size_t cap) {
+    std::size_t len = 0;
+    while (len + 1 < cap) {
+      const ssize_t n = ::pread(fd_, buf + len, cap - 1 - len, static_cast<off_t>(len));
+      if (n < 0 && errno == EINTR) continue;
+      if (n < 0 || (n == 0 && len == 0)) {
+        close();
+        return 0;
+      }
+      if (n == 0) break;
+      len += static_cast<std::size_t>(n);
+    }
+    buf[len] = '\0';
+    return len;
+  }
+
+ private:
+  char path_[512]{};
+  int fd_{-1};
+};
+
+// Skips blanks, then parses an unsigned decimal; `p` ends after the digits. Returns 0 (and
+// leaves `p` on the offending character) if there are none.
+inline std::uint64_t parse_proc_u64(const char*& p) {
+  while (*p == ' ' || *p == '\t') ++p;
+  std::uint64_t v = 0;
+  while (*p >= '0' && *p <= '9') v = v * 10 + static_cast<std::uint64_t>(*p++ - '0');
+  return v;
+}
+
+// Kernel counters are unsigned long: 32 bits on 32-bit hosts, and some drivers keep 32-bit
+// network counters. A drop is taken as a 32-bit wrap only when the wrapped distance is small
+// (the last value sat within 1/16 of 2^32 of the top); any other drop is a reset (device
+// re-registered, cgroup re-created) and the interval reports 0 rather than a ~4 GiB spike.
+inline std::uint64_t counter_delta(std::uint64_t prev, std::uint64_t cur) {
+  if (cur >= prev) return cur - prev;
+  constexpr std::uint64_t kWrap = std::uint64_t{1} << 32;
+  if (prev < kWrap && kWrap - prev + cur <= kWrap / 16) return kWrap - prev + cur;
+  return 0;
+}
+
+inline double per_second(std::uint64_t delta, double seconds) {
+  return seconds > 0.0 ? static_cast<double>(delta) / seconds : 0.0;
+}
+
+// printf-style append for detail JSON and OpenMetrics rows; a row longer than the buffer is
+// cut short.
+inline void append_row(std::string& out, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+inline void append_row(std::string& out, const char* fmt, ...) {
+  char row[384];
+  va_list ap;
+  va_start(ap, fmt);
+  const int n = std::vsnprintf(row, sizeof(row), fmt, ap);
+  va_end(ap);
+  if (n > 0) out.append(row, std::min(static_cast<std::size_t>(n), sizeof(row) - 1));
+}
+
+}  // namespace telemetry::metrics
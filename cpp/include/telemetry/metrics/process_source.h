@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "telemetry/metrics/metric_source.h"
+
+// Per-process CPU and memory, ranked (implemented for Linux only; the declarations are
+// platform-neutral so the server can serve TOP from it).
+
+namespace telemetry::metrics {
+
+struct ProcessSample final {
+  std::int32_t pid{0};
+  // Command name from /proc/<pid>/stat, sanitized for JSON and OpenMetrics labels.
+  char comm[20]{};
+  // CPU time over the process's last sampling interval; 100 = one core.
+  double cpu_pct{0.0};
+  std::uint64_t rss_bytes{0};
+};
+
+struct ProcessSourceConfig final {
+  // Prepended to /proc, as for add_linux_sources ("" = the live system).
+  const char* root = "";
+  // Rows kept in the ranking: the most TOP can return.
+  std::size_t top_n = 32;
+  // Processes read per collect(). A pass over /proc then spans several collects and the
+  // ranking is replaced when one completes, bounding the CPU cost of each sample on hosts
+  // with many processes. 0 = the whole of /proc on every collect.
+  std::size_t max_per_tick = 0;
+  // Processes whose counters are kept between passes; beyond it, new processes are still
+  // ranked but report 0 CPU until slots free up.
+  std::size_t max_processes = 65536;
+};
+
+// Scans /proc/<pid>/stat for every process, reading each with openat() relative to a cached
+// /proc descriptor. Previous CPU counters live in a pid-keyed open-addressing table and the
+// busiest processes in a bounded heap, both sized at construction, so a scan does not
+// allocate however many processes come and go.
+class ProcessSource final : public MetricSource {
+ public:
+  static constexpr std::size_t kMaxTop = 256;
+
+  explicit ProcessSource(const ProcessSourceConfig& cfg = {});
+  ~ProcessSource() override;
+  ProcessSource(const ProcessSource&) = delete;
+  ProcessSource& operator=(const ProcessSource&) = delete;
+
+  const char* name() const override { return "linux_processes"; }
+  Status collect(MetricsSnapshot& out) override;
+  bool append_detail_json(std::string& out) const override;
+  void append_openmetrics(std::string& out) const override;
+
+  // One collect() at an explicit monotonic time.
+  Status sample(std::uint64_t now_ns);
+
+  // The busiest processes of the last completed pass (by CPU, then RSS), busiest first.
+  const std::vector<ProcessSample>& top() const { return top_; }
+  // Processes seen in the last completed pass.
+  std::size_t processes() const { return pass_processes_; }
+  std::uint64_t passes() const { return passes_; }
+  // Processes in the last pass that had no table slot.
+  std::size_t untracked() const { return pass_untracked_; }
+
+ private:
+  struct Entry final {
+    std::int32_t pid{0};  // 0 = empty, -1 = deleted
+    std::uint32_t pass{0};
+    std::uint64_t ticks{0};
+    std::uint64_t start_time{0};  // tells a reused pid from the process before it
+    std::uint64_t ns{0};
+  };
+
+  void read_process(const char* name, std::int32_t pid, std::uint64_t now_ns);
+  Entry* find_or_insert(std::int32_t pid, bool& inserted);
+  void rehash();
+  void finish_pass();
+
+  ProcessSourceConfig cfg_;
+  std::string proc_path_;
+  int proc_fd_{-1};
+  std::vector<char> dents_;
+  std::size_t dents_off_{0};
+  std::size_t dents_len_{0};
+  bool in_pass_{false};
+
+  std::vector<Entry> table_;
+  std::vector<Entry> scratch_;  // rehash target, swapped with table_
+  std::size_t live_{0};
+  std::size_t deleted_{0};
+  std::uint32_t pass_{0};
+
+  std::vector<ProcessSample> heap_;
+  std::vector<ProcessSample> top_;
+  std::size_t seen_{0};
+  std::size_t untracked_{0};
+  std::size_t pass_processes_{0};
+  std::size_t pass_untracked_{0};
+  std::uint64_t passes_{0};
+  double ticks_per_s_{100.0};
+  std::uint64_t page_size_{4096};
+};
+
+}  // namespace telemetry::metrics
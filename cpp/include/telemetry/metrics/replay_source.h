@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "telemetry/metrics/metric_source.h"
+
+// Recorded snapshots played back as a metric source (POSIX only).
+
+namespace telemetry::metrics {
+
+struct ReplayConfig final {
+  // A spool directory (every segment, oldest first) or a single .tlog segment, as written by
+  // --spool-dir on a production agent.
+  const char* path = nullptr;
+  // Trace time per unit of wall time: 1 replays in real time, 10 ten times faster. 0 replays
+  // as fast as possible: every collect() returns the next record.
+  double speed = 1.0;
+  // Starts over after the last record; otherwise the last record is repeated.
+  bool loop = true;
+};
+
+// Plays a recorded spool back through collect(), so the server, subscribers, rules and
+// exporters see production-shaped data at a chosen rate instead of simulated sine waves.
+//
+// open() maps every segment read-only and indexes its records once: a record is a pointer
+// into the mapping, and collect() decodes one record in place, with no file I/O or copy.
+// Records are paced by their recorded timestamps, so bursts and gaps in the trace are kept;
+// a record whose CRC does not match ends its segment, as spool recovery treats a torn tail.
+// Fields are overwritten from the record except ts_ms, which keeps the time of the sample.
+class ReplaySource final : public MetricSource {
+ public:
+  explicit ReplaySource(const ReplayConfig& cfg);
+  ~ReplaySource() override;
+
+  ReplaySource(const ReplaySource&) = delete;
+  ReplaySource& operator=(const ReplaySource&) = delete;
+
+  // Maps and indexes the trace; InvalidArgument if it holds no valid record.
+  Status open();
+
+  const char* name() const override { return "replay"; }
+  Status collect(MetricsSnapshot& out) override;
+  bool append_detail_json(std::string& out) const override;
+
+  // collect() at an explicit monotonic time.
+  Status sample(MetricsSnapshot& out, std::uint64_t now_ns);
+
+  std::size_t records() const { return records_.size(); }
+  std::size_t segments() const { return maps_.size(); }
+  // Recorded time from the first record to the last.
+  std::uint64_t duration_ms() const { return records_.empty() ? 0 : records_.back().offset_ms; }
+  // Index of the record the last sample returned, and how many times the trace wrapped.
+  std::size_t position() const { return pos_; }
+  std::uint64_t loops() const { return loops_; }
+  // Recorded timestamp of the record the last sample returned.
+  std::uint64_t trace_ts_ms() const;
+
+ private:
+  struct Mapping final {
+    void* base{nullptr};
+    std::size_t len{0};
+  };
+  struct Record final {
+    const std::uint8_t* payload{nullptr};
+    std::uint32_t len{0};
+    // Milliseconds after the first record; never decreases, even across a clock step.
+    std::uint64_t offset_ms{0};
+  };
+
+  Status map_segment(const std::string& path);
+  void close();
+
+  ReplayConfig cfg_;
+  std::string path_;
+  std::vector<Mapping> maps_;
+  std::vector<Record> records_;
+  std::uint64_t first_ts_ms_{0};
+  // Trace time one pass covers: the recorded span plus one mean sample interval.
+  std::uint64_t cycle_ms_{1};
+  std::uint64_t start_ns_{0};
+  std::size_t pos_{0};
+  std::uint64_t loops_{0};
+  bool started_{false};
+};
+
+}  // namespace telemetry::metrics
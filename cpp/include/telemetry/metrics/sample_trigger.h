@@ -0,0 +1,21 @@
+#pragma once
+
+namespace telemetry::metrics {
+
+// A descriptor that asks for a sample when it becomes ready (POSIX only): the server polls
+// fd() for events() next to its sockets and, when on_ready() returns true, collects at once,
+// outside the throttle window, and pushes the snapshot to sinks and subscribers. Lets the
+// kernel report short-lived conditions (PSI stalls, ...) without raising the polling rate.
+class SampleTrigger {
+ public:
+  virtual ~SampleTrigger() = default;
+  virtual const char* name() const = 0;
+  // -1 while the trigger is not armed; it is then skipped.
+  virtual int fd() const = 0;
+  virtual short events() const = 0;
+  // Called on the event-loop thread with the poll() revents; must not block. False = no
+  // sample needed (the trigger only noted the event, e.g. for the next regular sample).
+  virtual bool on_ready(short revents) = 0;
+};
+
+}  // namespace telemetry::metrics
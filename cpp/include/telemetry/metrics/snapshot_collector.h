@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "telemetry/metrics_snapshot.h"
+#include "telemetry/status.h"
+
+namespace telemetry::metrics {
+
+// A set of metric sources sampled as one, which is what the server holds. Collector composes
+// its sources at run time; StaticCollector (static_collector.h) fixes them at compile time.
+class SnapshotCollector {
+ public:
+  virtual ~SnapshotCollector() = default;
+
+  // Runs every source into `out`, in order. A failing source does not stop the rest;
+  // Unavailable is tolerated and the first other error is returned.
+  virtual Status collect(MetricsSnapshot& out) = 0;
+  // Appends `"<source>":<detail>` members (comma-separated, no braces) for every source with
+  // detail, or only the one named `only`; returns how many were written.
+  virtual std::size_t append_detail_json(std::string& out, std::string_view only = {}) const = 0;
+  virtual void append_openmetrics(std::string& out) const = 0;
+};
+
+namespace detail {
+
+// One `"<source>":<detail>` member of append_detail_json(), after a comma unless `written` is
+// 0; `out` is left as it was if the source has no detail.
+template <class Source>
+bool append_source_detail(std::string& out, const Source& src, std::size_t written) {
+  const std::size_t mark = out.size();
+  if (written != 0) out.push_back(',');
+  out.push_back('"');
+  out.append(src.name());
+  out.append("\":");
+  if (src.append_detail_json(out)) return true;
+  out.resize(mark);
+  return false;
+}
+
+}  // namespace detail
+
+}  // namespace telemetry::metrics
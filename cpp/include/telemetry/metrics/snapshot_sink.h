@@ -0,0 +1,17 @@
+#pragma once
+
+#include "telemetry/metrics_snapshot.h"
+#include "telemetry/status.h"
+
+namespace telemetry::metrics {
+
+// Consumer of freshly collected snapshots (exporters, rule engines, ...).
+class SnapshotSink {
+ public:
+  virtual ~SnapshotSink() = default;
+  virtual const char* name() const = 0;
+  // Called on the sampling thread for every new snapshot; must not block.
+  virtual void on_snapshot(const MetricsSnapshot& snap, Status collect_status) = 0;
+};
+
+}  // namespace telemetry::metrics
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+#include "telemetry/metrics/metric_source.h"
+#include "telemetry/metrics/snapshot_collector.h"
+#include "telemetry/trace/trace.h"
+
+namespace telemetry::metrics {
+
+// A collector whose sources are fixed at compile time, for a source set known up front (a
+// platform's defaults, an embedded build). The sources are held by value in one tuple,
+// contiguous and with no allocation per source, and each is called through its own type:
+// calls into a final source are direct, and inlined where its definition is visible, instead
+// of one virtual call per source per sample. Sources run in template order with Collector's
+// error and detail semantics, and the server takes either through SnapshotCollector.
+//
+//   StaticCollector<DiskStatsSource, NetDevSource> c(root, root);
+template <class... Sources>
+class StaticCollector final : public SnapshotCollector {
+  static_assert((std::derived_from<Sources, MetricSource> && ...), "StaticCollector sources must be MetricSources");
+
+ public:
+  StaticCollector() = default;
+  // Constructs each source from the argument in the same position.
+  template <class... Args>
+    requires(sizeof...(Args) == sizeof...(Sources) && sizeof...(Args) != 0)
+  explicit StaticCollector(Args&&... args) : sources_(std::forward<Args>(args)...) {}
+
+  StaticCollector(const StaticCollector&) = delete;
+  StaticCollector& operator=(const StaticCollector&) = delete;
+
+  static constexpr std::size_t size() { return sizeof...(Sources); }
+
+  template <std::size_t I>
+  auto& source() {
+    return std::get<I>(sources_);
+  }
+  template <std::size_t I>
+  const auto& source() const {
+    return std::get<I>(sources_);
+  }
+
+  Status collect(MetricsSnapshot& out) override {
+    trace::Span span("collect", sizeof...(Sources));
+    Status first_error = Status::Ok();
+    std::apply([&](Sources&... src) { (collect_one(src, out, first_error), ...); }, sources_);
+    return first_error;
+  }
+
+  std::size_t append_detail_json(std::string& out, std::string_view only = {}) const override {
+    std::size_t written = 0;
+    const auto append_one = [&](const auto& src) {
+      if ((only.empty() || only == src.name()) && detail::append_source_detail(out, src, written)) ++written;
+    };
+    std::apply([&](const Sources&... src) { (append_one(src), ...); }, sources_);
+    return written;
+  }
+
+  void append_openmetrics(std::string& out) const override {
+    std::apply([&](const Sources&... src) { (src.append_openmetrics(out), ...); }, sources_);
+  }
+
+ private:
+  template <class Source>
+  static void collect_one(Source& src, MetricsSnapshot& out, Status& first_error) {
+    trace::Span source_span(src.name());
+    const Status st = src.collect(out);
+    if (!st.ok() && st.code != StatusCode::kUnavailable && first_error.ok()) first_error = st;
+  }
+
+  std::tuple<Sources...> sources_;
+};
+
+}  // namespace telemetry::metrics
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace telemetry::net {
+
+enum class HttpParseResult : std::uint8_t {
+  kIncomplete = 0,
+  kComplete,
+  kError,
+};
+
+struct HttpRequest final {
+  // Views into the buffer passed to parse(); valid until those bytes are consumed.
+  std::string_view method;
+  std::string_view target;
+  bool keep_alive{true};
+  bool wants_openmetrics{false};
+  // Bytes to consume for this request (head plus body).
+  std::size_t length{0};
+  // Suggested response status when parse() returns kError.
+  int error_status{0};
+};
+
+// Incremental HTTP/1.x request parser for the metrics listener.
+//
+// Call parse() whenever more bytes arrive, passing all unconsumed bytes. The search for
+// the end of the head resumes where the previous call stopped, so a request trickling in
+// over many reads is scanned once. Call reset() after consuming a request.
+class HttpRequestParser final {
+ public:
+  HttpParseResult parse(std::string_view data, HttpRequest& out);
+  void reset() { scanned_ = 0; }
+
+ private:
+  std::size_t scanned_{0};
+};
+
+}  // namespace telemetry::net
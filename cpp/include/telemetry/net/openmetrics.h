@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "telemetry/metrics_snapshot.h"
+#include "telemetry/status.h"
+
+namespace telemetry::net {
+
+// Content types for GET /metrics. The body is valid for both: OpenMetrics-only lines
+// (# UNIT, # EOF) are plain comments to the classic Prometheus text parser.
+inline constexpr const char* kOpenMetricsContentType = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+inline constexpr const char* kPrometheusTextContentType = "text/plain; version=0.0.4; charset=utf-8";
+
+// Renders one snapshot as an OpenMetrics text exposition into `out` (replacing its contents).
+// Memory is reported in bytes and the timestamp in seconds, per Prometheus base-unit conventions.
+// `extra_families` (complete families, e.g. from Collector::append_openmetrics) go before # EOF.
+Status render_openmetrics(const MetricsSnapshot& snap, Status collect_status, std::string& out,
+                          std::string_view extra_families = {});
+
+}  // namespace telemetry::net
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string_view>
 
+#include "telemetry/metrics_snapshot.h"
+#include "telemetry/status.h"
+
 namespace telemetry::net {
 
 enum class CommandType : std::uint8_t {
@@ -11,6 +15,28 @@ enum class CommandType : std::uint8_t {
   kGet,
   kRestart,
   kThrottle,
+  kDrain,
+  kFleet,
+  kAlerts,
+  kSubscribe,
+  kUnsubscribe,
+  kTrace,
+  kClients,
+  kDetail,
+  kTop,
+};
+
+enum class FleetQuery : std::uint8_t {
+  kAll = 0,
+  kTopCpu,
+  kOverCpu,
+};
+
+enum class TraceOp : std::uint8_t {
+  kDump = 0,
+  kOn,
+  kOff,
+  kClear,
 };
 
 struct ParsedCommand final {
@@ -18,6 +44,17 @@ struct ParsedCommand final {
   std::uint32_t throttle_ms{0};
   bool ok{true};
   const char* error{nullptr};
+  std::uint64_t cursor{0};
+  FleetQuery fleet_query{FleetQuery::kAll};
+  std::uint32_t count{0};
+  double threshold{0.0};
+  // SUBSCRIBE: deadband (see codec::DeadbandConfig) and keyframe interval in samples.
+  double deadband_abs{0.0};
+  double deadband_rel{0.0};
+  std::uint32_t keyframe_every{1};
+  TraceOp trace_op{TraceOp::kDump};
+  // DETAIL: source name (a view into the parsed line); empty = every source.
+  std::string_view source{};
 };
 
 // Parses a single line (no trailing \n, optional \r already stripped).
@@ -26,8 +63,21 @@ struct ParsedCommand final {
 // - GET
 // - RESTART
 // - THROTTLE <ms>
+// - DRAIN <cursor>
+// - FLEET [ALL] | FLEET TOP <n> | FLEET OVER <cpu_pct>
+// - ALERTS
+// - SUBSCRIBE | SUBSCRIBE DELTA <abs> [<rel> [<keyframe_every>]] | UNSUBSCRIBE
+// - TRACE ON | TRACE OFF | TRACE CLEAR | TRACE DUMP
+// - CLIENTS
+// - DETAIL [<source>]
+// - TOP [<n>] (1..256, default 10)
 ParsedCommand parse_command(std::string_view line);
 
+// Renders the GET reply (one JSON line, trailing \n included) into `out`.
+// Returns its length, or 0 if it does not fit in `cap`.
+std::size_t format_metrics_json(char* out, std::size_t cap, const MetricsSnapshot& snap, Status collect_status,
+                                std::uint32_t throttle_ms);
+
 }  // namespace telemetry::net
 
 
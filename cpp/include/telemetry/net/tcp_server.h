@@ -2,11 +2,27 @@
 
 #include <atomic>
 #include <cstdint>
+#include <string>
 #include <string_view>
+#include <vector>
+
+#include "telemetry/codec/delta_stream.h"
+#include "telemetry/fleet/fleet_table.h"
 
 #include "telemetry/metrics/collector.h"
+#include "telemetry/metrics/process_source.h"
+#include "telemetry/metrics/sample_trigger.h"
+#include "telemetry/metrics/snapshot_sink.h"
 #include "telemetry/metrics_snapshot.h"
+#include "telemetry/net/http.h"
+#include "telemetry/net/protocol.h"
+#include "telemetry/rules/rule_engine.h"
 #include "telemetry/status.h"
+#include "telemetry/util/timer_wheel.h"
+
+namespace telemetry::storage {
+class Spool;
+}  // namespace telemetry::storage
 
 namespace telemetry::net {
 
@@ -17,35 +33,166 @@ using SocketHandle = std::uintptr_t;
 using SocketHandle = int;
 #endif
 
+// Per-client state, defined by the platform event loop.
+struct Connection;
+
 struct TcpServerConfig final {
   const char* host = "0.0.0.0";
   std::uint16_t port = 9000;
   std::uint32_t throttle_ms = 250;
   std::uint32_t run_for_ms = 0;  // 0 = run forever
+  // OpenMetrics HTTP listener on `host` serving GET /metrics (POSIX only); 0 = disabled.
+  std::uint16_t metrics_port = 0;
+  // AF_UNIX stream socket path serving the line protocol next to the TCP port (POSIX only).
+  // A stale socket file at this path is replaced; the file is removed on shutdown.
+  const char* unix_path = nullptr;
+  // Fair scheduling (POSIX only). Per loop pass a connection runs at most this many commands
+  // (or HTTP requests) and reads at most this many bytes; unprocessed input waits in its
+  // buffer and is served first on the next pass, which starts one connection further on.
+  // 0 = unlimited: every readable connection is drained until EAGAIN.
+  std::uint32_t max_commands_per_pass = 0;
+  std::uint32_t max_read_bytes_per_pass = 0;
+  // Line and HTTP connections that neither send nor take output for this long are closed
+  // (POSIX only); ALERTS and SUBSCRIBE connections are exempt. 0 = never.
+  std::uint32_t idle_timeout_ms = 300000;
 };
 
 class TcpServer final {
  public:
-  TcpServer(metrics::Collector& collector, TcpServerConfig cfg);
+  static constexpr std::size_t kMaxTriggers = 16;
+
+  TcpServer(metrics::SnapshotCollector& collector, TcpServerConfig cfg);
+  ~TcpServer();
+  TcpServer(const TcpServer&) = delete;
+  TcpServer& operator=(const TcpServer&) = delete;
+
+  // Optional store-and-forward spool (POSIX only). When set, every snapshot is appended
+  // (with background sampling as for sinks) and DRAIN is served from it.
+  void set_spool(storage::Spool* spool) { spool_ = spool; }
+
+  // Sinks receive every fresh snapshot on the event-loop thread. Registering one enables
+  // background sampling every throttle_ms. Must be called before run_forever().
+  void add_sink(metrics::SnapshotSink* sink) { sinks_.push_back(sink); }
+
+  // Optional fleet table filled by a FleetAggregator; enables FLEET queries.
+  void set_fleet(const fleet::FleetTable* fleet) { fleet_ = fleet; }
+
+  // Optional rule engine (POSIX only), evaluated on every sample with background sampling.
+  // ALERTS subscribes a connection to its firing/resolved transitions.
+  void set_rules(rules::RuleEngine* rules) { rules_ = rules; }
+
+  // Optional process ranking (Linux only), refreshed by the collector it was added to;
+  // enables TOP.
+  void set_processes(const metrics::ProcessSource* processes) { processes_ = processes; }
+
+  // Descriptors polled by the event loop (POSIX only) that can force an immediate sample
+  // when they fire; at most kMaxTriggers, further ones are ignored. Must be called before
+  // run_forever().
+  void add_trigger(metrics::SampleTrigger* trigger) {
+    if (triggers_.size() < kMaxTriggers) triggers_.push_back(trigger);
+  }
 
   Status run_forever();
 
+  // Makes run_forever() return as it does at run_for_ms; safe from any thread. Wakes the
+  // event loop, which otherwise sleeps until its next timer.
+  void stop();
+
  private:
-  Status handle_command(std::string_view cmd, SocketHandle client_fd);
-  Status write_json_metrics(SocketHandle client_fd, const telemetry::MetricsSnapshot& snap, Status collect_status);
-  Status write_json_ok(SocketHandle client_fd, const char* msg);
-  Status write_json_error(SocketHandle client_fd, const char* msg);
+  // Collects a fresh snapshot if the throttle window elapsed since the last one (monotonic
+  // `now_ms`), or regardless when `force`d; returns true if it did.
+  bool refresh_snapshot(std::uint64_t now_ms, bool force = false);
+  // Feeds the spool, rules and sinks; `now_ms` is monotonic.
+  void publish_snapshot(std::uint64_t now_ms);
+  // Re-arms the sampling and spool flush timers after anything that may have moved them.
+  void arm_timers(std::uint64_t now_ms);
+  // Idle timer expiry for `conn`: closes it, or re-arms if it was active meanwhile.
+  void on_idle_timer(Connection& conn, std::uint64_t now_ms);
+  bool background_sampling() const {
+    return spool_ != nullptr || rules_ != nullptr || active_groups_ > 0 || !sinks_.empty();
+  }
+
+  void process_input(Connection& conn);
+  // True once `conn` has used this pass's command budget; its remaining input becomes backlog.
+  bool command_budget_spent(Connection& conn) const;
+  void process_http_input(Connection& conn);
+  Status handle_http(Connection& conn, const HttpRequest& req);
+  Status write_http_response(Connection& conn, int status, const char* content_type, const char* body,
+                             std::size_t body_len, bool keep_alive, bool head_only);
+  Status handle_command(std::string_view cmd, Connection& conn);
+  Status handle_drain(Connection& conn, std::uint64_t cursor);
+  Status handle_fleet(Connection& conn, const ParsedCommand& pc);
+  Status handle_alerts(Connection& conn);
+  Status handle_subscribe(Connection& conn, const ParsedCommand& pc);
+  Status handle_trace(Connection& conn, const ParsedCommand& pc);
+  Status handle_clients(Connection& conn);
+  Status handle_detail(Connection& conn, const ParsedCommand& pc);
+  Status handle_top(Connection& conn, const ParsedCommand& pc);
+  // Sends pending rule transitions and subscription lines; called once per loop pass.
+  void push_updates(Connection* clients, int count);
+  void push_alerts(Connection* clients, int count);
+  void push_subscriptions(Connection* clients, int count);
+  Status write_alert_event(Connection& conn, const rules::AlertEvent& ev);
+  Status write_json_metrics(Connection& conn, const telemetry::MetricsSnapshot& snap, Status collect_status);
+  Status write_json_ok(Connection& conn, const char* msg);
+  Status write_json_error(Connection& conn, const char* msg);
+  Status send_response(Connection& conn, const char* data, std::size_t len);
 
-  metrics::Collector& collector_;
+  metrics::SnapshotCollector& collector_;
   TcpServerConfig cfg_;
   std::atomic<std::uint32_t> throttle_ms_;
+  std::atomic<bool> stop_{false};
+  // Self-pipe stop() writes to so a sleeping poll() returns (POSIX only).
+  int wake_fds_[2]{-1, -1};
+
+  // Every deadline of the event loop (sampling, spool flush, idle connections, run_for_ms)
+  // is a timer on one wheel, driven by the monotonic clock; poll() sleeps until the next.
+  util::TimerWheel timers_;
+  util::WheelTimer sample_timer_;
+  util::WheelTimer spool_timer_;
+  util::WheelTimer deadline_timer_;
 
   // Cached snapshot for throttling.
   telemetry::MetricsSnapshot last_snapshot_{};
   Status last_collect_status_{Status::Ok()};
-  std::uint64_t last_collect_ms_{0};
-};
+  std::uint64_t last_collect_ms_{0};  // monotonic
+  // Bumped on every collection; the HTTP exposition is re-rendered only when it moves.
+  std::uint64_t snapshot_gen_{0};
+  std::uint64_t exposition_gen_{0};
+  std::string exposition_;
+  std::string detail_families_;
 
-}  // namespace telemetry::net
+  std::vector<metrics::SnapshotSink*> sinks_;
+  std::vector<metrics::SampleTrigger*> triggers_;
+  storage::Spool* spool_{nullptr};
+  bool spool_error_logged_{false};
 
+  const fleet::FleetTable* fleet_{nullptr};
+  std::vector<fleet::FleetHost> fleet_rows_;
 
+  rules::RuleEngine* rules_{nullptr};
+  const metrics::ProcessSource* processes_{nullptr};
+  std::vector<rules::AlertEvent> alert_scratch_;
+
+  // SUBSCRIBE clients with identical deadband settings share one group: the delta line is
+  // computed once per sample and the same bytes go to every member.
+  struct SubscriptionGroup final {
+    codec::DeltaStream stream;
+    bool active{false};
+  };
+  std::vector<SubscriptionGroup> sub_groups_;
+  std::vector<std::uint32_t> group_members_;
+  std::size_t active_groups_{0};
+  std::uint64_t streamed_gen_{0};
+  std::string stream_line_;
+  std::string response_buf_;
+  std::string trace_json_;
+
+  // The event loop's connection table while run_forever() runs (for CLIENTS).
+  Connection* clients_{nullptr};
+  std::uint64_t next_client_id_{0};
+  // Round-robin start of the per-pass service order.
+  int first_client_{0};
+};
+
+}  // namespace telemetry::net
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "telemetry/metrics_snapshot.h"
+#include "telemetry/status.h"
+
+namespace telemetry::rules {
+
+// A rule crossing into or out of the firing state.
+struct AlertEvent final {
+  std::uint32_t rule{0};
+  bool firing{false};
+  double value{0.0};      // left-hand side at the transition
+  double threshold{0.0};  // right-hand side at the transition
+  std::uint64_t ts_ms{0};
+};
+
+// Threshold rules evaluated on the agent for every sample.
+//
+// Rule syntax, one per line in a rules file:
+//
+//   [name:] <expr> (> | >= | < | <=) <expr> [for <duration>] [hysteresis <number>]
+//
+// Expressions combine the snapshot fields (cpu_usage_pct, mem_total_kb, mem_available_kb,
+// temperature_c, uptime_s) and numeric constants with + - * / and parentheses. Durations
+// take a unit: 500ms, 30s, 5m, 1h. A rule fires once its comparison has held for the whole
+// `for` duration and resolves when the left-hand side backs off past the threshold by the
+// hysteresis margin. Samples where either side is not a number (e.g. division by a zero
+// total) leave the rule's state unchanged.
+//
+// Rules are compiled at load time into constant-folded stack bytecode over metric IDs, kept
+// in one contiguous array, so per-sample cost is a linear walk with no allocation.
+class RuleEngine final {
+ public:
+  // Compiles and appends one rule. Unnamed rules are called "rule<index>".
+  Status add_rule(std::string_view text);
+
+  // Blank lines and `#` comments are skipped. On a compile error, `error_line` (if given)
+  // receives the 1-based line number.
+  Status load_file(const char* path, std::size_t* error_line = nullptr);
+
+  std::size_t size() const { return rules_.size(); }
+  std::size_t firing_count() const;
+  bool is_firing(std::uint32_t rule) const;
+  const char* rule_name(std::uint32_t rule) const;
+  // Appends one event per currently firing rule (as of its last evaluation) to `out`.
+  void firing(std::vector<AlertEvent>& out) const;
+
+  // Evaluates every rule against one sample and appends state transitions to events().
+  // `now_ms` is monotonic and times the `for` durations, so wall-clock steps neither fire
+  // pending rules early nor hold them back; events carry the snapshot's `ts_ms`.
+  void evaluate(const MetricsSnapshot& snap, std::uint64_t now_ms);
+
+  // Transitions since the last clear_events(); the owner drains them after each sample.
+  const std::vector<AlertEvent>& events() const { return events_; }
+  void clear_events() { events_.clear(); }
+
+ private:
+  enum class Cmp : std::uint8_t { kGt, kGe, kLt, kLe };
+  enum class State : std::uint8_t { kInactive, kPending, kFiring };
+
+  struct Instr final {
+    std::uint8_t op{0};
+    std::uint8_t metric{0};
+    double k{0.0};
+  };
+
+  struct Rule final {
+    char name[48]{};
+    std::uint32_t lhs_off{0};
+    std::uint32_t lhs_len{0};
+    std::uint32_t rhs_off{0};
+    std::uint32_t rhs_len{0};
+    Cmp cmp{Cmp::kGt};
+    State state{State::kInactive};
+    double hysteresis{0.0};
+    std::uint64_t for_ms{0};
+    std::uint64_t pending_since_ms{0};
+    std::uint64_t fired_ms{0};
+    double last_value{0.0};
+    double last_threshold{0.0};
+  };
+
+  class Parser;
+
+  static double run_program(const Instr* code, std::uint32_t len, const double* metrics);
+
+  std::vector<Instr> code_;
+  std::vector<Rule> rules_;
+  std::vector<AlertEvent> events_;
+};
+
+}  // namespace telemetry::rules
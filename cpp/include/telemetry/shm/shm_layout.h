@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "telemetry/metrics_snapshot.h"
+#include "telemetry/status.h"
+
+namespace telemetry::shm {
+
+// Shared-memory snapshot segment published by telemetryd (--shm) for local readers.
+//
+// Segment: one 64-byte ShmHeader, then `capacity` 128-byte ShmSlots forming a history ring.
+// The n-th published sample (0-based) lives in slot n % capacity and `published` counts the
+// samples written so far. Each slot is a seqlock: the writer makes `seq` odd, stores the
+// fields, then makes it even again; a reader keeps a copy only if it saw the same even
+// `seq` before and after. `index` records which sample a slot holds, so a reader can tell
+// the sample it asked for from one the writer has since lapped it with.
+//
+// Every shared word is a lock-free 64-bit atomic (doubles travel as their bit pattern), so
+// both processes stay within the C++ memory model. Compatible additions use the reserved
+// words; any other layout change bumps kShmVersion.
+constexpr std::uint32_t kShmMagic = 0x534D4C54;  // "TLMS" in little-endian byte order
+constexpr std::uint32_t kShmVersion = 1;
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "shm layout needs lock-free 64-bit atomics");
+
+struct ShmHeader final {
+  // Stored last (release) by the publisher once the rest of the header is filled in.
+  std::atomic<std::uint32_t> magic;
+  std::uint32_t version;
+  std::uint32_t header_size;
+  std::uint32_t slot_size;
+  std::uint32_t capacity;
+  std::uint32_t writer_pid;
+  std::atomic<std::uint64_t> published;
+  std::uint64_t reserved[4];
+};
+static_assert(sizeof(ShmHeader) == 64, "ShmHeader is part of the wire layout");
+
+struct ShmSlot final {
+  std::atomic<std::uint64_t> seq;
+  std::atomic<std::uint64_t> index;
+  std::atomic<std::uint64_t> status;  // StatusCode of the collection
+  std::atomic<std::uint64_t> ts_ms;
+  std::atomic<std::uint64_t> cpu_usage_pct;  // double bits
+  std::atomic<std::uint64_t> mem_total_kb;
+  std::atomic<std::uint64_t> mem_available_kb;
+  std::atomic<std::uint64_t> temperature_c;  // double bits
+  std::atomic<std::uint64_t> uptime_s;
+  std::atomic<std::uint64_t> reserved[7];
+};
+static_assert(sizeof(ShmSlot) == 128, "ShmSlot is part of the wire layout");
+
+struct ShmSample final {
+  MetricsSnapshot snap{};
+  StatusCode status{StatusCode::kOk};
+  // 0-based publish count of this sample.
+  std::uint64_t index{0};
+};
+
+constexpr std::size_t shm_segment_size(std::uint32_t capacity) {
+  return sizeof(ShmHeader) + static_cast<std::size_t>(capacity) * sizeof(ShmSlot);
+}
+
+// Single writer only.
+inline void write_slot(ShmSlot& s, std::uint64_t index, const MetricsSnapshot& snap, StatusCode status) {
+  const std::uint64_t seq = s.seq.load(std::memory_order_relaxed);
+  s.seq.store(seq + 1, std::memory_order_relaxed);
+  // Keeps the field stores below from becoming visible before the odd seq.
+  std::atomic_thread_fence(std::memory_order_release);
+  s.index.store(index, std::memory_order_relaxed);
+  s.status.store(static_cast<std::uint64_t>(status), std::memory_order_relaxed);
+  s.ts_ms.store(snap.ts_ms, std::memory_order_relaxed);
+  s.cpu_usage_pct.store(std::bit_cast<std::uint64_t>(snap.cpu_usage_pct), std::memory_order_relaxed);
+  s.mem_total_kb.store(snap.mem_total_kb, std::memory_order_relaxed);
+  s.mem_available_kb.store(snap.mem_available_kb, std::memory_order_relaxed);
+  s.temperature_c.store(std::bit_cast<std::uint64_t>(snap.temperature_c), std::memory_order_relaxed);
+  s.uptime_s.store(snap.uptime_s, std::memory_order_relaxed);
+  s.seq.store(seq + 2, std::memory_order_release);
+}
+
+// One read attempt; false if the writer was inside the slot at any point during the copy.
+inline bool read_slot(const ShmSlot& s, ShmSample& out) {
+  const std::uint64_t seq = s.seq.load(std::memory_order_acquire);
+  if (seq & 1U) return false;
+  out.index = s.index.load(std::memory_order_relaxed);
+  out.status = static_cast<StatusCode>(s.status.load(std::memory_order_relaxed));
+  out.snap.ts_ms = s.ts_ms.load(std::memory_order_relaxed);
+  out.snap.cpu_usage_pct = std::bit_cast<double>(s.cpu_usage_pct.load(std::memory_order_relaxed));
+  out.snap.mem_total_kb = s.mem_total_kb.load(std::memory_order_relaxed);
+  out.snap.mem_available_kb = s.mem_available_kb.load(std::memory_order_relaxed);
+  out.snap.temperature_c = std::bit_cast<double>(s.temperature_c.load(std::memory_order_relaxed));
+  out.snap.uptime_s = s.uptime_s.load(std::memory_order_relaxed);
+  // Orders the field loads before the re-check of seq.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return s.seq.load(std::memory_order_relaxed) == seq;
+}
+
+}  // namespace telemetry::shm
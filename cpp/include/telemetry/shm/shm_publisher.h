@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "telemetry/metrics/snapshot_sink.h"
+#include "telemetry/shm/shm_layout.h"
+#include "telemetry/status.h"
+
+namespace telemetry::shm {
+
+struct ShmConfig final {
+  // POSIX shared-memory object name (leading '/', no other slashes).
+  const char* name = "/telemetryd";
+  // Samples kept in the history ring; readers see up to history - 1 of them.
+  std::uint32_t history = 256;
+};
+
+// Publishes every snapshot into a POSIX shared-memory segment (layout in shm_layout.h) for
+// local readers using shm_reader.h. Publishing is a handful of stores into the mapping; no
+// syscalls after open(). open() fails if the segment's recorded writer is still running;
+// one left by a dead writer is unlinked and replaced. On destruction the segment is
+// unlinked only if it still names this process as its writer. POSIX only.
+class ShmPublisher final : public metrics::SnapshotSink {
+ public:
+  explicit ShmPublisher(ShmConfig cfg);
+  ~ShmPublisher() override;
+
+  ShmPublisher(const ShmPublisher&) = delete;
+  ShmPublisher& operator=(const ShmPublisher&) = delete;
+
+  Status open();
+
+  const char* name() const override { return "shm_publisher"; }
+  void on_snapshot(const MetricsSnapshot& snap, Status collect_status) override;
+
+  std::uint64_t published() const { return published_; }
+
+ private:
+  ShmConfig cfg_;
+  void* base_{nullptr};
+  std::size_t size_{0};
+  ShmHeader* header_{nullptr};
+  ShmSlot* slots_{nullptr};
+  std::uint64_t published_{0};
+};
+
+}  // namespace telemetry::shm
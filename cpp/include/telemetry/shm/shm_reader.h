@@ -0,0 +1,129 @@
+#pragma once
+
+// Header-only reader for the telemetryd shared-memory segment (see shm_layout.h). POSIX only.
+//
+//   telemetry::shm::ShmReader reader;
+//   if (reader.open("/telemetryd").ok()) {
+//     telemetry::shm::ShmSample s;
+//     if (reader.latest(s)) use(s.snap);
+//   }
+//
+// open() is the only call that enters the kernel; latest() and history() are plain loads
+// from the mapping. The publisher recreates the segment when telemetryd restarts, so a
+// reader whose newest sample stops advancing should reopen.
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "telemetry/shm/shm_layout.h"
+#include "telemetry/status.h"
+
+namespace telemetry::shm {
+
+class ShmReader final {
+ public:
+  ShmReader() = default;
+  ~ShmReader() { close(); }
+
+  ShmReader(const ShmReader&) = delete;
+  ShmReader& operator=(const ShmReader&) = delete;
+
+  Status open(const char* name) {
+    close();
+    const int fd = ::shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) return Status::IoError("shm_open failed");
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(ShmHeader)) {
+      ::close(fd);
+      return Status::InvalidArgument("shm segment too small");
+    }
+    const std::size_t size = static_cast<std::size_t>(st.st_size);
+    void* base = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) return Status::IoError("mmap failed");
+
+    const auto* header = static_cast<const ShmHeader*>(base);
+    Status err = Status::Ok();
+    if (header->magic.load(std::memory_order_acquire) != kShmMagic) {
+      err = Status::Unavailable("shm segment not initialized");
+    } else if (header->version != kShmVersion) {
+      err = Status::InvalidArgument("unsupported shm version");
+    } else if (header->header_size != sizeof(ShmHeader) || header->slot_size != sizeof(ShmSlot) ||
+               header->capacity == 0 || size < shm_segment_size(header->capacity)) {
+      err = Status::InvalidArgument("malformed shm segment");
+    }
+    if (!err.ok()) {
+      ::munmap(base, size);
+      return err;
+    }
+    base_ = base;
+    size_ = size;
+    header_ = header;
+    slots_ = reinterpret_cast<const ShmSlot*>(static_cast<const char*>(base) + sizeof(ShmHeader));
+    return Status::Ok();
+  }
+
+  void close() {
+    if (base_) ::munmap(base_, size_);
+    base_ = nullptr;
+    size_ = 0;
+    header_ = nullptr;
+    slots_ = nullptr;
+  }
+
+  bool is_open() const { return header_ != nullptr; }
+  std::uint32_t capacity() const { return header_ ? header_->capacity : 0; }
+  std::uint32_t writer_pid() const { return header_ ? header_->writer_pid : 0; }
+  // Samples published since the segment was created.
+  std::uint64_t published() const { return header_ ? header_->published.load(std::memory_order_acquire) : 0; }
+
+  // Copies the newest sample. False if none has been published yet (or, in theory, if the
+  // writer kept lapping the reader for kMaxAttempts tries).
+  bool latest(ShmSample& out) const {
+    for (int attempt = 0; attempt < kMaxAttempts; ++attempt) {
+      const std::uint64_t n = published();
+      if (n == 0) return false;
+      if (read_slot(slots_[(n - 1) % header_->capacity], out) && out.index == n - 1) return true;
+    }
+    return false;
+  }
+
+  // Copies up to `max` of the newest samples into `out`, oldest first, and returns how many.
+  // The slot the writer may be filling next is never read, so at most capacity() - 1 come back;
+  // samples overwritten during the call are skipped.
+  std::size_t history(ShmSample* out, std::size_t max) const {
+    if (!header_ || header_->capacity < 2) return 0;
+    const std::uint64_t n = published();
+    const std::uint64_t want = std::min<std::uint64_t>({max, n, header_->capacity - 1U});
+    std::size_t got = 0;
+    for (std::uint64_t i = n - want; i < n; ++i) {
+      const ShmSlot& slot = slots_[i % header_->capacity];
+      for (int attempt = 0; attempt < kMaxAttempts; ++attempt) {
+        if (!read_slot(slot, out[got])) continue;
+        if (out[got].index == i) ++got;
+        break;
+      }
+    }
+    return got;
+  }
+
+ private:
+  static constexpr int kMaxAttempts = 64;
+
+  void* base_{nullptr};
+  std::size_t size_{0};
+  const ShmHeader* header_{nullptr};
+  const ShmSlot* slots_{nullptr};
+};
+
+}  // namespace telemetry::shm
+
+#endif  // !_WIN32
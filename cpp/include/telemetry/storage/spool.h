@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "telemetry/metrics_snapshot.h"
+#include "telemetry/status.h"
+
+namespace telemetry::storage {
+
+// Append-only on-disk spool of snapshots for store-and-forward.
+//
+// The spool is a sequence of segment files named after the cursor of their first byte
+// (`<20-digit cursor>.tlog`). A cursor is a byte offset into the logical log, so it stays
+// valid across segment rotation and retention. Each record is:
+//
+//   u32 LE  payload length
+//   u32 LE  CRC-32 of payload
+//   bytes   payload (codec::encode_snapshot)
+//
+// Appends are buffered in memory and written once `flush_bytes` accumulate or
+// `flush_interval_ms` elapses; fsync is issued at most once per flush interval and on
+// rotation. Oldest segments are deleted once the total size exceeds `budget_bytes`.
+// The `now_ms` arguments are monotonic, so wall-clock steps neither delay nor bunch flushes.
+struct SpoolConfig final {
+  const char* dir = nullptr;
+  std::uint64_t segment_bytes = 4ULL * 1024ULL * 1024ULL;
+  std::uint64_t budget_bytes = 64ULL * 1024ULL * 1024ULL;
+  std::uint32_t flush_bytes = 16U * 1024U;
+  std::uint32_t flush_interval_ms = 1000;
+};
+
+constexpr std::size_t kSpoolRecordHeaderSize = 8;
+
+// Parses a segment file name, `<20-digit cursor>.tlog`, into the segment's base cursor;
+// false for anything else.
+bool parse_segment_name(const char* name, std::uint64_t& base);
+
+// Walks the records of one segment held in memory, front to back. The walk ends at the
+// end of the data or at the first record that is torn, oversized or fails its CRC, which
+// is where a crash mid-append leaves off.
+class SpoolRecordReader final {
+ public:
+  SpoolRecordReader(const std::uint8_t* data, std::size_t size) : data_(data), size_(size) {}
+
+  // Points `payload` at the next record's payload, in place; false once the walk has ended.
+  bool next(const std::uint8_t*& payload, std::uint32_t& len);
+
+  // Bytes of valid records so far: the whole segment unless it ends in a bad record.
+  std::size_t offset() const { return off_; }
+
+ private:
+  const std::uint8_t* data_;
+  std::size_t size_;
+  std::size_t off_{0};
+};
+
+// A contiguous byte range of one segment, ready to be streamed with sendfile().
+// `fd` is owned by the caller and stays readable even if retention deletes the segment.
+struct DrainRange final {
+  int fd{-1};
+  std::uint64_t file_offset{0};
+  std::uint64_t length{0};
+  std::uint64_t from_cursor{0};
+  std::uint64_t next_cursor{0};
+};
+
+class Spool final {
+ public:
+  explicit Spool(SpoolConfig cfg);
+  ~Spool();
+
+  Spool(const Spool&) = delete;
+  Spool& operator=(const Spool&) = delete;
+
+  // Scans `dir`, validates the tail segment and truncates a torn final record.
+  Status open();
+
+  Status append(const MetricsSnapshot& snap, Status collect_status, std::uint64_t now_ms);
+
+  // Writes buffered records; with `sync` also fsyncs the active segment.
+  Status flush(bool sync);
+
+  // Time-based flush; call from the event loop.
+  Status maybe_flush(std::uint64_t now_ms);
+
+  // Milliseconds until maybe_flush() has work to do (UINT32_MAX if nothing is pending).
+  std::uint32_t ms_until_flush(std::uint64_t now_ms) const;
+
+  // Flushes pending appends and resolves `cursor` to the rest of its segment. A cursor
+  // older than retention starts at the oldest segment, one inside a record at the next
+  // record; a cursor at or past the tail yields an empty range (fd == -1).
+  Status drain_range(std::uint64_t cursor, DrainRange& out);
+
+  std::uint64_t head_cursor() const;
+  std::uint64_t tail_cursor() const { return tail_cursor_; }
+  std::uint64_t disk_bytes() const { return disk_bytes_; }
+
+ private:
+  struct Segment final {
+    std::uint64_t base{0};
+    std::uint64_t size{0};
+  };
+
+  std::string segment_path(std::uint64_t base) const;
+  Status open_active(std::uint64_t base, bool create);
+  Status recover_tail(Segment& seg);
+  Status rotate();
+  void enforce_budget();
+
+  SpoolConfig cfg_;
+  std::string dir_;
+  std::vector<Segment> segments_;
+  int active_fd_{-1};
+  std::vector<std::uint8_t> pending_;
+  std::uint64_t tail_cursor_{0};
+  std::uint64_t disk_bytes_{0};
+  std::uint64_t last_flush_ms_{0};
+  bool dirty_{false};
+};
+
+}  // namespace telemetry::storage
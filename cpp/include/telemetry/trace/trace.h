@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "telemetry/status.h"
+#include "telemetry/util/time.h"
+
+namespace telemetry::trace {
+
+// Low-overhead span tracing for the event loop and collectors.
+//
+// Each thread records complete spans into its own fixed-size ring (single writer, no locks;
+// the oldest events are overwritten, and a wrapped ring dumps its newest kRingEvents - 1).
+// A dump copies every ring without stopping the writers and renders Chrome trace-event
+// JSON, loadable in Perfetto or chrome://tracing. While disabled, a span costs one relaxed
+// load and a branch.
+constexpr std::size_t kRingEvents = 4096;
+
+extern std::atomic<bool> g_enabled;
+
+inline bool enabled() { return g_enabled.load(std::memory_order_relaxed); }
+inline void set_enabled(bool on) { g_enabled.store(on, std::memory_order_relaxed); }
+
+// Appends one span to the calling thread's ring, allocating it on first use. `name` must
+// outlive the process's last dump (string literals, MetricSource::name()).
+void record(const char* name, std::uint64_t start_ns, std::uint64_t dur_ns, std::uint64_t arg);
+
+// Labels the calling thread in dumps (static string).
+void set_thread_name(const char* name);
+
+// Drops everything recorded so far.
+void clear();
+
+// Renders all rings as {"traceEvents":[...]} into `out` (replacing it); returns the event count.
+// Safe while other threads record: slots overwritten during the copy are left out.
+std::size_t write_chrome_json(std::string& out);
+
+Status dump_to_file(const char* path, std::size_t* events);
+
+#ifndef _WIN32
+// Makes `signo` (e.g. SIGUSR1) request a dump to `path`; the handler only sets a flag.
+Status install_dump_signal(int signo, const char* path);
+// Called by the event loop once per pass; writes the file if the signal fired.
+void service_dump_signal();
+// The handler also writes a byte to `fd` (a non-blocking pipe), so an event loop sleeping
+// without a timeout notices the request; -1 disables.
+void set_dump_wake_fd(int fd);
+#endif
+
+// Records [construction, destruction) as one span when tracing is enabled.
+class Span final {
+ public:
+  explicit Span(const char* name, std::uint64_t arg = 0) : name_(enabled() ? name : nullptr), arg_(arg) {
+    if (name_) start_ns_ = util::monotonic_ns();
+  }
+  ~Span() {
+    if (name_) record(name_, start_ns_, util::monotonic_ns() - start_ns_, arg_);
+  }
+  Span(const Span&) = delete;
+  Span& operator=(const Span&) = delete;
+
+  // Shown as args.n in the trace (bytes moved, fds ready, ...).
+  void set_arg(std::uint64_t arg) { arg_ = arg; }
+
+ private:
+  const char* name_;
+  std::uint64_t arg_;
+  std::uint64_t start_ns_{0};
+};
+
+}  // namespace telemetry::trace
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace telemetry::util {
+
+// Exponential reconnect backoff with full jitter: attempt k waits a uniform delay in
+// [min_ms, min(max_ms, min_ms * 2^k)], which spreads out reconnect storms after an outage.
+class JitteredBackoff final {
+ public:
+  JitteredBackoff(std::uint32_t min_ms, std::uint32_t max_ms, std::uint64_t seed)
+      : min_ms_(min_ms), max_ms_(std::max(min_ms, max_ms)), state_(seed ? seed : 0x9E3779B97F4A7C15ULL) {}
+
+  std::uint32_t delay_ms(std::uint32_t attempt) {
+    // xorshift64*: cheap and plenty random for de-synchronizing peers.
+    state_ ^= state_ >> 12;
+    state_ ^= state_ << 25;
+    state_ ^= state_ >> 27;
+    const std::uint64_t r = state_ * 0x2545F4914F6CDD1DULL;
+
+    const std::uint64_t lo = min_ms_;
+    const std::uint64_t hi =
+        std::max<std::uint64_t>(lo, std::min<std::uint64_t>(max_ms_, lo << std::min<std::uint32_t>(attempt, 20U)));
+    return static_cast<std::uint32_t>(lo + (r >> 11) % (hi - lo + 1));
+  }
+
+ private:
+  std::uint32_t min_ms_;
+  std::uint32_t max_ms_;
+  std::uint64_t state_;
+};
+
+}  // namespace telemetry::util
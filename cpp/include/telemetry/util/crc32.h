@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace telemetry::util {
+
+// CRC-32 (IEEE 802.3, reflected, poly 0xEDB88320). Pass the previous return value as `seed`
+// to checksum data incrementally.
+std::uint32_t crc32(const void* data, std::size_t len, std::uint32_t seed = 0);
+
+}  // namespace telemetry::util
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace telemetry::util {
+
+// HDR-style log-linear histogram of non-negative integer values (latencies in ns).
+//
+// Values below 256 are counted exactly; above that each power of two is split into 128
+// linear sub-buckets, so any recorded value is reported within 0.8% of its true value.
+// Values up to 2^40 (about 18 minutes in ns) are tracked; larger ones clamp to the top
+// bucket. Recording is a shift and an increment with no allocation after construction.
+class LatencyHistogram final {
+ public:
+  static constexpr int kSubBucketBits = 8;
+  static constexpr int kMaxValueBits = 40;
+
+  LatencyHistogram() : counts_(bucket_count(), 0) {}
+
+  void record(std::uint64_t v) {
+    ++counts_[index_of(v)];
+    ++count_;
+    sum_ += v;
+    min_ = std::min(min_, v);
+    max_ = std::max(max_, v);
+  }
+
+  void merge(const LatencyHistogram& other) {
+    for (std::size_t i = 0; i < counts_.size(); ++i) counts_[i] += other.counts_[i];
+    count_ += other.count_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+  }
+
+  void reset() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    count_ = 0;
+    sum_ = 0;
+    min_ = UINT64_MAX;
+    max_ = 0;
+  }
+
+  std::uint64_t count() const { return count_; }
+  std::uint64_t min() const { return count_ ? min_ : 0; }
+  std::uint64_t max() const { return max_; }
+  double mean() const { return count_ ? static_cast<double>(sum_) / static_cast<double>(count_) : 0.0; }
+
+  // Smallest bucket upper bound covering `pct` percent of recorded values (capped at max()).
+  std::uint64_t value_at_percentile(double pct) const {
+    if (count_ == 0) return 0;
+    if (pct >= 100.0) return max_;
+    std::uint64_t target = static_cast<std::uint64_t>(pct / 100.0 * static_cast<double>(count_) + 0.5);
+    if (target == 0) target = 1;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < counts_.size(); ++i) {
+      seen += counts_[i];
+      if (seen >= target) return std::min(upper_bound_of(i), max_);
+    }
+    return max_;
+  }
+
+ private:
+  static constexpr std::uint64_t kSub = 1ULL << kSubBucketBits;
+  static constexpr std::uint64_t kHalf = kSub / 2;
+
+  static constexpr std::size_t bucket_count() {
+    return static_cast<std::size_t>((kMaxValueBits - kSubBucketBits + 2) * kHalf + kHalf);
+  }
+
+  // [0, kSub) map to themselves; above that, exponent e and mantissa m in [kHalf, kSub)
+  // give index e * kHalf + m, which continues contiguously from kSub.
+  static std::size_t index_of(std::uint64_t v) {
+    if (v >= (1ULL << kMaxValueBits)) v = (1ULL << kMaxValueBits) - 1;
+    if (v < kSub) return static_cast<std::size_t>(v);
+    const int msb = 63 - std::countl_zero(v);
+    const int e = msb - kSubBucketBits + 1;
+    return static_cast<std::size_t>(static_cast<std::uint64_t>(e) * kHalf + (v >> e));
+  }
+
+  static std::uint64_t upper_bound_of(std::size_t idx) {
+    if (idx < kSub) return idx;
+    const std::uint64_t e = idx / kHalf - 1;
+    const std::uint64_t m = idx - e * kHalf;
+    return ((m + 1) << e) - 1;
+  }
+
+  std::vector<std::uint64_t> counts_;
+  std::uint64_t count_{0};
+  std::uint64_t sum_{0};
+  std::uint64_t min_{UINT64_MAX};
+  std::uint64_t max_{0};
+};
+
+}  // namespace telemetry::util
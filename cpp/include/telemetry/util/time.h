@@ -6,6 +6,10 @@ namespace telemetry::util {
 
 std::uint64_t unix_time_ms();
 
+// Monotonic clock for measuring intervals; unrelated to wall time.
+std::uint64_t monotonic_ns();
+std::uint64_t monotonic_ms();
+
 }  // namespace telemetry::util
 
 
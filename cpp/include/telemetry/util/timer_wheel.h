@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+
+namespace telemetry::util {
+
+struct TimerLink {
+  TimerLink* prev{nullptr};
+  TimerLink* next{nullptr};
+};
+
+// Intrusive timer owned by the caller; a TimerWheel links it while armed, so scheduling
+// never allocates. Must not be copied, moved or destroyed while armed.
+class WheelTimer final : private TimerLink {
+ public:
+  WheelTimer() = default;
+  WheelTimer(const WheelTimer&) = delete;
+  WheelTimer& operator=(const WheelTimer&) = delete;
+
+  bool armed() const { return next != nullptr; }
+  std::uint64_t due_ms() const { return due_ms_; }
+
+  // Free for the owner, e.g. to tell timers apart in the expiry callback.
+  std::uint32_t tag{0};
+
+ private:
+  friend class TimerWheel;
+  std::uint64_t due_ms_{0};
+  std::uint8_t level_{0};
+  std::uint8_t slot_{0};
+};
+
+// Hierarchical timing wheel with 1 ms ticks: kLevels levels of 64 slots, each level 64 times
+// coarser than the one below. A timer sits at the level of the highest base-64 digit in
+// which its due time differs from the wheel's clock and is moved down ("cascaded") when the
+// clock reaches its slot, so schedule() and cancel() are O(1). A bitmap per level finds the
+// next occupied slot without scanning, so next_due_ms() is O(kLevels) and an idle wheel is
+// skipped over in one step however far the clock moves. Timers due more than kMaxDelayMs
+// (about two years) ahead are parked at that horizon and re-placed as the clock gets there.
+//
+// Single-threaded; the caller supplies the (monotonic) clock.
+class TimerWheel final {
+ public:
+  static constexpr int kSlotBits = 6;
+  static constexpr int kSlots = 1 << kSlotBits;
+  static constexpr int kLevels = 6;
+  // The top level may wrap into its next rotation, up to one slot short of a full turn.
+  static constexpr std::uint64_t kMaxDelayMs = std::uint64_t{kSlots - 1} << (kSlotBits * (kLevels - 1));
+
+  explicit TimerWheel(std::uint64_t now_ms = 0) {
+    for (auto& level : slots_) {
+      for (TimerLink& head : level) head.prev = head.next = &head;
+    }
+    now_ = now_ms;
+  }
+
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  ~TimerWheel() { reset(now_); }
+
+  // Disarms every timer and restarts the clock at `now_ms`.
+  void reset(std::uint64_t now_ms) {
+    for (auto& level : slots_) {
+      for (TimerLink& head : level) {
+        while (head.next != &head) unlink(*head.next);
+      }
+    }
+    occupied_.fill(0);
+    count_ = 0;
+    now_ = now_ms;
+  }
+
+  std::uint64_t now_ms() const { return now_; }
+  std::size_t size() const { return count_; }
+
+  // (Re)arms `t` to fire at `due_ms`; a time already past fires on the next advance().
+  void schedule(WheelTimer& t, std::uint64_t due_ms) {
+    cancel(t);
+    t.due_ms_ = std::max(due_ms, now_);
+    insert(t);
+  }
+
+  void cancel(WheelTimer& t) {
+    if (!t.armed()) return;
+    unlink(t);
+    --count_;
+    TimerLink& head = slots_[t.level_][t.slot_];
+    if (head.next == &head) occupied_[t.level_] &= ~(std::uint64_t{1} << t.slot_);
+  }
+
+  // Lower bound on the earliest due time, exact when that timer is in the finest level.
+  // Waking at a coarser bound only cascades timers and computes a new bound.
+  bool next_due_ms(std::uint64_t& out) const {
+    Expiry e{};
+    if (!next_expiry(e)) return false;
+    out = e.at;
+    return true;
+  }
+
+  // poll() timeout from `now_ms` to the next due timer: -1 when none is armed.
+  int poll_timeout_ms(std::uint64_t now_ms) const {
+    std::uint64_t due = 0;
+    if (!next_due_ms(due)) return -1;
+    if (due <= now_ms) return 0;
+    return static_cast<int>(std::min<std::uint64_t>(due - now_ms, INT_MAX));
+  }
+
+  // Moves the clock to `now_ms` and calls on_expire(WheelTimer&) for each due timer, which is
+  // disarmed first so the callback may re-arm it or schedule and cancel others. Returns the
+  // number of timers fired.
+  template <typename F>
+  std::size_t advance(std::uint64_t now_ms, F&& on_expire) {
+    std::size_t fired = 0;
+    Expiry e{};
+    while (next_expiry(e) && e.at <= now_ms) {
+      now_ = e.at;
+      TimerLink& head = slots_[e.level][e.slot];
+      TimerLink pending;
+      pending.next = head.next;
+      pending.prev = head.prev;
+      pending.next->prev = &pending;
+      pending.prev->next = &pending;
+      head.prev = head.next = &head;
+      occupied_[e.level] &= ~(std::uint64_t{1} << e.slot);
+
+      while (pending.next != &pending) {
+        WheelTimer& t = *static_cast<WheelTimer*>(pending.next);
+        unlink(t);
+        --count_;
+        if (t.due_ms_ <= now_) {
+          ++fired;
+          on_expire(t);
+        } else {
+          insert(t);
+        }
+      }
+    }
+    now_ = std::max(now_, now_ms);
+    return fired;
+  }
+
+ private:
+  struct Expiry final {
+    int level{0};
+    int slot{0};
+    std::uint64_t at{0};
+  };
+
+  static int level_for(std::uint64_t now, std::uint64_t when) {
+    const std::uint64_t masked = (now ^ when) | (kSlots - 1);
+    const int significant = 63 - std::countl_zero(masked);
+    return std::min(significant / kSlotBits, kLevels - 1);
+  }
+
+  void insert(WheelTimer& t) {
+    const std::uint64_t when = t.due_ms_ - now_ > kMaxDelayMs ? now_ + kMaxDelayMs : t.due_ms_;
+    const int level = level_for(now_, when);
+    const int slot = static_cast<int>((when >> (level * kSlotBits)) & (kSlots - 1));
+    TimerLink& head = slots_[level][slot];
+    t.prev = head.prev;
+    t.next = &head;
+    head.prev->next = &t;
+    head.prev = &t;
+    t.level_ = static_cast<std::uint8_t>(level);
+    t.slot_ = static_cast<std::uint8_t>(slot);
+    occupied_[level] |= std::uint64_t{1} << slot;
+    ++count_;
+  }
+
+  static void unlink(TimerLink& l) {
+    l.prev->next = l.next;
+    l.next->prev = l.prev;
+    l.prev = l.next = nullptr;
+  }
+
+  // Lower levels only hold timers due before anything in higher levels. Within a level every
+  // timer is in or after the clock's current slot; only the top level wraps past its end.
+  bool next_expiry(Expiry& e) const {
+    for (int level = 0; level < kLevels; ++level) {
+      if (occupied_[level] == 0) continue;
+      const int shift = level * kSlotBits;
+      const int cur = static_cast<int>((now_ >> shift) & (kSlots - 1));
+      const int ahead = std::countr_zero(std::rotr(occupied_[level], cur));
+      const std::uint64_t span = std::uint64_t{1} << (shift + kSlotBits);
+      e.level = level;
+      e.slot = (cur + ahead) & (kSlots - 1);
+      e.at = (now_ & ~(span - 1)) + (static_cast<std::uint64_t>(cur + ahead) << shift);
+      return true;
+    }
+    return false;
+  }
+
+  std::array<std::array<TimerLink, kSlots>, kLevels> slots_;
+  std::array<std::uint64_t, kLevels> occupied_{};
+  std::size_t count_{0};
+  std::uint64_t now_{0};
+};
+
+}  // namespace telemetry::util
@@ -0,0 +1,129 @@
+#include "telemetry/codec/batch_codec.h"
+
+#include <cmath>
+
+#include "telemetry/codec/snapshot_codec.h"
+#include "telemetry/util/crc32.h"
+
+namespace telemetry::codec {
+
+namespace {
+
+constexpr std::size_t kFields = 6;
+
+static void fields_of(const MetricsSnapshot& s, std::int64_t (&f)[kFields]) {
+  f[0] = static_cast<std::int64_t>(s.ts_ms);
+  f[1] = static_cast<std::int64_t>(std::llround(s.cpu_usage_pct * 100.0));
+  f[2] = static_cast<std::int64_t>(s.mem_total_kb);
+  f[3] = static_cast<std::int64_t>(s.mem_available_kb);
+  f[4] = static_cast<std::int64_t>(std::llround(s.temperature_c * 100.0));
+  f[5] = static_cast<std::int64_t>(s.uptime_s);
+}
+
+static void snapshot_of(const std::int64_t (&f)[kFields], MetricsSnapshot& s) {
+  s.ts_ms = static_cast<std::uint64_t>(f[0]);
+  s.cpu_usage_pct = static_cast<double>(f[1]) / 100.0;
+  s.mem_total_kb = static_cast<std::uint64_t>(f[2]);
+  s.mem_available_kb = static_cast<std::uint64_t>(f[3]);
+  s.temperature_c = static_cast<double>(f[4]) / 100.0;
+  s.uptime_s = static_cast<std::uint64_t>(f[5]);
+}
+
+static void append_varint(std::vector<std::uint8_t>& out, std::uint64_t v) {
+  std::uint8_t tmp[10];
+  const std::size_t n = put_varint(v, tmp, sizeof(tmp));
+  out.insert(out.end(), tmp, tmp + n);
+}
+
+static void put_u32le(std::uint8_t* p, std::uint32_t v) {
+  p[0] = static_cast<std::uint8_t>(v);
+  p[1] = static_cast<std::uint8_t>(v >> 8);
+  p[2] = static_cast<std::uint8_t>(v >> 16);
+  p[3] = static_cast<std::uint8_t>(v >> 24);
+}
+
+static std::uint32_t get_u32le(const std::uint8_t* p) {
+  return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+         (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+}  // namespace
+
+std::size_t encode_batch(std::uint64_t seq, std::string_view agent_id, const BatchSample* samples, std::size_t count,
+                         std::vector<std::uint8_t>& out) {
+  const std::size_t frame_start = out.size();
+  out.resize(frame_start + kBatchFrameHeaderSize);
+  const std::size_t payload_start = out.size();
+
+  out.push_back(kBatchCodecVersion);
+  append_varint(out, seq);
+  append_varint(out, agent_id.size());
+  out.insert(out.end(), agent_id.begin(), agent_id.end());
+  append_varint(out, count);
+
+  std::int64_t prev[kFields] = {};
+  for (std::size_t i = 0; i < count; ++i) {
+    std::int64_t cur[kFields];
+    fields_of(samples[i].snap, cur);
+    out.push_back(static_cast<std::uint8_t>(samples[i].status));
+    for (std::size_t k = 0; k < kFields; ++k) {
+      append_varint(out, zigzag_encode(static_cast<std::int64_t>(static_cast<std::uint64_t>(cur[k]) -
+                                                                 static_cast<std::uint64_t>(prev[k]))));
+      prev[k] = cur[k];
+    }
+  }
+
+  const std::size_t payload_len = out.size() - payload_start;
+  put_u32le(out.data() + frame_start, static_cast<std::uint32_t>(payload_len));
+  put_u32le(out.data() + frame_start + 4, util::crc32(out.data() + payload_start, payload_len));
+  return out.size() - frame_start;
+}
+
+Status peek_batch_frame(const std::uint8_t* data, std::size_t len, std::size_t& frame_len) {
+  if (len < kBatchFrameHeaderSize) return Status::Unavailable("need more bytes");
+  const std::uint32_t payload_len = get_u32le(data);
+  if (payload_len == 0 || payload_len > kMaxBatchPayload) return Status::InvalidArgument("bad batch length");
+  if (len < kBatchFrameHeaderSize + payload_len) return Status::Unavailable("need more bytes");
+  frame_len = kBatchFrameHeaderSize + payload_len;
+  return Status::Ok();
+}
+
+Status decode_batch(const std::uint8_t* frame, std::size_t frame_len, std::uint64_t& seq, std::string_view& agent_id,
+                    std::vector<BatchSample>& samples) {
+  if (frame_len < kBatchFrameHeaderSize) return Status::InvalidArgument("batch truncated");
+  const std::uint8_t* p = frame + kBatchFrameHeaderSize;
+  const std::uint8_t* end = frame + frame_len;
+  if (get_u32le(frame) != frame_len - kBatchFrameHeaderSize) return Status::InvalidArgument("batch length mismatch");
+  if (util::crc32(p, static_cast<std::size_t>(end - p)) != get_u32le(frame + 4)) {
+    return Status::InvalidArgument("batch crc mismatch");
+  }
+
+  if (p >= end || *p++ != kBatchCodecVersion) return Status::InvalidArgument("unsupported batch version");
+  std::uint64_t id_len = 0;
+  std::uint64_t count = 0;
+  if (!get_varint(p, end, seq) || !get_varint(p, end, id_len)) return Status::InvalidArgument("batch truncated");
+  if (id_len > static_cast<std::uint64_t>(end - p)) return Status::InvalidArgument("batch truncated");
+  agent_id = std::string_view(reinterpret_cast<const char*>(p), static_cast<std::size_t>(id_len));
+  p += id_len;
+  if (!get_varint(p, end, count)) return Status::InvalidArgument("batch truncated");
+  // Every sample takes at least 1 + kFields bytes, which bounds `count` before resize().
+  if (count > static_cast<std::uint64_t>(end - p) / (1 + kFields)) return Status::InvalidArgument("batch truncated");
+
+  samples.resize(static_cast<std::size_t>(count));
+  std::int64_t prev[kFields] = {};
+  for (auto& s : samples) {
+    if (p >= end) return Status::InvalidArgument("batch truncated");
+    s.status = static_cast<StatusCode>(*p++);
+    for (std::size_t k = 0; k < kFields; ++k) {
+      std::uint64_t v = 0;
+      if (!get_varint(p, end, v)) return Status::InvalidArgument("batch truncated");
+      prev[k] = static_cast<std::int64_t>(static_cast<std::uint64_t>(prev[k]) +
+                                          static_cast<std::uint64_t>(zigzag_decode(v)));
+    }
+    snapshot_of(prev, s.snap);
+  }
+  if (p != end) return Status::InvalidArgument("trailing batch bytes");
+  return Status::Ok();
+}
+
+}  // namespace telemetry::codec
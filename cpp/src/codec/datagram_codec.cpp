@@ -0,0 +1,50 @@
+#include "telemetry/codec/datagram_codec.h"
+
+#include <cstring>
+
+namespace telemetry::codec {
+
+std::size_t encode_datagram(std::uint64_t seq, std::string_view host_id, const MetricsSnapshot& snap,
+                            StatusCode collect_status, std::uint8_t* out, std::size_t cap) {
+  if (host_id.size() > kMaxDatagramHostId) host_id = host_id.substr(0, kMaxDatagramHostId);
+  if (cap < 5) return 0;
+  out[0] = static_cast<std::uint8_t>(kDatagramMagic);
+  out[1] = static_cast<std::uint8_t>(kDatagramMagic >> 8);
+  out[2] = static_cast<std::uint8_t>(kDatagramMagic >> 16);
+  out[3] = static_cast<std::uint8_t>(kDatagramMagic >> 24);
+  out[4] = kDatagramCodecVersion;
+  std::size_t n = 5;
+
+  for (std::uint64_t v : {seq, static_cast<std::uint64_t>(host_id.size())}) {
+    const std::size_t w = put_varint(v, out + n, cap - n);
+    if (w == 0) return 0;
+    n += w;
+  }
+  if (cap - n < host_id.size()) return 0;
+  if (!host_id.empty()) std::memcpy(out + n, host_id.data(), host_id.size());
+  n += host_id.size();
+
+  const std::size_t w = encode_snapshot(snap, collect_status, out + n, cap - n);
+  return w == 0 ? 0 : n + w;
+}
+
+Status decode_datagram(const std::uint8_t* data, std::size_t len, SnapshotDatagram& out) {
+  if (len < 5) return Status::InvalidArgument("datagram truncated");
+  const std::uint32_t magic = static_cast<std::uint32_t>(data[0]) | (static_cast<std::uint32_t>(data[1]) << 8) |
+                              (static_cast<std::uint32_t>(data[2]) << 16) | (static_cast<std::uint32_t>(data[3]) << 24);
+  if (magic != kDatagramMagic) return Status::InvalidArgument("not a telemetry datagram");
+  if (data[4] != kDatagramCodecVersion) return Status::InvalidArgument("unsupported datagram version");
+
+  const std::uint8_t* p = data + 5;
+  const std::uint8_t* end = data + len;
+  std::uint64_t id_len = 0;
+  if (!get_varint(p, end, out.seq) || !get_varint(p, end, id_len)) return Status::InvalidArgument("datagram truncated");
+  if (id_len > kMaxDatagramHostId || id_len > static_cast<std::uint64_t>(end - p)) {
+    return Status::InvalidArgument("bad datagram host id");
+  }
+  out.host_id = std::string_view(reinterpret_cast<const char*>(p), static_cast<std::size_t>(id_len));
+  p += id_len;
+  return decode_snapshot(p, static_cast<std::size_t>(end - p), out.snap, &out.status);
+}
+
+}  // namespace telemetry::codec
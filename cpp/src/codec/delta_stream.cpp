@@ -0,0 +1,91 @@
+#include "telemetry/codec/delta_stream.h"
+
+#include <cmath>
+#include <cstdio>
+
+namespace telemetry::codec {
+
+namespace {
+
+enum Field : int {
+  kStatusCode = 0,
+  kCpuUsagePct,
+  kMemTotalKb,
+  kMemAvailableKb,
+  kTemperatureC,
+  kUptimeS,
+};
+
+struct FieldSpec final {
+  const char* name;
+  bool fractional;  // rendered with two decimals, else as an integer
+  bool exact;       // any change is sent regardless of the deadband
+};
+
+constexpr FieldSpec kSpecs[] = {
+    {"status_code", false, true},     {"cpu_usage_pct", true, false}, {"mem_total_kb", false, false},
+    {"mem_available_kb", false, false}, {"temperature_c", true, false}, {"uptime_s", false, false},
+};
+
+}  // namespace
+
+bool DeltaStream::update(const MetricsSnapshot& snap, Status collect_status, std::string& out) {
+  const double cur[kFields] = {
+      static_cast<double>(collect_status.code),     snap.cpu_usage_pct,  static_cast<double>(snap.mem_total_kb),
+      static_cast<double>(snap.mem_available_kb), snap.temperature_c, static_cast<double>(snap.uptime_s),
+  };
+  ts_ms_ = snap.ts_ms;
+
+  const bool key = !has_state_ || ++since_key_ >= cfg_.keyframe_every;
+  bool changed[kFields]{};
+  bool any = key;
+  for (int i = 0; i < kFields; ++i) {
+    if (key) {
+      changed[i] = true;
+    } else {
+      const double delta = std::fabs(cur[i] - sent_[i]);
+      const double band = kSpecs[i].exact ? 0.0 : std::fmax(cfg_.abs, cfg_.rel * std::fabs(sent_[i]));
+      changed[i] = delta > band;
+    }
+    if (changed[i]) {
+      sent_[i] = cur[i];
+      any = true;
+    }
+  }
+  if (key) {
+    has_state_ = true;
+    since_key_ = 0;
+  }
+
+  out.clear();
+  if (!any) return false;
+  render(key, changed, out);
+  return true;
+}
+
+bool DeltaStream::keyframe(std::string& out) const {
+  out.clear();
+  if (!has_state_) return false;
+  const bool all[kFields] = {true, true, true, true, true, true};
+  render(true, all, out);
+  return true;
+}
+
+void DeltaStream::render(bool key, const bool* changed, std::string& out) const {
+  char buf[64];
+  int n = std::snprintf(buf, sizeof(buf), "{%s\"ts_ms\":%llu", key ? "\"key\":true," : "",
+                        static_cast<unsigned long long>(ts_ms_));
+  out.append(buf, static_cast<std::size_t>(n));
+  for (int i = 0; i < kFields; ++i) {
+    if (!changed[i]) continue;
+    if (kSpecs[i].fractional) {
+      n = std::snprintf(buf, sizeof(buf), ",\"%s\":%.2f", kSpecs[i].name, sent_[i]);
+    } else {
+      n = std::snprintf(buf, sizeof(buf), ",\"%s\":%llu", kSpecs[i].name, static_cast<unsigned long long>(sent_[i]));
+    }
+    out.append(buf, static_cast<std::size_t>(n));
+  }
+  out.append("}\n");
+}
+
+}  // namespace telemetry::codec
@@ -0,0 +1,86 @@
+#include "telemetry/codec/snapshot_codec.h"
+
+#include <cmath>
+
+namespace telemetry::codec {
+
+namespace {
+
+static std::int64_t to_centi(double v) { return static_cast<std::int64_t>(std::llround(v * 100.0)); }
+
+}  // namespace
+
+std::size_t put_varint(std::uint64_t v, std::uint8_t* out, std::size_t cap) {
+  std::size_t n = 0;
+  while (true) {
+    if (n >= cap) return 0;
+    const std::uint8_t b = static_cast<std::uint8_t>(v & 0x7FU);
+    v >>= 7;
+    if (v == 0) {
+      out[n++] = b;
+      return n;
+    }
+    out[n++] = static_cast<std::uint8_t>(b | 0x80U);
+  }
+}
+
+bool get_varint(const std::uint8_t*& p, const std::uint8_t* end, std::uint64_t& out) {
+  std::uint64_t v = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (p >= end) return false;
+    const std::uint8_t b = *p++;
+    v |= static_cast<std::uint64_t>(b & 0x7FU) << shift;
+    if ((b & 0x80U) == 0) {
+      out = v;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::size_t encode_snapshot(const MetricsSnapshot& snap, StatusCode collect_status, std::uint8_t* out, std::size_t cap) {
+  if (cap < 2) return 0;
+  out[0] = kSnapshotCodecVersion;
+  out[1] = static_cast<std::uint8_t>(collect_status);
+  std::size_t n = 2;
+
+  const std::int64_t cpu = to_centi(snap.cpu_usage_pct);
+  const std::uint64_t fields[] = {
+      snap.ts_ms,
+      static_cast<std::uint64_t>(cpu < 0 ? 0 : cpu),
+      snap.mem_total_kb,
+      snap.mem_available_kb,
+      zigzag_encode(to_centi(snap.temperature_c)),
+      snap.uptime_s,
+  };
+  for (std::uint64_t f : fields) {
+    const std::size_t w = put_varint(f, out + n, cap - n);
+    if (w == 0) return 0;
+    n += w;
+  }
+  return n;
+}
+
+Status decode_snapshot(const std::uint8_t* data, std::size_t len, MetricsSnapshot& out, StatusCode* collect_status) {
+  if (len < 2) return Status::InvalidArgument("snapshot truncated");
+  if (data[0] != kSnapshotCodecVersion) return Status::InvalidArgument("unsupported snapshot version");
+
+  const std::uint8_t* p = data + 2;
+  const std::uint8_t* end = data + len;
+  std::uint64_t f[6] = {};
+  for (auto& v : f) {
+    if (!get_varint(p, end, v)) return Status::InvalidArgument("snapshot truncated");
+  }
+  if (p != end) return Status::InvalidArgument("trailing snapshot bytes");
+
+  if (collect_status) *collect_status = static_cast<StatusCode>(data[1]);
+  out.ts_ms = f[0];
+  out.cpu_usage_pct = static_cast<double>(f[1]) / 100.0;
+  out.mem_total_kb = f[2];
+  out.mem_available_kb = f[3];
+  out.temperature_c = static_cast<double>(zigzag_decode(f[4])) / 100.0;
+  out.uptime_s = f[5];
+  return Status::Ok();
+}
+
+}  // namespace telemetry::codec
@@ -0,0 +1,151 @@
+#include "telemetry/exporter/batch_receiver.h"
+
+#ifndef _WIN32
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string_view>
+
+namespace telemetry::exporter {
+
+namespace {
+
+static bool set_nonblocking(int fd) {
+  const int flags = fcntl(fd, F_GETFL, 0);
+  if (flags < 0) return false;
+  return fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+}  // namespace
+
+BatchReceiver::BatchReceiver(std::uint16_t port) : port_(port) {}
+
+BatchReceiver::~BatchReceiver() { stop(); }
+
+Status BatchReceiver::start() {
+  listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_fd_ < 0) return Status::IoError("socket() failed");
+  int yes = 1;
+  (void)::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port_);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t alen = sizeof(addr);
+  if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listen_fd_, 4) != 0 ||
+      ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &alen) != 0 || !set_nonblocking(listen_fd_)) {
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    return Status::IoError("receiver listen failed");
+  }
+  port_ = ntohs(addr.sin_port);
+
+  stop_.store(false, std::memory_order_relaxed);
+  thread_ = std::thread([this] { run(); });
+  return Status::Ok();
+}
+
+void BatchReceiver::stop() {
+  stop_.store(true, std::memory_order_relaxed);
+  if (thread_.joinable()) thread_.join();
+  if (listen_fd_ >= 0) ::close(listen_fd_);
+  listen_fd_ = -1;
+}
+
+std::vector<codec::BatchSample> BatchReceiver::take_samples() {
+  std::lock_guard<std::mutex> lock(mu_);
+  std::vector<codec::BatchSample> out;
+  out.swap(received_);
+  return out;
+}
+
+std::string BatchReceiver::last_agent_id() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return agent_id_;
+}
+
+bool BatchReceiver::on_readable(int fd, std::vector<std::uint8_t>& buf) {
+  std::uint8_t tmp[16 * 1024];
+  while (true) {
+    const ssize_t n = ::read(fd, tmp, sizeof(tmp));
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+      return false;
+    }
+    if (n == 0) return false;
+    buf.insert(buf.end(), tmp, tmp + n);
+    bytes_.fetch_add(static_cast<std::uint64_t>(n), std::memory_order_relaxed);
+  }
+
+  std::size_t off = 0;
+  while (true) {
+    std::size_t frame_len = 0;
+    const Status st = codec::peek_batch_frame(buf.data() + off, buf.size() - off, frame_len);
+    if (st.code == StatusCode::kUnavailable) break;
+    std::uint64_t seq = 0;
+    std::string_view agent;
+    if (!st.ok() || !codec::decode_batch(buf.data() + off, frame_len, seq, agent, scratch_).ok()) {
+      bad_frames_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    off += frame_len;
+
+    if (seq > last_seq_) {
+      last_seq_ = seq;
+      std::lock_guard<std::mutex> lock(mu_);
+      received_.insert(received_.end(), scratch_.begin(), scratch_.end());
+      agent_id_.assign(agent.data(), agent.size());
+      batches_.fetch_add(1, std::memory_order_relaxed);
+      samples_.fetch_add(scratch_.size(), std::memory_order_relaxed);
+    }
+
+    std::uint8_t ack[codec::kBatchAckSize];
+    for (std::size_t i = 0; i < sizeof(ack); ++i) ack[i] = static_cast<std::uint8_t>(last_seq_ >> (8 * i));
+    if (::write(fd, ack, sizeof(ack)) != static_cast<ssize_t>(sizeof(ack))) return false;
+  }
+  buf.erase(buf.begin(), buf.begin() + static_cast<std::ptrdiff_t>(off));
+  return true;
+}
+
+void BatchReceiver::run() {
+  int conn = -1;
+  std::vector<std::uint8_t> buf;
+  while (!stop_.load(std::memory_order_relaxed)) {
+    pollfd pfds[2]{};
+    pfds[0].fd = listen_fd_;
+    pfds[0].events = POLLIN;
+    pfds[1].fd = conn;
+    pfds[1].events = POLLIN;
+    if (::poll(pfds, conn >= 0 ? 2 : 1, 20) <= 0) continue;
+
+    if (pfds[0].revents & POLLIN) {
+      const int c = ::accept(listen_fd_, nullptr, nullptr);
+      if (c >= 0) {
+        // One exporter at a time; a reconnect replaces the previous stream.
+        if (conn >= 0) ::close(conn);
+        conn = c;
+        buf.clear();
+        (void)set_nonblocking(conn);
+      }
+    }
+    if (conn >= 0 && pfds[1].fd == conn && (pfds[1].revents & (POLLIN | POLLHUP | POLLERR)) &&
+        !on_readable(conn, buf)) {
+      ::close(conn);
+      conn = -1;
+      buf.clear();
+    }
+  }
+  if (conn >= 0) ::close(conn);
+}
+
+}  // namespace telemetry::exporter
+
+#endif  // !_WIN32
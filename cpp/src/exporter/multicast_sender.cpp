@@ -0,0 +1,75 @@
+#include "telemetry/exporter/multicast_sender.h"
+
+#ifndef _WIN32
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "telemetry/trace/trace.h"
+
+namespace telemetry::exporter {
+
+MulticastSender::MulticastSender(MulticastConfig cfg) : cfg_(cfg) {}
+
+MulticastSender::~MulticastSender() {
+  if (fd_ >= 0) ::close(fd_);
+}
+
+Status MulticastSender::open() {
+  if (!cfg_.group || cfg_.port == 0) return Status::InvalidArgument("multicast group not set");
+  in_addr group{};
+  if (::inet_pton(AF_INET, cfg_.group, &group) != 1 || !IN_MULTICAST(ntohl(group.s_addr))) {
+    return Status::InvalidArgument("not an IPv4 multicast group");
+  }
+  in_addr iface{};
+  iface.s_addr = htonl(INADDR_ANY);
+  if (cfg_.interface && ::inet_pton(AF_INET, cfg_.interface, &iface) != 1) {
+    return Status::InvalidArgument("invalid multicast interface");
+  }
+  if (fd_ >= 0) return Status::Ok();
+
+  const int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) return Status::IoError("socket(udp) failed");
+  const unsigned char ttl = cfg_.ttl;
+  const unsigned char loop = cfg_.loopback ? 1 : 0;
+  if (::setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) != 0 ||
+      ::setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) != 0 ||
+      (cfg_.interface && ::setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface)) != 0)) {
+    ::close(fd);
+    return Status::IoError("multicast setsockopt failed");
+  }
+
+  // Connecting fixes the destination, so each sample is a plain send().
+  sockaddr_in dst{};
+  dst.sin_family = AF_INET;
+  dst.sin_port = htons(cfg_.port);
+  dst.sin_addr = group;
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&dst), sizeof(dst)) != 0) {
+    ::close(fd);
+    return Status::IoError("connect(multicast) failed");
+  }
+  fd_ = fd;
+  return Status::Ok();
+}
+
+void MulticastSender::on_snapshot(const MetricsSnapshot& snap, Status collect_status) {
+  if (fd_ < 0) return;
+  trace::Span span("multicast_send");
+  // Consumed even when the send fails, so receivers see the loss as a gap.
+  const std::uint64_t seq = next_seq_++;
+  const std::size_t n = codec::encode_datagram(seq, cfg_.host_id ? cfg_.host_id : "", snap, collect_status.code,
+                                               buf_, sizeof(buf_));
+  if (n != 0 && ::send(fd_, buf_, n, MSG_DONTWAIT) == static_cast<ssize_t>(n)) {
+    ++stats_.sent;
+  } else {
+    ++stats_.send_errors;
+  }
+}
+
+}  // namespace telemetry::exporter
+
+#endif  // !_WIN32
@@ -0,0 +1,295 @@
+#include "telemetry/exporter/push_exporter.h"
+
+#ifndef _WIN32
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "telemetry/trace/trace.h"
+#include "telemetry/util/time.h"
+
+namespace telemetry::exporter {
+
+namespace {
+
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+// Idle wake-up interval when no batch is open and nothing is waiting to be sent.
+constexpr std::uint64_t kIdleWaitMs = 1000;
+
+static bool set_nonblocking(int fd) {
+  const int flags = fcntl(fd, F_GETFL, 0);
+  if (flags < 0) return false;
+  return fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static std::uint64_t get_u64le(const std::uint8_t* p) {
+  std::uint64_t v = 0;
+  for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+  return v;
+}
+
+}  // namespace
+
+PushExporter::PushExporter(ExporterConfig cfg)
+    : cfg_(cfg),
+      queue_(std::max<std::size_t>(cfg.queue_capacity, 2U * static_cast<std::size_t>(std::max(cfg.batch_max_samples, 1U)))),
+      backoff_(cfg.backoff_min_ms, cfg.backoff_max_ms,
+               telemetry::util::unix_time_ms() ^ reinterpret_cast<std::uintptr_t>(this)) {
+  if (cfg_.batch_max_samples == 0) cfg_.batch_max_samples = 1;
+  batch_.reserve(cfg_.batch_max_samples);
+}
+
+PushExporter::~PushExporter() {
+  stop();
+  for (int& fd : wake_fds_) {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+  }
+}
+
+void PushExporter::on_snapshot(const MetricsSnapshot& snap, Status collect_status) {
+  if (!queue_.try_push(codec::BatchSample{snap, collect_status.code})) {
+    dropped_queue_full_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  enqueued_.fetch_add(1, std::memory_order_relaxed);
+
+  // The exporter sleeps until a batch opens or fills, so at most two wake-ups per batch.
+  const std::size_t queued = queue_.size_approx();
+  if (queued == 1 || queued == cfg_.batch_max_samples) wake();
+}
+
+void PushExporter::wake() {
+  if (wake_fds_[1] < 0) return;
+  const char b = 1;
+  (void)::write(wake_fds_[1], &b, 1);
+}
+
+Status PushExporter::start() {
+  if (!cfg_.host || cfg_.port == 0) return Status::InvalidArgument("exporter endpoint not set");
+  in_addr probe{};
+  if (::inet_pton(AF_INET, cfg_.host, &probe) != 1) return Status::InvalidArgument("invalid exporter host");
+  if (thread_.joinable()) return Status::Ok();
+
+  if (wake_fds_[0] < 0) {
+    if (::pipe(wake_fds_) != 0) return Status::IoError("pipe() failed");
+    for (int fd : wake_fds_) {
+      (void)set_nonblocking(fd);
+      (void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+  }
+
+  stop_.store(false, std::memory_order_relaxed);
+  thread_ = std::thread([this] { run(); });
+  return Status::Ok();
+}
+
+void PushExporter::stop() {
+  stop_.store(true, std::memory_order_release);
+  wake();
+  if (thread_.joinable()) thread_.join();
+}
+
+ExporterStats PushExporter::stats() const {
+  ExporterStats s{};
+  s.enqueued = enqueued_.load(std::memory_order_relaxed);
+  s.dropped_queue_full = dropped_queue_full_.load(std::memory_order_relaxed);
+  s.dropped_retry_overflow = dropped_retry_overflow_.load(std::memory_order_relaxed);
+  s.batches_sealed = batches_sealed_.load(std::memory_order_relaxed);
+  s.batches_acked = batches_acked_.load(std::memory_order_relaxed);
+  s.bytes_sent = bytes_sent_.load(std::memory_order_relaxed);
+  s.connects = connects_.load(std::memory_order_relaxed);
+  return s;
+}
+
+void PushExporter::seal_batch(std::size_t max_samples) {
+  trace::Span span("seal_batch", max_samples);
+  batch_.clear();
+  codec::BatchSample s{};
+  while (batch_.size() < max_samples && queue_.try_pop(s)) batch_.push_back(s);
+  if (batch_.empty()) return;
+
+  const std::uint64_t seq = next_seq_++;
+  const std::size_t bytes = codec::encode_batch(seq, cfg_.agent_id ? cfg_.agent_id : "", batch_.data(), batch_.size(), retry_);
+  frames_.push_back(FrameInfo{seq, static_cast<std::uint32_t>(bytes), static_cast<std::uint32_t>(batch_.size())});
+  batches_sealed_.fetch_add(1, std::memory_order_relaxed);
+  enforce_retry_budget();
+}
+
+void PushExporter::enforce_retry_budget() {
+  // Always keep the newest frame, even if it alone exceeds the budget.
+  while (retry_.size() > cfg_.retry_buffer_bytes && frames_.size() > 1) {
+    const FrameInfo oldest = frames_.front();
+    if (send_off_ > 0 && send_off_ < oldest.bytes) {
+      // Half of it is on the wire; cutting it out would corrupt the stream, so start over.
+      disconnect(telemetry::util::unix_time_ms());
+    }
+    send_off_ = send_off_ >= oldest.bytes ? send_off_ - oldest.bytes : 0;
+    retry_.erase(retry_.begin(), retry_.begin() + oldest.bytes);
+    frames_.erase(frames_.begin());
+    dropped_retry_overflow_.fetch_add(oldest.samples, std::memory_order_relaxed);
+  }
+}
+
+void PushExporter::start_connect(std::uint64_t now_ms) {
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(cfg_.port);
+  (void)::inet_pton(AF_INET, cfg_.host, &addr.sin_addr);
+
+  fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (fd_ < 0 || !set_nonblocking(fd_)) {
+    disconnect(now_ms);
+    return;
+  }
+  (void)fcntl(fd_, F_SETFD, FD_CLOEXEC);
+  int yes = 1;
+  (void)::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+  if (::connect(fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0) {
+    connecting_ = false;
+    connects_.fetch_add(1, std::memory_order_relaxed);
+  } else if (errno == EINPROGRESS) {
+    connecting_ = true;
+  } else {
+    disconnect(now_ms);
+  }
+}
+
+void PushExporter::disconnect(std::uint64_t now_ms) {
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = -1;
+  connecting_ = false;
+  // Everything unacknowledged is resent on the next connection.
+  send_off_ = 0;
+  ack_len_ = 0;
+  retry_at_ms_ = now_ms + backoff_.delay_ms(attempt_);
+  if (attempt_ < 31) ++attempt_;
+}
+
+bool PushExporter::send_pending() {
+  trace::Span span("export_send", retry_.size() - send_off_);
+  while (send_off_ < retry_.size()) {
+    const ssize_t n = ::send(fd_, retry_.data() + send_off_, retry_.size() - send_off_, kSendFlags);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    send_off_ += static_cast<std::size_t>(n);
+    bytes_sent_.fetch_add(static_cast<std::uint64_t>(n), std::memory_order_relaxed);
+  }
+  return true;
+}
+
+bool PushExporter::read_acks() {
+  std::uint8_t tmp[256];
+  while (true) {
+    const ssize_t n = ::read(fd_, tmp, sizeof(tmp));
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    if (n == 0) return false;
+
+    for (ssize_t i = 0; i < n; ++i) {
+      ack_buf_[ack_len_++] = tmp[i];
+      if (ack_len_ < codec::kBatchAckSize) continue;
+      ack_len_ = 0;
+
+      const std::uint64_t acked = get_u64le(ack_buf_);
+      while (!frames_.empty() && frames_.front().seq <= acked) {
+        const std::uint32_t bytes = frames_.front().bytes;
+        retry_.erase(retry_.begin(), retry_.begin() + bytes);
+        send_off_ = send_off_ >= bytes ? send_off_ - bytes : 0;
+        frames_.erase(frames_.begin());
+        batches_acked_.fetch_add(1, std::memory_order_relaxed);
+      }
+      attempt_ = 0;
+    }
+  }
+}
+
+void PushExporter::run() {
+  trace::set_thread_name("exporter");
+  while (true) {
+    const bool stopping = stop_.load(std::memory_order_acquire);
+    std::uint64_t now = telemetry::util::unix_time_ms();
+
+    // The queue holds the open batch; seal full batches, then an expired partial one.
+    std::size_t queued = queue_.size_approx();
+    if (queued > 0 && batch_open_ms_ == 0) batch_open_ms_ = now;
+    while (queued >= cfg_.batch_max_samples ||
+           (queued > 0 && (stopping || now - batch_open_ms_ >= cfg_.batch_max_ms))) {
+      seal_batch(cfg_.batch_max_samples);
+      queued = queue_.size_approx();
+      batch_open_ms_ = queued > 0 ? now : 0;
+    }
+
+    if (fd_ < 0 && now >= retry_at_ms_ && !frames_.empty()) start_connect(now);
+    if (fd_ >= 0 && !connecting_ && !send_pending()) disconnect(now);
+    if (stopping) break;
+
+    std::uint64_t wait = kIdleWaitMs;
+    if (batch_open_ms_ != 0) {
+      const std::uint64_t due = batch_open_ms_ + cfg_.batch_max_ms;
+      wait = std::min(wait, due > now ? due - now : 0);
+    }
+    if (fd_ < 0 && !frames_.empty()) wait = std::min(wait, retry_at_ms_ > now ? retry_at_ms_ - now : 0);
+
+    pollfd pfds[2]{};
+    pfds[0].fd = wake_fds_[0];
+    pfds[0].events = POLLIN;
+    pfds[1].fd = fd_;
+    if (fd_ >= 0) {
+      pfds[1].events = connecting_ ? POLLOUT : static_cast<short>(POLLIN | (send_off_ < retry_.size() ? POLLOUT : 0));
+    }
+    const int rc = ::poll(pfds, fd_ >= 0 ? 2 : 1, static_cast<int>(wait));
+    if (rc <= 0) continue;
+
+    if (pfds[0].revents & POLLIN) {
+      char drain[64];
+      while (::read(wake_fds_[0], drain, sizeof(drain)) > 0) {
+      }
+    }
+
+    if (fd_ < 0 || pfds[1].revents == 0) continue;
+    now = telemetry::util::unix_time_ms();
+    if (connecting_) {
+      int err = 0;
+      socklen_t len = sizeof(err);
+      if (::getsockopt(fd_, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0) {
+        disconnect(now);
+      } else {
+        connecting_ = false;
+        connects_.fetch_add(1, std::memory_order_relaxed);
+      }
+      continue;
+    }
+    if ((pfds[1].revents & (POLLIN | POLLHUP | POLLERR)) && !read_acks()) {
+      disconnect(now);
+      continue;
+    }
+    if ((pfds[1].revents & POLLOUT) && !send_pending()) disconnect(now);
+  }
+
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = -1;
+}
+
+}  // namespace telemetry::exporter
+
+#endif  // !_WIN32
@@ -0,0 +1,358 @@
+#include "telemetry/fleet/aggregator.h"
+
+#ifndef _WIN32
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+
+#include "telemetry/trace/trace.h"
+#include "telemetry/util/time.h"
+
+namespace telemetry::fleet {
+
+namespace {
+
+constexpr std::size_t kReplyBufSize = 1024;
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+// Upper bound on a poll() sleep so stop() and reply timeouts are noticed promptly.
+constexpr std::uint64_t kMaxPollMs = 100;
+
+static bool set_nonblocking(int fd) {
+  const int flags = fcntl(fd, F_GETFL, 0);
+  if (flags < 0) return false;
+  return fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+// Finds `"key":` in a NUL-terminated reply line and parses the number that follows.
+static const char* json_value(const char* line, const char* key) {
+  char pattern[40];
+  const int n = std::snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+  if (n <= 0 || static_cast<std::size_t>(n) >= sizeof(pattern)) return nullptr;
+  const char* p = std::strstr(line, pattern);
+  return p ? p + n : nullptr;
+}
+
+static bool json_u64(const char* line, const char* key, std::uint64_t& out) {
+  const char* p = json_value(line, key);
+  if (!p) return false;
+  char* end = nullptr;
+  out = static_cast<std::uint64_t>(std::strtoull(p, &end, 10));
+  return end != p;
+}
+
+static bool json_double(const char* line, const char* key, double& out) {
+  const char* p = json_value(line, key);
+  if (!p) return false;
+  char* end = nullptr;
+  out = std::strtod(p, &end);
+  return end != p;
+}
+
+// Parses a GET reply line as produced by TcpServer::write_json_metrics.
+static bool parse_metrics_line(const char* line, MetricsSnapshot& snap, StatusCode& code) {
+  std::uint64_t status = 0;
+  if (!json_u64(line, "status_code", status)) return false;
+  if (!json_u64(line, "ts_ms", snap.ts_ms)) return false;
+  if (!json_double(line, "cpu_usage_pct", snap.cpu_usage_pct)) return false;
+  if (!json_u64(line, "mem_total_kb", snap.mem_total_kb)) return false;
+  if (!json_u64(line, "mem_available_kb", snap.mem_available_kb)) return false;
+  (void)json_double(line, "temperature_c", snap.temperature_c);
+  (void)json_u64(line, "uptime_s", snap.uptime_s);
+  code = static_cast<StatusCode>(status);
+  return true;
+}
+
+}  // namespace
+
+struct FleetAggregator::Peer final {
+  enum class State : std::uint8_t { kIdle, kConnecting, kConnected };
+
+  sockaddr_in addr{};
+  std::size_t id{0};
+  int fd{-1};
+  State state{State::kIdle};
+  std::uint32_t attempt{0};
+  std::uint32_t in_flight{0};
+  std::uint64_t retry_at_ms{0};
+  // Last connect completion or reply; drives the reply timeout.
+  std::uint64_t last_progress_ms{0};
+  std::array<char, kReplyBufSize> buf{};
+  std::size_t len{0};
+};
+
+FleetAggregator::FleetAggregator(FleetTable& table, AggregatorConfig cfg)
+    : table_(table),
+      cfg_(cfg),
+      backoff_(cfg.backoff_min_ms, cfg.backoff_max_ms,
+               telemetry::util::unix_time_ms() ^ reinterpret_cast<std::uintptr_t>(this)) {}
+
+FleetAggregator::~FleetAggregator() { stop(); }
+
+std::size_t FleetAggregator::target_count() const { return peers_.size(); }
+
+Status FleetAggregator::add_target(const char* host, std::uint16_t port, std::string_view name) {
+  if (thread_.joinable()) return Status::Internal("aggregator already running");
+
+  Peer p{};
+  p.addr.sin_family = AF_INET;
+  p.addr.sin_port = htons(port);
+  if (!host || ::inet_pton(AF_INET, host, &p.addr.sin_addr) != 1) return Status::InvalidArgument("invalid target host");
+
+  char default_name[kMaxHostName];
+  if (name.empty()) {
+    std::snprintf(default_name, sizeof(default_name), "%s:%u", host, static_cast<unsigned>(port));
+    name = default_name;
+  }
+  p.id = table_.add_host(name);
+  // Two targets on one row would overwrite each other's snapshot and status.
+  for (const Peer& other : peers_) {
+    if (other.id == p.id) return Status::InvalidArgument("duplicate target name");
+  }
+  peers_.push_back(p);
+  return Status::Ok();
+}
+
+Status FleetAggregator::load_targets_file(const char* path) {
+  std::FILE* f = std::fopen(path, "r");
+  if (!f) return Status::IoError("open targets file failed");
+
+  char line[256];
+  Status st = Status::Ok();
+  while (st.ok() && std::fgets(line, sizeof(line), f)) {
+    char* p = line;
+    while (*p == ' ' || *p == '\t') ++p;
+    if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') continue;
+
+    char* addr_end = p;
+    while (*addr_end && *addr_end != ' ' && *addr_end != '\t' && *addr_end != '\n' && *addr_end != '\r') ++addr_end;
+    char* name = addr_end;
+    while (*name == ' ' || *name == '\t') ++name;
+    char* name_end = name;
+    while (*name_end && *name_end != '\n' && *name_end != '\r' && *name_end != ' ' && *name_end != '\t') ++name_end;
+    *addr_end = '\0';
+    *name_end = '\0';
+
+    char* colon = std::strrchr(p, ':');
+    if (!colon || colon == p || colon[1] == '\0') {
+      st = Status::InvalidArgument("target must be <ipv4>:<port>");
+      break;
+    }
+    *colon = '\0';
+    char* port_end = nullptr;
+    const unsigned long port = std::strtoul(colon + 1, &port_end, 10);
+    if (*port_end != '\0' || port == 0 || port > 65535UL) {
+      st = Status::InvalidArgument("invalid target port");
+      break;
+    }
+
+    st = add_target(p, static_cast<std::uint16_t>(port), name);
+  }
+  std::fclose(f);
+  return st;
+}
+
+Status FleetAggregator::start() {
+  if (peers_.empty()) return Status::InvalidArgument("no aggregation targets");
+  if (thread_.joinable()) return Status::Ok();
+
+  // One descriptor per peer on top of whatever the server itself needs.
+  rlimit rl{};
+  if (::getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+    const rlim_t want = static_cast<rlim_t>(peers_.size()) + 256;
+    if (rl.rlim_cur < want) {
+      rl.rlim_cur = std::min(want, rl.rlim_max);
+      (void)::setrlimit(RLIMIT_NOFILE, &rl);
+    }
+  }
+
+  stop_.store(false, std::memory_order_relaxed);
+  thread_ = std::thread([this] { run(); });
+  return Status::Ok();
+}
+
+void FleetAggregator::stop() {
+  stop_.store(true, std::memory_order_relaxed);
+  if (thread_.joinable()) thread_.join();
+}
+
+void FleetAggregator::start_connect(Peer& p, std::uint64_t now_ms) {
+  p.fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (p.fd < 0) {
+    fail(p, now_ms);
+    return;
+  }
+  (void)fcntl(p.fd, F_SETFD, FD_CLOEXEC);
+  if (!set_nonblocking(p.fd)) {
+    fail(p, now_ms);
+    return;
+  }
+  int yes = 1;
+  (void)::setsockopt(p.fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+  p.last_progress_ms = now_ms;
+  if (::connect(p.fd, reinterpret_cast<const sockaddr*>(&p.addr), sizeof(p.addr)) == 0) {
+    on_connected(p, now_ms);
+  } else if (errno == EINPROGRESS) {
+    p.state = Peer::State::kConnecting;
+  } else {
+    fail(p, now_ms);
+  }
+}
+
+void FleetAggregator::on_connected(Peer& p, std::uint64_t now_ms) {
+  p.state = Peer::State::kConnected;
+  p.in_flight = 0;
+  p.len = 0;
+  p.last_progress_ms = now_ms;
+}
+
+void FleetAggregator::fail(Peer& p, std::uint64_t now_ms) {
+  if (p.fd >= 0) ::close(p.fd);
+  p.fd = -1;
+  p.state = Peer::State::kIdle;
+  p.in_flight = 0;
+  p.len = 0;
+  table_.set_up(p.id, false);
+  p.retry_at_ms = now_ms + backoff_.delay_ms(p.attempt);
+  if (p.attempt < 31) ++p.attempt;
+}
+
+bool FleetAggregator::read_replies(Peer& p, std::uint64_t now_ms) {
+  while (true) {
+    // Leave room for the NUL terminator the parser relies on.
+    if (p.len >= p.buf.size() - 1) return false;
+    const ssize_t n = ::read(p.fd, p.buf.data() + p.len, p.buf.size() - 1 - p.len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    if (n == 0) return false;
+    p.len += static_cast<std::size_t>(n);
+
+    while (true) {
+      char* nl = static_cast<char*>(std::memchr(p.buf.data(), '\n', p.len));
+      if (!nl) break;
+      *nl = '\0';
+
+      MetricsSnapshot snap{};
+      StatusCode code = StatusCode::kOk;
+      if (parse_metrics_line(p.buf.data(), snap, code)) table_.update(p.id, snap, code, now_ms);
+      if (p.in_flight > 0) --p.in_flight;
+      p.attempt = 0;
+      p.last_progress_ms = now_ms;
+
+      const std::size_t consumed = static_cast<std::size_t>(nl - p.buf.data()) + 1;
+      const std::size_t remaining = p.len - consumed;
+      if (remaining > 0) std::memmove(p.buf.data(), p.buf.data() + consumed, remaining);
+      p.len = remaining;
+    }
+  }
+}
+
+void FleetAggregator::run() {
+  trace::set_thread_name("aggregator");
+  std::vector<pollfd> pfds;
+  std::vector<std::uint32_t> owners;
+  pfds.reserve(peers_.size());
+  owners.reserve(peers_.size());
+
+  static constexpr char kGet[] = "GET\n";
+  std::uint64_t next_round_ms = telemetry::util::unix_time_ms();
+
+  while (!stop_.load(std::memory_order_relaxed)) {
+    const std::uint64_t now = telemetry::util::unix_time_ms();
+    const bool round = now >= next_round_ms;
+    if (round) next_round_ms = now + cfg_.interval_ms;
+    std::uint64_t next_due = next_round_ms;
+
+    pfds.clear();
+    owners.clear();
+    for (std::size_t i = 0; i < peers_.size(); ++i) {
+      Peer& p = peers_[i];
+
+      if (p.state == Peer::State::kIdle) {
+        if (now < p.retry_at_ms) {
+          next_due = std::min(next_due, p.retry_at_ms);
+          continue;
+        }
+        start_connect(p, now);
+        if (p.state == Peer::State::kIdle) continue;
+      }
+
+      const bool stalled = p.state == Peer::State::kConnecting || p.in_flight > 0;
+      if (stalled && now - p.last_progress_ms >= cfg_.reply_timeout_ms) {
+        fail(p, now);
+        continue;
+      }
+
+      if (p.state == Peer::State::kConnected && round && p.in_flight < cfg_.pipeline_depth) {
+        const ssize_t w = ::send(p.fd, kGet, sizeof(kGet) - 1, kSendFlags);
+        if (w == static_cast<ssize_t>(sizeof(kGet) - 1)) {
+          if (p.in_flight == 0) p.last_progress_ms = now;
+          ++p.in_flight;
+        } else if (w >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+          // A 4-byte write either fits or the socket is broken; never leave half a command.
+          fail(p, now);
+          continue;
+        }
+      }
+
+      pollfd pfd{};
+      pfd.fd = p.fd;
+      pfd.events = p.state == Peer::State::kConnecting ? POLLOUT : POLLIN;
+      pfds.push_back(pfd);
+      owners.push_back(static_cast<std::uint32_t>(i));
+    }
+
+    const std::uint64_t wait = std::min<std::uint64_t>(next_due > now ? next_due - now : 0, kMaxPollMs);
+    const int rc = ::poll(pfds.data(), pfds.size(), static_cast<int>(wait));
+    if (rc <= 0) continue;
+
+    trace::Span span("fleet_io", static_cast<std::uint64_t>(rc));
+    const std::uint64_t after = telemetry::util::unix_time_ms();
+    for (std::size_t k = 0; k < pfds.size(); ++k) {
+      if (pfds[k].revents == 0) continue;
+      Peer& p = peers_[owners[k]];
+
+      if (p.state == Peer::State::kConnecting) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (::getsockopt(p.fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0) {
+          fail(p, after);
+        } else {
+          on_connected(p, after);
+        }
+        continue;
+      }
+
+      if (!read_replies(p, after)) fail(p, after);
+    }
+  }
+
+  for (auto& p : peers_) {
+    if (p.fd >= 0) ::close(p.fd);
+    p.fd = -1;
+    p.state = Peer::State::kIdle;
+  }
+}
+
+}  // namespace telemetry::fleet
+
+#endif  // !_WIN32
@@ -0,0 +1,110 @@
+#include "telemetry/fleet/fleet_table.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace telemetry::fleet {
+
+std::size_t FleetTable::add_host(std::string_view name) {
+  std::lock_guard<std::mutex> lock(mu_);
+  const auto it = by_name_.find(std::string(name));
+  if (it != by_name_.end()) return it->second;
+
+  FleetHost h{};
+  const std::size_t n = std::min(name.size(), kMaxHostName - 1);
+  for (std::size_t i = 0; i < n; ++i) {
+    // Names are echoed into JSON unescaped.
+    const char ch = name[i];
+    h.name[i] = (ch == '"' || ch == '\\' || static_cast<unsigned char>(ch) < 0x20) ? '_' : ch;
+  }
+  h.name[n] = '\0';
+  hosts_.push_back(h);
+  by_name_.emplace(std::string(name), hosts_.size() - 1);
+  by_cpu_.reserve(hosts_.size());
+  cpu_index_dirty_ = true;
+  return hosts_.size() - 1;
+}
+
+void FleetTable::update(std::size_t id, const MetricsSnapshot& snap, StatusCode status_code, std::uint64_t now_ms) {
+  std::lock_guard<std::mutex> lock(mu_);
+  if (id >= hosts_.size()) return;
+  FleetHost& h = hosts_[id];
+  if (!h.up) ++up_count_;
+  h.up = true;
+  h.has_snapshot = true;
+  h.status_code = status_code;
+  h.snap = snap;
+  h.last_update_ms = now_ms;
+  ++h.updates;
+  cpu_index_dirty_ = true;
+}
+
+void FleetTable::set_up(std::size_t id, bool up) {
+  std::lock_guard<std::mutex> lock(mu_);
+  if (id >= hosts_.size()) return;
+  FleetHost& h = hosts_[id];
+  if (h.up == up) return;
+  h.up = up;
+  if (up) {
+    ++up_count_;
+  } else {
+    --up_count_;
+    ++h.reconnects;
+  }
+  cpu_index_dirty_ = true;
+}
+
+std::size_t FleetTable::size() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return hosts_.size();
+}
+
+std::size_t FleetTable::up_count() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return up_count_;
+}
+
+bool FleetTable::find(std::string_view name, FleetHost& out) const {
+  std::lock_guard<std::mutex> lock(mu_);
+  const auto it = by_name_.find(std::string(name));
+  if (it == by_name_.end()) return false;
+  out = hosts_[it->second];
+  return true;
+}
+
+void FleetTable::all(std::vector<FleetHost>& out) const {
+  std::lock_guard<std::mutex> lock(mu_);
+  out.assign(hosts_.begin(), hosts_.end());
+}
+
+void FleetTable::rebuild_cpu_index_locked() const {
+  if (!cpu_index_dirty_) return;
+  by_cpu_.clear();
+  for (std::size_t i = 0; i < hosts_.size(); ++i) {
+    if (hosts_[i].up && hosts_[i].has_snapshot) by_cpu_.push_back(static_cast<std::uint32_t>(i));
+  }
+  std::sort(by_cpu_.begin(), by_cpu_.end(), [this](std::uint32_t a, std::uint32_t b) {
+    return hosts_[a].snap.cpu_usage_pct > hosts_[b].snap.cpu_usage_pct;
+  });
+  cpu_index_dirty_ = false;
+}
+
+void FleetTable::top_cpu(std::size_t n, std::vector<FleetHost>& out) const {
+  std::lock_guard<std::mutex> lock(mu_);
+  rebuild_cpu_index_locked();
+  out.clear();
+  const std::size_t k = std::min(n, by_cpu_.size());
+  for (std::size_t i = 0; i < k; ++i) out.push_back(hosts_[by_cpu_[i]]);
+}
+
+void FleetTable::over_cpu(double pct, std::vector<FleetHost>& out) const {
+  std::lock_guard<std::mutex> lock(mu_);
+  rebuild_cpu_index_locked();
+  out.clear();
+  // by_cpu_ is descending, so matches form a prefix.
+  const auto end = std::partition_point(by_cpu_.begin(), by_cpu_.end(),
+                                        [this, pct](std::uint32_t id) { return hosts_[id].snap.cpu_usage_pct > pct; });
+  for (auto it = by_cpu_.begin(); it != end; ++it) out.push_back(hosts_[*it]);
+}
+
+}  // namespace telemetry::fleet
@@ -2,19 +2,76 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
+#include <vector>
 
+#ifndef _WIN32
+#include <csignal>
+#include <unistd.h>
+#endif
+
+#include "telemetry/exporter/multicast_sender.h"
+#include "telemetry/exporter/push_exporter.h"
+#include "telemetry/fleet/aggregator.h"
 #include "telemetry/metrics/default_sources.h"
+#ifdef __linux__
+#include "telemetry/metrics/linux_cgroup_source.h"
+#include "telemetry/metrics/linux_declared_source.h"
+#include "telemetry/metrics/linux_filesystem_source.h"
+#include "telemetry/metrics/linux_pressure_source.h"
+#endif
+#include "telemetry/metrics/process_source.h"
+#include "telemetry/metrics/replay_source.h"
 #include "telemetry/net/tcp_server.h"
+#include "telemetry/rules/rule_engine.h"
+#include "telemetry/shm/shm_publisher.h"
+#include "telemetry/storage/spool.h"
+#include "telemetry/trace/trace.h"
 
 namespace {
 
 static void print_usage(const char* argv0) {
   std::fprintf(stderr,
                "Usage: %s [--host <ip>] [--port <port>] [--throttle-ms <ms>] [--run-for-ms <ms>]\n"
-               "Defaults: --host 0.0.0.0 --port 9000 --throttle-ms 250 --run-for-ms 0\n",
+               "          [--metrics-port <port>] [--unix-socket <path>] [--rules <rules-file>] [--trace] [--trace-file <path>]\n"
+               "          [--max-commands-per-pass <n>] [--max-read-bytes-per-pass <n>] [--idle-timeout-ms <ms>]\n"
+               "          [--spool-dir <dir>] [--spool-segment-kb <kb>] [--spool-budget-mb <mb>]\n"
+               "          [--shm <name>] [--shm-history <n>]\n"
+               "          [--aggregate <targets-file>] [--aggregate-interval-ms <ms>]\n"
+               "          [--export <ipv4>:<port>] [--export-batch <n>] [--export-batch-ms <ms>] [--agent-id <id>]\n"
+               "          [--multicast <group>:<port>] [--multicast-if <ipv4>] [--multicast-ttl <n>]\n"
+               "          [--cgroup <auto|path>] [--cgroup-children]\n"
+               "          [--psi-trigger <cpu|memory|io>:<some|full>:<stall_ms>/<window_ms>]\n"
+               "          [--top <n>] [--top-per-tick <n>] [--metrics-config <file>]\n"
+               "          [--replay <spool-dir|segment>] [--replay-speed <x|max>] [--replay-once]\n"
+               "Defaults: --host 0.0.0.0 --port 9000 --throttle-ms 250 --run-for-ms 0\n"
+               "          (OpenMetrics GET /metrics served on --metrics-port when given)\n"
+               "          (line protocol also served on the AF_UNIX socket --unix-socket when given)\n"
+               "          (rules file: one `[name:] <expr> <op> <expr> [for 30s] [hysteresis n]` per line)\n"
+               "          --trace-file telemetryd-trace.json (SIGUSR1 writes the trace there; --trace starts it on)\n"
+               "          --max-commands-per-pass 0 --max-read-bytes-per-pass 0 (0 = no per-client budget)\n"
+               "          --idle-timeout-ms 300000 (silent non-subscriber connections are closed; 0 = never)\n"
+               "          --spool-segment-kb 4096 --spool-budget-mb 64 (spool disabled unless --spool-dir)\n"
+               "          --shm-history 256 (shared-memory snapshots disabled unless --shm, e.g. /telemetryd)\n"
+               "          --aggregate-interval-ms 1000 (targets file: one <ipv4>:<port> [name] per line)\n"
+               "          --export-batch 64 --export-batch-ms 1000 --agent-id <hostname>\n"
+               "          --multicast-ttl 1 (datagram broadcast disabled unless --multicast, e.g. 239.255.70.1:9200;\n"
+               "          datagrams carry --agent-id)\n"
+               "          (--cgroup reports CPU and memory against a cgroup v2 group's limits: auto = the agent's own,\n"
+               "          e.g. inside a container; --cgroup-children adds each child group to DETAIL and /metrics)\n"
+               "          (--psi-trigger, repeatable, e.g. memory:some:150/1000: a sample is taken and pushed to\n"
+               "          subscribers as soon as the kernel reports that much stall time in the window)\n"
+               "          (--top ranks the busiest <n> processes, at most 256, for TOP, DETAIL and /metrics;\n"
+               "          --top-per-tick spreads each pass over /proc across samples of that many processes)\n"
+               "          (metrics config: one `<name> <path> value|key <key> [n]|column <n> row <key> [keycol <k>]\n"
+               "          [scale <k>] [rate]` per line, exported as telemetry_<name>)\n"
+               "          --replay-speed 1 (--replay serves a recorded spool instead of live metrics, in real time,\n"
+               "          <x> times faster or, with max, one record per sample; it loops unless --replay-once)\n",
                argv0);
 }
 
+constexpr std::size_t kMaxPsiTriggers = 8;
+
 static bool parse_u16(const char* s, std::uint16_t& out) {
   if (!s || !*s) return false;
   unsigned long v = 0;
@@ -27,6 +84,15 @@ static bool parse_u16(const char* s, std::uint16_t& out) {
   return true;
 }
 
+// Splits "<ipv4>:<port>" in place; `s` must stay alive while `host` is used.
+static bool parse_endpoint(char* s, const char*& host, std::uint16_t& port) {
+  char* colon = std::strrchr(s, ':');
+  if (!colon || colon == s) return false;
+  *colon = '\0';
+  host = s;
+  return parse_u16(colon + 1, port) && port != 0;
+}
+
 static bool parse_u32(const char* s, std::uint32_t& out) {
   if (!s || !*s) return false;
   unsigned long v = 0;
@@ -43,6 +109,23 @@ static bool parse_u32(const char* s, std::uint32_t& out) {
 
 int main(int argc, char** argv) {
   telemetry::net::TcpServerConfig cfg{};
+  telemetry::storage::SpoolConfig spool_cfg{};
+  telemetry::fleet::AggregatorConfig agg_cfg{};
+  const char* aggregate_targets = nullptr;
+  const char* rules_file = nullptr;
+  bool trace_on = false;
+  const char* trace_file = "telemetryd-trace.json";
+  telemetry::exporter::ExporterConfig export_cfg{};
+  telemetry::shm::ShmConfig shm_cfg{};
+  bool shm_on = false;
+  telemetry::exporter::MulticastConfig mcast_cfg{};
+  const char* cgroup_path = nullptr;
+  bool cgroup_children = false;
+  std::vector<const char*> psi_triggers;
+  std::uint32_t top_n = 0;
+  std::uint32_t top_per_tick = 0;
+  const char* metrics_config = nullptr;
+  telemetry::metrics::ReplayConfig replay_cfg{};
 
   for (int i = 1; i < argc; ++i) {
     const char* a = argv[i];
@@ -58,6 +141,17 @@ int main(int argc, char** argv) {
         return 2;
       }
       cfg.port = port;
+    } else if (std::strcmp(a, "--metrics-port") == 0 && i + 1 < argc) {
+      if (!parse_u16(argv[++i], cfg.metrics_port) || cfg.metrics_port == 0) {
+        std::fprintf(stderr, "Invalid --metrics-port\n");
+        return 2;
+      }
+    } else if (std::strcmp(a, "--unix-socket") == 0 && i + 1 < argc) {
+      cfg.unix_path = argv[++i];
+      if (!*cfg.unix_path) {
+        std::fprintf(stderr, "Invalid --unix-socket\n");
+        return 2;
+      }
     } else if (std::strcmp(a, "--throttle-ms") == 0 && i + 1 < argc) {
       std::uint32_t ms = 0;
       if (!parse_u32(argv[++i], ms)) {
@@ -72,6 +166,133 @@ int main(int argc, char** argv) {
         return 2;
       }
       cfg.run_for_ms = ms;
+    } else if (std::strcmp(a, "--max-commands-per-pass") == 0 && i + 1 < argc) {
+      if (!parse_u32(argv[++i], cfg.max_commands_per_pass)) {
+        std::fprintf(stderr, "Invalid --max-commands-per-pass\n");
+        return 2;
+      }
+    } else if (std::strcmp(a, "--max-read-bytes-per-pass") == 0 && i + 1 < argc) {
+      if (!parse_u32(argv[++i], cfg.max_read_bytes_per_pass)) {
+        std::fprintf(stderr, "Invalid --max-read-bytes-per-pass\n");
+        return 2;
+      }
+    } else if (std::strcmp(a, "--idle-timeout-ms") == 0 && i + 1 < argc) {
+      if (!parse_u32(argv[++i], cfg.idle_timeout_ms)) {
+        std::fprintf(stderr, "Invalid --idle-timeout-ms\n");
+        return 2;
+      }
+    } else if (std::strcmp(a, "--spool-dir") == 0 && i + 1 < argc) {
+      spool_cfg.dir = argv[++i];
+    } else if (std::strcmp(a, "--spool-segment-kb") == 0 && i + 1 < argc) {
+      std::uint32_t kb = 0;
+      if (!parse_u32(argv[++i], kb) || kb == 0) {
+        std::fprintf(stderr, "Invalid --spool-segment-kb\n");
+        return 2;
+      }
+      spool_cfg.segment_bytes = static_cast<std::uint64_t>(kb) * 1024ULL;
+    } else if (std::strcmp(a, "--spool-budget-mb") == 0 && i + 1 < argc) {
+      std::uint32_t mb = 0;
+      if (!parse_u32(argv[++i], mb) || mb == 0) {
+        std::fprintf(stderr, "Invalid --spool-budget-mb\n");
+        return 2;
+      }
+      spool_cfg.budget_bytes = static_cast<std::uint64_t>(mb) * 1024ULL * 1024ULL;
+    } else if (std::strcmp(a, "--shm") == 0 && i + 1 < argc) {
+      shm_cfg.name = argv[++i];
+      shm_on = true;
+    } else if (std::strcmp(a, "--shm-history") == 0 && i + 1 < argc) {
+      if (!parse_u32(argv[++i], shm_cfg.history) || shm_cfg.history < 2) {
+        std::fprintf(stderr, "Invalid --shm-history\n");
+        return 2;
+      }
+    } else if (std::strcmp(a, "--rules") == 0 && i + 1 < argc) {
+      rules_file = argv[++i];
+    } else if (std::strcmp(a, "--trace") == 0) {
+      trace_on = true;
+    } else if (std::strcmp(a, "--trace-file") == 0 && i + 1 < argc) {
+      trace_file = argv[++i];
+    } else if (std::strcmp(a, "--aggregate") == 0 && i + 1 < argc) {
+      aggregate_targets = argv[++i];
+    } else if (std::strcmp(a, "--aggregate-interval-ms") == 0 && i + 1 < argc) {
+      std::uint32_t ms = 0;
+      if (!parse_u32(argv[++i], ms) || ms == 0) {
+        std::fprintf(stderr, "Invalid --aggregate-interval-ms\n");
+        return 2;
+      }
+      agg_cfg.interval_ms = ms;
+    } else if (std::strcmp(a, "--export") == 0 && i + 1 < argc) {
+      if (!parse_endpoint(argv[++i], export_cfg.host, export_cfg.port)) {
+        std::fprintf(stderr, "Invalid --export (want <ipv4>:<port>)\n");
+        return 2;
+      }
+    } else if (std::strcmp(a, "--export-batch") == 0 && i + 1 < argc) {
+      if (!parse_u32(argv[++i], export_cfg.batch_max_samples) || export_cfg.batch_max_samples == 0) {
+        std::fprintf(stderr, "Invalid --export-batch\n");
+        return 2;
+      }
+    } else if (std::strcmp(a, "--export-batch-ms") == 0 && i + 1 < argc) {
+      if (!parse_u32(argv[++i], export_cfg.batch_max_ms)) {
+        std::fprintf(stderr, "Invalid --export-batch-ms\n");
+        return 2;
+      }
+    } else if (std::strcmp(a, "--agent-id") == 0 && i + 1 < argc) {
+      export_cfg.agent_id = argv[++i];
+    } else if (std::strcmp(a, "--multicast") == 0 && i + 1 < argc) {
+      if (!parse_endpoint(argv[++i], mcast_cfg.group, mcast_cfg.port)) {
+        std::fprintf(stderr, "Invalid --multicast (want <group>:<port>)\n");
+        return 2;
+      }
+    } else if (std::strcmp(a, "--multicast-if") == 0 && i + 1 < argc) {
+      mcast_cfg.interface = argv[++i];
+    } else if (std::strcmp(a, "--multicast-ttl") == 0 && i + 1 < argc) {
+      std::uint32_t ttl = 0;
+      if (!parse_u32(argv[++i], ttl) || ttl == 0 || ttl > 255) {
+        std::fprintf(stderr, "Invalid --multicast-ttl\n");
+        return 2;
+      }
+      mcast_cfg.ttl = static_cast<std::uint8_t>(ttl);
+    } else if (std::strcmp(a, "--cgroup") == 0 && i + 1 < argc) {
+      cgroup_path = argv[++i];
+      if (!*cgroup_path) {
+        std::fprintf(stderr, "Invalid --cgroup\n");
+        return 2;
+      }
+    } else if (std::strcmp(a, "--cgroup-children") == 0) {
+      cgroup_children = true;
+    } else if (std::strcmp(a, "--psi-trigger") == 0 && i + 1 < argc) {
+      if (psi_triggers.size() == kMaxPsiTriggers) {
+        std::fprintf(stderr, "Too many --psi-trigger (max %u)\n", static_cast<unsigned>(kMaxPsiTriggers));
+        return 2;
+      }
+      psi_triggers.push_back(argv[++i]);
+    } else if (std::strcmp(a, "--top") == 0 && i + 1 < argc) {
+      if (!parse_u32(argv[++i], top_n) || top_n == 0 || top_n > telemetry::metrics::ProcessSource::kMaxTop) {
+        std::fprintf(stderr, "Invalid --top\n");
+        return 2;
+      }
+    } else if (std::strcmp(a, "--top-per-tick") == 0 && i + 1 < argc) {
+      if (!parse_u32(argv[++i], top_per_tick) || top_per_tick == 0) {
+        std::fprintf(stderr, "Invalid --top-per-tick\n");
+        return 2;
+      }
+    } else if (std::strcmp(a, "--metrics-config") == 0 && i + 1 < argc) {
+      metrics_config = argv[++i];
+    } else if (std::strcmp(a, "--replay") == 0 && i + 1 < argc) {
+      replay_cfg.path = argv[++i];
+    } else if (std::strcmp(a, "--replay-speed") == 0 && i + 1 < argc) {
+      const char* v = argv[++i];
+      if (std::strcmp(v, "max") == 0) {
+        replay_cfg.speed = 0.0;
+      } else {
+        char* end = nullptr;
+        replay_cfg.speed = std::strtod(v, &end);
+        if (end == v || *end != '\0' || !(replay_cfg.speed > 0.0 && replay_cfg.speed <= 1e6)) {
+          std::fprintf(stderr, "Invalid --replay-speed\n");
+          return 2;
+        }
+      }
+    } else if (std::strcmp(a, "--replay-once") == 0) {
+      replay_cfg.loop = false;
     } else {
       std::fprintf(stderr, "Unknown arg: %s\n", a);
       print_usage(argv[0]);
@@ -79,23 +300,312 @@ int main(int argc, char** argv) {
     }
   }
 
+  if (replay_cfg.path && spool_cfg.dir && std::strcmp(replay_cfg.path, spool_cfg.dir) == 0) {
+    // The spool truncates and rotates the segments the replay has mapped.
+    std::fprintf(stderr, "--replay cannot read the --spool-dir it writes\n");
+    return 2;
+  }
+
   telemetry::metrics::Collector collector;
-  telemetry::metrics::add_default_sources(collector);
+  if (!replay_cfg.path) {
+    telemetry::metrics::add_default_sources(collector);
+  } else {
+#ifndef _WIN32
+    auto replay = std::make_unique<telemetry::metrics::ReplaySource>(replay_cfg);
+    const telemetry::Status rpst = replay->open();
+    if (!rpst.ok()) {
+      std::fprintf(stderr, "telemetryd replay open failed: %s\n", rpst.message ? rpst.message : "(none)");
+      return 1;
+    }
+    char speed[32] = "max";
+    if (replay_cfg.speed > 0.0) std::snprintf(speed, sizeof(speed), "%gx", replay_cfg.speed);
+    std::fprintf(stderr, "telemetryd replaying %llu records (%llu ms in %llu segments) from %s at %s%s\n",
+                 static_cast<unsigned long long>(replay->records()), static_cast<unsigned long long>(replay->duration_ms()),
+                 static_cast<unsigned long long>(replay->segments()), replay_cfg.path, speed,
+                 replay_cfg.loop ? ", looping" : "");
+    collector.add_source(std::move(replay));
+#endif
+  }
+  if (cgroup_children && !cgroup_path) cgroup_path = "auto";
+#ifdef __linux__
+  if (cgroup_path) {
+    // Registered after the /proc sources so its CPU and memory figures win.
+    telemetry::metrics::CgroupConfig cgroup_cfg{};
+    cgroup_cfg.path = std::strcmp(cgroup_path, "auto") == 0 ? nullptr : cgroup_path;
+    cgroup_cfg.children = cgroup_children;
+    auto cgroup = std::make_unique<telemetry::metrics::CgroupSource>(cgroup_cfg);
+    if (cgroup->dir().empty()) {
+      std::fprintf(stderr, "telemetryd cgroup: no cgroup v2 group found, reporting host CPU and memory\n");
+    } else {
+      std::fprintf(stderr, "telemetryd cgroup: %s%s\n", cgroup->dir().c_str(), cgroup_children ? " (with children)" : "");
+    }
+    collector.add_source(std::move(cgroup));
+  }
+  // Its mount watch is registered with the server below.
+  auto filesystem_source = std::make_unique<telemetry::metrics::FilesystemSource>();
+  telemetry::metrics::FilesystemSource* filesystems = filesystem_source.get();
+  collector.add_source(std::move(filesystem_source));
+  if (top_per_tick != 0 && top_n == 0) top_n = 10;
+  const telemetry::metrics::ProcessSource* processes = nullptr;
+  if (top_n != 0) {
+    telemetry::metrics::ProcessSourceConfig process_cfg{};
+    process_cfg.top_n = top_n;
+    process_cfg.max_per_tick = top_per_tick;
+    auto source = std::make_unique<telemetry::metrics::ProcessSource>(process_cfg);
+    processes = source.get();
+    collector.add_source(std::move(source));
+  }
+  if (metrics_config) {
+    auto declared = std::make_unique<telemetry::metrics::DeclaredSource>();
+    std::size_t bad_line = 0;
+    const telemetry::Status dst = declared->load_file(metrics_config, &bad_line);
+    if (!dst.ok()) {
+      std::fprintf(stderr, "telemetryd metrics config: %s:%llu: %s\n", metrics_config,
+                   static_cast<unsigned long long>(bad_line), dst.message ? dst.message : "(none)");
+      return 1;
+    }
+    std::fprintf(stderr, "telemetryd declared %llu metrics over %llu files from %s\n",
+                 static_cast<unsigned long long>(declared->size()), static_cast<unsigned long long>(declared->files()),
+                 metrics_config);
+    collector.add_source(std::move(declared));
+  }
+#else
+  if (cgroup_path) {
+    std::fprintf(stderr, "--cgroup is only supported on Linux\n");
+    return 2;
+  }
+  if (!psi_triggers.empty()) {
+    std::fprintf(stderr, "--psi-trigger is only supported on Linux\n");
+    return 2;
+  }
+  if (top_n != 0 || top_per_tick != 0) {
+    std::fprintf(stderr, "--top is only supported on Linux\n");
+    return 2;
+  }
+  if (metrics_config) {
+    std::fprintf(stderr, "--metrics-config is only supported on Linux\n");
+    return 2;
+  }
+#endif
 
   std::fprintf(stderr, "telemetryd starting: host=%s port=%u throttle_ms=%u\n", cfg.host,
                static_cast<unsigned>(cfg.port), static_cast<unsigned>(cfg.throttle_ms));
   if (cfg.run_for_ms != 0) {
     std::fprintf(stderr, "telemetryd will exit after run_for_ms=%u\n", static_cast<unsigned>(cfg.run_for_ms));
   }
+  if (cfg.metrics_port != 0) {
+    std::fprintf(stderr, "telemetryd serving OpenMetrics on %s:%u/metrics\n", cfg.host,
+                 static_cast<unsigned>(cfg.metrics_port));
+  }
+  if (cfg.unix_path) std::fprintf(stderr, "telemetryd serving the line protocol on unix:%s\n", cfg.unix_path);
   std::fprintf(stderr, "telemetryd listening... \n");
 
+#ifndef _WIN32
+  // Peers that disconnect mid-response must surface as EPIPE, not kill the daemon.
+  (void)std::signal(SIGPIPE, SIG_IGN);
+#endif
+
   telemetry::net::TcpServer server(collector, cfg);
+
+#ifdef _WIN32
+  if (cfg.metrics_port != 0) {
+    std::fprintf(stderr, "--metrics-port is not supported on Windows\n");
+    return 2;
+  }
+  if (cfg.unix_path) {
+    std::fprintf(stderr, "--unix-socket is not supported on Windows\n");
+    return 2;
+  }
+  if (spool_cfg.dir) {
+    std::fprintf(stderr, "--spool-dir is not supported on Windows\n");
+    return 2;
+  }
+  if (replay_cfg.path) {
+    std::fprintf(stderr, "--replay is not supported on Windows\n");
+    return 2;
+  }
+  if (rules_file) {
+    std::fprintf(stderr, "--rules is not supported on Windows\n");
+    return 2;
+  }
+  if (shm_on) {
+    std::fprintf(stderr, "--shm is not supported on Windows\n");
+    return 2;
+  }
+  if (trace_on) {
+    std::fprintf(stderr, "--trace is not supported on Windows\n");
+    return 2;
+  }
+  if (cfg.max_commands_per_pass != 0 || cfg.max_read_bytes_per_pass != 0) {
+    std::fprintf(stderr, "--max-commands-per-pass/--max-read-bytes-per-pass are not supported on Windows\n");
+    return 2;
+  }
+  if (aggregate_targets) {
+    std::fprintf(stderr, "--aggregate is not supported on Windows\n");
+    return 2;
+  }
+  if (export_cfg.host) {
+    std::fprintf(stderr, "--export is not supported on Windows\n");
+    return 2;
+  }
+  if (mcast_cfg.group) {
+    std::fprintf(stderr, "--multicast is not supported on Windows\n");
+    return 2;
+  }
+#else
+  const telemetry::Status tst = telemetry::trace::install_dump_signal(SIGUSR1, trace_file);
+  if (!tst.ok()) {
+    std::fprintf(stderr, "telemetryd trace signal failed: %s\n", tst.message ? tst.message : "(none)");
+    return 1;
+  }
+  if (trace_on) {
+    telemetry::trace::set_enabled(true);
+    std::fprintf(stderr, "telemetryd tracing on (kill -USR1 %d writes %s)\n", static_cast<int>(::getpid()), trace_file);
+  }
+
+  std::unique_ptr<telemetry::storage::Spool> spool;
+  if (spool_cfg.dir) {
+    spool = std::make_unique<telemetry::storage::Spool>(spool_cfg);
+    const telemetry::Status sst = spool->open();
+    if (!sst.ok()) {
+      std::fprintf(stderr, "telemetryd spool open failed: %s\n", sst.message ? sst.message : "(none)");
+      return 1;
+    }
+    std::fprintf(stderr, "telemetryd spooling to %s (head=%llu tail=%llu)\n", spool_cfg.dir,
+                 static_cast<unsigned long long>(spool->head_cursor()),
+                 static_cast<unsigned long long>(spool->tail_cursor()));
+    server.set_spool(spool.get());
+  }
+
+  std::unique_ptr<telemetry::shm::ShmPublisher> shm;
+  if (shm_on) {
+    shm = std::make_unique<telemetry::shm::ShmPublisher>(shm_cfg);
+    const telemetry::Status hst = shm->open();
+    if (!hst.ok()) {
+      std::fprintf(stderr, "telemetryd shm open failed: %s\n", hst.message ? hst.message : "(none)");
+      return 1;
+    }
+    std::fprintf(stderr, "telemetryd publishing snapshots to shm %s (history=%u)\n", shm_cfg.name,
+                 static_cast<unsigned>(shm_cfg.history));
+    server.add_sink(shm.get());
+  }
+
+  telemetry::rules::RuleEngine rules;
+  if (rules_file) {
+    std::size_t bad_line = 0;
+    const telemetry::Status rst = rules.load_file(rules_file, &bad_line);
+    if (!rst.ok()) {
+      std::fprintf(stderr, "telemetryd rules: %s:%llu: %s\n", rules_file, static_cast<unsigned long long>(bad_line),
+                   rst.message ? rst.message : "(none)");
+      return 1;
+    }
+    std::fprintf(stderr, "telemetryd loaded %llu rules from %s\n", static_cast<unsigned long long>(rules.size()),
+                 rules_file);
+    server.set_rules(&rules);
+  }
+
+  telemetry::fleet::FleetTable fleet;
+  std::unique_ptr<telemetry::fleet::FleetAggregator> aggregator;
+  if (aggregate_targets) {
+    aggregator = std::make_unique<telemetry::fleet::FleetAggregator>(fleet, agg_cfg);
+    telemetry::Status ast = aggregator->load_targets_file(aggregate_targets);
+    if (ast.ok()) ast = aggregator->start();
+    if (!ast.ok()) {
+      std::fprintf(stderr, "telemetryd aggregator failed: %s\n", ast.message ? ast.message : "(none)");
+      return 1;
+    }
+    std::fprintf(stderr, "telemetryd aggregating %llu targets every %u ms\n",
+                 static_cast<unsigned long long>(aggregator->target_count()),
+                 static_cast<unsigned>(agg_cfg.interval_ms));
+    server.set_fleet(&fleet);
+  }
+
+  char hostname[64] = "telemetryd";
+  if ((export_cfg.host || mcast_cfg.group) && std::strcmp(export_cfg.agent_id, "telemetryd") == 0 &&
+      ::gethostname(hostname, sizeof(hostname) - 1) == 0) {
+    export_cfg.agent_id = hostname;
+  }
+  std::unique_ptr<telemetry::exporter::PushExporter> exporter;
+  if (export_cfg.host) {
+    exporter = std::make_unique<telemetry::exporter::PushExporter>(export_cfg);
+    const telemetry::Status est = exporter->start();
+    if (!est.ok()) {
+      std::fprintf(stderr, "telemetryd exporter failed: %s\n", est.message ? est.message : "(none)");
+      return 1;
+    }
+    std::fprintf(stderr, "telemetryd exporting to %s:%u as %s\n", export_cfg.host,
+                 static_cast<unsigned>(export_cfg.port), export_cfg.agent_id);
+    server.add_sink(exporter.get());
+  }
+
+  std::unique_ptr<telemetry::exporter::MulticastSender> multicast;
+  if (mcast_cfg.group) {
+    mcast_cfg.host_id = export_cfg.agent_id;
+    multicast = std::make_unique<telemetry::exporter::MulticastSender>(mcast_cfg);
+    const telemetry::Status mst = multicast->open();
+    if (!mst.ok()) {
+      std::fprintf(stderr, "telemetryd multicast failed: %s\n", mst.message ? mst.message : "(none)");
+      return 1;
+    }
+    std::fprintf(stderr, "telemetryd broadcasting snapshots to %s:%u as %s (ttl=%u)\n", mcast_cfg.group,
+                 static_cast<unsigned>(mcast_cfg.port), mcast_cfg.host_id, static_cast<unsigned>(mcast_cfg.ttl));
+    server.add_sink(multicast.get());
+  }
+#endif
+
+#ifdef __linux__
+  server.set_processes(processes);
+  server.add_trigger(&filesystems->mount_watch());
+  std::vector<std::unique_ptr<telemetry::metrics::PressureTrigger>> pressure_triggers;
+  for (const char* spec : psi_triggers) {
+    telemetry::metrics::PressureTriggerConfig pcfg{};
+    telemetry::Status pst = telemetry::metrics::parse_pressure_trigger(spec, pcfg);
+    if (!pst.ok()) {
+      std::fprintf(stderr, "Invalid --psi-trigger %s: %s\n", spec, pst.message ? pst.message : "(none)");
+      return 2;
+    }
+    auto trigger = std::make_unique<telemetry::metrics::PressureTrigger>(pcfg);
+    pst = trigger->open();
+    if (!pst.ok()) {
+      std::fprintf(stderr, "telemetryd psi trigger %s failed: %s\n", spec, pst.message ? pst.message : "(none)");
+      return 1;
+    }
+    std::fprintf(stderr, "telemetryd armed PSI trigger %s\n", spec);
+    server.add_trigger(trigger.get());
+    pressure_triggers.push_back(std::move(trigger));
+  }
+#endif
+
   const telemetry::Status st = server.run_forever();
   if (!st.ok()) {
     std::fprintf(stderr, "telemetryd failed: code=%u msg=%s\n", static_cast<unsigned>(st.code),
                  st.message ? st.message : "(none)");
     return 1;
   }
+#ifndef _WIN32
+  if (exporter) {
+    exporter->stop();
+    const telemetry::exporter::ExporterStats es = exporter->stats();
+    std::fprintf(stderr,
+                 "telemetryd exporter: enqueued=%llu dropped_queue_full=%llu dropped_retry_overflow=%llu "
+                 "batches_acked=%llu/%llu bytes_sent=%llu\n",
+                 static_cast<unsigned long long>(es.enqueued), static_cast<unsigned long long>(es.dropped_queue_full),
+                 static_cast<unsigned long long>(es.dropped_retry_overflow),
+                 static_cast<unsigned long long>(es.batches_acked), static_cast<unsigned long long>(es.batches_sealed),
+                 static_cast<unsigned long long>(es.bytes_sent));
+  }
+  if (multicast) {
+    const telemetry::exporter::MulticastStats ms = multicast->stats();
+    std::fprintf(stderr, "telemetryd multicast: sent=%llu send_errors=%llu\n", static_cast<unsigned long long>(ms.sent),
+                 static_cast<unsigned long long>(ms.send_errors));
+  }
+#endif
+#ifdef __linux__
+  for (const auto& trigger : pressure_triggers) {
+    std::fprintf(stderr, "telemetryd %s: fired=%llu\n", trigger->name(),
+                 static_cast<unsigned long long>(trigger->fired()));
+  }
+#endif
   std::fprintf(stderr, "telemetryd stopped.\n");
   return 0;
 }
@@ -1,5 +1,7 @@
 #include "telemetry/metrics/collector.h"
 
+#include "telemetry/trace/trace.h"
+
 namespace telemetry::metrics {
 
 void Collector::add_source(std::unique_ptr<MetricSource> src) { sources_.push_back(std::move(src)); }
@@ -10,14 +12,29 @@ Status Collector::collect(MetricsSnapshot& out) {
   //
   // IMPORTANT: StatusCode::kUnavailable is treated as non-fatal (common for
   // optional metrics like temperature on some platforms).
+  trace::Span span("collect", sources_.size());
   Status first_error = Status::Ok();
   for (auto& s : sources_) {
+    trace::Span source_span(s->name());
     const Status st = s->collect(out);
     if (!st.ok() && st.code != StatusCode::kUnavailable && first_error.ok()) first_error = st;
   }
   return first_error;
 }
 
+std::size_t Collector::append_detail_json(std::string& out, std::string_view only) const {
+  std::size_t written = 0;
+  for (const auto& s : sources_) {
+    if (!only.empty() && only != s->name()) continue;
+    if (detail::append_source_detail(out, *s, written)) ++written;
+  }
+  return written;
+}
+
+void Collector::append_openmetrics(std::string& out) const {
+  for (const auto& s : sources_) s->append_openmetrics(out);
+}
+
 }  // namespace telemetry::metrics
 
 
@@ -1,9 +1,10 @@
 #include "telemetry/metrics/default_sources.h"
 
+#include "telemetry/metrics/linux_sources.h"
+
 namespace telemetry::metrics {
 
 // Forward decls implemented per-platform (compiled conditionally via CMake).
-void add_linux_sources(Collector& collector);
 void add_macos_sources(Collector& collector);
 void add_windows_sources(Collector& collector);
 void add_simulated_sources(Collector& collector);
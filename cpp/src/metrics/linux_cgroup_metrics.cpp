@@ -0,0 +1,391 @@
+#include "telemetry/metrics/linux_cgroup_source.h"
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "telemetry/util/time.h"
+
+namespace telemetry::metrics {
+
+namespace {
+
+constexpr std::size_t kTextSize = 16 * 1024;
+
+// Like sanitize_name for devices, but keeps the '/' separators of a cgroup path.
+void sanitize_path(const char* p, char (&out)[128]) {
+  std::size_t i = 0;
+  for (; p[i] && i + 1 < sizeof(out); ++i) {
+    const char c = p[i];
+    const bool plain = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '.' ||
+                       c == '-' || c == '_' || c == '@' || c == '+' || c == ':' || c == '/';
+    out[i] = plain ? c : '_';
+  }
+  out[i] = '\0';
+}
+
+// Calls f(key, value) for each "key value" line (cpu.stat, memory.stat).
+template <typename F>
+void for_each_stat(const char* text, F&& f) {
+  for (const char* line = text; *line;) {
+    const char* p = line;
+    const char* nl = std::strchr(line, '\n');
+    line = nl ? nl + 1 : line + std::strlen(line);
+    const char* key = p;
+    while (*p && *p != ' ' && *p != '\n') ++p;
+    if (*p != ' ') continue;
+    const std::string_view k(key, static_cast<std::size_t>(p - key));
+    f(k, parse_proc_u64(p));
+  }
+}
+
+// A single-value file such as memory.current, or memory.max where "max" reads as 0.
+bool read_value(ProcFile& file, std::uint64_t& v) {
+  char text[32];
+  if (!file.open() || !file.read(text, sizeof(text))) return false;
+  const char* p = text;
+  v = parse_proc_u64(p);
+  return true;
+}
+
+// "0-3,8,10-11" -> 7.
+unsigned count_cpu_list(const char* p) {
+  unsigned n = 0;
+  while (*p >= '0' && *p <= '9') {
+    const std::uint64_t lo = parse_proc_u64(p);
+    std::uint64_t hi = lo;
+    if (*p == '-') hi = parse_proc_u64(++p);
+    if (hi >= lo) n += static_cast<unsigned>(hi - lo + 1);
+    if (*p != ',') break;
+    ++p;
+  }
+  return n;
+}
+
+void append_stats_json(std::string& out, const CgroupStats& s, bool full) {
+  append_row(out,
+             "{\"cgroup\":\"%s\",\"cpu_pct\":%.2f,\"cpu_limit_cores\":%.2f,\"cpu_throttled_pct\":%.2f,"
+             "\"memory_current_bytes\":%llu,\"memory_max_bytes\":%llu,\"memory_working_set_bytes\":%llu",
+             s.name, s.cpu_pct, s.cpu_limit_cores, s.cpu_throttled_pct,
+             static_cast<unsigned long long>(s.memory_current_bytes),
+             static_cast<unsigned long long>(s.memory_max_bytes),
+             static_cast<unsigned long long>(s.memory_working_set_bytes));
+  if (full) {
+    append_row(out,
+               ",\"io_read_bytes_per_s\":%.2f,\"io_write_bytes_per_s\":%.2f,\"io_reads_per_s\":%.2f,"
+               "\"io_writes_per_s\":%.2f",
+               s.io_read_bytes_per_s, s.io_write_bytes_per_s, s.io_reads_per_s, s.io_writes_per_s);
+  }
+}
+
+// One OpenMetrics gauge family with a sample for the group and, if `with_children`, each
+// child. Zero values are left out when `skip_zero` (memory.max of unlimited groups).
+template <typename T>
+void append_family(std::string& out, const CgroupStats& self, const std::vector<CgroupStats>& children,
+                   const char* family, const char* help, T CgroupStats::*field, bool with_children,
+                   bool skip_zero = false) {
+  auto row = [&](const CgroupStats& s, bool& header) {
+    if (skip_zero && s.*field == T{}) return;
+    if (!header) {
+      append_row(out, "# TYPE %s gauge\n# HELP %s %s\n", family, family, help);
+      header = true;
+    }
+    if constexpr (std::is_same_v<T, double>) {
+      append_row(out, "%s{cgroup=\"%s\"} %.2f\n", family, s.name, s.*field);
+    } else {
+      append_row(out, "%s{cgroup=\"%s\"} %llu\n", family, s.name, static_cast<unsigned long long>(s.*field));
+    }
+  };
+  bool header = false;
+  row(self, header);
+  if (!with_children) return;
+  for (const CgroupStats& s : children) row(s, header);
+}
+
+}  // namespace
+
+CgroupSource::CgroupSource(const CgroupConfig& cfg)
+    : cfg_(cfg), children_(cfg.children ? kMaxChildren : 0), text_(kTextSize) {
+  const std::string root = cfg.root ? cfg.root : "";
+  std::string mount = root + "/sys/fs/cgroup";
+  if (::access((mount + "/cgroup.controllers").c_str(), F_OK) != 0) {
+    // Hybrid hosts mount the v2 hierarchy beside the v1 controllers.
+    mount += "/unified";
+    if (::access((mount + "/cgroup.controllers").c_str(), F_OK) != 0) {
+      setup_error_ = "no cgroup2 mount";
+      return;
+    }
+  }
+
+  std::string rel;
+  if (cfg.path) {
+    rel = cfg.path;
+  } else {
+    ProcFile self(cfg.root, "/proc/self/cgroup");
+    char text[4096];
+    if (!self.open() || !self.read(text, sizeof(text))) {
+      setup_error_ = "read /proc/self/cgroup failed";
+      return;
+    }
+    // The v2 membership is the "0::<path>" line; hybrid hosts list v1 hierarchies too.
+    const char* line = text;
+    while (line && std::strncmp(line, "0::", 3) != 0) {
+      line = std::strchr(line, '\n');
+      if (line) ++line;
+    }
+    if (!line) {
+      setup_error_ = "not in a cgroup v2 group";
+      return;
+    }
+    line += 3;
+    rel.assign(line, std::strcspn(line, "\n"));
+  }
+  if (rel.empty() || rel.front() != '/') rel = "/" + rel;
+  while (rel.size() > 1 && rel.back() == '/') rel.pop_back();
+
+  dir_ = rel == "/" ? mount : mount + rel;
+  sanitize_path(rel.c_str(), self_.stats.name);
+  self_.used = true;
+  open_group(self_, dir_.c_str());
+  memory_stat_.assign(dir_.c_str(), "/memory.stat");
+  io_stat_.assign(dir_.c_str(), "/io.stat");
+  cpuset_.assign(dir_.c_str(), "/cpuset.cpus.effective");
+  child_stats_.reserve(children_.size());
+}
+
+CgroupSource::~CgroupSource() {
+  if (dir_fd_ >= 0) ::close(dir_fd_);
+}
+
+void CgroupSource::open_group(Group& g, const char* dir) {
+  g.cpu_stat.assign(dir, "/cpu.stat");
+  g.cpu_max.assign(dir, "/cpu.max");
+  g.memory_current.assign(dir, "/memory.current");
+  g.memory_max.assign(dir, "/memory.max");
+}
+
+Status CgroupSource::collect(MetricsSnapshot& out) { return sample(out, telemetry::util::monotonic_ns()); }
+
+double CgroupSource::online_cpus() {
+  if (cpuset_.open() && cpuset_.read(text_.data(), text_.size())) {
+    const unsigned n = count_cpu_list(text_.data());
+    if (n != 0) return n;
+  }
+  const long n = ::sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? static_cast<double>(n) : 1.0;
+}
+
+bool CgroupSource::sample_group(Group& g, double seconds, double cpus) {
+  char text[1024];
+  if (!g.cpu_stat.open() || !g.cpu_stat.read(text, sizeof(text))) return false;
+  std::array<std::uint64_t, 3> cur{};
+  for_each_stat(text, [&cur](std::string_view key, std::uint64_t v) {
+    if (key == "usage_usec") cur[0] = v;
+    if (key == "nr_periods") cur[1] = v;
+    if (key == "nr_throttled") cur[2] = v;
+  });
+
+  CgroupStats& s = g.stats;
+  // "<quota> <period>", or "max <period>" without a quota (and no file in the root group).
+  s.cpu_limit_cores = cpus;
+  if (g.cpu_max.open() && g.cpu_max.read(text, sizeof(text)) && text[0] != 'm') {
+    const char* p = text;
+    const std::uint64_t quota = parse_proc_u64(p);
+    const std::uint64_t period = parse_proc_u64(p);
+    if (quota != 0 && period != 0) s.cpu_limit_cores = static_cast<double>(quota) / static_cast<double>(period);
+  }
+
+  s.cpu_pct = 0.0;
+  s.cpu_throttled_pct = 0.0;
+  if (g.primed && seconds > 0.0) {
+    const double used = per_second(counter_delta(g.prev[0], cur[0]), seconds) / 1e6 / s.cpu_limit_cores * 100.0;
+    s.cpu_pct = used > 100.0 ? 100.0 : used;
+    const std::uint64_t periods = counter_delta(g.prev[1], cur[1]);
+    if (periods != 0) {
+      s.cpu_throttled_pct = static_cast<double>(counter_delta(g.prev[2], cur[2])) / static_cast<double>(periods) * 100.0;
+    }
+  }
+  g.prev = cur;
+  g.primed = true;
+
+  if (!read_value(g.memory_current, s.memory_current_bytes)) s.memory_current_bytes = 0;
+  if (!read_value(g.memory_max, s.memory_max_bytes)) s.memory_max_bytes = 0;
+  s.memory_working_set_bytes = s.memory_current_bytes;
+  return true;
+}
+
+Status CgroupSource::sample(MetricsSnapshot& out, std::uint64_t now_ns) {
+  if (setup_error_) return Status::Unavailable(setup_error_);
+
+  const double seconds = prev_ns_ != 0 && now_ns > prev_ns_ ? static_cast<double>(now_ns - prev_ns_) / 1e9 : 0.0;
+  prev_ns_ = now_ns;
+  const double cpus = online_cpus();
+  const bool rates = self_.primed && seconds > 0.0;
+  if (!sample_group(self_, seconds, cpus)) return Status::Unavailable("read cgroup cpu.stat failed");
+
+  CgroupStats& s = self_.stats;
+  if (memory_stat_.open() && memory_stat_.read(text_.data(), text_.size())) {
+    std::uint64_t inactive_file = 0;
+    for_each_stat(text_.data(), [&inactive_file](std::string_view key, std::uint64_t v) {
+      if (key == "inactive_file") inactive_file = v;
+    });
+    s.memory_working_set_bytes = s.memory_current_bytes - std::min(s.memory_current_bytes, inactive_file);
+  }
+
+  // "<major>:<minor> rbytes=.. wbytes=.. rios=.. wios=.. dbytes=.. dios=.." per device.
+  std::array<std::uint64_t, 4> io{};
+  if (io_stat_.open() && io_stat_.read(text_.data(), text_.size())) {
+    for (const char* p = text_.data(); *p;) {
+      const char* key = p;
+      while (*p && *p != '=' && *p != ' ' && *p != '\n') ++p;
+      if (*p != '=') {
+        if (*p) ++p;
+        continue;
+      }
+      const std::string_view k(key, static_cast<std::size_t>(p - key));
+      ++p;
+      const std::uint64_t v = parse_proc_u64(p);
+      if (k == "rbytes") io[0] += v;
+      if (k == "wbytes") io[1] += v;
+      if (k == "rios") io[2] += v;
+      if (k == "wios") io[3] += v;
+    }
+    const bool io_rates = rates && io_primed_;
+    s.io_read_bytes_per_s = io_rates ? per_second(counter_delta(prev_io_[0], io[0]), seconds) : 0.0;
+    s.io_write_bytes_per_s = io_rates ? per_second(counter_delta(prev_io_[1], io[1]), seconds) : 0.0;
+    s.io_reads_per_s = io_rates ? per_second(counter_delta(prev_io_[2], io[2]), seconds) : 0.0;
+    s.io_writes_per_s = io_rates ? per_second(counter_delta(prev_io_[3], io[3]), seconds) : 0.0;
+    prev_io_ = io;
+    io_primed_ = true;
+  } else {
+    // A missed read leaves no baseline for the interval after it.
+    s.io_read_bytes_per_s = s.io_write_bytes_per_s = s.io_reads_per_s = s.io_writes_per_s = 0.0;
+    io_primed_ = false;
+  }
+
+  if (!children_.empty()) sample_children(seconds, cpus);
+
+  out.cpu_usage_pct = s.cpu_pct;
+  if (s.memory_max_bytes != 0) {
+    // The host may have less memory than the limit allows.
+    std::uint64_t total_kb = s.memory_max_bytes / 1024;
+    if (out.mem_total_kb != 0) total_kb = std::min(total_kb, out.mem_total_kb);
+    std::uint64_t avail_kb = total_kb - std::min(total_kb, s.memory_working_set_bytes / 1024);
+    if (out.mem_available_kb != 0) avail_kb = std::min(avail_kb, out.mem_available_kb);
+    out.mem_total_kb = total_kb;
+    out.mem_available_kb = avail_kb;
+  }
+  return Status::Ok();
+}
+
+void CgroupSource::sample_children(double seconds, double cpus) {
+  child_stats_.clear();
+  untracked_children_ = 0;
+  if (dir_fd_ < 0) dir_fd_ = ::open(dir_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir_fd_ < 0 || ::lseek(dir_fd_, 0, SEEK_SET) < 0) return;
+  for (Group& g : children_) g.seen = false;
+
+  alignas(struct dirent64) char buf[4096];
+  char path[512];
+  while (true) {
+    const ssize_t n = ::getdents64(dir_fd_, buf, sizeof(buf));
+    if (n <= 0) break;
+    for (ssize_t off = 0; off < n;) {
+      const auto* d = reinterpret_cast<const struct dirent64*>(buf + off);
+      off += d->d_reclen;
+      const char* entry = d->d_name;
+      if (entry[0] == '.' && (entry[1] == '\0' || (entry[1] == '.' && entry[2] == '\0'))) continue;
+      if (d->d_type != DT_DIR) {
+        struct stat st {};
+        if (d->d_type != DT_UNKNOWN || ::fstatat(dir_fd_, entry, &st, 0) != 0 || !S_ISDIR(st.st_mode)) continue;
+      }
+
+      Group* g = nullptr;
+      Group* free_slot = nullptr;
+      for (Group& c : children_) {
+        if (c.used && std::strcmp(c.dir_name, entry) == 0) {
+          g = &c;
+          break;
+        }
+        if (!c.used && !free_slot) free_slot = &c;
+      }
+      if (!g) {
+        if (!free_slot || std::strlen(entry) >= sizeof(free_slot->dir_name)) {
+          ++untracked_children_;
+          continue;
+        }
+        g = free_slot;
+        g->used = true;
+        g->primed = false;
+        std::strcpy(g->dir_name, entry);
+        std::snprintf(path, sizeof(path), "%s/%s", dir_.c_str(), entry);
+        open_group(*g, path);
+        std::snprintf(path, sizeof(path), "%s/%s", self_.stats.name[1] ? self_.stats.name : "", entry);
+        sanitize_path(path, g->stats.name);
+      }
+      g->seen = true;
+      if (sample_group(*g, seconds, cpus)) child_stats_.push_back(g->stats);
+    }
+  }
+
+  // Removed groups free their slots and descriptors.
+  for (Group& g : children_) {
+    if (!g.used || g.seen) continue;
+    g.used = false;
+    g.cpu_stat.close();
+    g.cpu_max.close();
+    g.memory_current.close();
+    g.memory_max.close();
+  }
+}
+
+bool CgroupSource::append_detail_json(std::string& out) const {
+  if (setup_error_) return false;
+  append_stats_json(out, self_.stats, true);
+  if (cfg_.children) {
+    out.append(",\"children\":[");
+    for (std::size_t i = 0; i < child_stats_.size(); ++i) {
+      if (i) out.push_back(',');
+      append_stats_json(out, child_stats_[i], false);
+      out.push_back('}');
+    }
+    append_row(out, "],\"untracked_children\":%llu", static_cast<unsigned long long>(untracked_children_));
+  }
+  out.push_back('}');
+  return true;
+}
+
+void CgroupSource::append_openmetrics(std::string& out) const {
+  if (setup_error_) return;
+  const CgroupStats& s = self_.stats;
+  const auto& c = child_stats_;
+  append_family(out, s, c, "telemetry_cgroup_cpu_usage_percent", "CPU used, as a share of the cgroup's CPU limit.",
+                &CgroupStats::cpu_pct, true);
+  append_family(out, s, c, "telemetry_cgroup_cpu_limit_cores", "CPU quota, or the CPUs available without one.",
+                &CgroupStats::cpu_limit_cores, true);
+  append_family(out, s, c, "telemetry_cgroup_cpu_throttled_percent", "Share of quota periods that were throttled.",
+                &CgroupStats::cpu_throttled_pct, true);
+  append_family(out, s, c, "telemetry_cgroup_memory_current_bytes", "Memory charged to the cgroup.",
+                &CgroupStats::memory_current_bytes, true);
+  append_family(out, s, c, "telemetry_cgroup_memory_max_bytes", "Memory limit (memory.max), when set.",
+                &CgroupStats::memory_max_bytes, true, true);
+  append_family(out, s, c, "telemetry_cgroup_memory_working_set_bytes",
+                "Memory charged less inactive file cache.", &CgroupStats::memory_working_set_bytes, false);
+  append_family(out, s, c, "telemetry_cgroup_io_read_bytes_per_second", "Bytes read per second.",
+                &CgroupStats::io_read_bytes_per_s, false);
+  append_family(out, s, c, "telemetry_cgroup_io_write_bytes_per_second", "Bytes written per second.",
+                &CgroupStats::io_write_bytes_per_s, false);
+}
+
+}  // namespace telemetry::metrics
+
+#endif  // __linux__
@@ -0,0 +1,312 @@
+#include "telemetry/metrics/linux_declared_source.h"
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "telemetry/util/time.h"
+
+namespace telemetry::metrics {
+
+namespace {
+
+bool is_sep(char c) { return c == ' ' || c == '\t' || c == ':'; }
+bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+// Next blank-separated token of a declaration; empty at the end.
+std::string_view next_token(std::string_view& s) {
+  std::size_t i = 0;
+  while (i < s.size() && is_blank(s[i])) ++i;
+  std::size_t j = i;
+  while (j < s.size() && !is_blank(s[j])) ++j;
+  const std::string_view tok = s.substr(i, j - i);
+  s.remove_prefix(j);
+  return tok;
+}
+
+bool parse_index(std::string_view tok, std::size_t max, std::uint8_t& out) {
+  if (tok.empty() || tok.size() > 3) return false;
+  std::size_t v = 0;
+  for (const char c : tok) {
+    if (c < '0' || c > '9') return false;
+    v = v * 10 + static_cast<std::size_t>(c - '0');
+  }
+  if (v == 0 || v > max) return false;
+  out = static_cast<std::uint8_t>(v);
+  return true;
+}
+
+bool parse_scale(std::string_view tok, double& out) {
+  char buf[32];
+  if (tok.empty() || tok.size() >= sizeof(buf)) return false;
+  std::memcpy(buf, tok.data(), tok.size());
+  buf[tok.size()] = '\0';
+  char* end = nullptr;
+  out = std::strtod(buf, &end);
+  return *end == '\0' && std::isfinite(out);
+}
+
+bool valid_name(std::string_view name) {
+  if (name.empty()) return false;
+  for (std::size_t i = 0; i < name.size(); ++i) {
+    const char c = name[i];
+    const bool alpha = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    if (!alpha && (i == 0 || c < '0' || c > '9')) return false;
+  }
+  return true;
+}
+
+void copy_token(char* dst, std::size_t cap, std::string_view tok) {
+  const std::size_t n = std::min(tok.size(), cap - 1);
+  std::memcpy(dst, tok.data(), n);
+  dst[n] = '\0';
+}
+
+}  // namespace
+
+DeclaredSource::DeclaredSource(const char* root) : root_(root ? root : "") {}
+
+Status DeclaredSource::add_metric(std::string_view text) {
+  if (metrics_.size() == kMaxMetrics) return Status::InvalidArgument("too many declared metrics");
+  Metric m{};
+  const std::string_view name = next_token(text);
+  if (name.size() >= sizeof(m.name) || !valid_name(name)) return Status::InvalidArgument("bad metric name");
+  for (const Metric& other : metrics_) {
+    if (name == other.name) return Status::InvalidArgument("duplicate metric name");
+  }
+  copy_token(m.name, sizeof(m.name), name);
+
+  const std::string_view path = next_token(text);
+  if (path.size() < 2 || path[0] != '/' || path.size() >= 384) return Status::InvalidArgument("bad path");
+  if (path.find_first_of("\\\"") != std::string_view::npos) return Status::InvalidArgument("bad path");
+
+  const std::string_view mode = next_token(text);
+  if (mode == "value") {
+    m.mode = Mode::kValue;
+  } else if (mode == "key") {
+    m.mode = Mode::kKey;
+    const std::string_view key = next_token(text);
+    if (key.empty() || key.size() >= sizeof(m.key)) return Status::InvalidArgument("bad key");
+    copy_token(m.key, sizeof(m.key), key);
+    // "key Dirty" is field 2 of the line whose field 1 is "Dirty"; "key <k> <n>" field n + 1.
+    m.col = 2;
+    std::string_view rest = text;
+    const std::string_view n = next_token(rest);
+    std::uint8_t after = 0;
+    if (parse_index(n, kMaxFields - 1, after)) {
+      m.col = static_cast<std::uint8_t>(after + 1);
+      text = rest;
+    }
+  } else if (mode == "column") {
+    m.mode = Mode::kColumn;
+    if (!parse_index(next_token(text), kMaxFields, m.col)) return Status::InvalidArgument("bad column");
+    if (next_token(text) != "row") return Status::InvalidArgument("column needs row <key>");
+    const std::string_view key = next_token(text);
+    if (key.empty() || key.size() >= sizeof(m.key)) return Status::InvalidArgument("bad key");
+    copy_token(m.key, sizeof(m.key), key);
+  } else {
+    return Status::InvalidArgument("mode must be value, key or column");
+  }
+
+  for (std::string_view opt = next_token(text); !opt.empty(); opt = next_token(text)) {
+    if (opt == "scale") {
+      if (!parse_scale(next_token(text), m.scale)) return Status::InvalidArgument("bad scale");
+    } else if (opt == "rate") {
+      m.rate = true;
+    } else if (opt == "keycol" && m.mode == Mode::kColumn) {
+      if (!parse_index(next_token(text), kMaxFields, m.keycol)) return Status::InvalidArgument("bad keycol");
+    } else {
+      return Status::InvalidArgument("unknown option");
+    }
+  }
+  if (m.mode != Mode::kValue && m.col == m.keycol) return Status::InvalidArgument("column is the key column");
+
+  // Files are shared by path; a new one is opened now and its buffer sized to what it holds.
+  std::size_t fi = 0;
+  while (fi < files_.size() && files_[fi]->path != path) ++fi;
+  if (fi == files_.size()) {
+    auto f = std::make_unique<File>();
+    f->path.assign(path);
+    f->file.assign(root_.c_str(), f->path.c_str());
+    f->text.resize(4096);
+    while (f->file.open() && f->file.read_all(f->text.data(), f->text.size()) + 1 == f->text.size()) {
+      f->text.resize(f->text.size() * 2);
+    }
+    files_.push_back(std::move(f));
+  }
+  m.file = static_cast<std::uint32_t>(fi);
+  File& f = *files_[fi];
+  const std::uint32_t index = static_cast<std::uint32_t>(metrics_.size());
+  metrics_.push_back(m);
+
+  if (m.mode == Mode::kValue) {
+    f.whole.push_back(index);
+    return Status::Ok();
+  }
+  const auto before = [this](std::uint32_t a, std::uint32_t b) {
+    const Metric& x = metrics_[a];
+    const Metric& y = metrics_[b];
+    return x.keycol != y.keycol ? x.keycol < y.keycol : std::strcmp(x.key, y.key) < 0;
+  };
+  f.keyed.insert(std::upper_bound(f.keyed.begin(), f.keyed.end(), index, before), index);
+  if (std::find(f.keycols.begin(), f.keycols.end(), m.keycol) == f.keycols.end()) {
+    f.keycols.insert(std::upper_bound(f.keycols.begin(), f.keycols.end(), m.keycol), m.keycol);
+  }
+  return Status::Ok();
+}
+
+Status DeclaredSource::load_file(const char* path, std::size_t* error_line) {
+  std::FILE* f = std::fopen(path, "r");
+  if (!f) return Status::IoError("open metrics config failed");
+
+  char line[512];
+  std::size_t lineno = 0;
+  Status st = Status::Ok();
+  while (st.ok() && std::fgets(line, sizeof(line), f)) {
+    ++lineno;
+    // fgets splits a line that does not fit; the rest would be read as a line of its own.
+    if (!std::strchr(line, '\n') && std::fgetc(f) != EOF) {
+      st = Status::InvalidArgument("metrics config line too long");
+      break;
+    }
+    const char* p = line;
+    while (*p == ' ' || *p == '\t') ++p;
+    if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') continue;
+    st = add_metric(p);
+  }
+  std::fclose(f);
+  if (!st.ok() && error_line) *error_line = lineno;
+  return st;
+}
+
+bool DeclaredSource::value(std::size_t metric, double& out) const {
+  if (metric >= metrics_.size() || !metrics_[metric].valid) return false;
+  out = metrics_[metric].value;
+  return true;
+}
+
+void DeclaredSource::store(Metric& m, const char* field) {
+  if (m.found) return;  // the first matching line wins
+  if (m.rate) {
+    if (*field < '0' || *field > '9') return;
+    const std::uint64_t cur = parse_proc_u64(field);
+    m.found = true;
+    m.valid = m.primed && seconds_ > 0.0;
+    if (m.valid) m.value = per_second(counter_delta(m.prev, cur), seconds_) * m.scale;
+    m.prev = cur;
+    m.primed = true;
+    return;
+  }
+  char* end = nullptr;
+  const double v = std::strtod(field, &end);
+  if (end == field || !std::isfinite(v)) return;
+  m.found = true;
+  m.valid = true;
+  m.value = v * m.scale;
+}
+
+void DeclaredSource::parse_file(File& f) {
+  if (!f.file.open()) return;
+  std::size_t len = f.file.read_all(f.text.data(), f.text.size());
+  // The file outgrew the buffer sized at load: grow it and read again.
+  while (len != 0 && len + 1 == f.text.size()) {
+    f.text.resize(f.text.size() * 2);
+    len = f.file.read_all(f.text.data(), f.text.size());
+  }
+  if (len == 0) return;
+
+  const char* p = f.text.data();
+  if (!f.whole.empty()) {
+    const char* first = p;
+    while (is_blank(*first)) ++first;
+    for (const std::uint32_t i : f.whole) store(metrics_[i], first);
+  }
+  if (f.keyed.empty()) return;
+
+  // One pass over the lines; each line is split once and looked up once per key column.
+  const char* fields[kMaxFields];
+  std::size_t lens[kMaxFields];
+  while (*p) {
+    std::size_t n = 0;
+    while (*p && *p != '\n') {
+      while (is_sep(*p)) ++p;
+      if (!*p || *p == '\n') break;
+      const char* start = p;
+      while (*p && *p != '\n' && !is_sep(*p)) ++p;
+      if (n < kMaxFields) {
+        fields[n] = start;
+        lens[n] = static_cast<std::size_t>(p - start);
+        ++n;
+      }
+    }
+    if (*p == '\n') ++p;
+
+    for (const std::uint8_t kc : f.keycols) {
+      if (kc > n) break;
+      const std::string_view key(fields[kc - 1], lens[kc - 1]);
+      const auto lo = std::partition_point(f.keyed.begin(), f.keyed.end(), [&](std::uint32_t i) {
+        const Metric& m = metrics_[i];
+        return m.keycol != kc ? m.keycol < kc : std::string_view(m.key) < key;
+      });
+      for (auto it = lo; it != f.keyed.end(); ++it) {
+        Metric& m = metrics_[*it];
+        if (m.keycol != kc || std::string_view(m.key) != key) break;
+        if (m.col <= n) store(m, fields[m.col - 1]);
+      }
+    }
+  }
+}
+
+Status DeclaredSource::collect(MetricsSnapshot&) { return sample(telemetry::util::monotonic_ns()); }
+
+Status DeclaredSource::sample(std::uint64_t now_ns) {
+  seconds_ = prev_ns_ != 0 && now_ns > prev_ns_ ? static_cast<double>(now_ns - prev_ns_) / 1e9 : 0.0;
+  prev_ns_ = now_ns;
+  for (Metric& m : metrics_) m.found = false;
+  for (auto& f : files_) parse_file(*f);
+
+  bool any = false;
+  for (Metric& m : metrics_) {
+    if (m.found) {
+      any = true;
+    } else {
+      // Gone from the file (device removed, key renamed): a later rate restarts from scratch.
+      m.valid = false;
+      m.primed = false;
+    }
+  }
+  return any || metrics_.empty() ? Status::Ok() : Status::Unavailable("no declared metric found");
+}
+
+bool DeclaredSource::append_detail_json(std::string& out) const {
+  if (metrics_.empty()) return false;
+  out.push_back('{');
+  for (std::size_t i = 0; i < metrics_.size(); ++i) {
+    const Metric& m = metrics_[i];
+    if (m.valid) {
+      append_row(out, "%s\"%s\":%.15g", i ? "," : "", m.name, m.value);
+    } else {
+      append_row(out, "%s\"%s\":null", i ? "," : "", m.name);
+    }
+  }
+  out.push_back('}');
+  return true;
+}
+
+void DeclaredSource::append_openmetrics(std::string& out) const {
+  for (const Metric& m : metrics_) {
+    if (!m.valid) continue;
+    append_row(out, "# TYPE telemetry_%s gauge\n", m.name);
+    append_row(out, "# HELP telemetry_%s Declared from %s%s.\n", m.name, files_[m.file]->path.c_str(),
+               m.rate ? " (per second)" : "");
+    append_row(out, "telemetry_%s %.15g\n", m.name, m.value);
+  }
+}
+
+}  // namespace telemetry::metrics
+
+#endif  // __linux__
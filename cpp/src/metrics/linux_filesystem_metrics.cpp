@@ -0,0 +1,268 @@
+#include "telemetry/metrics/linux_filesystem_source.h"
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include <poll.h>
+#include <sys/statvfs.h>
+
+#include "telemetry/util/time.h"
+
+namespace telemetry::metrics {
+
+namespace {
+
+// Kernel and container plumbing rather than storage.
+constexpr const char* kPseudoTypes[] = {
+    "autofs",     "binfmt_misc", "bpf",      "cgroup",    "cgroup2",  "configfs", "debugfs",   "devpts",
+    "devtmpfs",   "efivarfs",    "fusectl",  "hugetlbfs", "mqueue",   "nsfs",     "proc",      "pstore",
+    "ramfs",      "rpc_pipefs",  "securityfs", "selinuxfs", "sysfs",  "tracefs",  "squashfs",  "iso9660",
+    "overlay"};
+// statvfs() on these waits for a server or cluster, as it does on any "fuse.*" filesystem.
+constexpr const char* kNetworkTypes[] = {"nfs",    "nfs4", "cifs",   "smb3",  "smbfs", "ceph",  "glusterfs", "9p",
+                                         "lustre", "gpfs", "beegfs", "davfs", "afs",   "ncpfs", "coda",      "orangefs",
+                                         "pvfs2"};
+
+bool type_in(const char* type, std::size_t len, const char* const* list, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    if (std::strlen(list[i]) == len && std::memcmp(list[i], type, len) == 0) return true;
+  }
+  return false;
+}
+
+// statvfs() runs on the event loop, where one hung mount would stall every client, so
+// anything that may be remote is left out: known network and cluster types, FUSE daemons,
+// and sources naming a server ("host:/export", "//host/share") whatever their type.
+bool is_network(const char* type, std::size_t type_len, const char* source, std::size_t source_len) {
+  if (type_in(type, type_len, kNetworkTypes, std::size(kNetworkTypes))) return true;
+  if (type_len > 5 && std::memcmp(type, "fuse.", 5) == 0) return true;
+  if (source_len > 2 && source[0] == '/' && source[1] == '/') return true;
+  const void* colon = std::memchr(source, ':', source_len);
+  return colon != nullptr && static_cast<const char*>(colon) + 1 < source + source_len &&
+         static_cast<const char*>(colon)[1] == '/';
+}
+
+// Next blank-separated field of a mountinfo line; `p` ends on the separator.
+bool next_field(const char*& p, const char*& start, std::size_t& len) {
+  while (*p == ' ') ++p;
+  if (*p == '\0' || *p == '\n') return false;
+  start = p;
+  while (*p && *p != ' ' && *p != '\n') ++p;
+  len = static_cast<std::size_t>(p - start);
+  return true;
+}
+
+// mountinfo escapes blanks, newlines and backslashes in paths as \ooo octal; decodes them.
+std::size_t unescape(char* dst, std::size_t cap, const char* src, std::size_t len) {
+  std::size_t n = 0;
+  for (std::size_t i = 0; i < len && n + 1 < cap; ++i) {
+    if (src[i] == '\\' && i + 3 < len && src[i + 1] >= '0' && src[i + 1] <= '3' &&
+        src[i + 2] >= '0' && src[i + 2] <= '7' && src[i + 3] >= '0' && src[i + 3] <= '7') {
+      dst[n++] = static_cast<char>((src[i + 1] - '0') * 64 + (src[i + 2] - '0') * 8 + (src[i + 3] - '0'));
+      i += 3;
+    } else {
+      dst[n++] = src[i];
+    }
+  }
+  dst[n] = '\0';
+  return n;
+}
+
+// A copy safe inside a JSON string and an OpenMetrics label value.
+void copy_label(char* dst, std::size_t cap, const char* src) {
+  std::size_t n = 0;
+  for (; *src && n + 1 < cap; ++src) {
+    const unsigned char c = static_cast<unsigned char>(*src);
+    dst[n++] = c < 0x20 || c == '"' || c == '\\' || c == 0x7F ? '_' : *src;
+  }
+  dst[n] = '\0';
+}
+
+// One gauge family with a sample per filesystem statvfs() answered for.
+template <class F>
+void append_family(std::string& out, const std::vector<FilesystemStats>& stats, const char* family, const char* help,
+                   F value) {
+  bool header = false;
+  for (const FilesystemStats& s : stats) {
+    if (!s.ok) continue;
+    if (!header) {
+      append_row(out, "# TYPE %s gauge\n# HELP %s %s\n", family, family, help);
+      header = true;
+    }
+    append_row(out, "%s{mount=\"%s\",fstype=\"%s\"} ", family, s.mount, s.fstype);
+    value(s);
+  }
+}
+
+}  // namespace
+
+FilesystemSource::FilesystemSource(const char* root) : root_(root ? root : "") {
+  mountinfo_.assign(root, "/proc/self/mountinfo");
+  // Opened now so mount_watch() is armed before the first sample.
+  (void)mountinfo_.open();
+  text_.resize(16 * 1024);
+}
+
+short FilesystemSource::MountWatch::events() const { return POLLPRI; }
+
+bool FilesystemSource::MountWatch::on_ready(short revents) {
+  // mountinfo reports a change as POLLPRI | POLLERR, once per change.
+  if (revents & (POLLPRI | POLLERR)) src_.mounts_changed();
+  return false;
+}
+
+bool FilesystemSource::parse_mounts() {
+  if (!mountinfo_.open()) return false;
+  std::size_t len = mountinfo_.read_all(text_.data(), text_.size());
+  while (len != 0 && len + 1 == text_.size()) {
+    text_.resize(text_.size() * 2);
+    len = mountinfo_.read_all(text_.data(), text_.size());
+  }
+  if (len == 0) return false;
+  ++parses_;
+  stats_.clear();
+  paths_.clear();
+
+  // 36 35 98:0 /mnt1 /mnt/parent rw,noatime master:1 - ext3 /dev/root rw,errors=continue
+  // Devices listed so far, parallel to stats_.
+  std::vector<std::uint64_t> devices;
+  const char* p = text_.data();
+  while (*p && stats_.size() < kMaxMounts) {
+    const char* line = p;
+    const char* nl = std::strchr(line, '\n');
+    p = nl ? nl + 1 : line + std::strlen(line);
+
+    const char* q = line;
+    const char* f[6];
+    std::size_t flen[6];
+    bool ok = true;
+    for (int i = 0; i < 6 && ok; ++i) ok = next_field(q, f[i], flen[i]);
+    if (!ok) continue;
+    // Optional fields up to the " - " separator, then type and source.
+    const char* start = nullptr;
+    std::size_t n = 0;
+    while ((ok = next_field(q, start, n)) && !(n == 1 && *start == '-')) {
+    }
+    const char* type = nullptr;
+    std::size_t type_len = 0;
+    const char* source = nullptr;
+    std::size_t source_len = 0;
+    if (!ok || !next_field(q, type, type_len) || !next_field(q, source, source_len)) continue;
+
+    const bool is_root = flen[4] == 1 && f[4][0] == '/';
+    if (is_network(type, type_len, source, source_len)) continue;
+    if (type_in(type, type_len, kPseudoTypes, std::size(kPseudoTypes)) &&
+        !(is_root && type_len == 7 && std::memcmp(type, "overlay", 7) == 0)) {
+      continue;
+    }
+    const char* dev = f[2];
+    const std::uint64_t major = parse_proc_u64(dev);
+    if (*dev == ':') ++dev;
+    const std::uint64_t device = major << 32 | parse_proc_u64(dev);
+    char decoded[512];
+    unescape(decoded, sizeof(decoded), f[4], flen[4]);
+    std::string path = root_ + decoded;
+
+    // Mounted over an earlier mount: statvfs() sees only the later one, which takes its
+    // place, so the earlier mount's device no longer counts as listed.
+    const std::size_t slot = static_cast<std::size_t>(std::find(paths_.begin(), paths_.end(), path) - paths_.begin());
+    // A device already listed: a bind mount, or the same filesystem mounted twice.
+    bool listed = false;
+    for (std::size_t i = 0; i < devices.size() && !listed; ++i) listed = i != slot && devices[i] == device;
+    if (listed) {
+      // Covered by a device listed elsewhere: the earlier mount is gone too.
+      if (slot != paths_.size()) {
+        paths_.erase(paths_.begin() + static_cast<std::ptrdiff_t>(slot));
+        stats_.erase(stats_.begin() + static_cast<std::ptrdiff_t>(slot));
+        devices.erase(devices.begin() + static_cast<std::ptrdiff_t>(slot));
+      }
+      continue;
+    }
+
+    FilesystemStats s{};
+    copy_label(s.mount, sizeof(s.mount), decoded);
+    unescape(decoded, sizeof(decoded), type, type_len);
+    copy_label(s.fstype, sizeof(s.fstype), decoded);
+    unescape(decoded, sizeof(decoded), source, source_len);
+    copy_label(s.device, sizeof(s.device), decoded);
+    if (slot != paths_.size()) {
+      stats_[slot] = s;
+      devices[slot] = device;
+      continue;
+    }
+    paths_.push_back(std::move(path));
+    stats_.push_back(s);
+    devices.push_back(device);
+  }
+  return true;
+}
+
+Status FilesystemSource::collect(MetricsSnapshot&) { return sample(telemetry::util::monotonic_ns()); }
+
+Status FilesystemSource::sample(std::uint64_t) {
+  if (reparse_) {
+    // Cleared first: a change that lands during the parse is reported again and re-read.
+    reparse_ = false;
+    if (!parse_mounts()) {
+      reparse_ = true;
+      available_ = false;
+      return Status::Unavailable("read /proc/self/mountinfo failed");
+    }
+  }
+  available_ = true;
+  for (std::size_t i = 0; i < stats_.size(); ++i) {
+    FilesystemStats& s = stats_[i];
+    struct statvfs vfs {};
+    s.ok = ::statvfs(paths_[i].c_str(), &vfs) == 0 && vfs.f_blocks != 0;
+    if (!s.ok) continue;
+    const std::uint64_t frsize = vfs.f_frsize ? vfs.f_frsize : vfs.f_bsize;
+    s.size_bytes = static_cast<std::uint64_t>(vfs.f_blocks) * frsize;
+    s.used_bytes = static_cast<std::uint64_t>(vfs.f_blocks - vfs.f_bfree) * frsize;
+    s.avail_bytes = static_cast<std::uint64_t>(vfs.f_bavail) * frsize;
+    const std::uint64_t usable = s.used_bytes + s.avail_bytes;
+    s.used_pct = usable != 0 ? static_cast<double>(s.used_bytes) / static_cast<double>(usable) * 100.0 : 0.0;
+    s.inodes = vfs.f_files;
+    s.inodes_free = vfs.f_ffree;
+  }
+  return Status::Ok();
+}
+
+bool FilesystemSource::append_detail_json(std::string& out) const {
+  if (!available_) return false;
+  append_row(out, "{\"mount_table_parses\":%llu,\"filesystems\":[", static_cast<unsigned long long>(parses_));
+  bool first = true;
+  for (const FilesystemStats& s : stats_) {
+    if (!s.ok) continue;
+    append_row(out, "%s{\"mount\":\"%s\",\"fstype\":\"%s\",\"device\":\"%s\",", first ? "" : ",", s.mount, s.fstype,
+               s.device);
+    append_row(out, "\"size_bytes\":%llu,\"used_bytes\":%llu,\"avail_bytes\":%llu,\"used_pct\":%.2f,",
+               static_cast<unsigned long long>(s.size_bytes), static_cast<unsigned long long>(s.used_bytes),
+               static_cast<unsigned long long>(s.avail_bytes), s.used_pct);
+    append_row(out, "\"inodes\":%llu,\"inodes_free\":%llu}", static_cast<unsigned long long>(s.inodes),
+               static_cast<unsigned long long>(s.inodes_free));
+    first = false;
+  }
+  out.append("]}");
+  return true;
+}
+
+void FilesystemSource::append_openmetrics(std::string& out) const {
+  if (!available_) return;
+  const auto u64 = [&](std::uint64_t v) { append_row(out, "%llu\n", static_cast<unsigned long long>(v)); };
+  append_family(out, stats_, "telemetry_filesystem_size_bytes", "Filesystem size.",
+                [&](const FilesystemStats& s) { u64(s.size_bytes); });
+  append_family(out, stats_, "telemetry_filesystem_avail_bytes", "Free space available to unprivileged users.",
+                [&](const FilesystemStats& s) { u64(s.avail_bytes); });
+  append_family(out, stats_, "telemetry_filesystem_used_percent", "Used share of the space available to users.",
+                [&](const FilesystemStats& s) { append_row(out, "%.2f\n", s.used_pct); });
+  append_family(out, stats_, "telemetry_filesystem_inodes_free", "Free inodes.",
+                [&](const FilesystemStats& s) { u64(s.inodes_free); });
+}
+
+}  // namespace telemetry::metrics
+
+#endif  // __linux__
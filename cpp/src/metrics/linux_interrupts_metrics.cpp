@@ -0,0 +1,488 @@
+#include "telemetry/metrics/linux_interrupts_source.h"
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "telemetry/metrics/counter_scan.h"
+#include "telemetry/util/time.h"
+
+namespace telemetry::metrics {
+
+namespace {
+
+// scan_counters() reads whole 16-byte blocks, so buffers keep this much past their NUL.
+constexpr std::size_t kScanSlack = 16;
+
+// Lower rank = hotter, for a min-heap whose front is the coolest of the kept IRQs.
+bool hotter(const IrqStats& a, const IrqStats& b) { return a.per_s > b.per_s; }
+
+// Copies [p, end) into `out`, trimming blanks at both ends, folding runs of blanks into one
+// and replacing what cannot go into a JSON string or an OpenMetrics label.
+void copy_label(char* out, std::size_t cap, const char* p, const char* end) {
+  while (p < end && (*p == ' ' || *p == '\t')) ++p;
+  std::size_t n = 0;
+  bool blank = false;
+  for (; p < end && n + 1 < cap; ++p) {
+    const char c = *p;
+    if (c == ' ' || c == '\t') {
+      blank = true;
+      continue;
+    }
+    if (blank && n != 0 && n + 2 < cap) out[n++] = ' ';
+    blank = false;
+    out[n++] = (c < 0x20 || c == '"' || c == '\\' || c == 0x7f) ? '_' : c;
+  }
+  out[n] = '\0';
+}
+
+// Parses the "CPU0 CPU1 ..." header into `columns`; returns false if it differs from what
+// `columns` already holds (rewriting it), e.g. after a CPU went on- or offline.
+bool parse_header(const char*& p, std::vector<std::int32_t>& columns) {
+  std::size_t n = 0;
+  bool same = true;
+  std::int32_t ids[64];
+  std::size_t pending = 0;
+  const auto flush = [&]() {
+    for (std::size_t i = 0; i < pending; ++i) {
+      if (n + i < columns.size() && columns[n + i] == ids[i]) continue;
+      same = false;
+      if (n + i >= columns.size()) columns.resize(n + i + 1);
+      columns[n + i] = ids[i];
+    }
+    n += pending;
+    pending = 0;
+  };
+  while (*p && *p != '\n') {
+    while (*p == ' ' || *p == '\t') ++p;
+    if (std::strncmp(p, "CPU", 3) != 0) break;
+    p += 3;
+    ids[pending++] = static_cast<std::int32_t>(parse_proc_u64(p));
+    if (pending == 64) flush();
+    if (n + pending == InterruptsSource::kMaxCpus) break;
+  }
+  flush();
+  if (n != columns.size()) {
+    columns.resize(n);
+    same = false;
+  }
+  const char* nl = std::strchr(p, '\n');
+  p = nl ? nl + 1 : p + std::strlen(p);
+  return same;
+}
+
+// The counter cells of a fixed-width row: `ncols` cells of `width` bytes from `cells`, each a
+// blank and then one right-aligned number, as the kernel's "%10u" columns are. Returns the
+// width, or 0 if the row is laid out any other way.
+std::size_t cell_width(const char* cells, const char* end, std::size_t ncols) {
+  const std::size_t bytes = static_cast<std::size_t>(end - cells);
+  if (ncols == 0 || bytes % ncols != 0) return 0;
+  const std::size_t width = bytes / ncols;
+  if (width < 2 || width > UINT8_MAX) return 0;
+  for (const char* c = cells; c < end; c += width) {
+    if ((c[0] != ' ' && c[0] != '\t') || c[width - 1] < '0' || c[width - 1] > '9') return 0;
+  }
+  return width;
+}
+
+// Whether a cell of the new text still holds one right-aligned number: blanks, then digits
+// up to its last byte.
+bool valid_cell(const char* c, std::size_t width) {
+  if (c[0] != ' ' && c[0] != '\t') return false;
+  std::size_t i = 1;
+  while (i < width && (c[i] == ' ' || c[i] == '\t')) ++i;
+  if (i == width) return false;
+  for (; i < width; ++i) {
+    if (c[i] < '0' || c[i] > '9') return false;
+  }
+  return true;
+}
+
+std::uint64_t parse_cell(const char* c, std::size_t width) {
+  std::size_t i = 0;
+  while (c[i] == ' ' || c[i] == '\t') ++i;
+  std::uint64_t v = 0;
+  for (; i < width; ++i) v = v * 10 + static_cast<std::uint64_t>(c[i] - '0');
+  return v;
+}
+
+// Compares `len` bytes of a row with the same row of the previous text and lists, in column
+// order, the cells that differ. False if a byte outside the cells differs (a new label or
+// description, a line that grew or shrank), a changed cell no longer holds one number, or
+// more than `max_changed` cells differ: past that, scanning the whole row is cheaper than
+// parsing its cells one by one. Both buffers must be readable 15 bytes past `len`.
+bool diff_cells(const char* cur, const char* prev, std::size_t len, std::size_t cells, std::size_t width,
+                std::size_t ncols, std::size_t max_changed, std::uint32_t* changed, std::size_t& nchanged) {
+  const std::size_t cells_end = cells + ncols * width;
+  std::size_t skip_to = 0;  // bytes before this belong to a cell already listed
+  nchanged = 0;
+  for (std::size_t i = 0; i < len; i += 16) {
+#if defined(__SSE2__)
+    // Most of a row is unchanged: step over it 64 bytes at a time.
+    while (i + 64 <= len) {
+      __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i)),
+                                  _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + i)));
+      for (std::size_t k = 16; k < 64; k += 16) {
+        eq = _mm_and_si128(eq, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i + k)),
+                                              _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + i + k))));
+      }
+      if (_mm_movemask_epi8(eq) != 0xFFFF) break;
+      i += 64;
+    }
+    if (i >= len) break;
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + i));
+    unsigned diff = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b))) & 0xFFFFu;
+#else
+    unsigned diff = 0;
+    for (unsigned k = 0; k < 16; ++k) diff |= static_cast<unsigned>(cur[i + k] != prev[i + k]) << k;
+#endif
+    if (len - i < 16) diff &= (1u << (len - i)) - 1u;
+    if (skip_to > i) diff &= skip_to - i >= 16 ? 0u : ~0u << (skip_to - i);
+    while (diff != 0) {
+      const std::size_t at = i + static_cast<std::size_t>(__builtin_ctz(diff));
+      if (at < cells || at >= cells_end) return false;
+      const std::size_t col = (at - cells) / width;
+      if (nchanged == max_changed || !valid_cell(cur + cells + col * width, width)) return false;
+      changed[nchanged++] = static_cast<std::uint32_t>(col);
+      skip_to = cells + (col + 1) * width;
+      diff &= skip_to - i >= 16 ? 0u : ~0u << (skip_to - i);
+    }
+  }
+  return true;
+}
+
+std::size_t count_lines(const char* p) {
+  std::size_t n = 0;
+  while ((p = std::strchr(p, '\n')) != nullptr) {
+    ++n;
+    ++p;
+  }
+  return n;
+}
+
+}  // namespace
+
+InterruptsSource::InterruptsSource(const InterruptsConfig& cfg) : cfg_(cfg) {
+  cfg_.top_k = std::clamp<std::size_t>(cfg_.top_k, 1, kMaxTopK);
+  init_matrix(interrupts_, "/proc/interrupts");
+  init_matrix(softirqs_, "/proc/softirqs");
+  heap_.reserve(cfg_.top_k);
+  top_.reserve(cfg_.top_k);
+  softirq_stats_.reserve(softirqs_.rows.size());
+  cpu_stats_.reserve(interrupts_.columns.size());
+}
+
+void InterruptsSource::init_matrix(Matrix& m, const char* path) {
+  m.file.assign(cfg_.root, path);
+  // Read the file whole once to size everything: the text buffer with room to grow, the
+  // columns, and twice the rows present for IRQs registered later.
+  std::size_t len = 0;
+  m.text.resize(64 * 1024);
+  while (m.file.open()) {
+    len = m.file.read_all(m.text.data(), m.text.size() - kScanSlack);
+    if (len + 1 < m.text.size() - kScanSlack) break;
+    m.text.resize(m.text.size() * 2);
+  }
+  std::size_t rows = 0;
+  if (len != 0) {
+    const char* p = m.text.data();
+    (void)parse_header(p, m.columns);
+    rows = count_lines(p);
+  }
+  m.text.resize(std::max<std::size_t>(4096, len + len / 2) + kScanSlack);
+  m.prev_text.resize(m.text.size());
+  const std::size_t slots = rows * 2 + 16;
+  m.rows.resize(slots);
+  m.used.assign(slots, 0);
+  m.seen.assign(slots, 0);
+  m.primed.assign(slots, 0);
+  m.row_off.assign(slots, 0);
+  m.row_len.assign(slots, 0);
+  m.cell_width.assign(slots, 0);
+  m.prev.resize(slots * std::max<std::size_t>(m.columns.size(), 1));
+  m.cur.resize(std::max<std::size_t>(m.columns.size(), 1));
+  m.changed.resize(m.cur.size());
+  m.cpu_delta.resize(m.columns.size());
+}
+
+std::size_t InterruptsSource::find_slot(Matrix& m, const char* label, std::size_t len) {
+  const auto matches = [&](std::size_t i) {
+    return m.used[i] && std::strlen(m.rows[i].irq) == len && std::memcmp(m.rows[i].irq, label, len) == 0;
+  };
+  // Rows come in the same order every sample, so the slot after the previous hit is tried first.
+  if (m.hint < m.rows.size() && matches(m.hint)) return m.hint++;
+  std::size_t free_slot = SIZE_MAX;
+  for (std::size_t i = 0; i < m.rows.size(); ++i) {
+    if (matches(i)) {
+      m.hint = i + 1;
+      return i;
+    }
+    if (!m.used[i] && free_slot == SIZE_MAX) free_slot = i;
+  }
+  if (free_slot == SIZE_MAX) {
+    ++m.untracked;
+    return SIZE_MAX;
+  }
+  m.rows[free_slot] = IrqStats{};
+  copy_label(m.rows[free_slot].irq, sizeof(m.rows[free_slot].irq), label, label + len);
+  m.used[free_slot] = 1;
+  m.primed[free_slot] = 0;
+  m.hint = free_slot + 1;
+  return free_slot;
+}
+
+template <class F>
+bool InterruptsSource::parse_matrix(Matrix& m, F on_row) {
+  if (!m.file.open()) return false;
+  std::size_t len = m.file.read_all(m.text.data(), m.text.size() - kScanSlack);
+  // The file outgrew the buffer (IRQs registered since): grow it and read again.
+  while (len != 0 && len + 1 == m.text.size() - kScanSlack) {
+    m.text.resize(m.text.size() * 2);
+    len = m.file.read_all(m.text.data(), m.text.size() - kScanSlack);
+  }
+  if (len == 0) return false;
+
+  const char* p = m.text.data();
+  if (!parse_header(p, m.columns)) {
+    // CPUs went on- or offline: columns moved, so no row has a comparable previous sample.
+    std::fill(m.primed.begin(), m.primed.end(), 0);
+    m.prev.resize(m.rows.size() * std::max<std::size_t>(m.columns.size(), 1));
+    m.cur.resize(std::max<std::size_t>(m.columns.size(), 1));
+    m.changed.resize(m.cur.size());
+    m.cpu_delta.resize(m.columns.size());
+  }
+  const std::size_t ncols = m.columns.size();
+  std::fill(m.cpu_delta.begin(), m.cpu_delta.end(), 0);
+  std::fill(m.seen.begin(), m.seen.end(), 0);
+  m.untracked = 0;
+
+  //  44:   19842   0   PCI-MSIX-0000:00:05.0   2-edge      virtio4-tx
+  // NMI:   0   0   Non-maskable interrupts
+  // ERR:   0                                  (one system-wide counter)
+  const char* const text = m.text.data();
+  bool cur_zero = false;  // m.cur holds no deltas of an earlier row
+  while (*p) {
+    const char* line = p;
+    while (*p == ' ') ++p;
+    const char* label = p;
+    const char* colon = p;
+    while (*colon && *colon != ':' && *colon != '\n') ++colon;
+    if (*colon != ':') {
+      p = *colon ? colon + 1 : colon;
+      continue;
+    }
+    p = colon + 1;
+    const std::size_t slot = find_slot(m, label, static_cast<std::size_t>(colon - label));
+    const std::size_t off = static_cast<std::size_t>(line - text);
+    const std::size_t cells = static_cast<std::size_t>(p - line);
+
+    // Same row at the same offset as last sample: only its changed cells need parsing. Rows
+    // that count on most CPUs (LOC, RES, the softirqs) change everywhere and are scanned.
+    std::size_t nchanged = 0;
+    if (slot != SIZE_MAX && m.primed[slot] && m.cell_width[slot] != 0 && m.row_off[slot] == off &&
+        off + m.row_len[slot] <= std::min(len, m.prev_len) &&
+        diff_cells(line, m.prev_text.data() + off, m.row_len[slot] + 1, cells, m.cell_width[slot], ncols,
+                   ncols / 8, m.changed.data(), nchanged)) {
+      const std::size_t width = m.cell_width[slot];
+      std::uint64_t* prev = &m.prev[slot * ncols];
+      if (!cur_zero) std::fill_n(m.cur.data(), ncols, 0);
+      std::uint64_t total = 0;
+      std::size_t top_col = SIZE_MAX;
+      std::uint64_t top_delta = 0;
+      for (std::size_t k = 0; k < nchanged; ++k) {
+        const std::size_t c = m.changed[k];
+        const std::uint64_t cur = parse_cell(p + c * width, width);
+        const std::uint64_t d = counter_delta(prev[c], cur);
+        prev[c] = cur;
+        m.cur[c] = d;
+        total += d;
+        m.cpu_delta[c] += d;
+        if (d > top_delta) {
+          top_delta = d;
+          top_col = c;
+        }
+      }
+      m.seen[slot] = 1;
+      on_row(slot, ncols, true, total, top_col, top_delta);
+      for (std::size_t k = 0; k < nchanged; ++k) m.cur[m.changed[k]] = 0;
+      cur_zero = true;
+      p = line + m.row_len[slot];
+      if (*p == '\n') ++p;
+      continue;
+    }
+
+    cur_zero = false;
+    const char* cells_begin = p;
+    const std::size_t n = scan_counters(p, m.cur.data(), std::max<std::size_t>(ncols, 1));
+    const char* nl = std::strchr(p, '\n');
+    const char* eol = nl ? nl : p + std::strlen(p);
+    if (slot != SIZE_MAX) {
+      IrqStats& row = m.rows[slot];
+      if (!m.primed[slot]) copy_label(row.desc, sizeof(row.desc), p, eol);
+      m.seen[slot] = 1;
+      // Rows with fewer counters than CPUs are system-wide totals, not per-CPU columns.
+      const bool per_cpu = n == ncols && ncols != 0;
+      m.row_off[slot] = static_cast<std::uint32_t>(off);
+      m.row_len[slot] = static_cast<std::uint32_t>(eol - line);
+      m.cell_width[slot] = static_cast<std::uint8_t>(per_cpu ? cell_width(cells_begin, p, ncols) : 0);
+      std::uint64_t* prev = &m.prev[slot * std::max<std::size_t>(ncols, 1)];
+      std::uint64_t total = 0;
+      std::size_t top_col = SIZE_MAX;
+      std::uint64_t top_delta = 0;
+      for (std::size_t c = 0; c < n; ++c) {
+        const std::uint64_t cur = m.cur[c];
+        const std::uint64_t d = m.primed[slot] ? counter_delta(prev[c], cur) : 0;
+        prev[c] = cur;
+        m.cur[c] = d;
+        total += d;
+        if (per_cpu) {
+          m.cpu_delta[c] += d;
+          if (d > top_delta) {
+            top_delta = d;
+            top_col = c;
+          }
+        }
+      }
+      if (m.primed[slot]) on_row(slot, n, per_cpu, total, top_col, top_delta);
+      m.primed[slot] = 1;
+    }
+    p = nl ? nl + 1 : eol;
+  }
+
+  for (std::size_t i = 0; i < m.rows.size(); ++i) {
+    if (m.used[i] && !m.seen[i]) m.used[i] = 0;
+  }
+  // This text is what the next sample compares against.
+  m.text.swap(m.prev_text);
+  m.prev_len = len;
+  return true;
+}
+
+Status InterruptsSource::collect(MetricsSnapshot&) { return sample(telemetry::util::monotonic_ns()); }
+
+Status InterruptsSource::sample(std::uint64_t now_ns) {
+  const double seconds = prev_ns_ != 0 && now_ns > prev_ns_ ? static_cast<double>(now_ns - prev_ns_) / 1e9 : 0.0;
+  prev_ns_ = now_ns;
+
+  heap_.clear();
+  irq_per_s_ = 0.0;
+  const bool have_irqs = parse_matrix(
+      interrupts_, [&](std::size_t slot, std::size_t, bool per_cpu, std::uint64_t total, std::size_t top_col,
+                       std::uint64_t top_delta) {
+        IrqStats s = interrupts_.rows[slot];
+        s.per_s = per_second(total, seconds);
+        s.top_cpu = per_cpu && top_col != SIZE_MAX ? interrupts_.columns[top_col] : -1;
+        s.top_cpu_pct = total != 0 && per_cpu ? static_cast<double>(top_delta) / static_cast<double>(total) * 100.0 : 0.0;
+        irq_per_s_ += s.per_s;
+        if (heap_.size() < cfg_.top_k) {
+          heap_.push_back(s);
+          std::push_heap(heap_.begin(), heap_.end(), hotter);
+        } else if (hotter(s, heap_.front())) {
+          std::pop_heap(heap_.begin(), heap_.end(), hotter);
+          heap_.back() = s;
+          std::push_heap(heap_.begin(), heap_.end(), hotter);
+        }
+      });
+  std::sort_heap(heap_.begin(), heap_.end(), hotter);
+  top_.swap(heap_);
+
+  cpu_stats_.resize(interrupts_.columns.size());
+  for (std::size_t c = 0; c < cpu_stats_.size(); ++c) {
+    cpu_stats_[c] = CpuIrqStats{};
+    cpu_stats_[c].cpu = interrupts_.columns[c];
+    cpu_stats_[c].irq_per_s = per_second(interrupts_.cpu_delta[c], seconds);
+  }
+
+  softirq_stats_.clear();
+  const bool have_softirqs = parse_matrix(
+      softirqs_, [&](std::size_t slot, std::size_t n, bool per_cpu, std::uint64_t total, std::size_t, std::uint64_t) {
+        IrqStats s = softirqs_.rows[slot];
+        s.per_s = per_second(total, seconds);
+        softirq_stats_.push_back(s);
+        if (!per_cpu || std::strcmp(s.irq, "NET_RX") != 0) return;
+        // /proc/softirqs has a column per possible CPU, /proc/interrupts per online CPU.
+        for (std::size_t c = 0, i = 0; c < n && i < cpu_stats_.size(); ++c) {
+          while (i < cpu_stats_.size() && cpu_stats_[i].cpu < softirqs_.columns[c]) ++i;
+          if (i < cpu_stats_.size() && cpu_stats_[i].cpu == softirqs_.columns[c]) {
+            cpu_stats_[i].net_rx_per_s = per_second(softirqs_.cur[c], seconds);
+          }
+        }
+      });
+  if (have_softirqs) {
+    for (std::size_t c = 0, i = 0; c < softirqs_.columns.size() && i < cpu_stats_.size(); ++c) {
+      while (i < cpu_stats_.size() && cpu_stats_[i].cpu < softirqs_.columns[c]) ++i;
+      if (i < cpu_stats_.size() && cpu_stats_[i].cpu == softirqs_.columns[c]) {
+        cpu_stats_[i].softirq_per_s = per_second(softirqs_.cpu_delta[c], seconds);
+      }
+    }
+  }
+
+  available_ = have_irqs || have_softirqs;
+  return available_ ? Status::Ok() : Status::Unavailable("open /proc/interrupts failed");
+}
+
+bool InterruptsSource::append_detail_json(std::string& out) const {
+  if (!available_) return false;
+  append_row(out, "{\"irq_per_s\":%.2f,\"untracked\":%zu,\"top\":[", irq_per_s_, interrupts_.untracked);
+  for (std::size_t i = 0; i < top_.size(); ++i) {
+    const IrqStats& s = top_[i];
+    append_row(out, "%s{\"irq\":\"%s\",\"desc\":\"%s\",\"per_s\":%.2f,\"top_cpu\":%d,\"top_cpu_pct\":%.2f}",
+               i ? "," : "", s.irq, s.desc, s.per_s, static_cast<int>(s.top_cpu), s.top_cpu_pct);
+  }
+  out.append("],\"softirqs\":[");
+  for (std::size_t i = 0; i < softirq_stats_.size(); ++i) {
+    append_row(out, "%s{\"type\":\"%s\",\"per_s\":%.2f}", i ? "," : "", softirq_stats_[i].irq, softirq_stats_[i].per_s);
+  }
+  out.append("],\"cpus\":[");
+  for (std::size_t i = 0; i < cpu_stats_.size(); ++i) {
+    const CpuIrqStats& c = cpu_stats_[i];
+    append_row(out, "%s{\"cpu\":%d,\"irq_per_s\":%.2f,\"softirq_per_s\":%.2f,\"net_rx_per_s\":%.2f}", i ? "," : "",
+               static_cast<int>(c.cpu), c.irq_per_s, c.softirq_per_s, c.net_rx_per_s);
+  }
+  out.append("]}");
+  return true;
+}
+
+void InterruptsSource::append_openmetrics(std::string& out) const {
+  if (!available_) return;
+  if (!top_.empty()) {
+    out.append("# TYPE telemetry_irq_per_second gauge\n"
+               "# HELP telemetry_irq_per_second Rate of the hottest hardware interrupts.\n");
+    for (const IrqStats& s : top_) {
+      append_row(out, "telemetry_irq_per_second{irq=\"%s\",desc=\"%s\"} %.2f\n", s.irq, s.desc, s.per_s);
+    }
+    out.append("# TYPE telemetry_irq_top_cpu_percent gauge\n"
+               "# HELP telemetry_irq_top_cpu_percent Share of each hot interrupt taken by its busiest CPU.\n");
+    for (const IrqStats& s : top_) {
+      if (s.top_cpu < 0) continue;
+      append_row(out, "telemetry_irq_top_cpu_percent{irq=\"%s\",cpu=\"%d\"} %.2f\n", s.irq, static_cast<int>(s.top_cpu),
+                 s.top_cpu_pct);
+    }
+  }
+  if (!softirq_stats_.empty()) {
+    out.append("# TYPE telemetry_softirq_per_second gauge\n"
+               "# HELP telemetry_softirq_per_second Rate of each softirq type over all CPUs.\n");
+    for (const IrqStats& s : softirq_stats_) {
+      append_row(out, "telemetry_softirq_per_second{type=\"%s\"} %.2f\n", s.irq, s.per_s);
+    }
+  }
+  if (!cpu_stats_.empty()) {
+    out.append("# TYPE telemetry_cpu_interrupts_per_second gauge\n"
+               "# HELP telemetry_cpu_interrupts_per_second Hardware, soft and NET_RX interrupts handled per CPU.\n");
+    for (const CpuIrqStats& c : cpu_stats_) {
+      const int cpu = static_cast<int>(c.cpu);
+      append_row(out,
+                 "telemetry_cpu_interrupts_per_second{cpu=\"%d\",kind=\"hard\"} %.2f\n"
+                 "telemetry_cpu_interrupts_per_second{cpu=\"%d\",kind=\"soft\"} %.2f\n"
+                 "telemetry_cpu_interrupts_per_second{cpu=\"%d\",kind=\"net_rx\"} %.2f\n",
+                 cpu, c.irq_per_s, cpu, c.softirq_per_s, cpu, c.net_rx_per_s);
+    }
+  }
+}
+
+}  // namespace telemetry::metrics
+
+#endif  // __linux__
@@ -0,0 +1,252 @@
+#include "telemetry/metrics/linux_io_sources.h"
+
+#ifdef __linux__
+
+#include <cstdio>
+#include <cstring>
+
+#include "telemetry/util/time.h"
+
+namespace telemetry::metrics {
+
+namespace {
+
+constexpr std::size_t kInitialTextSize = 64 * 1024;
+constexpr std::size_t kMaxTextSize = 4 * 1024 * 1024;
+constexpr double kSectorBytes = 512.0;
+
+// Reads the whole file into `text`, growing it (rarely: only when the table outgrows it) if
+// a read fills the buffer. Returns the length, 0 on failure.
+std::size_t read_table(ProcFile& file, std::vector<char>& text) {
+  while (true) {
+    const std::size_t n = file.read_all(text.data(), text.size());
+    if (n == 0 || n + 1 < text.size() || text.size() >= kMaxTextSize) return n;
+    text.resize(text.size() * 2);
+  }
+}
+
+// Device names go into JSON strings and OpenMetrics labels unescaped, so anything unusual
+// becomes '_'. Returns the sanitized length.
+std::size_t sanitize_name(const char* p, std::size_t len, char (&out)[32]) {
+  if (len >= sizeof(out)) len = sizeof(out) - 1;
+  for (std::size_t i = 0; i < len; ++i) {
+    const char c = p[i];
+    const bool plain = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '.' ||
+                       c == '-' || c == '_' || c == '@' || c == '+';
+    out[i] = plain ? c : '_';
+  }
+  out[len] = '\0';
+  return len;
+}
+
+bool all_digits(std::string_view s) {
+  if (s.empty()) return false;
+  for (char c : s) {
+    if (c < '0' || c > '9') return false;
+  }
+  return true;
+}
+
+// Partitions follow their disk in /proc/diskstats: sda1 after sda, nvme0n1p2 after nvme0n1.
+// The kernel inserts the 'p' exactly when the disk name ends in a digit.
+bool is_partition_of(std::string_view name, std::string_view disk) {
+  if (disk.empty() || name.size() <= disk.size() || name.substr(0, disk.size()) != disk) return false;
+  std::string_view rest = name.substr(disk.size());
+  if (disk.back() >= '0' && disk.back() <= '9') {
+    if (rest.front() != 'p') return false;
+    rest.remove_prefix(1);
+  }
+  return all_digits(rest);
+}
+
+bool starts_with(std::string_view s, std::string_view prefix) {
+  return s.size() >= prefix.size() && s.substr(0, prefix.size()) == prefix;
+}
+
+// One OpenMetrics gauge family with a sample per device.
+template <typename Stats>
+void append_family(std::string& out, const std::vector<Stats>& devices, const char* family, const char* help,
+                   double Stats::*field) {
+  if (devices.empty()) return;
+  append_row(out, "# TYPE %s gauge\n# HELP %s %s\n", family, family, help);
+  for (const Stats& d : devices) append_row(out, "%s{device=\"%s\"} %.2f\n", family, d.name, d.*field);
+}
+
+}  // namespace
+
+DiskStatsSource::DiskStatsSource(const char* root) : file_(root, "/proc/diskstats"), text_(kInitialTextSize) {
+  devices_.reserve(kMaxDevices);
+}
+
+Status DiskStatsSource::collect(MetricsSnapshot&) { return sample(telemetry::util::monotonic_ns()); }
+
+Status DiskStatsSource::sample(std::uint64_t now_ns) {
+  if (!file_.open()) return Status::Unavailable("open /proc/diskstats failed");
+  if (read_table(file_, text_) == 0) return Status::IoError("read /proc/diskstats failed");
+
+  const double seconds = prev_ns_ != 0 && now_ns > prev_ns_ ? static_cast<double>(now_ns - prev_ns_) / 1e9 : 0.0;
+  const double interval_ms = seconds * 1000.0;
+  prev_ns_ = now_ns;
+  devices_.clear();
+  index_.begin_sample();
+
+  // major minor name reads merged sectors ms writes merged sectors ms in_flight io_ms ...
+  std::string_view disk;  // the last whole disk, to recognise its partitions
+  for (const char* line = text_.data(); *line;) {
+    const char* p = line;
+    const char* nl = std::strchr(line, '\n');
+    line = nl ? nl + 1 : line + std::strlen(line);
+
+    (void)parse_proc_u64(p);
+    (void)parse_proc_u64(p);
+    while (*p == ' ') ++p;
+    const char* name_start = p;
+    while (*p && *p != ' ' && *p != '\n') ++p;
+    if (p == name_start) continue;
+    char name[32];
+    const std::string_view id(name, sanitize_name(name_start, static_cast<std::size_t>(p - name_start), name));
+
+    std::uint64_t f[10];
+    for (std::uint64_t& v : f) v = parse_proc_u64(p);
+    if (*p != ' ' && *p != '\n' && *p != '\0') continue;
+
+    DeviceIndex<5>::Slot* slot = index_.lookup(id);
+    if (!slot) continue;
+    if (!slot->primed) {
+      slot->hidden = starts_with(id, "loop") || starts_with(id, "ram") || is_partition_of(id, disk);
+    }
+    if (slot->hidden) continue;
+    disk = slot->name;
+
+    const std::array<std::uint64_t, 5> cur{f[0], f[2], f[4], f[6], f[9]};
+    DiskDeviceStats& d = devices_.emplace_back();
+    std::memcpy(d.name, slot->name, sizeof(d.name));
+    if (slot->primed && seconds > 0.0) {
+      d.reads_per_s = per_second(counter_delta(slot->prev[0], cur[0]), seconds);
+      d.read_bytes_per_s = per_second(counter_delta(slot->prev[1], cur[1]), seconds) * kSectorBytes;
+      d.writes_per_s = per_second(counter_delta(slot->prev[2], cur[2]), seconds);
+      d.write_bytes_per_s = per_second(counter_delta(slot->prev[3], cur[3]), seconds) * kSectorBytes;
+      const double busy = static_cast<double>(counter_delta(slot->prev[4], cur[4])) / interval_ms * 100.0;
+      d.util_pct = busy > 100.0 ? 100.0 : busy;
+    }
+    slot->prev = cur;
+    slot->primed = true;
+  }
+  index_.end_sample();
+  return Status::Ok();
+}
+
+bool DiskStatsSource::append_detail_json(std::string& out) const {
+  out.push_back('[');
+  for (std::size_t i = 0; i < devices_.size(); ++i) {
+    const DiskDeviceStats& d = devices_[i];
+    append_row(out,
+               "%s{\"device\":\"%s\",\"read_bytes_per_s\":%.2f,\"write_bytes_per_s\":%.2f,\"reads_per_s\":%.2f,"
+               "\"writes_per_s\":%.2f,\"util_pct\":%.2f}",
+               i ? "," : "", d.name, d.read_bytes_per_s, d.write_bytes_per_s, d.reads_per_s, d.writes_per_s,
+               d.util_pct);
+  }
+  out.push_back(']');
+  return true;
+}
+
+void DiskStatsSource::append_openmetrics(std::string& out) const {
+  append_family(out, devices_, "telemetry_disk_read_bytes_per_second", "Bytes read per second.",
+                &DiskDeviceStats::read_bytes_per_s);
+  append_family(out, devices_, "telemetry_disk_write_bytes_per_second", "Bytes written per second.",
+                &DiskDeviceStats::write_bytes_per_s);
+  append_family(out, devices_, "telemetry_disk_reads_per_second", "Read requests completed per second.",
+                &DiskDeviceStats::reads_per_s);
+  append_family(out, devices_, "telemetry_disk_writes_per_second", "Write requests completed per second.",
+                &DiskDeviceStats::writes_per_s);
+  append_family(out, devices_, "telemetry_disk_utilization_percent", "Share of time with I/O in flight.",
+                &DiskDeviceStats::util_pct);
+}
+
+NetDevSource::NetDevSource(const char* root) : file_(root, "/proc/net/dev"), text_(kInitialTextSize) {
+  devices_.reserve(kMaxDevices);
+}
+
+Status NetDevSource::collect(MetricsSnapshot&) { return sample(telemetry::util::monotonic_ns()); }
+
+Status NetDevSource::sample(std::uint64_t now_ns) {
+  if (!file_.open()) return Status::Unavailable("open /proc/net/dev failed");
+  if (read_table(file_, text_) == 0) return Status::IoError("read /proc/net/dev failed");
+
+  const double seconds = prev_ns_ != 0 && now_ns > prev_ns_ ? static_cast<double>(now_ns - prev_ns_) / 1e9 : 0.0;
+  prev_ns_ = now_ns;
+  devices_.clear();
+  index_.begin_sample();
+
+  // Two header lines, then "  name: rx bytes packets errs drop fifo frame compressed multicast
+  // tx bytes packets errs drop fifo colls carrier compressed".
+  for (const char* line = text_.data(); *line;) {
+    const char* p = line;
+    const char* nl = std::strchr(line, '\n');
+    line = nl ? nl + 1 : line + std::strlen(line);
+
+    while (*p == ' ') ++p;
+    const char* name_start = p;
+    while (*p && *p != ':' && *p != '\n' && *p != '|') ++p;
+    if (*p != ':' || p == name_start) continue;
+    char name[32];
+    const std::string_view id(name, sanitize_name(name_start, static_cast<std::size_t>(p - name_start), name));
+    ++p;
+
+    std::uint64_t f[16];
+    for (std::uint64_t& v : f) v = parse_proc_u64(p);
+    if (*p != ' ' && *p != '\n' && *p != '\0') continue;
+
+    DeviceIndex<6>::Slot* slot = index_.lookup(id);
+    if (!slot) continue;
+
+    const std::array<std::uint64_t, 6> cur{f[0], f[1], f[3], f[8], f[9], f[11]};
+    NetDeviceStats& d = devices_.emplace_back();
+    std::memcpy(d.name, slot->name, sizeof(d.name));
+    if (slot->primed && seconds > 0.0) {
+      d.rx_bytes_per_s = per_second(counter_delta(slot->prev[0], cur[0]), seconds);
+      d.rx_packets_per_s = per_second(counter_delta(slot->prev[1], cur[1]), seconds);
+      d.rx_drops_per_s = per_second(counter_delta(slot->prev[2], cur[2]), seconds);
+      d.tx_bytes_per_s = per_second(counter_delta(slot->prev[3], cur[3]), seconds);
+      d.tx_packets_per_s = per_second(counter_delta(slot->prev[4], cur[4]), seconds);
+      d.tx_drops_per_s = per_second(counter_delta(slot->prev[5], cur[5]), seconds);
+    }
+    slot->prev = cur;
+    slot->primed = true;
+  }
+  index_.end_sample();
+  return Status::Ok();
+}
+
+bool NetDevSource::append_detail_json(std::string& out) const {
+  out.push_back('[');
+  for (std::size_t i = 0; i < devices_.size(); ++i) {
+    const NetDeviceStats& d = devices_[i];
+    append_row(out,
+               "%s{\"device\":\"%s\",\"rx_bytes_per_s\":%.2f,\"tx_bytes_per_s\":%.2f,\"rx_packets_per_s\":%.2f,"
+               "\"tx_packets_per_s\":%.2f,\"rx_drops_per_s\":%.2f,\"tx_drops_per_s\":%.2f}",
+               i ? "," : "", d.name, d.rx_bytes_per_s, d.tx_bytes_per_s, d.rx_packets_per_s, d.tx_packets_per_s,
+               d.rx_drops_per_s, d.tx_drops_per_s);
+  }
+  out.push_back(']');
+  return true;
+}
+
+void NetDevSource::append_openmetrics(std::string& out) const {
+  append_family(out, devices_, "telemetry_network_receive_bytes_per_second", "Bytes received per second.",
+                &NetDeviceStats::rx_bytes_per_s);
+  append_family(out, devices_, "telemetry_network_transmit_bytes_per_second", "Bytes sent per second.",
+                &NetDeviceStats::tx_bytes_per_s);
+  append_family(out, devices_, "telemetry_network_receive_packets_per_second", "Packets received per second.",
+                &NetDeviceStats::rx_packets_per_s);
+  append_family(out, devices_, "telemetry_network_transmit_packets_per_second", "Packets sent per second.",
+                &NetDeviceStats::tx_packets_per_s);
+  append_family(out, devices_, "telemetry_network_receive_drops_per_second", "Received packets dropped per second.",
+                &NetDeviceStats::rx_drops_per_s);
+  append_family(out, devices_, "telemetry_network_transmit_drops_per_second", "Outgoing packets dropped per second.",
+                &NetDeviceStats::tx_drops_per_s);
+}
+
+}  // namespace telemetry::metrics
+
+#endif  // __linux__
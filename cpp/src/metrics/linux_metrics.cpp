@@ -1,9 +1,16 @@
-#include <cerrno>
 #include <cstdio>
 #include <cstring>
 
-#include "telemetry/metrics/metric_source.h"
 #include "telemetry/metrics/collector.h"
+#include "telemetry/metrics/linux_sources.h"
+#include "telemetry/metrics/metric_source.h"
+#ifdef __linux__
+#include "telemetry/metrics/linux_interrupts_source.h"
+#include "telemetry/metrics/linux_io_sources.h"
+#include "telemetry/metrics/linux_numa_source.h"
+#include "telemetry/metrics/linux_pressure_source.h"
+#include "telemetry/metrics/proc_file.h"
+#endif
 
 namespace telemetry::metrics {
 
@@ -13,16 +20,16 @@ namespace {
 
 class LinuxCpuUsageSource final : public MetricSource {
  public:
+  explicit LinuxCpuUsageSource(const char* root) : file_(root, "/proc/stat") {}
+
   const char* name() const override { return "linux_cpu"; }
 
   Status collect(MetricsSnapshot& out) override {
-    std::FILE* f = std::fopen("/proc/stat", "r");
-    if (!f) return Status::Unavailable("open /proc/stat failed");
+    if (!file_.open()) return Status::Unavailable("open /proc/stat failed");
 
+    // Only the aggregate first line is needed.
     char line[256];
-    const char* got = std::fgets(line, sizeof(line), f);
-    std::fclose(f);
-    if (!got) return Status::IoError("read /proc/stat failed");
+    if (!file_.read(line, sizeof(line))) return Status::IoError("read /proc/stat failed");
 
     // Format: cpu  user nice system idle iowait irq softirq steal guest guest_nice
     unsigned long long user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
@@ -58,6 +65,7 @@ class LinuxCpuUsageSource final : public MetricSource {
   }
 
  private:
+  ProcFile file_;
   bool has_prev_{false};
   unsigned long long prev_total_{0};
   unsigned long long prev_idle_{0};
@@ -65,25 +73,29 @@ class LinuxCpuUsageSource final : public MetricSource {
 
 class LinuxMemInfoSource final : public MetricSource {
  public:
+  explicit LinuxMemInfoSource(const char* root) : file_(root, "/proc/meminfo") {}
+
   const char* name() const override { return "linux_meminfo"; }
 
   Status collect(MetricsSnapshot& out) override {
-    std::FILE* f = std::fopen("/proc/meminfo", "r");
-    if (!f) return Status::Unavailable("open /proc/meminfo failed");
+    if (!file_.open()) return Status::Unavailable("open /proc/meminfo failed");
+
+    // MemTotal and MemAvailable are the first and third lines; 1 KiB leaves ample slack.
+    char text[1024];
+    if (!file_.read(text, sizeof(text))) return Status::IoError("read /proc/meminfo failed");
 
-    char line[256];
     std::uint64_t total_kb = 0;
     std::uint64_t avail_kb = 0;
-
-    while (std::fgets(line, sizeof(line), f)) {
+    for (const char* line = text; *line;) {
       unsigned long long v = 0;
       if (std::sscanf(line, "MemTotal: %llu kB", &v) == 1) total_kb = static_cast<std::uint64_t>(v);
       if (std::sscanf(line, "MemAvailable: %llu kB", &v) == 1) avail_kb = static_cast<std::uint64_t>(v);
       if (total_kb && avail_kb) break;
+      const char* nl = std::strchr(line, '\n');
+      if (!nl) break;
+      line = nl + 1;
     }
 
-    std::fclose(f);
-
     if (!total_kb) return Status::IoError("parse MemTotal failed");
     if (!avail_kb) return Status::IoError("parse MemAvailable failed");
 
@@ -91,53 +103,71 @@ class LinuxMemInfoSource final : public MetricSource {
     out.mem_available_kb = avail_kb;
     return Status::Ok();
   }
+
+ private:
+  ProcFile file_;
 };
 
 class LinuxUptimeSource final : public MetricSource {
  public:
+  explicit LinuxUptimeSource(const char* root) : file_(root, "/proc/uptime") {}
+
   const char* name() const override { return "linux_uptime"; }
 
   Status collect(MetricsSnapshot& out) override {
-    std::FILE* f = std::fopen("/proc/uptime", "r");
-    if (!f) return Status::Unavailable("open /proc/uptime failed");
+    if (!file_.open()) return Status::Unavailable("open /proc/uptime failed");
 
+    char text[64];
     double uptime = 0.0;
-    const int n = std::fscanf(f, "%lf", &uptime);
-    std::fclose(f);
-    if (n != 1) return Status::IoError("parse /proc/uptime failed");
+    if (!file_.read(text, sizeof(text))) return Status::IoError("read /proc/uptime failed");
+    if (std::sscanf(text, "%lf", &uptime) != 1) return Status::IoError("parse /proc/uptime failed");
 
     if (uptime < 0.0) uptime = 0.0;
     out.uptime_s = static_cast<std::uint64_t>(uptime);
     return Status::Ok();
   }
+
+ private:
+  ProcFile file_;
 };
 
 class LinuxTemperatureSource final : public MetricSource {
  public:
+  explicit LinuxTemperatureSource(const char* root) : file_(root, "/sys/class/thermal/thermal_zone0/temp") {}
+
   const char* name() const override { return "linux_temperature"; }
 
   Status collect(MetricsSnapshot& out) override {
     // Common path on many embedded Linux systems.
-    std::FILE* f = std::fopen("/sys/class/thermal/thermal_zone0/temp", "r");
-    if (!f) return Status::Unavailable("open thermal temp failed");
+    if (!file_.open()) return Status::Unavailable("open thermal temp failed");
 
+    char text[32];
     long temp_milli_c = 0;
-    const int n = std::fscanf(f, "%ld", &temp_milli_c);
-    std::fclose(f);
-    if (n != 1) return Status::IoError("parse thermal temp failed");
+    if (!file_.read(text, sizeof(text))) return Status::IoError("read thermal temp failed");
+    if (std::sscanf(text, "%ld", &temp_milli_c) != 1) return Status::IoError("parse thermal temp failed");
 
     out.temperature_c = static_cast<double>(temp_milli_c) / 1000.0;
     return Status::Ok();
   }
+
+ private:
+  ProcFile file_;
 };
 
 }  // namespace
 
-void add_linux_sources(Collector& collector) {
-  collector.add_source(std::make_unique<LinuxCpuUsageSource>());
-  collector.add_source(std::make_unique<LinuxMemInfoSource>());
-  collector.add_source(std::make_unique<LinuxUptimeSource>());
-  collector.add_source(std::make_unique<LinuxTemperatureSource>());
+void add_linux_sources(Collector& collector, const char* root) {
+  collector.add_source(std::make_unique<LinuxCpuUsageSource>(root));
+  collector.add_source(std::make_unique<LinuxMemInfoSource>(root));
+  collector.add_source(std::make_unique<LinuxUptimeSource>(root));
+  collector.add_source(std::make_unique<LinuxTemperatureSource>(root));
+  collector.add_source(std::make_unique<DiskStatsSource>(root));
+  collector.add_source(std::make_unique<NetDevSource>(root));
+  collector.add_source(std::make_unique<PressureSource>(root));
+  collector.add_source(std::make_unique<NumaSource>(root));
+  InterruptsConfig interrupts_cfg{};
+  interrupts_cfg.root = root;
+  collector.add_source(std::make_unique<InterruptsSource>(interrupts_cfg));
 }
 
 #endif
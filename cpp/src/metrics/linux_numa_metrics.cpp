@@ -0,0 +1,335 @@
+#include "telemetry/metrics/linux_numa_source.h"
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "telemetry/util/time.h"
+
+namespace telemetry::metrics {
+
+namespace {
+
+constexpr const char* kNodeDir = "/sys/devices/system/node";
+constexpr const char* kNumastatKeys[5] = {"numa_hit", "numa_miss", "numa_foreign", "local_node", "other_node"};
+
+// Calls f(n) for every number in a sysfs list such as "0-3,8,10-11\n".
+template <class F>
+void for_each_in_list(const char* p, F f) {
+  while (*p >= '0' && *p <= '9') {
+    const std::uint64_t first = parse_proc_u64(p);
+    std::uint64_t last = first;
+    if (*p == '-') {
+      ++p;
+      last = parse_proc_u64(p);
+    }
+    for (std::uint64_t n = first; n <= last && n < NumaSource::kMaxCpus; ++n) f(static_cast<std::size_t>(n));
+    if (*p != ',') break;
+    ++p;
+  }
+}
+
+// Parses "cpu<N> " at `p`; false for the aggregate line and anything that is not a CPU.
+bool parse_cpu_label(const char*& p, std::size_t& cpu) {
+  if (std::strncmp(p, "cpu", 3) != 0 || p[3] < '0' || p[3] > '9') return false;
+  p += 3;
+  cpu = static_cast<std::size_t>(parse_proc_u64(p));
+  return true;
+}
+
+bool key_is(const char* key, std::size_t len, const char* want) {
+  return std::strlen(want) == len && std::memcmp(key, want, len) == 0;
+}
+
+}  // namespace
+
+NumaSource::NumaSource(const char* root) {
+  stat_.assign(root, "/proc/stat");
+  char path[96];
+  char text[256];
+
+  // Node ids from the online list; each node's cpulist assigns its CPUs.
+  ProcFile online(root, "/sys/devices/system/node/online");
+  if (online.open() && online.read(text, sizeof(text))) {
+    for_each_in_list(text, [&](std::size_t id) {
+      if (nodes_.size() == kMaxNodes) return;
+      auto node = std::make_unique<Node>();
+      std::snprintf(path, sizeof(path), "%s/node%zu/meminfo", kNodeDir, id);
+      node->meminfo.assign(root, path);
+      std::snprintf(path, sizeof(path), "%s/node%zu/numastat", kNodeDir, id);
+      node->numastat.assign(root, path);
+      NumaNodeStats stats{};
+      stats.node = static_cast<std::int32_t>(id);
+      std::snprintf(path, sizeof(path), "%s/node%zu/cpulist", kNodeDir, id);
+      ProcFile cpulist(root, path);
+      char list[1024];
+      if (cpulist.open() && cpulist.read(list, sizeof(list))) {
+        const auto index = static_cast<std::int16_t>(nodes_.size());
+        for_each_in_list(list, [&](std::size_t cpu) {
+          if (cpu >= cpu_node_.size()) cpu_node_.resize(cpu + 1, -1);
+          cpu_node_[cpu] = index;
+        });
+      }
+      nodes_.push_back(std::move(node));
+      stats_.push_back(stats);
+    });
+  }
+  numa_ = !nodes_.empty();
+  if (!numa_) {
+    // No topology in sysfs: one node with every CPU, and the memory of /proc/meminfo.
+    auto node = std::make_unique<Node>();
+    node->meminfo.assign(root, "/proc/meminfo");
+    nodes_.push_back(std::move(node));
+    stats_.push_back(NumaNodeStats{});
+  }
+
+  // Size the CPU table and the /proc/stat buffer from the CPUs listed now. Only the cpu lines
+  // at the top are read; the interrupt counters after them may be cut short.
+  std::size_t max_cpu = cpu_node_.size();
+  std::vector<char> probe(64 * 1024);
+  if (stat_.open() && stat_.read_all(probe.data(), probe.size()) != 0) {
+    for (const char* line = probe.data(); *line;) {
+      const char* p = line;
+      std::size_t cpu = 0;
+      if (parse_cpu_label(p, cpu) && cpu < kMaxCpus) max_cpu = std::max(max_cpu, cpu + 1);
+      const char* nl = std::strchr(line, '\n');
+      if (!nl) break;
+      line = nl + 1;
+    }
+  }
+  if (!numa_) cpu_node_.assign(max_cpu, 0);
+  cpu_node_.resize(max_cpu, -1);
+  cpus_.resize(max_cpu);
+  // Ten 20-digit counters per line, plus the aggregate line.
+  text_.resize((max_cpu + 2) * 224 + 1);
+}
+
+Status NumaSource::collect(MetricsSnapshot&) { return sample(telemetry::util::monotonic_ns()); }
+
+Status NumaSource::sample(std::uint64_t now_ns) {
+  const double seconds = prev_ns_ != 0 && now_ns > prev_ns_ ? static_cast<double>(now_ns - prev_ns_) / 1e9 : 0.0;
+  prev_ns_ = now_ns;
+
+  bool any = sample_cpus();
+  for (std::size_t i = 0; i < nodes_.size(); ++i) any = sample_node(i, seconds) || any;
+  available_ = any;
+  return any ? Status::Ok() : Status::Unavailable("no NUMA node or /proc/stat data");
+}
+
+bool NumaSource::sample_cpus() {
+  for (std::size_t i = 0; i < nodes_.size(); ++i) {
+    nodes_[i]->total_delta = 0;
+    nodes_[i]->idle_delta = 0;
+    stats_[i].cpus = 0;
+  }
+  for (Cpu& c : cpus_) c.seen = false;
+
+  const bool ok = stat_.open() && stat_.read_all(text_.data(), text_.size()) != 0;
+  if (ok) {
+    for (const char* line = text_.data(); std::strncmp(line, "cpu", 3) == 0;) {
+      const char* p = line;
+      std::size_t cpu = 0;
+      if (parse_cpu_label(p, cpu) && cpu < cpus_.size()) {
+        // user nice system idle iowait irq softirq steal (guest time is already in user)
+        std::uint64_t f[8] = {};
+        for (std::uint64_t& v : f) v = parse_proc_u64(p);
+        const std::uint64_t idle = f[3] + f[4];
+        const std::uint64_t total = idle + f[0] + f[1] + f[2] + f[5] + f[6] + f[7];
+        Cpu& c = cpus_[cpu];
+        c.seen = true;
+        c.pct = 0.0;
+        if (c.primed && total > c.prev_total && idle >= c.prev_idle) {
+          const std::uint64_t totald = total - c.prev_total;
+          const std::uint64_t idled = std::min(idle - c.prev_idle, totald);
+          c.pct = static_cast<double>(totald - idled) / static_cast<double>(totald) * 100.0;
+          if (cpu_node_[cpu] >= 0) {
+            Node& n = *nodes_[static_cast<std::size_t>(cpu_node_[cpu])];
+            n.total_delta += totald;
+            n.idle_delta += idled;
+          }
+        }
+        c.prev_total = total;
+        c.prev_idle = idle;
+        c.primed = true;
+        if (cpu_node_[cpu] >= 0) ++stats_[static_cast<std::size_t>(cpu_node_[cpu])].cpus;
+      }
+      const char* nl = std::strchr(line, '\n');
+      if (!nl) break;
+      line = nl + 1;
+    }
+  }
+  // An offlined CPU restarts from its next sample when it comes back.
+  for (Cpu& c : cpus_) {
+    if (!c.seen) c = Cpu{};
+  }
+  for (std::size_t i = 0; i < nodes_.size(); ++i) {
+    const Node& n = *nodes_[i];
+    stats_[i].cpu_pct = n.total_delta != 0
+                            ? static_cast<double>(n.total_delta - n.idle_delta) / static_cast<double>(n.total_delta) * 100.0
+                            : 0.0;
+  }
+  return ok;
+}
+
+bool NumaSource::sample_node(std::size_t i, double seconds) {
+  Node& n = *nodes_[i];
+  NumaNodeStats& s = stats_[i];
+  bool ok = false;
+
+  // Node 0 MemTotal:       32816124 kB   (per node; /proc/meminfo has no "Node N" prefix)
+  char text[4096];
+  if (n.meminfo.open() && n.meminfo.read(text, sizeof(text))) {
+    ok = true;
+    std::uint64_t file_pages = 0;
+    std::uint64_t buffers_cached = 0;
+    bool has_file_pages = false;
+    for (const char* line = text; *line;) {
+      const char* p = line;
+      if (std::strncmp(p, "Node ", 5) == 0) {
+        p += 5;
+        (void)parse_proc_u64(p);
+        while (*p == ' ') ++p;
+      }
+      const char* colon = std::strchr(p, ':');
+      const char* nl = std::strchr(line, '\n');
+      if (colon && (!nl || colon < nl)) {
+        const std::size_t len = static_cast<std::size_t>(colon - p);
+        const char* v = colon + 1;
+        const std::uint64_t kb = parse_proc_u64(v);
+        if (key_is(p, len, "MemTotal")) {
+          s.mem_total_kb = kb;
+        } else if (key_is(p, len, "MemFree")) {
+          s.mem_free_kb = kb;
+        } else if (key_is(p, len, "FilePages")) {
+          file_pages = kb;
+          has_file_pages = true;
+        } else if (key_is(p, len, "AnonPages")) {
+          s.anon_pages_kb = kb;
+        } else if (key_is(p, len, "Buffers") || key_is(p, len, "Cached")) {
+          buffers_cached += kb;
+        }
+      }
+      if (!nl) break;
+      line = nl + 1;
+    }
+    s.file_pages_kb = has_file_pages ? file_pages : buffers_cached;
+  }
+
+  // numa_hit 21157845\nnuma_miss 0\n...
+  s.has_numastat = false;
+  if (n.numastat.open() && n.numastat.read(text, sizeof(text))) {
+    ok = true;
+    std::uint64_t cur[5] = {};
+    for (const char* line = text; *line;) {
+      const char* sp = std::strchr(line, ' ');
+      const char* nl = std::strchr(line, '\n');
+      if (sp && (!nl || sp < nl)) {
+        const std::size_t len = static_cast<std::size_t>(sp - line);
+        for (std::size_t k = 0; k < 5; ++k) {
+          if (!key_is(line, len, kNumastatKeys[k])) continue;
+          const char* v = sp;
+          cur[k] = parse_proc_u64(v);
+        }
+      }
+      if (!nl) break;
+      line = nl + 1;
+    }
+    double rates[5] = {};
+    if (n.primed && seconds > 0.0) {
+      for (std::size_t k = 0; k < 5; ++k) rates[k] = per_second(counter_delta(n.prev[k], cur[k]), seconds);
+    }
+    s.numa_hit_per_s = rates[0];
+    s.numa_miss_per_s = rates[1];
+    s.numa_foreign_per_s = rates[2];
+    s.local_node_per_s = rates[3];
+    s.other_node_per_s = rates[4];
+    std::memcpy(n.prev, cur, sizeof(cur));
+    n.primed = true;
+    s.has_numastat = true;
+  }
+  return ok;
+}
+
+bool NumaSource::append_detail_json(std::string& out) const {
+  if (!available_) return false;
+  append_row(out, "{\"numa\":%s,\"nodes\":[", numa_ ? "true" : "false");
+  for (std::size_t i = 0; i < stats_.size(); ++i) {
+    const NumaNodeStats& s = stats_[i];
+    append_row(out,
+               "%s{\"node\":%d,\"cpus\":%u,\"cpu_pct\":%.2f,\"mem_total_kb\":%llu,\"mem_free_kb\":%llu,"
+               "\"file_pages_kb\":%llu,\"anon_pages_kb\":%llu",
+               i ? "," : "", static_cast<int>(s.node), static_cast<unsigned>(s.cpus), s.cpu_pct,
+               static_cast<unsigned long long>(s.mem_total_kb), static_cast<unsigned long long>(s.mem_free_kb),
+               static_cast<unsigned long long>(s.file_pages_kb), static_cast<unsigned long long>(s.anon_pages_kb));
+    if (s.has_numastat) {
+      append_row(out,
+                 ",\"numa_hit_per_s\":%.2f,\"numa_miss_per_s\":%.2f,\"numa_foreign_per_s\":%.2f,"
+                 "\"local_node_per_s\":%.2f,\"other_node_per_s\":%.2f",
+                 s.numa_hit_per_s, s.numa_miss_per_s, s.numa_foreign_per_s, s.local_node_per_s, s.other_node_per_s);
+    }
+    out.append(",\"cores\":[");
+    bool first = true;
+    for (std::size_t cpu = 0; cpu < cpus_.size(); ++cpu) {
+      if (cpu_node_[cpu] != static_cast<std::int16_t>(i) || !cpus_[cpu].seen) continue;
+      append_row(out, "%s{\"cpu\":%zu,\"pct\":%.2f}", first ? "" : ",", cpu, cpus_[cpu].pct);
+      first = false;
+    }
+    out.append("]}");
+  }
+  out.append("]}");
+  return true;
+}
+
+void NumaSource::append_openmetrics(std::string& out) const {
+  if (!available_) return;
+  out.append("# TYPE telemetry_numa_cpu_percent gauge\n"
+             "# HELP telemetry_numa_cpu_percent Busy share of the node's CPUs over the last interval.\n");
+  for (const NumaNodeStats& s : stats_) {
+    append_row(out, "telemetry_numa_cpu_percent{node=\"%d\"} %.2f\n", static_cast<int>(s.node), s.cpu_pct);
+  }
+  out.append("# TYPE telemetry_numa_memory_bytes gauge\n"
+             "# HELP telemetry_numa_memory_bytes Memory of the node: total, free, page cache and anonymous.\n");
+  for (const NumaNodeStats& s : stats_) {
+    const int node = static_cast<int>(s.node);
+    append_row(out,
+               "telemetry_numa_memory_bytes{node=\"%d\",kind=\"total\"} %llu\n"
+               "telemetry_numa_memory_bytes{node=\"%d\",kind=\"free\"} %llu\n"
+               "telemetry_numa_memory_bytes{node=\"%d\",kind=\"file\"} %llu\n"
+               "telemetry_numa_memory_bytes{node=\"%d\",kind=\"anon\"} %llu\n",
+               node, static_cast<unsigned long long>(s.mem_total_kb) * 1024ULL, node,
+               static_cast<unsigned long long>(s.mem_free_kb) * 1024ULL, node,
+               static_cast<unsigned long long>(s.file_pages_kb) * 1024ULL, node,
+               static_cast<unsigned long long>(s.anon_pages_kb) * 1024ULL);
+  }
+  bool header = false;
+  for (const NumaNodeStats& s : stats_) {
+    if (!s.has_numastat) continue;
+    if (!header) {
+      out.append("# TYPE telemetry_numa_allocations_per_second gauge\n"
+                 "# HELP telemetry_numa_allocations_per_second Page allocations by NUMA placement outcome.\n");
+      header = true;
+    }
+    const int node = static_cast<int>(s.node);
+    append_row(out,
+               "telemetry_numa_allocations_per_second{node=\"%d\",kind=\"hit\"} %.2f\n"
+               "telemetry_numa_allocations_per_second{node=\"%d\",kind=\"miss\"} %.2f\n"
+               "telemetry_numa_allocations_per_second{node=\"%d\",kind=\"foreign\"} %.2f\n",
+               node, s.numa_hit_per_s, node, s.numa_miss_per_s, node, s.numa_foreign_per_s);
+    append_row(out,
+               "telemetry_numa_allocations_per_second{node=\"%d\",kind=\"local\"} %.2f\n"
+               "telemetry_numa_allocations_per_second{node=\"%d\",kind=\"remote\"} %.2f\n",
+               node, s.local_node_per_s, node, s.other_node_per_s);
+  }
+  out.append("# TYPE telemetry_cpu_core_percent gauge\n"
+             "# HELP telemetry_cpu_core_percent Busy share of each CPU over the last interval.\n");
+  for (std::size_t cpu = 0; cpu < cpus_.size(); ++cpu) {
+    if (!cpus_[cpu].seen) continue;
+    append_row(out, "telemetry_cpu_core_percent{cpu=\"%zu\",node=\"%d\"} %.2f\n", cpu, cpu_node(cpu), cpus_[cpu].pct);
+  }
+}
+
+}  // namespace telemetry::metrics
+
+#endif  // __linux__
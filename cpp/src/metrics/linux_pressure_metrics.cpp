@@ -0,0 +1,227 @@
+#include "telemetry/metrics/linux_pressure_source.h"
+
+#ifdef __linux__
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <poll.h>
+
+#include "telemetry/util/time.h"
+
+namespace telemetry::metrics {
+
+namespace {
+
+constexpr const char* kPressurePaths[3] = {"/proc/pressure/cpu", "/proc/pressure/memory", "/proc/pressure/io"};
+
+bool parse_ms(const char*& p, std::uint32_t& out) {
+  if (*p < '0' || *p > '9') return false;
+  std::uint64_t v = 0;
+  while (*p >= '0' && *p <= '9') {
+    v = v * 10 + static_cast<std::uint64_t>(*p++ - '0');
+    if (v > 10000) return false;
+  }
+  out = static_cast<std::uint32_t>(v);
+  return true;
+}
+
+double clamp_pct(double v) { return v > 100.0 ? 100.0 : v; }
+
+// One gauge family with a sample per available resource and line.
+void append_family(std::string& out, const PressureStats* stats, const char* family, const char* help,
+                   double PressureStats::*some, double PressureStats::*full) {
+  bool header = false;
+  for (std::size_t i = 0; i < 3; ++i) {
+    const PressureStats& s = stats[i];
+    if (!s.available) continue;
+    if (!header) {
+      append_row(out, "# TYPE %s gauge\n# HELP %s %s\n", family, family, help);
+      header = true;
+    }
+    const char* res = pressure_resource_name(static_cast<PressureResource>(i));
+    append_row(out, "%s{resource=\"%s\",kind=\"some\"} %.2f\n%s{resource=\"%s\",kind=\"full\"} %.2f\n", family, res,
+               s.*some, family, res, s.*full);
+  }
+}
+
+}  // namespace
+
+const char* pressure_resource_name(PressureResource r) {
+  switch (r) {
+    case PressureResource::kCpu:
+      return "cpu";
+    case PressureResource::kMemory:
+      return "memory";
+    case PressureResource::kIo:
+      return "io";
+  }
+  return "?";
+}
+
+PressureSource::PressureSource(const char* root) {
+  for (std::size_t i = 0; i < resources_.size(); ++i) resources_[i].file.assign(root, kPressurePaths[i]);
+}
+
+Status PressureSource::collect(MetricsSnapshot&) { return sample(telemetry::util::monotonic_ns()); }
+
+Status PressureSource::sample(std::uint64_t now_ns) {
+  const double seconds = prev_ns_ != 0 && now_ns > prev_ns_ ? static_cast<double>(now_ns - prev_ns_) / 1e9 : 0.0;
+  prev_ns_ = now_ns;
+
+  std::size_t read = 0;
+  for (Resource& r : resources_) {
+    r.stats.available = false;
+    if (!r.file.open()) continue;
+
+    // some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+    // full avg10=0.00 avg60=0.00 avg300=0.00 total=0   (cpu: 5.13 and later)
+    char text[256];
+    if (!r.file.read(text, sizeof(text))) continue;
+    PressureStats& s = r.stats;
+    unsigned long long some_us = 0;
+    unsigned long long full_us = 0;
+    if (std::sscanf(text, "some avg10=%lf avg60=%lf avg300=%lf total=%llu", &s.some_avg10, &s.some_avg60,
+                    &s.some_avg300, &some_us) != 4) {
+      continue;
+    }
+    const char* full = std::strstr(text, "\nfull ");
+    if (!full || std::sscanf(full + 1, "full avg10=%lf avg60=%lf avg300=%lf total=%llu", &s.full_avg10, &s.full_avg60,
+                             &s.full_avg300, &full_us) != 4) {
+      s.full_avg10 = s.full_avg60 = s.full_avg300 = 0.0;
+      full_us = 0;
+    }
+
+    s.some_stalled_pct = 0.0;
+    s.full_stalled_pct = 0.0;
+    if (r.primed && seconds > 0.0) {
+      s.some_stalled_pct = clamp_pct(per_second(counter_delta(r.prev_some_us, some_us), seconds) / 1e4);
+      s.full_stalled_pct = clamp_pct(per_second(counter_delta(r.prev_full_us, full_us), seconds) / 1e4);
+    }
+    r.prev_some_us = some_us;
+    r.prev_full_us = full_us;
+    r.primed = true;
+    s.available = true;
+    ++read;
+  }
+  return read != 0 ? Status::Ok() : Status::Unavailable("no /proc/pressure files");
+}
+
+bool PressureSource::append_detail_json(std::string& out) const {
+  const std::size_t mark = out.size();
+  out.push_back('{');
+  bool first = true;
+  for (std::size_t i = 0; i < resources_.size(); ++i) {
+    const PressureStats& s = resources_[i].stats;
+    if (!s.available) continue;
+    append_row(out,
+               "%s\"%s\":{\"some_avg10\":%.2f,\"some_avg60\":%.2f,\"some_avg300\":%.2f,\"some_stalled_pct\":%.2f,"
+               "\"full_avg10\":%.2f,\"full_avg60\":%.2f,\"full_avg300\":%.2f,\"full_stalled_pct\":%.2f}",
+               first ? "" : ",", pressure_resource_name(static_cast<PressureResource>(i)), s.some_avg10, s.some_avg60,
+               s.some_avg300, s.some_stalled_pct, s.full_avg10, s.full_avg60, s.full_avg300, s.full_stalled_pct);
+    first = false;
+  }
+  if (first) {
+    out.resize(mark);
+    return false;
+  }
+  out.push_back('}');
+  return true;
+}
+
+void PressureSource::append_openmetrics(std::string& out) const {
+  const PressureStats stats[3] = {resources_[0].stats, resources_[1].stats, resources_[2].stats};
+  append_family(out, stats, "telemetry_pressure_stalled_percent", "Share of the last interval with tasks stalled.",
+                &PressureStats::some_stalled_pct, &PressureStats::full_stalled_pct);
+  append_family(out, stats, "telemetry_pressure_avg10_percent", "Kernel 10 s average of the stalled share.",
+                &PressureStats::some_avg10, &PressureStats::full_avg10);
+  append_family(out, stats, "telemetry_pressure_avg60_percent", "Kernel 60 s average of the stalled share.",
+                &PressureStats::some_avg60, &PressureStats::full_avg60);
+  append_family(out, stats, "telemetry_pressure_avg300_percent", "Kernel 300 s average of the stalled share.",
+                &PressureStats::some_avg300, &PressureStats::full_avg300);
+}
+
+Status parse_pressure_trigger(const char* spec, PressureTriggerConfig& out) {
+  if (!spec) return Status::InvalidArgument("empty trigger");
+  PressureTriggerConfig cfg{};
+  const char* p = spec;
+  if (std::strncmp(p, "cpu:", 4) == 0) {
+    cfg.resource = PressureResource::kCpu;
+    p += 4;
+  } else if (std::strncmp(p, "memory:", 7) == 0) {
+    cfg.resource = PressureResource::kMemory;
+    p += 7;
+  } else if (std::strncmp(p, "io:", 3) == 0) {
+    cfg.resource = PressureResource::kIo;
+    p += 3;
+  } else {
+    return Status::InvalidArgument("want cpu, memory or io");
+  }
+  if (std::strncmp(p, "some:", 5) == 0) {
+    cfg.full = false;
+  } else if (std::strncmp(p, "full:", 5) == 0) {
+    cfg.full = true;
+  } else {
+    return Status::InvalidArgument("want some or full");
+  }
+  p += 5;
+  std::uint32_t stall_ms = 0;
+  std::uint32_t window_ms = 0;
+  if (!parse_ms(p, stall_ms) || *p++ != '/' || !parse_ms(p, window_ms) || *p != '\0') {
+    return Status::InvalidArgument("want <stall_ms>/<window_ms>");
+  }
+  if (window_ms < 500 || window_ms > 10000) return Status::InvalidArgument("window must be 500..10000 ms");
+  if (stall_ms == 0 || stall_ms > window_ms) return Status::InvalidArgument("stall must be 1..window ms");
+  cfg.stall_us = stall_ms * 1000;
+  cfg.window_us = window_ms * 1000;
+  out = cfg;
+  return Status::Ok();
+}
+
+PressureTrigger::PressureTrigger(const PressureTriggerConfig& cfg, const char* root) : cfg_(cfg) {
+  std::snprintf(path_, sizeof(path_), "%s%s", root ? root : "", kPressurePaths[static_cast<std::size_t>(cfg.resource)]);
+  std::snprintf(name_, sizeof(name_), "psi_%s_%s", pressure_resource_name(cfg.resource), cfg.full ? "full" : "some");
+}
+
+PressureTrigger::~PressureTrigger() {
+  if (fd_ >= 0) ::close(fd_);
+}
+
+Status PressureTrigger::open() {
+  if (fd_ >= 0) return Status::Ok();
+  const int fd = ::open(path_, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) return Status::Unavailable("open /proc/pressure failed (kernel without PSI?)");
+  char spec[64];
+  const int n = std::snprintf(spec, sizeof(spec), "%s %u %u", cfg_.full ? "full" : "some",
+                              static_cast<unsigned>(cfg_.stall_us), static_cast<unsigned>(cfg_.window_us));
+  // The trigger lives as long as this descriptor stays open.
+  if (::write(fd, spec, static_cast<std::size_t>(n) + 1) < 0) {
+    const int err = errno;
+    ::close(fd);
+    if (err == EPERM || err == EACCES) {
+      return Status::Unavailable("PSI trigger refused (unprivileged: window must be a multiple of 2 s)");
+    }
+    return Status::InvalidArgument("PSI trigger rejected by the kernel");
+  }
+  fd_ = fd;
+  return Status::Ok();
+}
+
+short PressureTrigger::events() const { return POLLPRI; }
+
+bool PressureTrigger::on_ready(short revents) {
+  if (revents & (POLLERR | POLLNVAL)) {
+    // The monitored cgroup or the file went away; the trigger cannot fire again.
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+  if (!(revents & POLLPRI)) return false;
+  ++fired_;
+  return true;
+}
+
+}  // namespace telemetry::metrics
+
+#endif  // __linux__
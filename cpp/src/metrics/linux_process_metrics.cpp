@@ -0,0 +1,276 @@
+#include "telemetry/metrics/process_source.h"
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "telemetry/metrics/proc_file.h"
+#include "telemetry/util/time.h"
+
+namespace telemetry::metrics {
+
+namespace {
+
+constexpr std::size_t kDentsSize = 32 * 1024;
+
+// Ranking order: more CPU first, then more memory, then lower pid for a stable order.
+bool busier(const ProcessSample& a, const ProcessSample& b) {
+  if (a.cpu_pct != b.cpu_pct) return a.cpu_pct > b.cpu_pct;
+  if (a.rss_bytes != b.rss_bytes) return a.rss_bytes > b.rss_bytes;
+  return a.pid < b.pid;
+}
+
+std::size_t hash_pid(std::int32_t pid, std::size_t mask) {
+  return static_cast<std::size_t>(static_cast<std::uint32_t>(pid) * 0x9E3779B1U) & mask;
+}
+
+bool parse_pid(const char* name, std::int32_t& pid) {
+  std::int64_t v = 0;
+  if (!*name) return false;
+  for (const char* p = name; *p; ++p) {
+    if (*p < '0' || *p > '9') return false;
+    v = v * 10 + (*p - '0');
+    if (v > INT32_MAX) return false;
+  }
+  pid = static_cast<std::int32_t>(v);
+  return pid > 0;
+}
+
+// Skips `n` space-separated fields, including negative ones parse_proc_u64 cannot read.
+const char* skip_fields(const char* p, int n) {
+  for (int i = 0; i < n && *p; ++i) {
+    while (*p == ' ') ++p;
+    while (*p && *p != ' ') ++p;
+  }
+  return p;
+}
+
+}  // namespace
+
+ProcessSource::ProcessSource(const ProcessSourceConfig& cfg)
+    : cfg_(cfg), proc_path_(std::string(cfg.root ? cfg.root : "") + "/proc"), dents_(kDentsSize) {
+  cfg_.top_n = std::clamp<std::size_t>(cfg_.top_n, 1, kMaxTop);
+  std::size_t capacity = 64;
+  while (capacity < cfg_.max_processes * 2) capacity <<= 1;
+  table_.resize(capacity);
+  scratch_.resize(capacity);
+  heap_.reserve(cfg_.top_n);
+  top_.reserve(cfg_.top_n);
+  const long hz = ::sysconf(_SC_CLK_TCK);
+  if (hz > 0) ticks_per_s_ = static_cast<double>(hz);
+  const long page = ::sysconf(_SC_PAGESIZE);
+  if (page > 0) page_size_ = static_cast<std::uint64_t>(page);
+}
+
+ProcessSource::~ProcessSource() {
+  if (proc_fd_ >= 0) ::close(proc_fd_);
+}
+
+Status ProcessSource::collect(MetricsSnapshot&) { return sample(telemetry::util::monotonic_ns()); }
+
+Status ProcessSource::sample(std::uint64_t now_ns) {
+  if (proc_fd_ < 0) proc_fd_ = ::open(proc_path_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (proc_fd_ < 0) return Status::Unavailable("open /proc failed");
+
+  if (!in_pass_) {
+    if (::lseek(proc_fd_, 0, SEEK_SET) < 0) return Status::IoError("rewind /proc failed");
+    dents_off_ = dents_len_ = 0;
+    heap_.clear();
+    seen_ = 0;
+    untracked_ = 0;
+    ++pass_;
+    in_pass_ = true;
+  }
+
+  std::size_t budget = cfg_.max_per_tick != 0 ? cfg_.max_per_tick : SIZE_MAX;
+  while (budget != 0) {
+    if (dents_off_ >= dents_len_) {
+      const ssize_t n = ::getdents64(proc_fd_, dents_.data(), dents_.size());
+      if (n < 0) {
+        in_pass_ = false;
+        return Status::IoError("read /proc failed");
+      }
+      if (n == 0) {
+        finish_pass();
+        break;
+      }
+      dents_len_ = static_cast<std::size_t>(n);
+      dents_off_ = 0;
+    }
+    const auto* d = reinterpret_cast<const struct dirent64*>(dents_.data() + dents_off_);
+    dents_off_ += d->d_reclen;
+    std::int32_t pid = 0;
+    if (!parse_pid(d->d_name, pid)) continue;
+    read_process(d->d_name, pid, now_ns);
+    --budget;
+  }
+  return Status::Ok();
+}
+
+void ProcessSource::read_process(const char* name, std::int32_t pid, std::uint64_t now_ns) {
+  char path[32];
+  std::snprintf(path, sizeof(path), "%s/stat", name);
+  const int fd = ::openat(proc_fd_, path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return;  // exited since the directory was listed
+  char text[1024];
+  const ssize_t n = ::read(fd, text, sizeof(text) - 1);
+  ::close(fd);
+  if (n <= 0) return;
+  text[n] = '\0';
+
+  // pid (comm) state ppid pgrp session tty_nr tpgid flags minflt cminflt majflt cmajflt
+  // utime stime cutime cstime priority nice num_threads itrealvalue starttime vsize rss ...
+  // comm may itself contain spaces and parentheses, so it ends at the last ')'.
+  const char* open = std::strchr(text, '(');
+  const char* close = std::strrchr(text, ')');
+  if (!open || !close || close < open) return;
+  const char* p = skip_fields(close + 1, 11);  // state .. cmajflt
+  const std::uint64_t utime = parse_proc_u64(p);
+  const std::uint64_t stime = parse_proc_u64(p);
+  p = skip_fields(p, 6);  // cutime .. itrealvalue
+  const std::uint64_t start_time = parse_proc_u64(p);
+  p = skip_fields(p, 1);  // vsize
+  const std::uint64_t rss_pages = parse_proc_u64(p);
+
+  ProcessSample s{};
+  s.pid = pid;
+  const std::size_t comm_len = std::min<std::size_t>(static_cast<std::size_t>(close - open - 1), sizeof(s.comm) - 1);
+  for (std::size_t i = 0; i < comm_len; ++i) {
+    const char c = open[1 + i];
+    s.comm[i] = (c < 0x20 || c == '"' || c == '\\' || c == 0x7f) ? '_' : c;
+  }
+  s.rss_bytes = rss_pages * page_size_;
+  ++seen_;
+
+  const std::uint64_t ticks = utime + stime;
+  bool inserted = false;
+  Entry* e = find_or_insert(pid, inserted);
+  if (!e) {
+    ++untracked_;
+  } else {
+    if (!inserted && e->start_time == start_time && now_ns > e->ns && ticks >= e->ticks) {
+      const double seconds = static_cast<double>(now_ns - e->ns) / 1e9;
+      s.cpu_pct = static_cast<double>(ticks - e->ticks) / ticks_per_s_ / seconds * 100.0;
+    }
+    e->ticks = ticks;
+    e->start_time = start_time;
+    e->ns = now_ns;
+    e->pass = pass_;
+  }
+
+  // Min-heap on rank: its front is the least busy of the current top.
+  if (heap_.size() < cfg_.top_n) {
+    heap_.push_back(s);
+    std::push_heap(heap_.begin(), heap_.end(), busier);
+  } else if (busier(s, heap_.front())) {
+    std::pop_heap(heap_.begin(), heap_.end(), busier);
+    heap_.back() = s;
+    std::push_heap(heap_.begin(), heap_.end(), busier);
+  }
+}
+
+ProcessSource::Entry* ProcessSource::find_or_insert(std::int32_t pid, bool& inserted) {
+  const std::size_t mask = table_.size() - 1;
+  Entry* reuse = nullptr;
+  for (std::size_t i = hash_pid(pid, mask);; i = (i + 1) & mask) {
+    Entry& e = table_[i];
+    if (e.pid == pid) {
+      inserted = false;
+      return &e;
+    }
+    if (e.pid == -1) {
+      if (!reuse) reuse = &e;
+      continue;
+    }
+    if (e.pid == 0) {
+      if (live_ >= cfg_.max_processes) return nullptr;
+      if (reuse) {
+        --deleted_;
+      } else {
+        reuse = &e;
+      }
+      *reuse = Entry{};
+      reuse->pid = pid;
+      ++live_;
+      inserted = true;
+      return reuse;
+    }
+  }
+}
+
+void ProcessSource::rehash() {
+  const std::size_t mask = scratch_.size() - 1;
+  std::fill(scratch_.begin(), scratch_.end(), Entry{});
+  for (const Entry& e : table_) {
+    if (e.pid <= 0) continue;
+    std::size_t i = hash_pid(e.pid, mask);
+    while (scratch_[i].pid != 0) i = (i + 1) & mask;
+    scratch_[i] = e;
+  }
+  table_.swap(scratch_);
+  deleted_ = 0;
+}
+
+void ProcessSource::finish_pass() {
+  in_pass_ = false;
+  // Processes not seen this pass have exited.
+  for (Entry& e : table_) {
+    if (e.pid > 0 && e.pass != pass_) {
+      e.pid = -1;
+      --live_;
+      ++deleted_;
+    }
+  }
+  // Deleted markers lengthen probes; clear them out once they fill a quarter of the table.
+  if (deleted_ * 4 > table_.size()) rehash();
+
+  std::sort_heap(heap_.begin(), heap_.end(), busier);
+  top_.swap(heap_);
+  heap_.clear();
+  pass_processes_ = seen_;
+  pass_untracked_ = untracked_;
+  ++passes_;
+}
+
+bool ProcessSource::append_detail_json(std::string& out) const {
+  if (passes_ == 0) return false;
+  append_row(out, "{\"processes\":%llu,\"untracked\":%llu,\"top\":[", static_cast<unsigned long long>(pass_processes_),
+             static_cast<unsigned long long>(pass_untracked_));
+  for (std::size_t i = 0; i < top_.size(); ++i) {
+    const ProcessSample& s = top_[i];
+    append_row(out, "%s{\"pid\":%d,\"comm\":\"%s\",\"cpu_pct\":%.2f,\"rss_bytes\":%llu}", i ? "," : "",
+               static_cast<int>(s.pid), s.comm, s.cpu_pct, static_cast<unsigned long long>(s.rss_bytes));
+  }
+  out.append("]}");
+  return true;
+}
+
+void ProcessSource::append_openmetrics(std::string& out) const {
+  if (passes_ == 0) return;
+  append_row(out, "# TYPE telemetry_processes gauge\n# HELP telemetry_processes Processes in the last scan.\n"
+                  "telemetry_processes %llu\n",
+             static_cast<unsigned long long>(pass_processes_));
+  if (top_.empty()) return;
+  out.append("# TYPE telemetry_process_cpu_percent gauge\n"
+             "# HELP telemetry_process_cpu_percent CPU of the busiest processes (100 = one core).\n");
+  for (const ProcessSample& s : top_) {
+    append_row(out, "telemetry_process_cpu_percent{pid=\"%d\",comm=\"%s\"} %.2f\n", static_cast<int>(s.pid), s.comm,
+               s.cpu_pct);
+  }
+  out.append("# TYPE telemetry_process_resident_bytes gauge\n"
+             "# HELP telemetry_process_resident_bytes Resident memory of the busiest processes.\n");
+  for (const ProcessSample& s : top_) {
+    append_row(out, "telemetry_process_resident_bytes{pid=\"%d\",comm=\"%s\"} %llu\n", static_cast<int>(s.pid), s.comm,
+               static_cast<unsigned long long>(s.rss_bytes));
+  }
+}
+
+}  // namespace telemetry::metrics
+
+#endif  // __linux__
@@ -0,0 +1,175 @@
+#include "telemetry/metrics/replay_source.h"
+
+#ifndef _WIN32
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+
+#include "telemetry/codec/snapshot_codec.h"
+#include "telemetry/storage/spool.h"
+#include "telemetry/util/time.h"
+
+namespace telemetry::metrics {
+
+ReplaySource::ReplaySource(const ReplayConfig& cfg) : cfg_(cfg), path_(cfg.path ? cfg.path : "") {}
+
+ReplaySource::~ReplaySource() { close(); }
+
+void ReplaySource::close() {
+  for (const Mapping& m : maps_) (void)::munmap(m.base, m.len);
+  maps_.clear();
+  records_.clear();
+}
+
+Status ReplaySource::map_segment(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return Status::IoError("open(replay segment) failed");
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    return Status::IoError("fstat(replay segment) failed");
+  }
+  const std::size_t size = static_cast<std::size_t>(st.st_size);
+  if (size < storage::kSpoolRecordHeaderSize) {
+    ::close(fd);
+    return Status::Ok();
+  }
+  void* base = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED) return Status::IoError("mmap(replay segment) failed");
+  // Read front to back once to index, then one record per sample in the same order.
+  (void)::madvise(base, size, MADV_SEQUENTIAL);
+  maps_.push_back(Mapping{base, size});
+
+  storage::SpoolRecordReader reader(static_cast<const std::uint8_t*>(base), size);
+  const std::uint8_t* payload = nullptr;
+  std::uint32_t len = 0;
+  std::size_t off = 0;
+  while (reader.next(payload, len)) {
+    MetricsSnapshot snap{};
+    if (!codec::decode_snapshot(payload, len, snap, nullptr).ok()) break;
+
+    if (records_.empty()) first_ts_ms_ = snap.ts_ms;
+    std::uint64_t offset = snap.ts_ms > first_ts_ms_ ? snap.ts_ms - first_ts_ms_ : 0;
+    if (!records_.empty()) offset = std::max(offset, records_.back().offset_ms);
+    records_.push_back(Record{payload, len, offset});
+    off = reader.offset();
+  }
+  if (off != size) {
+    std::fprintf(stderr, "replay: %s: stopped at byte %llu of %llu (bad record)\n", path.c_str(),
+                 static_cast<unsigned long long>(off), static_cast<unsigned long long>(size));
+  }
+  return Status::Ok();
+}
+
+Status ReplaySource::open() {
+  close();
+  if (path_.empty()) return Status::InvalidArgument("replay path is empty");
+  struct stat st {};
+  if (::stat(path_.c_str(), &st) != 0) return Status::IoError("stat(replay path) failed");
+
+  std::vector<std::string> files;
+  if (S_ISDIR(st.st_mode)) {
+    DIR* d = ::opendir(path_.c_str());
+    if (!d) return Status::IoError("opendir(replay dir) failed");
+    std::uint64_t base = 0;
+    while (const dirent* e = ::readdir(d)) {
+      if (storage::parse_segment_name(e->d_name, base)) files.push_back(path_ + "/" + e->d_name);
+    }
+    ::closedir(d);
+    // Segments are named after their zero-padded starting cursor, so name order is log order.
+    std::sort(files.begin(), files.end());
+  } else {
+    files.push_back(path_);
+  }
+  for (const std::string& f : files) {
+    const Status s = map_segment(f);
+    if (!s.ok()) {
+      close();
+      return s;
+    }
+  }
+  if (records_.empty()) return Status::InvalidArgument("replay trace has no records");
+
+  // The gap between the last record and the first of the next pass is one mean interval.
+  const std::uint64_t span = records_.back().offset_ms;
+  cycle_ms_ = std::max<std::uint64_t>(1, records_.size() > 1 ? span + span / (records_.size() - 1) : span);
+  started_ = false;
+  pos_ = 0;
+  loops_ = 0;
+  return Status::Ok();
+}
+
+Status ReplaySource::collect(MetricsSnapshot& out) { return sample(out, telemetry::util::monotonic_ns()); }
+
+Status ReplaySource::sample(MetricsSnapshot& out, std::uint64_t now_ns) {
+  if (records_.empty()) return Status::Unavailable("replay trace not open");
+
+  if (cfg_.speed <= 0.0) {
+    if (!started_) {
+      started_ = true;
+    } else if (++pos_ == records_.size()) {
+      if (cfg_.loop) {
+        pos_ = 0;
+        ++loops_;
+      } else {
+        pos_ = records_.size() - 1;
+      }
+    }
+  } else {
+    if (!started_) {
+      start_ns_ = now_ns;
+      started_ = true;
+    }
+    const double elapsed_ms = now_ns > start_ns_ ? static_cast<double>(now_ns - start_ns_) / 1e6 * cfg_.speed : 0.0;
+    std::uint64_t t = static_cast<std::uint64_t>(elapsed_ms);
+    if (cfg_.loop) {
+      loops_ = t / cycle_ms_;
+      t %= cycle_ms_;
+    }
+    // The last record at or before the trace time; the first record is at 0.
+    const auto it = std::upper_bound(records_.begin(), records_.end(), t,
+                                     [](std::uint64_t v, const Record& r) { return v < r.offset_ms; });
+    pos_ = static_cast<std::size_t>(it - records_.begin()) - 1;
+  }
+
+  const Record& r = records_[pos_];
+  const std::uint64_t ts_ms = out.ts_ms;
+  StatusCode recorded = StatusCode::kOk;
+  const Status st = codec::decode_snapshot(r.payload, r.len, out, &recorded);
+  out.ts_ms = ts_ms;
+  if (!st.ok()) return st;
+  // The agent that recorded the trace failed this sample the same way.
+  if (recorded != StatusCode::kOk) return Status{recorded, "recorded collect failed"};
+  return Status::Ok();
+}
+
+std::uint64_t ReplaySource::trace_ts_ms() const {
+  return records_.empty() ? 0 : first_ts_ms_ + records_[pos_].offset_ms;
+}
+
+bool ReplaySource::append_detail_json(std::string& out) const {
+  if (records_.empty()) return false;
+  char buf[320];
+  const int n = std::snprintf(
+      buf, sizeof(buf),
+      "{\"records\":%llu,\"segments\":%llu,\"duration_ms\":%llu,\"speed\":%.3g,\"loop\":%s,\"position\":%llu,"
+      "\"loops\":%llu,\"trace_ts_ms\":%llu}",
+      static_cast<unsigned long long>(records_.size()), static_cast<unsigned long long>(maps_.size()),
+      static_cast<unsigned long long>(duration_ms()), cfg_.speed, cfg_.loop ? "true" : "false",
+      static_cast<unsigned long long>(pos_), static_cast<unsigned long long>(loops_),
+      static_cast<unsigned long long>(trace_ts_ms()));
+  if (n <= 0) return false;
+  out.append(buf, std::min(static_cast<std::size_t>(n), sizeof(buf) - 1));
+  return true;
+}
+
+}  // namespace telemetry::metrics
+
+#endif  // !_WIN32
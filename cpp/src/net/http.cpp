@@ -0,0 +1,111 @@
+#include "telemetry/net/http.h"
+
+#include <cstring>
+
+namespace telemetry::net {
+
+namespace {
+
+static char lower(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+
+static bool iequals(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) return false;
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    if (lower(a[i]) != lower(b[i])) return false;
+  }
+  return true;
+}
+
+static bool icontains(std::string_view hay, std::string_view needle) {
+  if (needle.size() > hay.size()) return false;
+  for (std::size_t i = 0; i + needle.size() <= hay.size(); ++i) {
+    if (iequals(hay.substr(i, needle.size()), needle)) return true;
+  }
+  return false;
+}
+
+static std::string_view trim(std::string_view s) {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+  return s;
+}
+
+static HttpParseResult fail(HttpRequest& out, int status) {
+  out.error_status = status;
+  return HttpParseResult::kError;
+}
+
+}  // namespace
+
+HttpParseResult HttpRequestParser::parse(std::string_view data, HttpRequest& out) {
+  // Resume the terminator search just before where the last call stopped, in case
+  // "\r\n\r\n" straddles two reads.
+  const std::size_t from = scanned_ > 3 ? scanned_ - 3 : 0;
+  const std::size_t end = data.find("\r\n\r\n", from);
+  if (end == std::string_view::npos) {
+    scanned_ = data.size();
+    return HttpParseResult::kIncomplete;
+  }
+  const std::size_t head_len = end + 4;
+
+  out = HttpRequest{};
+  std::string_view head = data.substr(0, end);
+  const std::size_t line_end = head.find("\r\n");
+  const std::string_view request_line = head.substr(0, line_end);
+  head = line_end == std::string_view::npos ? std::string_view{} : head.substr(line_end + 2);
+
+  // METHOD SP TARGET SP HTTP/1.x
+  const std::size_t sp1 = request_line.find(' ');
+  const std::size_t sp2 = sp1 == std::string_view::npos ? sp1 : request_line.find(' ', sp1 + 1);
+  if (sp2 == std::string_view::npos) return fail(out, 400);
+  out.method = request_line.substr(0, sp1);
+  out.target = request_line.substr(sp1 + 1, sp2 - sp1 - 1);
+  const std::string_view version = request_line.substr(sp2 + 1);
+  if (out.method.empty() || out.target.empty()) return fail(out, 400);
+  if (version == "HTTP/1.1") {
+    out.keep_alive = true;
+  } else if (version == "HTTP/1.0") {
+    out.keep_alive = false;
+  } else {
+    return fail(out, 505);
+  }
+
+  std::size_t content_length = 0;
+  while (!head.empty()) {
+    const std::size_t eol = head.find("\r\n");
+    const std::string_view line = head.substr(0, eol);
+    head = eol == std::string_view::npos ? std::string_view{} : head.substr(eol + 2);
+
+    const std::size_t colon = line.find(':');
+    if (colon == std::string_view::npos || colon == 0) return fail(out, 400);
+    const std::string_view name = line.substr(0, colon);
+    const std::string_view value = trim(line.substr(colon + 1));
+
+    if (iequals(name, "connection")) {
+      if (icontains(value, "close")) out.keep_alive = false;
+      if (icontains(value, "keep-alive")) out.keep_alive = true;
+    } else if (iequals(name, "accept")) {
+      out.wants_openmetrics = icontains(value, "application/openmetrics-text");
+    } else if (iequals(name, "content-length")) {
+      content_length = 0;
+      if (value.empty()) return fail(out, 400);
+      for (char ch : value) {
+        if (ch < '0' || ch > '9') return fail(out, 400);
+        content_length = content_length * 10 + static_cast<std::size_t>(ch - '0');
+        if (content_length > 4096) return fail(out, 413);
+      }
+    } else if (iequals(name, "transfer-encoding")) {
+      return fail(out, 501);
+    }
+  }
+
+  // Bodies are ignored but must be skipped to find the next pipelined request.
+  if (data.size() < head_len + content_length) {
+    scanned_ = end + 3;  // the next call finds this head again and re-checks the body
+    return HttpParseResult::kIncomplete;
+  }
+  out.length = head_len + content_length;
+  return HttpParseResult::kComplete;
+}
+
+}  // namespace telemetry::net
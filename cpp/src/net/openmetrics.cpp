@@ -0,0 +1,59 @@
+#include "telemetry/net/openmetrics.h"
+
+#include <cstdio>
+
+#include "telemetry/platform.h"
+
+namespace telemetry::net {
+
+Status render_openmetrics(const MetricsSnapshot& snap, Status collect_status, std::string& out,
+                          std::string_view extra_families) {
+  char buf[2048];
+  const int n = std::snprintf(
+      buf, sizeof(buf),
+      "# TYPE telemetry_collect_ok gauge\n"
+      "# HELP telemetry_collect_ok Whether the last collection succeeded (1) or failed (0).\n"
+      "telemetry_collect_ok %d\n"
+      "# TYPE telemetry_collect_status_code gauge\n"
+      "# HELP telemetry_collect_status_code Status code of the last collection (0 = ok).\n"
+      "telemetry_collect_status_code %u\n"
+      "# TYPE telemetry_snapshot_timestamp_seconds gauge\n"
+      "# UNIT telemetry_snapshot_timestamp_seconds seconds\n"
+      "# HELP telemetry_snapshot_timestamp_seconds Unix time the snapshot was taken.\n"
+      "telemetry_snapshot_timestamp_seconds %llu.%03u\n"
+      "# TYPE telemetry_cpu_usage_percent gauge\n"
+      "# UNIT telemetry_cpu_usage_percent percent\n"
+      "# HELP telemetry_cpu_usage_percent CPU busy time over the last sampling interval.\n"
+      "telemetry_cpu_usage_percent %.2f\n"
+      "# TYPE telemetry_memory_total_bytes gauge\n"
+      "# UNIT telemetry_memory_total_bytes bytes\n"
+      "# HELP telemetry_memory_total_bytes Total physical memory.\n"
+      "telemetry_memory_total_bytes %llu\n"
+      "# TYPE telemetry_memory_available_bytes gauge\n"
+      "# UNIT telemetry_memory_available_bytes bytes\n"
+      "# HELP telemetry_memory_available_bytes Memory available without swapping.\n"
+      "telemetry_memory_available_bytes %llu\n"
+      "# TYPE telemetry_temperature_celsius gauge\n"
+      "# UNIT telemetry_temperature_celsius celsius\n"
+      "# HELP telemetry_temperature_celsius Best-effort board temperature.\n"
+      "telemetry_temperature_celsius %.2f\n"
+      "# TYPE telemetry_uptime_seconds gauge\n"
+      "# UNIT telemetry_uptime_seconds seconds\n"
+      "# HELP telemetry_uptime_seconds System uptime.\n"
+      "telemetry_uptime_seconds %llu\n"
+      "# TYPE telemetry_agent_platform gauge\n"
+      "# HELP telemetry_agent_platform Constant 1, labelled with the agent platform.\n"
+      "telemetry_agent_platform{platform=\"%s\"} 1\n",
+      collect_status.ok() ? 1 : 0, static_cast<unsigned>(collect_status.code),
+      static_cast<unsigned long long>(snap.ts_ms / 1000), static_cast<unsigned>(snap.ts_ms % 1000),
+      snap.cpu_usage_pct, static_cast<unsigned long long>(snap.mem_total_kb) * 1024ULL,
+      static_cast<unsigned long long>(snap.mem_available_kb) * 1024ULL, snap.temperature_c,
+      static_cast<unsigned long long>(snap.uptime_s), telemetry::platform_name());
+  if (n <= 0 || static_cast<std::size_t>(n) >= sizeof(buf)) return Status::Internal("exposition too large");
+  out.assign(buf, static_cast<std::size_t>(n));
+  out.append(extra_families);
+  out.append("# EOF\n");
+  return Status::Ok();
+}
+
+}  // namespace telemetry::net
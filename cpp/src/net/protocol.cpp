@@ -1,5 +1,9 @@
 #include "telemetry/net/protocol.h"
 
+#include <cstdio>
+
+#include "telemetry/platform.h"
+
 namespace telemetry::net {
 
 namespace {
@@ -8,6 +12,30 @@ static bool starts_with(std::string_view s, std::string_view prefix) {
   return s.size() >= prefix.size() && s.substr(0, prefix.size()) == prefix;
 }
 
+// Non-negative decimal with optional fraction ("90", "92.5").
+static bool parse_decimal(std::string_view s, double& out) {
+  if (s.empty()) return false;
+  double v = 0.0;
+  double scale = 0.0;
+  bool digits = false;
+  for (char ch : s) {
+    if (ch == '.' && scale == 0.0) {
+      scale = 1.0;
+      continue;
+    }
+    if (ch < '0' || ch > '9') return false;
+    digits = true;
+    if (scale == 0.0) {
+      v = v * 10.0 + static_cast<double>(ch - '0');
+    } else {
+      scale *= 10.0;
+      v += static_cast<double>(ch - '0') / scale;
+    }
+  }
+  out = v;
+  return digits;
+}
+
 }  // namespace
 
 ParsedCommand parse_command(std::string_view line) {
@@ -28,9 +56,147 @@ ParsedCommand parse_command(std::string_view line) {
     return ParsedCommand{CommandType::kThrottle, static_cast<std::uint32_t>(ms), true, nullptr};
   }
 
+  if (starts_with(line, "DRAIN ")) {
+    const std::string_view arg = line.substr(std::string_view("DRAIN ").size());
+    if (arg.empty()) return ParsedCommand{CommandType::kDrain, 0, false, "missing cursor"};
+
+    ParsedCommand pc{CommandType::kDrain, 0, true, nullptr};
+    for (char ch : arg) {
+      if (ch < '0' || ch > '9') return ParsedCommand{CommandType::kDrain, 0, false, "invalid cursor"};
+      const std::uint64_t digit = static_cast<std::uint64_t>(ch - '0');
+      if (pc.cursor > (UINT64_MAX - digit) / 10ULL) return ParsedCommand{CommandType::kDrain, 0, false, "cursor too large"};
+      pc.cursor = pc.cursor * 10ULL + digit;
+    }
+    return pc;
+  }
+
+  if (line == "FLEET" || line == "FLEET ALL") return ParsedCommand{CommandType::kFleet, 0, true, nullptr};
+
+  if (starts_with(line, "FLEET TOP ")) {
+    const std::string_view arg = line.substr(std::string_view("FLEET TOP ").size());
+    ParsedCommand pc{CommandType::kFleet, 0, true, nullptr};
+    pc.fleet_query = FleetQuery::kTopCpu;
+    if (arg.empty()) return ParsedCommand{CommandType::kFleet, 0, false, "missing n"};
+    for (char ch : arg) {
+      if (ch < '0' || ch > '9') return ParsedCommand{CommandType::kFleet, 0, false, "invalid n"};
+      pc.count = pc.count * 10U + static_cast<std::uint32_t>(ch - '0');
+      if (pc.count > 100000U) return ParsedCommand{CommandType::kFleet, 0, false, "n too large"};
+    }
+    if (pc.count == 0) return ParsedCommand{CommandType::kFleet, 0, false, "invalid n"};
+    return pc;
+  }
+
+  if (starts_with(line, "FLEET OVER ")) {
+    ParsedCommand pc{CommandType::kFleet, 0, true, nullptr};
+    pc.fleet_query = FleetQuery::kOverCpu;
+    if (!parse_decimal(line.substr(std::string_view("FLEET OVER ").size()), pc.threshold)) {
+      return ParsedCommand{CommandType::kFleet, 0, false, "invalid threshold"};
+    }
+    return pc;
+  }
+
+  if (line == "ALERTS") return ParsedCommand{CommandType::kAlerts, 0, true, nullptr};
+  if (line == "CLIENTS") return ParsedCommand{CommandType::kClients, 0, true, nullptr};
+
+  if (line == "DETAIL" || starts_with(line, "DETAIL ")) {
+    ParsedCommand pc{CommandType::kDetail, 0, true, nullptr};
+    pc.source = line.size() > 7 ? line.substr(7) : std::string_view{};
+    if (line.size() == 7 || pc.source.find(' ') != std::string_view::npos) {
+      return ParsedCommand{CommandType::kDetail, 0, false, "want DETAIL [<source>]"};
+    }
+    return pc;
+  }
+  if (line == "TOP") {
+    ParsedCommand pc{CommandType::kTop, 0, true, nullptr};
+    pc.count = 10;
+    return pc;
+  }
+  if (starts_with(line, "TOP ")) {
+    const std::string_view arg = line.substr(std::string_view("TOP ").size());
+    ParsedCommand pc{CommandType::kTop, 0, true, nullptr};
+    if (arg.empty()) return ParsedCommand{CommandType::kTop, 0, false, "missing n"};
+    for (char ch : arg) {
+      if (ch < '0' || ch > '9') return ParsedCommand{CommandType::kTop, 0, false, "invalid n"};
+      pc.count = pc.count * 10U + static_cast<std::uint32_t>(ch - '0');
+      if (pc.count > 256U) return ParsedCommand{CommandType::kTop, 0, false, "n too large"};
+    }
+    if (pc.count == 0) return ParsedCommand{CommandType::kTop, 0, false, "invalid n"};
+    return pc;
+  }
+  if (line == "UNSUBSCRIBE") return ParsedCommand{CommandType::kUnsubscribe, 0, true, nullptr};
+
+  // Plain SUBSCRIBE streams every sample in full (a keyframe per line).
+  if (line == "SUBSCRIBE") return ParsedCommand{CommandType::kSubscribe, 0, true, nullptr};
+
+  if (line == "SUBSCRIBE DELTA") return ParsedCommand{CommandType::kSubscribe, 0, false, "missing abs deadband"};
+
+  if (starts_with(line, "SUBSCRIBE ")) {
+    if (!starts_with(line, "SUBSCRIBE DELTA ")) return ParsedCommand{CommandType::kSubscribe, 0, false, "unknown subscribe mode"};
+    std::string_view rest = line.substr(std::string_view("SUBSCRIBE DELTA ").size());
+    std::string_view args[3];
+    std::size_t nargs = 0;
+    while (!rest.empty()) {
+      const std::size_t sp = rest.find(' ');
+      if (nargs == 3) return ParsedCommand{CommandType::kSubscribe, 0, false, "too many arguments"};
+      args[nargs++] = rest.substr(0, sp);
+      rest = sp == std::string_view::npos ? std::string_view{} : rest.substr(sp + 1);
+    }
+
+    ParsedCommand pc{CommandType::kSubscribe, 0, true, nullptr};
+    pc.keyframe_every = 60;
+    if (nargs == 0 || !parse_decimal(args[0], pc.deadband_abs)) {
+      return ParsedCommand{CommandType::kSubscribe, 0, false, "invalid abs deadband"};
+    }
+    if (nargs >= 2 && !parse_decimal(args[1], pc.deadband_rel)) {
+      return ParsedCommand{CommandType::kSubscribe, 0, false, "invalid rel deadband"};
+    }
+    if (nargs == 3) {
+      pc.keyframe_every = 0;
+      for (char ch : args[2]) {
+        if (ch < '0' || ch > '9') return ParsedCommand{CommandType::kSubscribe, 0, false, "invalid keyframe interval"};
+        pc.keyframe_every = pc.keyframe_every * 10U + static_cast<std::uint32_t>(ch - '0');
+        if (pc.keyframe_every > 100000U) return ParsedCommand{CommandType::kSubscribe, 0, false, "keyframe interval too large"};
+      }
+      if (pc.keyframe_every == 0) return ParsedCommand{CommandType::kSubscribe, 0, false, "invalid keyframe interval"};
+    }
+    return pc;
+  }
+
+  if (line == "TRACE" || starts_with(line, "TRACE ")) {
+    ParsedCommand pc{CommandType::kTrace, 0, true, nullptr};
+    const std::string_view arg = line.size() > 6 ? line.substr(6) : std::string_view{};
+    if (arg == "DUMP") {
+      pc.trace_op = TraceOp::kDump;
+    } else if (arg == "ON") {
+      pc.trace_op = TraceOp::kOn;
+    } else if (arg == "OFF") {
+      pc.trace_op = TraceOp::kOff;
+    } else if (arg == "CLEAR") {
+      pc.trace_op = TraceOp::kClear;
+    } else {
+      return ParsedCommand{CommandType::kTrace, 0, false, "want TRACE ON|OFF|CLEAR|DUMP"};
+    }
+    return pc;
+  }
+
   return ParsedCommand{CommandType::kUnknown, 0, true, nullptr};
 }
 
-}  // namespace telemetry::net
-
+std::size_t format_metrics_json(char* out, std::size_t cap, const MetricsSnapshot& snap, Status collect_status,
+                                std::uint32_t throttle_ms) {
+  const int n = std::snprintf(
+      out, cap,
+      "{\"ok\":%s,\"status_code\":%u,\"platform\":\"%s\",\"temperature_best_effort\":%s,\"ts_ms\":%llu,\"cpu_usage_pct\":%.2f,"
+      "\"mem_total_kb\":%llu,\"mem_available_kb\":%llu,\"temperature_c\":%.2f,"
+      "\"uptime_s\":%llu,\"throttle_ms\":%u}\n",
+      collect_status.ok() ? "true" : "false", static_cast<unsigned>(collect_status.code),
+      telemetry::platform_name(),
+      telemetry::temperature_best_effort_supported() ? "true" : "false",
+      static_cast<unsigned long long>(snap.ts_ms), snap.cpu_usage_pct,
+      static_cast<unsigned long long>(snap.mem_total_kb), static_cast<unsigned long long>(snap.mem_available_kb),
+      snap.temperature_c, static_cast<unsigned long long>(snap.uptime_s), static_cast<unsigned>(throttle_ms));
+  if (n <= 0 || static_cast<std::size_t>(n) >= cap) return 0;
+  return static_cast<std::size_t>(n);
+}
 
+}  // namespace telemetry::net
@@ -8,15 +8,25 @@
 #include <cstring>
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <poll.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <unistd.h>
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
 
+#include <algorithm>
 #include <array>
 #include <string_view>
+#include <vector>
 
+#include "telemetry/net/openmetrics.h"
 #include "telemetry/net/protocol.h"
-#include "telemetry/platform.h"
+#include "telemetry/storage/spool.h"
+#include "telemetry/trace/trace.h"
 #include "telemetry/util/time.h"
 
 namespace telemetry::net {
@@ -24,243 +34,1154 @@ namespace telemetry::net {
 namespace {
 
 constexpr int kMaxClients = 64;
-constexpr std::size_t kBufSize = 1024;
+constexpr int kMaxListeners = 3;
+// Sized for HTTP request heads (scrapers and browsers send a few hundred bytes of headers).
+constexpr std::size_t kBufSize = 4096;
+// Poll cap when the stop() wake pipe could not be created.
+constexpr int kIdlePollMs = 250;
+// Lower bound on background sampling so THROTTLE 0 does not turn the loop into a spin.
+constexpr std::uint32_t kMinSampleIntervalMs = 10;
+// A client that lets this much output pile up is dropped rather than buffered further.
+constexpr std::size_t kMaxPendingOut = 4 * 1024 * 1024;
+constexpr std::size_t kDrainChunk = 1024 * 1024;
 
-struct Client final {
+// WheelTimer tags; a connection's idle timer is kIdleTimerTag + its slot.
+constexpr std::uint32_t kDeadlineTimerTag = 1;
+constexpr std::uint32_t kSampleTimerTag = 2;
+constexpr std::uint32_t kSpoolTimerTag = 3;
+constexpr std::uint32_t kIdleTimerTag = 16;
+
+enum class ListenerKind : std::uint8_t {
+  kLine = 0,  // newline-delimited command protocol
+  kHttp,      // OpenMetrics scrape endpoint
+};
+
+struct Listener final {
+  int fd{-1};
+  ListenerKind kind{ListenerKind::kLine};
+  // Socket file of an AF_UNIX listener (unlinked on close); nullptr for TCP.
+  const char* unix_path{nullptr};
+  // Identity of the socket file bound, so close leaves a file that has since been replaced.
+  dev_t unix_dev{0};
+  ino_t unix_ino{0};
+};
+
+}  // namespace
+
+struct Connection final {
   SocketHandle fd{-1};
   std::array<char, kBufSize> buf{};
   std::size_t len{0};
+  ListenerKind kind{ListenerKind::kLine};
+  bool unix_socket{false};
+  HttpRequestParser http;
+
+  // Response bytes the socket did not accept yet.
+  std::vector<char> out;
+  std::size_t out_off{0};
+
+  // In-progress DRAIN body, streamed from a spool segment once `out` is empty.
+  int drain_fd{-1};
+  std::uint64_t drain_off{0};
+  std::uint64_t drain_left{0};
+
+  bool closing{false};
+  // Close once queued output is flushed (HTTP without keep-alive, protocol errors).
+  bool close_after_output{false};
+  // Subscribed to rule transitions via ALERTS.
+  bool alerts{false};
+  // Index into the server's subscription groups, or -1.
+  int sub_group{-1};
+
+  // Reported by CLIENTS: server-assigned id and lifetime counters. `deferred` counts passes
+  // cut short by the per-pass budget.
+  std::uint64_t id{0};
+  std::uint64_t commands{0};
+  std::uint64_t bytes_in{0};
+  std::uint64_t bytes_out{0};
+  std::uint64_t deferred{0};
+  // Budget spent in the current loop pass.
+  std::uint32_t pass_commands{0};
+  std::size_t pass_bytes{0};
+  // Complete input left over when the command budget ran out; served first next pass.
+  bool backlog{false};
+
+  // Armed while idle_timeout_ms is set. It is not moved on every read or write: on expiry it
+  // is re-armed from `last_active_ms` (monotonic) if the connection was active meanwhile.
+  util::WheelTimer idle_timer;
+  std::uint64_t last_active_ms{0};
+
+  bool has_pending_output() const { return out_off < out.size() || drain_fd >= 0; }
 };
 
+namespace {
+
 static bool set_nonblocking(int fd) {
   const int flags = fcntl(fd, F_GETFL, 0);
   if (flags < 0) return false;
   return fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
 }
 
-static void close_client(Client& c) {
+static void close_client(Connection& c, util::TimerWheel& timers) {
+  timers.cancel(c.idle_timer);
   if (c.fd >= 0) close(c.fd);
+  if (c.drain_fd >= 0) close(c.drain_fd);
   c.fd = -1;
   c.len = 0;
+  c.out.clear();
+  c.out_off = 0;
+  c.drain_fd = -1;
+  c.drain_off = 0;
+  c.drain_left = 0;
+  c.closing = false;
+  c.close_after_output = false;
+  c.alerts = false;
+  c.sub_group = -1;
+  c.http.reset();
+  c.unix_socket = false;
+  c.id = 0;
+  c.commands = 0;
+  c.bytes_in = 0;
+  c.bytes_out = 0;
+  c.deferred = 0;
+  c.pass_commands = 0;
+  c.pass_bytes = 0;
+  c.backlog = false;
+  c.last_active_ms = 0;
 }
 
-}  // namespace
+// Binds `fd` to `addr`, listens and makes it non-blocking; closes `fd` on failure.
+static Status bind_and_listen(int fd, const sockaddr* addr, socklen_t addr_len, int& out_fd) {
+  if (::bind(fd, addr, addr_len) != 0) {
+    ::close(fd);
+    return Status::IoError("bind() failed");
+  }
 
-TcpServer::TcpServer(metrics::Collector& collector, TcpServerConfig cfg)
-    : collector_(collector), cfg_(cfg), throttle_ms_(cfg.throttle_ms) {}
+  if (::listen(fd, 16) != 0) {
+    ::close(fd);
+    return Status::IoError("listen() failed");
+  }
 
-Status TcpServer::run_forever() {
-  const std::uint64_t start_ms = telemetry::util::unix_time_ms();
-  const int listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
-  if (listen_fd < 0) return Status::IoError("socket() failed");
+  if (!set_nonblocking(fd)) {
+    ::close(fd);
+    return Status::IoError("set_nonblocking(listen_fd) failed");
+  }
+  out_fd = fd;
+  return Status::Ok();
+}
+
+static Status open_listener(const char* host, std::uint16_t port, int& out_fd) {
+  const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return Status::IoError("socket() failed");
 
   int yes = 1;
-  (void)::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  (void)::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
 
   sockaddr_in addr{};
   addr.sin_family = AF_INET;
-  addr.sin_port = htons(cfg_.port);
-  if (::inet_pton(AF_INET, cfg_.host, &addr.sin_addr) != 1) {
-    ::close(listen_fd);
+  addr.sin_port = htons(port);
+  if (::inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+    ::close(fd);
     return Status::InvalidArgument("invalid host");
   }
+  return bind_and_listen(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr), out_fd);
+}
 
-  if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
-    ::close(listen_fd);
-    return Status::IoError("bind() failed");
+static Status open_unix_listener(const char* path, int& out_fd, struct stat& bound) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (std::strlen(path) >= sizeof(addr.sun_path)) return Status::InvalidArgument("unix socket path too long");
+  std::memcpy(addr.sun_path, path, std::strlen(path) + 1);
+
+  // A socket file left by a crashed run would make bind() fail. It is replaced only if
+  // nothing accepts on it (ECONNREFUSED); a live agent's socket fails startup instead, and
+  // any other kind of file is kept.
+  struct stat st {};
+  if (::lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+    const int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0) return Status::IoError("socket(AF_UNIX) failed");
+    // Non-blocking, so a listener with a full backlog answers EAGAIN instead of stalling.
+    if (!set_nonblocking(probe)) {
+      ::close(probe);
+      return Status::IoError("set_nonblocking(unix probe) failed");
+    }
+    const bool refused = ::connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 && errno == ECONNREFUSED;
+    ::close(probe);
+    if (!refused) return Status::IoError("unix socket address in use");
+    (void)::unlink(path);
   }
 
-  if (::listen(listen_fd, 16) != 0) {
-    ::close(listen_fd);
-    return Status::IoError("listen() failed");
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) return Status::IoError("socket(AF_UNIX) failed");
+  const Status bst = bind_and_listen(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr), out_fd);
+  if (!bst.ok()) return bst;
+  if (::lstat(path, &bound) != 0) {
+    ::close(out_fd);
+    out_fd = -1;
+    return Status::IoError("stat(unix socket) failed");
   }
+  return Status::Ok();
+}
 
-  if (!set_nonblocking(listen_fd)) {
-    ::close(listen_fd);
-    return Status::IoError("set_nonblocking(listen_fd) failed");
+static void close_listeners(std::array<Listener, kMaxListeners>& listeners, int count) {
+  for (int i = 0; i < count; ++i) {
+    ::close(listeners[i].fd);
+    struct stat st {};
+    if (listeners[i].unix_path && ::lstat(listeners[i].unix_path, &st) == 0 && st.st_dev == listeners[i].unix_dev &&
+        st.st_ino == listeners[i].unix_ino) {
+      (void)::unlink(listeners[i].unix_path);
+    }
+  }
+}
+
+// Opens every listener the config asks for; on failure none stay open.
+static Status open_listeners(const TcpServerConfig& cfg, std::array<Listener, kMaxListeners>& listeners, int& count) {
+  count = 0;
+  Status st = open_listener(cfg.host, cfg.port, listeners[count].fd);
+  if (!st.ok()) return st;
+  listeners[count++].kind = ListenerKind::kLine;
+
+  if (cfg.metrics_port != 0) {
+    st = open_listener(cfg.host, cfg.metrics_port, listeners[count].fd);
+    if (!st.ok()) {
+      close_listeners(listeners, count);
+      return st;
+    }
+    listeners[count++].kind = ListenerKind::kHttp;
+  }
+
+  if (cfg.unix_path != nullptr) {
+    struct stat bound {};
+    st = open_unix_listener(cfg.unix_path, listeners[count].fd, bound);
+    if (!st.ok()) {
+      close_listeners(listeners, count);
+      return st;
+    }
+    listeners[count].kind = ListenerKind::kLine;
+    listeners[count].unix_dev = bound.st_dev;
+    listeners[count].unix_ino = bound.st_ino;
+    listeners[count++].unix_path = cfg.unix_path;
+  }
+  return Status::Ok();
+}
+
+static const char* http_reason(int status) {
+  switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Content Too Large";
+    case 431: return "Request Header Fields Too Large";
+    case 501: return "Not Implemented";
+    case 505: return "HTTP Version Not Supported";
+    default: return "Internal Server Error";
   }
+}
+
+static ssize_t stream_file(int sock, int fd, std::uint64_t off, std::uint64_t len) {
+  const std::size_t chunk = static_cast<std::size_t>(std::min<std::uint64_t>(len, kDrainChunk));
+#if defined(__linux__)
+  off_t o = static_cast<off_t>(off);
+  return ::sendfile(sock, fd, &o, chunk);
+#else
+  char tmp[16 * 1024];
+  const ssize_t r = ::pread(fd, tmp, std::min(chunk, sizeof(tmp)), static_cast<off_t>(off));
+  if (r <= 0) return r;
+  return ::write(sock, tmp, static_cast<std::size_t>(r));
+#endif
+}
 
-  std::array<Client, kMaxClients> clients{};
+static ParsedCommand traced_parse(std::string_view line) {
+  trace::Span span("parse");
+  return parse_command(line);
+}
 
-  // Simple poll loop: [0] is listener, [1..] clients.
+// Writes as much pending output as the socket accepts. Returns false if the connection broke.
+static bool flush_output(Connection& c) {
+  trace::Span span("flush", c.out.size() - c.out_off);
+  while (c.out_off < c.out.size()) {
+    const ssize_t n = ::write(c.fd, c.out.data() + c.out_off, c.out.size() - c.out_off);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    c.out_off += static_cast<std::size_t>(n);
+  }
+  c.out.clear();
+  c.out_off = 0;
+
+  while (c.drain_fd >= 0 && c.drain_left > 0) {
+    const ssize_t n = stream_file(c.fd, c.drain_fd, c.drain_off, c.drain_left);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    // The header promised drain_left bytes; a short file cannot be recovered mid-stream.
+    if (n == 0) return false;
+    c.bytes_out += static_cast<std::uint64_t>(n);
+    c.drain_off += static_cast<std::uint64_t>(n);
+    c.drain_left -= static_cast<std::uint64_t>(n);
+  }
+  if (c.drain_fd >= 0) {
+    close(c.drain_fd);
+    c.drain_fd = -1;
+  }
+  return true;
+}
+
+}  // namespace
+
+TcpServer::TcpServer(metrics::SnapshotCollector& collector, TcpServerConfig cfg)
+    : collector_(collector), cfg_(cfg), throttle_ms_(cfg.throttle_ms) {
+  deadline_timer_.tag = kDeadlineTimerTag;
+  sample_timer_.tag = kSampleTimerTag;
+  spool_timer_.tag = kSpoolTimerTag;
+  if (::pipe(wake_fds_) != 0) {
+    wake_fds_[0] = wake_fds_[1] = -1;
+    return;
+  }
+  for (int fd : wake_fds_) {
+    (void)set_nonblocking(fd);
+    (void)::fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+}
+
+TcpServer::~TcpServer() {
+  for (int fd : wake_fds_) {
+    if (fd >= 0) ::close(fd);
+  }
+}
+
+void TcpServer::stop() {
+  stop_.store(true, std::memory_order_relaxed);
+  if (wake_fds_[1] >= 0) {
+    const char b = 1;
+    (void)::write(wake_fds_[1], &b, 1);  // a full pipe already has a wakeup pending
+  }
+}
+
+void TcpServer::arm_timers(std::uint64_t now) {
+  if (background_sampling()) {
+    // Keep spool and sinks fed while no client is asking.
+    const std::uint32_t interval = std::max(throttle_ms_.load(std::memory_order_relaxed), kMinSampleIntervalMs);
+    const std::uint64_t due = std::max(last_collect_ms_ + interval, now);
+    if (!sample_timer_.armed() || sample_timer_.due_ms() != due) timers_.schedule(sample_timer_, due);
+  } else {
+    timers_.cancel(sample_timer_);
+  }
+
+  if (spool_) {
+    const std::uint32_t wait = spool_->ms_until_flush(now);
+    if (wait == UINT32_MAX) {
+      timers_.cancel(spool_timer_);
+    } else if (!spool_timer_.armed() || spool_timer_.due_ms() > now + wait) {
+      timers_.schedule(spool_timer_, now + wait);
+    }
+  }
+}
+
+void TcpServer::on_idle_timer(Connection& c, std::uint64_t now) {
+  if (c.fd < 0) return;
+  const std::uint64_t timeout = cfg_.idle_timeout_ms;
+  // Push subscribers are expected to sit silent.
+  if (c.alerts || c.sub_group >= 0) {
+    timers_.schedule(c.idle_timer, now + timeout);
+  } else if (now - c.last_active_ms < timeout) {
+    timers_.schedule(c.idle_timer, c.last_active_ms + timeout);
+  } else {
+    close_client(c, timers_);
+  }
+}
+
+Status TcpServer::run_forever() {
+  const std::uint64_t start_ms = telemetry::util::monotonic_ms();
+
+  std::array<Listener, kMaxListeners> listeners{};
+  int listener_count = 0;
+  const Status st = open_listeners(cfg_, listeners, listener_count);
+  if (!st.ok()) return st;
+
+  // Connections own their idle timers; the wheel is reset before this table goes away.
+  std::array<Connection, kMaxClients> clients{};
+  for (int i = 0; i < kMaxClients; ++i) clients[i].idle_timer.tag = kIdleTimerTag + static_cast<std::uint32_t>(i);
+  clients_ = clients.data();
+  trace::set_thread_name("event-loop");
+  bool backlog = false;
+
+  trace::set_dump_wake_fd(wake_fds_[1]);
+  timers_.reset(start_ms);
+  if (cfg_.run_for_ms != 0) timers_.schedule(deadline_timer_, start_ms + cfg_.run_for_ms);
+  bool deadline = false;
+  std::uint64_t now = start_ms;
+  auto on_timer = [&](util::WheelTimer& t) {
+    switch (t.tag) {
+      case kDeadlineTimerTag:
+        deadline = true;
+        break;
+      case kSampleTimerTag:
+        (void)refresh_snapshot(now);
+        push_updates(clients.data(), kMaxClients);
+        break;
+      case kSpoolTimerTag:
+        (void)spool_->maybe_flush(now);
+        break;
+      default:
+        on_idle_timer(clients[t.tag - kIdleTimerTag], now);
+        break;
+    }
+  };
+
+  // Poll loop: [0, listener_count) are listeners, then one slot per client, the wake pipe and
+  // the sample triggers.
+  constexpr int kWakeSlot = kMaxListeners + kMaxClients;
   while (true) {
-    if (cfg_.run_for_ms != 0) {
-      const std::uint64_t now = telemetry::util::unix_time_ms();
-      if (now - start_ms >= cfg_.run_for_ms) {
-        ::close(listen_fd);
-        for (auto& c : clients) close_client(c);
-        return Status::Ok();
-      }
+    now = telemetry::util::monotonic_ms();
+    (void)timers_.advance(now, on_timer);
+    if (deadline || stop_.load(std::memory_order_relaxed)) {
+      close_listeners(listeners, listener_count);
+      for (auto& c : clients) close_client(c, timers_);
+      timers_.reset(now);
+      trace::set_dump_wake_fd(-1);
+      if (spool_) (void)spool_->flush(true);
+      clients_ = nullptr;
+      return Status::Ok();
     }
+    trace::service_dump_signal();
 
-    std::array<pollfd, kMaxClients + 1> pfds{};
-    pfds[0].fd = listen_fd;
-    pfds[0].events = POLLIN;
+    arm_timers(now);
+    int timeout_ms = timers_.poll_timeout_ms(now);
+    if (wake_fds_[0] < 0 && (timeout_ms < 0 || timeout_ms > kIdlePollMs)) timeout_ms = kIdlePollMs;
+    // Input held back by the budget is already here; only pick up new events.
+    if (backlog) timeout_ms = 0;
+
+    std::array<pollfd, kWakeSlot + 1 + kMaxTriggers> pfds{};
+    for (int l = 0; l < kMaxListeners; ++l) {
+      pfds[l].fd = l < listener_count ? listeners[l].fd : -1;
+      pfds[l].events = POLLIN;
+    }
+    pfds[kWakeSlot].fd = wake_fds_[0];
+    pfds[kWakeSlot].events = POLLIN;
+    for (std::size_t t = 0; t < kMaxTriggers; ++t) {
+      pollfd& p = pfds[kWakeSlot + 1 + t];
+      p.fd = t < triggers_.size() ? triggers_[t]->fd() : -1;
+      p.events = p.fd < 0 ? 0 : triggers_[t]->events();
+    }
 
     for (int i = 0; i < kMaxClients; ++i) {
-      pfds[i + 1].fd = clients[i].fd;
-      pfds[i + 1].events = (clients[i].fd >= 0) ? POLLIN : 0;
+      const Connection& c = clients[i];
+      pollfd& p = pfds[kMaxListeners + i];
+      p.fd = c.fd;
+      // While a response is still being written, stop reading so input stays in the kernel.
+      p.events = (c.fd < 0) ? 0 : (c.has_pending_output() ? POLLOUT : POLLIN);
     }
 
-    const int rc = ::poll(pfds.data(), pfds.size(), 250);
+    int rc = 0;
+    {
+      trace::Span span("poll");
+      rc = ::poll(pfds.data(), pfds.size(), timeout_ms);
+      span.set_arg(rc > 0 ? static_cast<std::uint64_t>(rc) : 0);
+    }
     if (rc < 0) {
       if (errno == EINTR) continue;
-      ::close(listen_fd);
+      close_listeners(listeners, listener_count);
+      for (auto& c : clients) close_client(c, timers_);
+      timers_.reset(now);
+      trace::set_dump_wake_fd(-1);
+      clients_ = nullptr;
       return Status::IoError("poll() failed");
     }
+    // Reads below count as activity at this time, not at the time poll() was entered.
+    now = telemetry::util::monotonic_ms();
+    if (pfds[kWakeSlot].revents & POLLIN) {
+      char drain[64];
+      while (::read(wake_fds_[0], drain, sizeof(drain)) > 0) {
+      }
+    }
+
+    // A trigger fired: sample now, outside the throttle window, and push the result. Several
+    // firing together share one sample.
+    bool triggered = false;
+    for (std::size_t t = 0; t < triggers_.size(); ++t) {
+      const short revents = pfds[kWakeSlot + 1 + t].revents;
+      if (revents != 0 && triggers_[t]->on_ready(revents)) triggered = true;
+    }
+    if (triggered) {
+      trace::Span span("trigger");
+      (void)refresh_snapshot(now, true);
+      push_updates(clients.data(), kMaxClients);
+    }
 
-    if (pfds[0].revents & POLLIN) {
+    for (int l = 0; l < listener_count; ++l) {
+      if (!(pfds[l].revents & POLLIN)) continue;
+      trace::Span span("accept");
+      std::uint64_t accepted = 0;
       // Accept as many as possible.
       while (true) {
-        sockaddr_in caddr{};
+        sockaddr_storage caddr{};
         socklen_t clen = sizeof(caddr);
-        const int cfd = ::accept(listen_fd, reinterpret_cast<sockaddr*>(&caddr), &clen);
+        const int cfd = ::accept(listeners[l].fd, reinterpret_cast<sockaddr*>(&caddr), &clen);
         if (cfd < 0) {
           if (errno == EAGAIN || errno == EWOULDBLOCK) break;
           break;
         }
         (void)set_nonblocking(cfd);
+        const bool unix_socket = listeners[l].unix_path != nullptr;
+        if (!unix_socket) {
+          // Replies are small and written whole; Nagle would hold one back until the peer's
+          // delayed ACK or next request arrives.
+          int one = 1;
+          (void)::setsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
 
         bool placed = false;
         for (auto& c : clients) {
           if (c.fd < 0) {
             c.fd = cfd;
             c.len = 0;
+            c.kind = listeners[l].kind;
+            c.unix_socket = unix_socket;
+            c.id = ++next_client_id_;
+            c.last_active_ms = now;
+            if (cfg_.idle_timeout_ms != 0) timers_.schedule(c.idle_timer, now + cfg_.idle_timeout_ms);
             placed = true;
             break;
           }
         }
         if (!placed) ::close(cfd);
+        span.set_arg(++accepted);
       }
     }
 
-    for (int i = 0; i < kMaxClients; ++i) {
-      Client& c = clients[i];
-      pollfd& p = pfds[i + 1];
+    // Service order rotates so a budget-limited pass does not always favour low slots.
+    const int first = first_client_;
+    first_client_ = (first_client_ + 1) % kMaxClients;
+    backlog = false;
+    for (int k = 0; k < kMaxClients; ++k) {
+      const int i = (first + k) % kMaxClients;
+      Connection& c = clients[i];
+      pollfd& p = pfds[kMaxListeners + i];
 
       if (c.fd < 0) continue;
       if (p.revents & (POLLHUP | POLLERR | POLLNVAL)) {
-        close_client(c);
+        close_client(c, timers_);
         continue;
       }
+      c.pass_commands = 0;
+      c.pass_bytes = 0;
+
+      if (p.revents & POLLOUT) {
+        if (!flush_output(c)) {
+          close_client(c, timers_);
+          continue;
+        }
+        // Writable again means the peer took bytes: a long drain or response is activity.
+        c.last_active_ms = now;
+        // Lines that arrived while we were blocked on output.
+        if (!c.has_pending_output()) process_input(c);
+      } else if (c.backlog && !c.has_pending_output()) {
+        // Carry-over from the previous pass, ahead of anything newly read.
+        process_input(c);
+      }
 
       if (p.revents & POLLIN) {
         // Read available data.
-        while (true) {
+        while (!c.closing && !c.close_after_output && !c.has_pending_output() && !c.backlog) {
+          std::size_t want = c.buf.size() - c.len;
+          if (cfg_.max_read_bytes_per_pass != 0) {
+            if (c.pass_bytes >= cfg_.max_read_bytes_per_pass) {
+              ++c.deferred;
+              break;
+            }
+            want = std::min<std::size_t>(want, cfg_.max_read_bytes_per_pass - c.pass_bytes);
+          }
           if (c.len >= c.buf.size()) {
-            (void)write_json_error(c.fd, "request too large");
-            close_client(c);
+            if (c.kind == ListenerKind::kHttp) {
+              (void)write_http_response(c, 431, "text/plain", "request too large\n", 18, false, false);
+            } else {
+              (void)write_json_error(c, "request too large");
+              c.closing = true;
+            }
             break;
           }
 
-          const ssize_t n = ::read(c.fd, c.buf.data() + c.len, c.buf.size() - c.len);
+          ssize_t n = 0;
+          {
+            trace::Span span("read");
+            n = ::read(c.fd, c.buf.data() + c.len, want);
+            span.set_arg(n > 0 ? static_cast<std::uint64_t>(n) : 0);
+          }
           if (n < 0) {
             if (errno == EAGAIN || errno == EWOULDBLOCK) break;
-            close_client(c);
+            c.closing = true;
             break;
           }
           if (n == 0) {
-            close_client(c);
+            c.closing = true;
             break;
           }
 
           c.len += static_cast<std::size_t>(n);
+          c.last_active_ms = now;
+          c.pass_bytes += static_cast<std::size_t>(n);
+          c.bytes_in += static_cast<std::uint64_t>(n);
+          process_input(c);
+        }
+      }
+
+      if (c.closing || (c.close_after_output && !c.has_pending_output())) {
+        close_client(c, timers_);
+        continue;
+      }
+      backlog = backlog || c.backlog;
+    }
+
+    // Samples taken while answering GETs.
+    push_updates(clients.data(), kMaxClients);
+  }
+}
 
-          // Process complete lines.
-          while (true) {
-            const void* nl = std::memchr(c.buf.data(), '\n', c.len);
-            if (!nl) break;
+void TcpServer::process_input(Connection& c) {
+  if (c.kind == ListenerKind::kHttp) {
+    process_http_input(c);
+    return;
+  }
 
-            const std::size_t line_len = static_cast<const char*>(nl) - c.buf.data();
-            std::string_view line(c.buf.data(), line_len);
-            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+  // Process complete lines; stop early if a response is backed up so replies stay ordered.
+  c.backlog = false;
+  while (!c.closing && !c.has_pending_output()) {
+    const void* nl = std::memchr(c.buf.data(), '\n', c.len);
+    if (!nl) break;
+    if (command_budget_spent(c)) break;
 
-            (void)handle_command(line, c.fd);
+    const std::size_t line_len = static_cast<const char*>(nl) - c.buf.data();
+    std::string_view line(c.buf.data(), line_len);
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
 
-            // Shift remaining bytes left.
-            const std::size_t remaining = c.len - (line_len + 1);
-            if (remaining > 0) std::memmove(c.buf.data(), c.buf.data() + line_len + 1, remaining);
-            c.len = remaining;
-          }
-        }
-      }
+    (void)handle_command(line, c);
+    ++c.pass_commands;
+    ++c.commands;
+
+    // Shift remaining bytes left.
+    const std::size_t remaining = c.len - (line_len + 1);
+    if (remaining > 0) std::memmove(c.buf.data(), c.buf.data() + line_len + 1, remaining);
+    c.len = remaining;
+  }
+}
+
+bool TcpServer::command_budget_spent(Connection& c) const {
+  if (cfg_.max_commands_per_pass == 0 || c.pass_commands < cfg_.max_commands_per_pass) return false;
+  c.backlog = true;
+  ++c.deferred;
+  return true;
+}
+
+void TcpServer::process_http_input(Connection& c) {
+  // Pipelined requests are answered in order; like line input, stop while output is backed up.
+  c.backlog = false;
+  while (!c.closing && !c.close_after_output && !c.has_pending_output() && c.len > 0) {
+    if (command_budget_spent(c)) break;
+    HttpRequest req{};
+    HttpParseResult r = HttpParseResult::kIncomplete;
+    {
+      trace::Span span("http_parse", c.len);
+      r = c.http.parse(std::string_view(c.buf.data(), c.len), req);
+    }
+    if (r == HttpParseResult::kIncomplete) break;
+    if (r == HttpParseResult::kError) {
+      const char* reason = http_reason(req.error_status);
+      (void)write_http_response(c, req.error_status, "text/plain", reason, std::strlen(reason), false, false);
+      break;
     }
+
+    (void)handle_http(c, req);
+    ++c.pass_commands;
+    ++c.commands;
+
+    c.http.reset();
+    const std::size_t remaining = c.len - req.length;
+    if (remaining > 0) std::memmove(c.buf.data(), c.buf.data() + req.length, remaining);
+    c.len = remaining;
   }
 }
 
-Status TcpServer::handle_command(std::string_view cmd, SocketHandle client_fd) {
-  const ParsedCommand pc = parse_command(cmd);
-  if (pc.type == CommandType::kPing) return write_json_ok(client_fd, "pong");
+Status TcpServer::handle_http(Connection& conn, const HttpRequest& req) {
+  const bool head_only = req.method == "HEAD";
+  if (req.method != "GET" && !head_only) {
+    const char* body = "method not allowed\n";
+    return write_http_response(conn, 405, "text/plain", body, std::strlen(body), req.keep_alive, head_only);
+  }
 
-  if (pc.type == CommandType::kGet) {
-    const std::uint64_t now = telemetry::util::unix_time_ms();
-    const std::uint32_t throttle = throttle_ms_.load(std::memory_order_relaxed);
-
-    if (last_collect_ms_ == 0 || now - last_collect_ms_ >= throttle) {
-      MetricsSnapshot snap{};
-      snap.ts_ms = now;
-      last_collect_status_ = collector_.collect(snap);
-      last_snapshot_ = snap;
-      last_collect_ms_ = now;
+  std::string_view path = req.target;
+  const std::size_t q = path.find('?');
+  if (q != std::string_view::npos) path = path.substr(0, q);
+  if (path != "/metrics") {
+    const char* body = "not found; try /metrics\n";
+    return write_http_response(conn, 404, "text/plain", body, std::strlen(body), req.keep_alive, head_only);
+  }
+
+  (void)refresh_snapshot(telemetry::util::monotonic_ms());
+  if (exposition_gen_ != snapshot_gen_ || exposition_.empty()) {
+    detail_families_.clear();
+    collector_.append_openmetrics(detail_families_);
+    const Status st = render_openmetrics(last_snapshot_, last_collect_status_, exposition_, detail_families_);
+    if (!st.ok()) {
+      const char* body = "render failed\n";
+      return write_http_response(conn, 500, "text/plain", body, std::strlen(body), false, head_only);
+    }
+    exposition_gen_ = snapshot_gen_;
+  }
+  return write_http_response(conn, 200, req.wants_openmetrics ? kOpenMetricsContentType : kPrometheusTextContentType,
+                             exposition_.data(), exposition_.size(), req.keep_alive, head_only);
+}
+
+Status TcpServer::write_http_response(Connection& conn, int status, const char* content_type, const char* body,
+                                      std::size_t body_len, bool keep_alive, bool head_only) {
+  char head[256];
+  const int n = std::snprintf(head, sizeof(head),
+                              "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %llu\r\nConnection: %s\r\n\r\n",
+                              status, http_reason(status), content_type, static_cast<unsigned long long>(body_len),
+                              keep_alive ? "keep-alive" : "close");
+  if (n <= 0 || static_cast<std::size_t>(n) >= sizeof(head)) return Status::Internal("response too large");
+  if (!keep_alive) conn.close_after_output = true;
+
+  // One write per response keeps head and body in a single segment.
+  response_buf_.assign(head, static_cast<std::size_t>(n));
+  if (!head_only) response_buf_.append(body, body_len);
+  return send_response(conn, response_buf_.data(), response_buf_.size());
+}
+
+bool TcpServer::refresh_snapshot(std::uint64_t now, bool force) {
+  const std::uint32_t throttle = throttle_ms_.load(std::memory_order_relaxed);
+  if (!force && last_collect_ms_ != 0 && now - last_collect_ms_ < throttle) return false;
+
+  MetricsSnapshot snap{};
+  snap.ts_ms = telemetry::util::unix_time_ms();
+  last_collect_status_ = collector_.collect(snap);
+  last_snapshot_ = snap;
+  last_collect_ms_ = now;
+  ++snapshot_gen_;
+  publish_snapshot(now);
+  return true;
+}
+
+void TcpServer::publish_snapshot(std::uint64_t now_ms) {
+  trace::Span span("publish");
+  if (spool_) {
+    const Status st = spool_->append(last_snapshot_, last_collect_status_, now_ms);
+    if (!st.ok() && !spool_error_logged_) {
+      std::fprintf(stderr, "telemetryd: spool append failed: %s\n", st.message ? st.message : "(none)");
     }
-    return write_json_metrics(client_fd, last_snapshot_, last_collect_status_);
+    spool_error_logged_ = !st.ok();
+  }
+  if (rules_) rules_->evaluate(last_snapshot_, now_ms);
+  for (metrics::SnapshotSink* sink : sinks_) sink->on_snapshot(last_snapshot_, last_collect_status_);
+}
+
+Status TcpServer::handle_command(std::string_view cmd, Connection& conn) {
+  const ParsedCommand pc = traced_parse(cmd);
+  trace::Span span("handle", static_cast<std::uint64_t>(pc.type));
+  if (pc.type == CommandType::kPing) return write_json_ok(conn, "pong");
+
+  if (pc.type == CommandType::kGet) {
+    (void)refresh_snapshot(telemetry::util::monotonic_ms());
+    return write_json_metrics(conn, last_snapshot_, last_collect_status_);
   }
 
   if (pc.type == CommandType::kRestart) {
     // Stub: in real embedded deployments you'd interface with systemd/init or a watchdog.
-    return write_json_ok(client_fd, "restart requested");
+    return write_json_ok(conn, "restart requested");
   }
 
   if (pc.type == CommandType::kThrottle) {
-    if (!pc.ok) return write_json_error(client_fd, pc.error ? pc.error : "invalid throttle");
+    if (!pc.ok) return write_json_error(conn, pc.error ? pc.error : "invalid throttle");
     throttle_ms_.store(pc.throttle_ms, std::memory_order_relaxed);
     cfg_.throttle_ms = pc.throttle_ms;
-    return write_json_ok(client_fd, "throttle set");
+    return write_json_ok(conn, "throttle set");
+  }
+
+  if (pc.type == CommandType::kDrain) {
+    if (!pc.ok) return write_json_error(conn, pc.error ? pc.error : "invalid drain");
+    return handle_drain(conn, pc.cursor);
   }
 
-  return write_json_error(client_fd, "unknown command");
+  if (pc.type == CommandType::kFleet) {
+    if (!pc.ok) return write_json_error(conn, pc.error ? pc.error : "invalid fleet query");
+    return handle_fleet(conn, pc);
+  }
+
+  if (pc.type == CommandType::kAlerts) return handle_alerts(conn);
+
+  if (pc.type == CommandType::kSubscribe) {
+    if (!pc.ok) return write_json_error(conn, pc.error ? pc.error : "invalid subscribe");
+    return handle_subscribe(conn, pc);
+  }
+
+  if (pc.type == CommandType::kUnsubscribe) {
+    conn.sub_group = -1;
+    return write_json_ok(conn, "unsubscribed");
+  }
+
+  if (pc.type == CommandType::kTrace) {
+    if (!pc.ok) return write_json_error(conn, pc.error ? pc.error : "invalid trace command");
+    return handle_trace(conn, pc);
+  }
+
+  if (pc.type == CommandType::kClients) return handle_clients(conn);
+  if (pc.type == CommandType::kDetail) return handle_detail(conn, pc);
+  if (pc.type == CommandType::kTop) return handle_top(conn, pc);
+
+  return write_json_error(conn, "unknown command");
 }
 
-Status TcpServer::write_json_metrics(SocketHandle client_fd, const telemetry::MetricsSnapshot& snap, Status collect_status) {
-  char out[512];
-  const std::uint32_t throttle = throttle_ms_.load(std::memory_order_relaxed);
-  const int n = std::snprintf(
-      out, sizeof(out),
-      "{\"ok\":%s,\"status_code\":%u,\"platform\":\"%s\",\"temperature_best_effort\":%s,\"ts_ms\":%llu,\"cpu_usage_pct\":%.2f,"
-      "\"mem_total_kb\":%llu,\"mem_available_kb\":%llu,\"temperature_c\":%.2f,"
-      "\"uptime_s\":%llu,\"throttle_ms\":%u}\n",
-      collect_status.ok() ? "true" : "false", static_cast<unsigned>(collect_status.code),
-      telemetry::platform_name(),
-      telemetry::temperature_best_effort_supported() ? "true" : "false",
-      static_cast<unsigned long long>(snap.ts_ms), snap.cpu_usage_pct,
-      static_cast<unsigned long long>(snap.mem_total_kb), static_cast<unsigned long long>(snap.mem_available_kb),
-      snap.temperature_c, static_cast<unsigned long long>(snap.uptime_s), static_cast<unsigned>(throttle));
+Status TcpServer::handle_fleet(Connection& conn, const ParsedCommand& pc) {
+  if (!fleet_) return write_json_error(conn, "aggregator disabled");
+
+  switch (pc.fleet_query) {
+    case FleetQuery::kAll:
+      fleet_->all(fleet_rows_);
+      break;
+    case FleetQuery::kTopCpu:
+      fleet_->top_cpu(pc.count, fleet_rows_);
+      break;
+    case FleetQuery::kOverCpu:
+      fleet_->over_cpu(pc.threshold, fleet_rows_);
+      break;
+  }
+
+  const std::uint64_t now = telemetry::util::unix_time_ms();
+  char row[384];
+  response_buf_.clear();
+  int n = std::snprintf(row, sizeof(row), "{\"ok\":true,\"hosts_total\":%llu,\"hosts_up\":%llu,\"hosts\":[",
+                        static_cast<unsigned long long>(fleet_->size()),
+                        static_cast<unsigned long long>(fleet_->up_count()));
+  if (n <= 0 || static_cast<std::size_t>(n) >= sizeof(row)) return Status::Internal("response too large");
+  response_buf_.append(row, static_cast<std::size_t>(n));
 
+  for (std::size_t i = 0; i < fleet_rows_.size(); ++i) {
+    const fleet::FleetHost& h = fleet_rows_[i];
+    const MetricsSnapshot& s = h.snap;
+    n = std::snprintf(row, sizeof(row),
+                      "%s{\"host\":\"%s\",\"up\":%s,\"age_ms\":%lld,\"status_code\":%u,\"reconnects\":%u,"
+                      "\"cpu_usage_pct\":%.2f,\"mem_total_kb\":%llu,\"mem_available_kb\":%llu,"
+                      "\"temperature_c\":%.2f,\"uptime_s\":%llu}",
+                      i == 0 ? "" : ",", h.name, h.up ? "true" : "false",
+                      h.has_snapshot ? static_cast<long long>(now - h.last_update_ms) : -1LL,
+                      static_cast<unsigned>(h.status_code), static_cast<unsigned>(h.reconnects), s.cpu_usage_pct,
+                      static_cast<unsigned long long>(s.mem_total_kb),
+                      static_cast<unsigned long long>(s.mem_available_kb), s.temperature_c,
+                      static_cast<unsigned long long>(s.uptime_s));
+    if (n <= 0 || static_cast<std::size_t>(n) >= sizeof(row)) return Status::Internal("response too large");
+    response_buf_.append(row, static_cast<std::size_t>(n));
+  }
+  response_buf_.append("]}\n");
+  return send_response(conn, response_buf_.data(), response_buf_.size());
+}
+
+Status TcpServer::handle_alerts(Connection& conn) {
+  if (!rules_) return write_json_error(conn, "rules disabled");
+
+  char out[128];
+  const int n = std::snprintf(out, sizeof(out), "{\"ok\":true,\"message\":\"subscribed\",\"rules\":%llu,\"firing\":%llu}\n",
+                              static_cast<unsigned long long>(rules_->size()),
+                              static_cast<unsigned long long>(rules_->firing_count()));
   if (n <= 0 || static_cast<std::size_t>(n) >= sizeof(out)) return Status::Internal("response too large");
-  const ssize_t w = ::write(static_cast<int>(client_fd), out, static_cast<std::size_t>(n));
-  if (w < 0) return Status::IoError("write() failed");
+  Status st = send_response(conn, out, static_cast<std::size_t>(n));
+  conn.alerts = true;
+
+  // Replay what is already firing so a subscriber starts from the current state.
+  alert_scratch_.clear();
+  rules_->firing(alert_scratch_);
+  for (const rules::AlertEvent& ev : alert_scratch_) {
+    if (!st.ok()) break;
+    st = write_alert_event(conn, ev);
+  }
+  return st;
+}
+
+Status TcpServer::handle_subscribe(Connection& conn, const ParsedCommand& pc) {
+  codec::DeadbandConfig cfg{};
+  cfg.abs = pc.deadband_abs;
+  cfg.rel = pc.deadband_rel;
+  cfg.keyframe_every = pc.keyframe_every;
+
+  int group = -1;
+  int free_slot = -1;
+  for (std::size_t g = 0; g < sub_groups_.size(); ++g) {
+    if (sub_groups_[g].active && sub_groups_[g].stream.config() == cfg) {
+      group = static_cast<int>(g);
+      break;
+    }
+    if (!sub_groups_[g].active && free_slot < 0) free_slot = static_cast<int>(g);
+  }
+
+  bool fresh = false;
+  if (group < 0) {
+    if (free_slot < 0) {
+      // Empty groups are reclaimed once per loop pass, so this only trips on a burst of
+      // resubscribes with distinct settings.
+      if (sub_groups_.size() >= static_cast<std::size_t>(kMaxClients)) {
+        return write_json_error(conn, "too many subscription groups");
+      }
+      free_slot = static_cast<int>(sub_groups_.size());
+      sub_groups_.push_back(SubscriptionGroup{codec::DeltaStream(cfg), false});
+    } else {
+      sub_groups_[static_cast<std::size_t>(free_slot)] = SubscriptionGroup{codec::DeltaStream(cfg), false};
+    }
+    group = free_slot;
+    sub_groups_[static_cast<std::size_t>(group)].active = true;
+    ++active_groups_;
+    fresh = true;
+  }
+  conn.sub_group = group;
+
+  Status st = write_json_ok(conn, "subscribed");
+  if (!st.ok()) return st;
+
+  // Start the subscriber from the group's reference state (a new group seeds it from the
+  // latest snapshot), so later deltas apply to the same values every member holds.
+  codec::DeltaStream& stream = sub_groups_[static_cast<std::size_t>(group)].stream;
+  const bool have_line = fresh ? (last_collect_ms_ != 0 && stream.update(last_snapshot_, last_collect_status_, stream_line_))
+                               : stream.keyframe(stream_line_);
+  if (!have_line) return Status::Ok();
+  return send_response(conn, stream_line_.data(), stream_line_.size());
+}
+
+void TcpServer::push_updates(Connection* clients, int count) {
+  trace::Span span("push");
+  push_alerts(clients, count);
+  push_subscriptions(clients, count);
+}
+
+void TcpServer::push_subscriptions(Connection* clients, int count) {
+  if (active_groups_ == 0) return;
+
+  group_members_.assign(sub_groups_.size(), 0);
+  for (int i = 0; i < count; ++i) {
+    if (clients[i].fd >= 0 && clients[i].sub_group >= 0) ++group_members_[static_cast<std::size_t>(clients[i].sub_group)];
+  }
+  for (std::size_t g = 0; g < sub_groups_.size(); ++g) {
+    if (sub_groups_[g].active && group_members_[g] == 0) {
+      sub_groups_[g].active = false;
+      --active_groups_;
+    }
+  }
+
+  if (streamed_gen_ == snapshot_gen_) return;
+  streamed_gen_ = snapshot_gen_;
+  for (std::size_t g = 0; g < sub_groups_.size(); ++g) {
+    if (!sub_groups_[g].active) continue;
+    if (!sub_groups_[g].stream.update(last_snapshot_, last_collect_status_, stream_line_)) continue;
+    for (int i = 0; i < count; ++i) {
+      Connection& c = clients[i];
+      if (c.fd < 0 || c.closing || c.sub_group != static_cast<int>(g)) continue;
+      (void)send_response(c, stream_line_.data(), stream_line_.size());
+    }
+  }
+}
+
+void TcpServer::push_alerts(Connection* clients, int count) {
+  if (!rules_ || rules_->events().empty()) return;
+  for (int i = 0; i < count; ++i) {
+    Connection& c = clients[i];
+    if (c.fd < 0 || !c.alerts || c.closing) continue;
+    for (const rules::AlertEvent& ev : rules_->events()) {
+      if (!write_alert_event(c, ev).ok()) break;
+    }
+  }
+  rules_->clear_events();
+}
+
+Status TcpServer::write_alert_event(Connection& conn, const rules::AlertEvent& ev) {
+  char out[256];
+  const int n = std::snprintf(out, sizeof(out),
+                              "{\"event\":\"alert\",\"rule\":\"%s\",\"state\":\"%s\",\"value\":%.6g,\"threshold\":%.6g,"
+                              "\"ts_ms\":%llu}\n",
+                              rules_->rule_name(ev.rule), ev.firing ? "firing" : "resolved", ev.value, ev.threshold,
+                              static_cast<unsigned long long>(ev.ts_ms));
+  if (n <= 0 || static_cast<std::size_t>(n) >= sizeof(out)) return Status::Internal("response too large");
+  return send_response(conn, out, static_cast<std::size_t>(n));
+}
+
+Status TcpServer::handle_drain(Connection& conn, std::uint64_t cursor) {
+  if (!spool_) return write_json_error(conn, "spool disabled");
+
+  storage::DrainRange r{};
+  const Status st = spool_->drain_range(cursor, r);
+  if (!st.ok()) return write_json_error(conn, st.message ? st.message : "drain failed");
+
+  // Header line, then exactly `bytes` raw spool records. Clients continue from `next`
+  // until `bytes` is 0.
+  char out[256];
+  const int n = std::snprintf(out, sizeof(out),
+                              "{\"ok\":true,\"from\":%llu,\"next\":%llu,\"bytes\":%llu,\"head\":%llu,\"tail\":%llu}\n",
+                              static_cast<unsigned long long>(r.from_cursor),
+                              static_cast<unsigned long long>(r.next_cursor),
+                              static_cast<unsigned long long>(r.length),
+                              static_cast<unsigned long long>(spool_->head_cursor()),
+                              static_cast<unsigned long long>(spool_->tail_cursor()));
+  if (n <= 0 || static_cast<std::size_t>(n) >= sizeof(out)) {
+    if (r.fd >= 0) ::close(r.fd);
+    return Status::Internal("response too large");
+  }
+
+  const Status wst = send_response(conn, out, static_cast<std::size_t>(n));
+  if (!wst.ok() || r.length == 0) {
+    if (r.fd >= 0) ::close(r.fd);
+    return wst;
+  }
+
+  conn.drain_fd = r.fd;
+  conn.drain_off = r.file_offset;
+  conn.drain_left = r.length;
+  if (!flush_output(conn)) {
+    conn.closing = true;
+    return Status::IoError("sendfile() failed");
+  }
   return Status::Ok();
 }
 
-Status TcpServer::write_json_ok(SocketHandle client_fd, const char* msg) {
+Status TcpServer::handle_trace(Connection& conn, const ParsedCommand& pc) {
+  switch (pc.trace_op) {
+    case TraceOp::kOn:
+      trace::set_enabled(true);
+      return write_json_ok(conn, "tracing on");
+    case TraceOp::kOff:
+      trace::set_enabled(false);
+      return write_json_ok(conn, "tracing off");
+    case TraceOp::kClear:
+      trace::clear();
+      return write_json_ok(conn, "trace cleared");
+    case TraceOp::kDump:
+      break;
+  }
+
+  // Header line, then exactly `bytes` of Chrome trace JSON (as DRAIN frames spool records).
+  const std::size_t events = trace::write_chrome_json(trace_json_);
+  char head[160];
+  const int n = std::snprintf(head, sizeof(head), "{\"ok\":true,\"enabled\":%s,\"events\":%llu,\"bytes\":%llu}\n",
+                              trace::enabled() ? "true" : "false", static_cast<unsigned long long>(events),
+                              static_cast<unsigned long long>(trace_json_.size()));
+  if (n <= 0 || static_cast<std::size_t>(n) >= sizeof(head)) return Status::Internal("response too large");
+  response_buf_.assign(head, static_cast<std::size_t>(n));
+  response_buf_.append(trace_json_);
+  return send_response(conn, response_buf_.data(), response_buf_.size());
+}
+
+Status TcpServer::handle_clients(Connection& conn) {
+  char buf[256];
+  int n = std::snprintf(buf, sizeof(buf), "{\"ok\":true,\"max_commands_per_pass\":%u,\"max_read_bytes_per_pass\":%u,\"clients\":[",
+                        static_cast<unsigned>(cfg_.max_commands_per_pass),
+                        static_cast<unsigned>(cfg_.max_read_bytes_per_pass));
+  if (n <= 0 || static_cast<std::size_t>(n) >= sizeof(buf)) return Status::Internal("response too large");
+  response_buf_.assign(buf, static_cast<std::size_t>(n));
+  bool first = true;
+  for (int i = 0; i < kMaxClients; ++i) {
+    const Connection& c = clients_[i];
+    if (c.fd < 0) continue;
+    n = std::snprintf(buf, sizeof(buf),
+                      "%s{\"id\":%llu,\"kind\":\"%s\",\"transport\":\"%s\",\"self\":%s,\"commands\":%llu,\"bytes_in\":%llu,"
+                      "\"bytes_out\":%llu,\"deferred\":%llu}",
+                      first ? "" : ",", static_cast<unsigned long long>(c.id),
+                      c.kind == ListenerKind::kHttp ? "http" : "line", c.unix_socket ? "unix" : "tcp", &c == &conn ? "true" : "false",
+                      static_cast<unsigned long long>(c.commands), static_cast<unsigned long long>(c.bytes_in),
+                      static_cast<unsigned long long>(c.bytes_out), static_cast<unsigned long long>(c.deferred));
+    if (n <= 0 || static_cast<std::size_t>(n) >= sizeof(buf)) return Status::Internal("response too large");
+    response_buf_.append(buf, static_cast<std::size_t>(n));
+    first = false;
+  }
+  response_buf_.append("]}\n");
+  return send_response(conn, response_buf_.data(), response_buf_.size());
+}
+
+Status TcpServer::handle_detail(Connection& conn, const ParsedCommand& pc) {
+  if (!pc.ok) return write_json_error(conn, pc.error ? pc.error : "invalid detail");
+  (void)refresh_snapshot(telemetry::util::monotonic_ms());
+  char head[96];
+  const int n = std::snprintf(head, sizeof(head), "{\"ok\":true,\"ts_ms\":%llu,\"detail\":{",
+                              static_cast<unsigned long long>(last_snapshot_.ts_ms));
+  if (n <= 0 || static_cast<std::size_t>(n) >= sizeof(head)) return Status::Internal("response too large");
+  response_buf_.assign(head, static_cast<std::size_t>(n));
+  if (collector_.append_detail_json(response_buf_, pc.source) == 0 && !pc.source.empty()) {
+    return write_json_error(conn, "no detail for source");
+  }
+  response_buf_.append("}}\n");
+  return send_response(conn, response_buf_.data(), response_buf_.size());
+}
+
+Status TcpServer::handle_top(Connection& conn, const ParsedCommand& pc) {
+  if (!pc.ok) return write_json_error(conn, pc.error ? pc.error : "invalid top");
+  if (!processes_) return write_json_error(conn, "top disabled");
+  (void)refresh_snapshot(telemetry::util::monotonic_ms());
+
+  const std::vector<metrics::ProcessSample>& top = processes_->top();
+  const std::size_t rows = std::min<std::size_t>(pc.count, top.size());
+  char row[192];
+  int n = std::snprintf(row, sizeof(row), "{\"ok\":true,\"ts_ms\":%llu,\"processes\":%llu,\"top\":[",
+                        static_cast<unsigned long long>(last_snapshot_.ts_ms),
+                        static_cast<unsigned long long>(processes_->processes()));
+  if (n <= 0 || static_cast<std::size_t>(n) >= sizeof(row)) return Status::Internal("response too large");
+  response_buf_.assign(row, static_cast<std::size_t>(n));
+  for (std::size_t i = 0; i < rows; ++i) {
+    const metrics::ProcessSample& s = top[i];
+    n = std::snprintf(row, sizeof(row), "%s{\"pid\":%d,\"comm\":\"%s\",\"cpu_pct\":%.2f,\"rss_bytes\":%llu}",
+                      i == 0 ? "" : ",", static_cast<int>(s.pid), s.comm, s.cpu_pct,
+                      static_cast<unsigned long long>(s.rss_bytes));
+    if (n <= 0 || static_cast<std::size_t>(n) >= sizeof(row)) return Status::Internal("response too large");
+    response_buf_.append(row, static_cast<std::size_t>(n));
+  }
+  response_buf_.append("]}\n");
+  return send_response(conn, response_buf_.data(), response_buf_.size());
+}
+
+Status TcpServer::send_response(Connection& conn, const char* data, std::size_t len) {
+  trace::Span span("write", len);
+  conn.bytes_out += len;
+  std::size_t sent = 0;
+  if (!conn.has_pending_output()) {
+    while (sent < len) {
+      const ssize_t w = ::write(conn.fd, data + sent, len - sent);
+      if (w < 0) {
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        conn.closing = true;
+        return Status::IoError("write() failed");
+      }
+      sent += static_cast<std::size_t>(w);
+    }
+    if (sent == len) return Status::Ok();
+  }
+
+  if (conn.out.size() - conn.out_off + (len - sent) > kMaxPendingOut) {
+    conn.closing = true;
+    return Status::IoError("client output backlog too large");
+  }
+  conn.out.insert(conn.out.end(), data + sent, data + len);
+  return Status::Ok();
+}
+
+Status TcpServer::write_json_metrics(Connection& conn, const telemetry::MetricsSnapshot& snap, Status collect_status) {
+  char out[512];
+  const std::size_t n =
+      format_metrics_json(out, sizeof(out), snap, collect_status, throttle_ms_.load(std::memory_order_relaxed));
+  if (n == 0) return Status::Internal("response too large");
+  return send_response(conn, out, n);
+}
+
+Status TcpServer::write_json_ok(Connection& conn, const char* msg) {
   char out[256];
   const int n = std::snprintf(out, sizeof(out), "{\"ok\":true,\"message\":\"%s\"}\n", msg ? msg : "");
   if (n <= 0 || static_cast<std::size_t>(n) >= sizeof(out)) return Status::Internal("response too large");
-  const ssize_t w = ::write(static_cast<int>(client_fd), out, static_cast<std::size_t>(n));
-  if (w < 0) return Status::IoError("write() failed");
-  return Status::Ok();
+  return send_response(conn, out, static_cast<std::size_t>(n));
 }
 
-Status TcpServer::write_json_error(SocketHandle client_fd, const char* msg) {
+Status TcpServer::write_json_error(Connection& conn, const char* msg) {
   char out[256];
   const int n = std::snprintf(out, sizeof(out), "{\"ok\":false,\"error\":\"%s\"}\n", msg ? msg : "error");
   if (n <= 0 || static_cast<std::size_t>(n) >= sizeof(out)) return Status::Internal("response too large");
-  const ssize_t w = ::write(static_cast<int>(client_fd), out, static_cast<std::size_t>(n));
-  if (w < 0) return Status::IoError("write() failed");
-  return Status::Ok();
+  return send_response(conn, out, static_cast<std::size_t>(n));
 }
 
 }  // namespace telemetry::net
 
 #endif  // !_WIN32
-
@@ -13,7 +13,6 @@
 #include <string_view>
 
 #include "telemetry/net/protocol.h"
-#include "telemetry/platform.h"
 #include "telemetry/util/time.h"
 
 #pragma comment(lib, "Ws2_32.lib")
@@ -25,13 +24,17 @@ namespace {
 constexpr int kMaxClients = 64;
 constexpr std::size_t kBufSize = 1024;
 
-struct Client final {
+}  // namespace
+
+struct Connection final {
   SOCKET s{INVALID_SOCKET};
   std::array<char, kBufSize> buf{};
   std::size_t len{0};
 };
 
-static void close_client(Client& c) {
+namespace {
+
+static void close_client(Connection& c) {
   if (c.s != INVALID_SOCKET) closesocket(c.s);
   c.s = INVALID_SOCKET;
   c.len = 0;
@@ -42,16 +45,21 @@ static bool set_nonblocking(SOCKET s) {
   return ioctlsocket(s, FIONBIO, &mode) == 0;
 }
 
-static SocketHandle to_handle(SOCKET s) { return static_cast<SocketHandle>(s); }
-static SOCKET to_socket(SocketHandle h) { return static_cast<SOCKET>(h); }
 
 }  // namespace
 
-TcpServer::TcpServer(metrics::Collector& collector, TcpServerConfig cfg)
+TcpServer::TcpServer(metrics::SnapshotCollector& collector, TcpServerConfig cfg)
     : collector_(collector), cfg_(cfg), throttle_ms_(cfg.throttle_ms) {}
 
+TcpServer::~TcpServer() = default;
+
+// No wake pipe here: the loop below polls with a fixed timeout and sees the flag within it.
+void TcpServer::stop() { stop_.store(true, std::memory_order_relaxed); }
+
 Status TcpServer::run_forever() {
-  const std::uint64_t start_ms = telemetry::util::unix_time_ms();
+  const std::uint64_t start_ms = telemetry::util::monotonic_ms();
+  if (cfg_.metrics_port != 0) return Status::InvalidArgument("metrics listener unsupported on windows");
+  if (cfg_.unix_path != nullptr) return Status::InvalidArgument("unix socket listener unsupported on windows");
 
   WSADATA wsa{};
   if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return Status::IoError("WSAStartup failed");
@@ -88,19 +96,20 @@ Status TcpServer::run_forever() {
 
   (void)set_nonblocking(listen_s);
 
-  std::array<Client, kMaxClients> clients{};
+  std::array<Connection, kMaxClients> clients{};
 
   while (true) {
-    if (cfg_.run_for_ms != 0) {
-      const std::uint64_t now = telemetry::util::unix_time_ms();
-      if (now - start_ms >= cfg_.run_for_ms) {
-        closesocket(listen_s);
-        for (auto& c : clients) close_client(c);
-        WSACleanup();
-        return Status::Ok();
-      }
+    const std::uint64_t now = telemetry::util::monotonic_ms();
+    if (stop_.load(std::memory_order_relaxed) || (cfg_.run_for_ms != 0 && now - start_ms >= cfg_.run_for_ms)) {
+      closesocket(listen_s);
+      for (auto& c : clients) close_client(c);
+      WSACleanup();
+      return Status::Ok();
     }
 
+    // Sinks are fed at poll granularity here; the POSIX loop wakes exactly on schedule.
+    if (background_sampling()) (void)refresh_snapshot(telemetry::util::monotonic_ms());
+
     std::array<WSAPOLLFD, kMaxClients + 1> pfds{};
     pfds[0].fd = listen_s;
     pfds[0].events = POLLRDNORM;
@@ -118,6 +127,8 @@ Status TcpServer::run_forever() {
         SOCKET cs = accept(listen_s, nullptr, nullptr);
         if (cs == INVALID_SOCKET) break;
         (void)set_nonblocking(cs);
+        BOOL nodelay = TRUE;
+        (void)setsockopt(cs, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&nodelay), sizeof(nodelay));
 
         bool placed = false;
         for (auto& c : clients) {
@@ -133,7 +144,7 @@ Status TcpServer::run_forever() {
     }
 
     for (int i = 0; i < kMaxClients; ++i) {
-      Client& c = clients[i];
+      Connection& c = clients[i];
       WSAPOLLFD& p = pfds[i + 1];
       if (c.s == INVALID_SOCKET) continue;
       if (p.revents & (POLLERR | POLLHUP | POLLNVAL)) {
@@ -143,7 +154,7 @@ Status TcpServer::run_forever() {
       if (p.revents & POLLRDNORM) {
         while (true) {
           if (c.len >= c.buf.size()) {
-            (void)write_json_error(to_handle(c.s), "request too large");
+            (void)write_json_error(c, "request too large");
             close_client(c);
             break;
           }
@@ -159,95 +170,154 @@ Status TcpServer::run_forever() {
             break;
           }
           c.len += static_cast<std::size_t>(n);
-
-          while (true) {
-            const void* nl = std::memchr(c.buf.data(), '\n', c.len);
-            if (!nl) break;
-            const std::size_t line_len = static_cast<const char*>(nl) - c.buf.data();
-            std::string_view line(c.buf.data(), line_len);
-            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
-
-            (void)handle_command(line, to_handle(c.s));
-
-            const std::size_t remaining = c.len - (line_len + 1);
-            if (remaining > 0) std::memmove(c.buf.data(), c.buf.data() + line_len + 1, remaining);
-            c.len = remaining;
-          }
+          process_input(c);
         }
       }
     }
   }
 }
 
-Status TcpServer::handle_command(std::string_view cmd, SocketHandle client_fd) {
+void TcpServer::process_input(Connection& c) {
+  while (true) {
+    const void* nl = std::memchr(c.buf.data(), '\n', c.len);
+    if (!nl) break;
+    const std::size_t line_len = static_cast<const char*>(nl) - c.buf.data();
+    std::string_view line(c.buf.data(), line_len);
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+    (void)handle_command(line, c);
+
+    const std::size_t remaining = c.len - (line_len + 1);
+    if (remaining > 0) std::memmove(c.buf.data(), c.buf.data() + line_len + 1, remaining);
+    c.len = remaining;
+  }
+}
+
+bool TcpServer::refresh_snapshot(std::uint64_t now, bool force) {
+  const std::uint32_t throttle = throttle_ms_.load(std::memory_order_relaxed);
+  if (!force && last_collect_ms_ != 0 && now - last_collect_ms_ < throttle) return false;
+
+  MetricsSnapshot snap{};
+  snap.ts_ms = telemetry::util::unix_time_ms();
+  last_collect_status_ = collector_.collect(snap);
+  last_snapshot_ = snap;
+  last_collect_ms_ = now;
+  ++snapshot_gen_;
+  publish_snapshot(snap.ts_ms);
+  return true;
+}
+
+// The store-and-forward spool is POSIX-only; only sinks are fed here.
+void TcpServer::publish_snapshot(std::uint64_t) {
+  for (metrics::SnapshotSink* sink : sinks_) sink->on_snapshot(last_snapshot_, last_collect_status_);
+}
+
+Status TcpServer::handle_command(std::string_view cmd, Connection& conn) {
   const ParsedCommand pc = parse_command(cmd);
-  if (pc.type == CommandType::kPing) return write_json_ok(client_fd, "pong");
+  if (pc.type == CommandType::kPing) return write_json_ok(conn, "pong");
 
   if (pc.type == CommandType::kGet) {
-    const std::uint64_t now = telemetry::util::unix_time_ms();
-    const std::uint32_t throttle = throttle_ms_.load(std::memory_order_relaxed);
-
-    if (last_collect_ms_ == 0 || now - last_collect_ms_ >= throttle) {
-      MetricsSnapshot snap{};
-      snap.ts_ms = now;
-      last_collect_status_ = collector_.collect(snap);
-      last_snapshot_ = snap;
-      last_collect_ms_ = now;
-    }
-    return write_json_metrics(client_fd, last_snapshot_, last_collect_status_);
+    (void)refresh_snapshot(telemetry::util::monotonic_ms());
+    return write_json_metrics(conn, last_snapshot_, last_collect_status_);
   }
 
-  if (pc.type == CommandType::kRestart) return write_json_ok(client_fd, "restart requested");
+  if (pc.type == CommandType::kRestart) return write_json_ok(conn, "restart requested");
 
   if (pc.type == CommandType::kThrottle) {
-    if (!pc.ok) return write_json_error(client_fd, pc.error ? pc.error : "invalid throttle");
+    if (!pc.ok) return write_json_error(conn, pc.error ? pc.error : "invalid throttle");
     throttle_ms_.store(pc.throttle_ms, std::memory_order_relaxed);
     cfg_.throttle_ms = pc.throttle_ms;
-    return write_json_ok(client_fd, "throttle set");
+    return write_json_ok(conn, "throttle set");
+  }
+
+  if (pc.type == CommandType::kDrain) {
+    if (!pc.ok) return write_json_error(conn, pc.error ? pc.error : "invalid drain");
+    return handle_drain(conn, pc.cursor);
+  }
+  if (pc.type == CommandType::kFleet) return handle_fleet(conn, pc);
+  if (pc.type == CommandType::kAlerts) return handle_alerts(conn);
+  if (pc.type == CommandType::kSubscribe || pc.type == CommandType::kUnsubscribe) return handle_subscribe(conn, pc);
+  if (pc.type == CommandType::kTrace) return handle_trace(conn, pc);
+  if (pc.type == CommandType::kClients) return handle_clients(conn);
+  if (pc.type == CommandType::kDetail) return handle_detail(conn, pc);
+  if (pc.type == CommandType::kTop) return handle_top(conn, pc);
+
+  return write_json_error(conn, "unknown command");
+}
+
+Status TcpServer::handle_drain(Connection& conn, std::uint64_t) {
+  return write_json_error(conn, "spool unsupported on windows");
+}
+
+Status TcpServer::handle_fleet(Connection& conn, const ParsedCommand&) {
+  return write_json_error(conn, "aggregator unsupported on windows");
+}
+
+Status TcpServer::handle_alerts(Connection& conn) {
+  return write_json_error(conn, "rules unsupported on windows");
+}
+
+Status TcpServer::handle_subscribe(Connection& conn, const ParsedCommand&) {
+  return write_json_error(conn, "subscribe unsupported on windows");
+}
+
+Status TcpServer::handle_trace(Connection& conn, const ParsedCommand&) {
+  return write_json_error(conn, "trace unsupported on windows");
+}
+
+Status TcpServer::handle_clients(Connection& conn) {
+  return write_json_error(conn, "clients unsupported on windows");
+}
+
+Status TcpServer::handle_detail(Connection& conn, const ParsedCommand& pc) {
+  if (!pc.ok) return write_json_error(conn, pc.error ? pc.error : "invalid detail");
+  (void)refresh_snapshot(telemetry::util::monotonic_ms());
+  char head[96];
+  const int n = std::snprintf(head, sizeof(head), "{\"ok\":true,\"ts_ms\":%llu,\"detail\":{",
+                              static_cast<unsigned long long>(last_snapshot_.ts_ms));
+  if (n <= 0 || static_cast<std::size_t>(n) >= sizeof(head)) return Status::Internal("response too large");
+  response_buf_.assign(head, static_cast<std::size_t>(n));
+  if (collector_.append_detail_json(response_buf_, pc.source) == 0 && !pc.source.empty()) {
+    return write_json_error(conn, "no detail for source");
   }
+  response_buf_.append("}}\n");
+  return send_response(conn, response_buf_.data(), response_buf_.size());
+}
 
-  return write_json_error(client_fd, "unknown command");
+Status TcpServer::handle_top(Connection& conn, const ParsedCommand&) {
+  return write_json_error(conn, "top unsupported on windows");
 }
 
-static Status send_all(SOCKET s, const char* data, int len) {
-  int sent = 0;
+Status TcpServer::send_response(Connection& conn, const char* data, std::size_t len) {
+  std::size_t sent = 0;
   while (sent < len) {
-    const int n = send(s, data + sent, len - sent, 0);
+    const int n = send(conn.s, data + sent, static_cast<int>(len - sent), 0);
     if (n <= 0) return Status::IoError("send() failed");
-    sent += n;
+    sent += static_cast<std::size_t>(n);
   }
   return Status::Ok();
 }
 
-Status TcpServer::write_json_metrics(SocketHandle client_fd, const telemetry::MetricsSnapshot& snap, Status collect_status) {
+Status TcpServer::write_json_metrics(Connection& conn, const telemetry::MetricsSnapshot& snap, Status collect_status) {
   char out[512];
-  const std::uint32_t throttle = throttle_ms_.load(std::memory_order_relaxed);
-  const int n = std::snprintf(
-      out, sizeof(out),
-      "{\"ok\":%s,\"status_code\":%u,\"platform\":\"%s\",\"temperature_best_effort\":%s,\"ts_ms\":%llu,\"cpu_usage_pct\":%.2f,"
-      "\"mem_total_kb\":%llu,\"mem_available_kb\":%llu,\"temperature_c\":%.2f,"
-      "\"uptime_s\":%llu,\"throttle_ms\":%u}\n",
-      collect_status.ok() ? "true" : "false", static_cast<unsigned>(collect_status.code),
-      telemetry::platform_name(), telemetry::temperature_best_effort_supported() ? "true" : "false",
-      static_cast<unsigned long long>(snap.ts_ms), snap.cpu_usage_pct,
-      static_cast<unsigned long long>(snap.mem_total_kb), static_cast<unsigned long long>(snap.mem_available_kb),
-      snap.temperature_c, static_cast<unsigned long long>(snap.uptime_s), static_cast<unsigned>(throttle));
-  if (n <= 0 || n >= static_cast<int>(sizeof(out))) return Status::Internal("response too large");
-  return send_all(to_socket(client_fd), out, n);
+  const std::size_t n =
+      format_metrics_json(out, sizeof(out), snap, collect_status, throttle_ms_.load(std::memory_order_relaxed));
+  if (n == 0) return Status::Internal("response too large");
+  return send_response(conn, out, n);
 }
 
-Status TcpServer::write_json_ok(SocketHandle client_fd, const char* msg) {
+Status TcpServer::write_json_ok(Connection& conn, const char* msg) {
   char out[256];
   const int n = std::snprintf(out, sizeof(out), "{\"ok\":true,\"message\":\"%s\"}\n", msg ? msg : "");
   if (n <= 0 || n >= static_cast<int>(sizeof(out))) return Status::Internal("response too large");
-  return send_all(to_socket(client_fd), out, n);
+  return send_response(conn, out, static_cast<std::size_t>(n));
 }
 
-Status TcpServer::write_json_error(SocketHandle client_fd, const char* msg) {
+Status TcpServer::write_json_error(Connection& conn, const char* msg) {
   char out[256];
   const int n = std::snprintf(out, sizeof(out), "{\"ok\":false,\"error\":\"%s\"}\n", msg ? msg : "error");
   if (n <= 0 || n >= static_cast<int>(sizeof(out))) return Status::Internal("response too large");
-  return send_all(to_socket(client_fd), out, n);
+  return send_response(conn, out, static_cast<std::size_t>(n));
 }
 
 }  // namespace telemetry::net
@@ -0,0 +1,401 @@
+#include "telemetry/rules/rule_engine.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace telemetry::rules {
+
+namespace {
+
+enum Op : std::uint8_t {
+  kOpConst = 0,
+  kOpLoad,
+  kOpAdd,
+  kOpSub,
+  kOpMul,
+  kOpDiv,
+  kOpNeg,
+};
+
+enum MetricId : std::uint8_t {
+  kCpuUsagePct = 0,
+  kMemTotalKb,
+  kMemAvailableKb,
+  kTemperatureC,
+  kUptimeS,
+  kMetricCount,
+};
+
+constexpr const char* kMetricNames[kMetricCount] = {
+    "cpu_usage_pct", "mem_total_kb", "mem_available_kb", "temperature_c", "uptime_s",
+};
+
+// Evaluation uses a fixed on-stack operand stack; deeper expressions are rejected at compile time.
+constexpr int kMaxStack = 16;
+
+static bool is_ident_start(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; }
+static bool is_ident_char(char c) { return is_ident_start(c) || (c >= '0' && c <= '9'); }
+static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+}  // namespace
+
+// Recursive-descent compiler from rule text to postfix bytecode appended to code_.
+class RuleEngine::Parser final {
+ public:
+  Parser(std::string_view text, std::vector<Instr>& code) : s_(text), code_(code) {}
+
+  Status rule(Rule& r) {
+    skip_ws();
+    const std::size_t colon = s_.find(':', pos_);
+    if (colon != std::string_view::npos) {
+      std::string_view name = s_.substr(pos_, colon - pos_);
+      while (!name.empty() && (name.back() == ' ' || name.back() == '\t')) name.remove_suffix(1);
+      if (name.empty() || name.size() >= sizeof(r.name)) return Status::InvalidArgument("invalid rule name");
+      for (char c : name) {
+        if (!is_ident_char(c) && c != '-' && c != '.') return Status::InvalidArgument("invalid rule name");
+      }
+      std::memcpy(r.name, name.data(), name.size());
+      r.name[name.size()] = '\0';
+      pos_ = colon + 1;
+    }
+
+    r.lhs_off = static_cast<std::uint32_t>(code_.size());
+    Status st = expr_top();
+    if (!st.ok()) return st;
+    r.lhs_len = static_cast<std::uint32_t>(code_.size()) - r.lhs_off;
+
+    skip_ws();
+    if (match(">=")) {
+      r.cmp = Cmp::kGe;
+    } else if (match("<=")) {
+      r.cmp = Cmp::kLe;
+    } else if (match(">")) {
+      r.cmp = Cmp::kGt;
+    } else if (match("<")) {
+      r.cmp = Cmp::kLt;
+    } else {
+      return Status::InvalidArgument("expected comparison");
+    }
+
+    r.rhs_off = static_cast<std::uint32_t>(code_.size());
+    st = expr_top();
+    if (!st.ok()) return st;
+    r.rhs_len = static_cast<std::uint32_t>(code_.size()) - r.rhs_off;
+
+    while (true) {
+      skip_ws();
+      if (pos_ >= s_.size()) break;
+      if (keyword("for")) {
+        st = duration(r.for_ms);
+      } else if (keyword("hysteresis")) {
+        skip_ws();
+        st = number(r.hysteresis);
+        if (st.ok() && r.hysteresis < 0.0) st = Status::InvalidArgument("negative hysteresis");
+      } else {
+        st = Status::InvalidArgument("unexpected trailing input");
+      }
+      if (!st.ok()) return st;
+    }
+    return Status::Ok();
+  }
+
+ private:
+  Status expr_top() {
+    depth_ = 0;
+    max_depth_ = 0;
+    const Status st = expr();
+    if (!st.ok()) return st;
+    if (max_depth_ > kMaxStack) return Status::InvalidArgument("expression too deep");
+    return Status::Ok();
+  }
+
+  // expr := term (('+' | '-') term)*
+  Status expr() {
+    Status st = term();
+    while (st.ok()) {
+      skip_ws();
+      if (match("+")) {
+        st = term();
+        if (st.ok()) emit_binary(kOpAdd);
+      } else if (match("-")) {
+        st = term();
+        if (st.ok()) emit_binary(kOpSub);
+      } else {
+        break;
+      }
+    }
+    return st;
+  }
+
+  // term := factor (('*' | '/') factor)*
+  Status term() {
+    Status st = factor();
+    while (st.ok()) {
+      skip_ws();
+      if (match("*")) {
+        st = factor();
+        if (st.ok()) emit_binary(kOpMul);
+      } else if (match("/")) {
+        st = factor();
+        if (st.ok()) emit_binary(kOpDiv);
+      } else {
+        break;
+      }
+    }
+    return st;
+  }
+
+  // factor := number | metric | '(' expr ')' | '-' factor
+  Status factor() {
+    skip_ws();
+    if (pos_ >= s_.size()) return Status::InvalidArgument("unexpected end of rule");
+    const char c = s_[pos_];
+    if (c == '(') {
+      ++pos_;
+      const Status st = expr();
+      if (!st.ok()) return st;
+      skip_ws();
+      if (!match(")")) return Status::InvalidArgument("expected ')'");
+      return Status::Ok();
+    }
+    if (c == '-') {
+      ++pos_;
+      const Status st = factor();
+      if (!st.ok()) return st;
+      if (code_.back().op == kOpConst) {
+        code_.back().k = -code_.back().k;
+      } else {
+        code_.push_back(Instr{kOpNeg, 0, 0.0});
+      }
+      return Status::Ok();
+    }
+    if (is_digit(c) || c == '.') {
+      double v = 0.0;
+      const Status st = number(v);
+      if (!st.ok()) return st;
+      push(Instr{kOpConst, 0, v});
+      return Status::Ok();
+    }
+    if (is_ident_start(c)) {
+      const std::size_t start = pos_;
+      while (pos_ < s_.size() && is_ident_char(s_[pos_])) ++pos_;
+      const std::string_view ident = s_.substr(start, pos_ - start);
+      for (std::uint8_t id = 0; id < kMetricCount; ++id) {
+        if (ident == kMetricNames[id]) {
+          push(Instr{kOpLoad, id, 0.0});
+          return Status::Ok();
+        }
+      }
+      return Status::InvalidArgument("unknown metric");
+    }
+    return Status::InvalidArgument("unexpected character");
+  }
+
+  Status number(double& out) {
+    char buf[64];
+    std::size_t n = 0;
+    while (pos_ < s_.size() && n + 1 < sizeof(buf) && (is_digit(s_[pos_]) || s_[pos_] == '.')) buf[n++] = s_[pos_++];
+    buf[n] = '\0';
+    if (n == 0) return Status::InvalidArgument("expected number");
+    char* end = nullptr;
+    out = std::strtod(buf, &end);
+    if (end != buf + n) return Status::InvalidArgument("invalid number");
+    return Status::Ok();
+  }
+
+  Status duration(std::uint64_t& out_ms) {
+    skip_ws();
+    double v = 0.0;
+    const Status st = number(v);
+    if (!st.ok()) return st;
+    double scale = 0.0;
+    if (match("ms")) {
+      scale = 1.0;
+    } else if (match("s")) {
+      scale = 1000.0;
+    } else if (match("m")) {
+      scale = 60.0 * 1000.0;
+    } else if (match("h")) {
+      scale = 3600.0 * 1000.0;
+    } else {
+      return Status::InvalidArgument("duration needs a unit (ms, s, m, h)");
+    }
+    if (pos_ < s_.size() && is_ident_char(s_[pos_])) return Status::InvalidArgument("invalid duration unit");
+    out_ms = static_cast<std::uint64_t>(v * scale);
+    return Status::Ok();
+  }
+
+  void push(Instr in) {
+    code_.push_back(in);
+    if (++depth_ > max_depth_) max_depth_ = depth_;
+  }
+
+  // Both operands are on top of the emitted code; two constants fold into one.
+  void emit_binary(std::uint8_t op) {
+    --depth_;
+    const std::size_t n = code_.size();
+    if (code_[n - 1].op == kOpConst && code_[n - 2].op == kOpConst) {
+      const double a = code_[n - 2].k;
+      const double b = code_[n - 1].k;
+      code_.pop_back();
+      code_.back().k = op == kOpAdd ? a + b : op == kOpSub ? a - b : op == kOpMul ? a * b : a / b;
+      return;
+    }
+    code_.push_back(Instr{op, 0, 0.0});
+  }
+
+  bool match(std::string_view tok) {
+    if (s_.substr(pos_, tok.size()) != tok) return false;
+    pos_ += tok.size();
+    return true;
+  }
+
+  bool keyword(std::string_view kw) {
+    if (s_.substr(pos_, kw.size()) != kw) return false;
+    if (pos_ + kw.size() < s_.size() && is_ident_char(s_[pos_ + kw.size()])) return false;
+    pos_ += kw.size();
+    return true;
+  }
+
+  void skip_ws() {
+    while (pos_ < s_.size() && (s_[pos_] == ' ' || s_[pos_] == '\t' || s_[pos_] == '\r' || s_[pos_] == '\n')) ++pos_;
+  }
+
+  std::string_view s_;
+  std::size_t pos_{0};
+  std::vector<Instr>& code_;
+  int depth_{0};
+  int max_depth_{0};
+};
+
+Status RuleEngine::add_rule(std::string_view text) {
+  Rule r{};
+  const std::size_t code_mark = code_.size();
+  Parser p(text, code_);
+  const Status st = p.rule(r);
+  if (!st.ok()) {
+    code_.resize(code_mark);
+    return st;
+  }
+  if (r.name[0] == '\0') std::snprintf(r.name, sizeof(r.name), "rule%zu", rules_.size());
+  rules_.push_back(r);
+  return Status::Ok();
+}
+
+Status RuleEngine::load_file(const char* path, std::size_t* error_line) {
+  std::FILE* f = std::fopen(path, "r");
+  if (!f) return Status::IoError("open rules file failed");
+
+  char line[512];
+  std::size_t lineno = 0;
+  Status st = Status::Ok();
+  while (st.ok() && std::fgets(line, sizeof(line), f)) {
+    ++lineno;
+    const char* p = line;
+    while (*p == ' ' || *p == '\t') ++p;
+    if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') continue;
+    st = add_rule(p);
+  }
+  std::fclose(f);
+  if (!st.ok() && error_line) *error_line = lineno;
+  return st;
+}
+
+std::size_t RuleEngine::firing_count() const {
+  std::size_t n = 0;
+  for (const Rule& r : rules_) n += r.state == State::kFiring ? 1 : 0;
+  return n;
+}
+
+bool RuleEngine::is_firing(std::uint32_t rule) const {
+  return rule < rules_.size() && rules_[rule].state == State::kFiring;
+}
+
+const char* RuleEngine::rule_name(std::uint32_t rule) const {
+  return rule < rules_.size() ? rules_[rule].name : "";
+}
+
+void RuleEngine::firing(std::vector<AlertEvent>& out) const {
+  for (std::uint32_t i = 0; i < rules_.size(); ++i) {
+    const Rule& r = rules_[i];
+    if (r.state == State::kFiring) out.push_back(AlertEvent{i, true, r.last_value, r.last_threshold, r.fired_ms});
+  }
+}
+
+double RuleEngine::run_program(const Instr* code, std::uint32_t len, const double* metrics) {
+  // Constant-folded right-hand sides are the common case.
+  if (len == 1 && code[0].op == kOpConst) return code[0].k;
+
+  double stack[kMaxStack];
+  int sp = 0;
+  for (std::uint32_t i = 0; i < len; ++i) {
+    const Instr& in = code[i];
+    switch (in.op) {
+      case kOpConst: stack[sp++] = in.k; break;
+      case kOpLoad: stack[sp++] = metrics[in.metric]; break;
+      case kOpAdd: --sp; stack[sp - 1] += stack[sp]; break;
+      case kOpSub: --sp; stack[sp - 1] -= stack[sp]; break;
+      case kOpMul: --sp; stack[sp - 1] *= stack[sp]; break;
+      case kOpDiv: --sp; stack[sp - 1] = stack[sp] == 0.0 ? NAN : stack[sp - 1] / stack[sp]; break;
+      case kOpNeg: stack[sp - 1] = -stack[sp - 1]; break;
+    }
+  }
+  return stack[0];
+}
+
+void RuleEngine::evaluate(const MetricsSnapshot& snap, std::uint64_t now_ms) {
+  double metrics[kMetricCount];
+  metrics[kCpuUsagePct] = snap.cpu_usage_pct;
+  metrics[kMemTotalKb] = static_cast<double>(snap.mem_total_kb);
+  metrics[kMemAvailableKb] = static_cast<double>(snap.mem_available_kb);
+  metrics[kTemperatureC] = snap.temperature_c;
+  metrics[kUptimeS] = static_cast<double>(snap.uptime_s);
+
+  const Instr* code = code_.data();
+  for (std::uint32_t i = 0; i < rules_.size(); ++i) {
+    Rule& r = rules_[i];
+    const double v = run_program(code + r.lhs_off, r.lhs_len, metrics);
+    const double t = run_program(code + r.rhs_off, r.rhs_len, metrics);
+    if (std::isnan(v) || std::isnan(t)) continue;
+    r.last_value = v;
+    r.last_threshold = t;
+
+    // While firing, the threshold is relaxed by the hysteresis margin so a value hovering at
+    // the threshold does not flap.
+    const double h = r.state == State::kFiring ? r.hysteresis : 0.0;
+    bool holds = false;
+    switch (r.cmp) {
+      case Cmp::kGt: holds = v > t - h; break;
+      case Cmp::kGe: holds = v >= t - h; break;
+      case Cmp::kLt: holds = v < t + h; break;
+      case Cmp::kLe: holds = v <= t + h; break;
+    }
+
+    switch (r.state) {
+      case State::kInactive:
+        if (!holds) break;
+        r.pending_since_ms = now_ms;
+        r.state = State::kPending;
+        [[fallthrough]];
+      case State::kPending:
+        if (!holds) {
+          r.state = State::kInactive;
+        } else if (now_ms - r.pending_since_ms >= r.for_ms) {
+          r.state = State::kFiring;
+          r.fired_ms = snap.ts_ms;
+          events_.push_back(AlertEvent{i, true, v, t, snap.ts_ms});
+        }
+        break;
+      case State::kFiring:
+        if (!holds) {
+          r.state = State::kInactive;
+          events_.push_back(AlertEvent{i, false, v, t, snap.ts_ms});
+        }
+        break;
+    }
+  }
+}
+
+}  // namespace telemetry::rules
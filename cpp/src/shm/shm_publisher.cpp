@@ -0,0 +1,105 @@
+#include "telemetry/shm/shm_publisher.h"
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <new>
+
+namespace telemetry::shm {
+
+namespace {
+
+// The writer pid recorded in the segment called `name`; false if there is no such segment
+// or its header was never completed.
+bool segment_writer(const char* name, std::uint32_t& pid) {
+  const int fd = ::shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+  if (fd < 0) return false;
+  struct stat st {};
+  void* base = MAP_FAILED;
+  if (::fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(ShmHeader)) {
+    base = ::mmap(nullptr, sizeof(ShmHeader), PROT_READ, MAP_SHARED, fd, 0);
+  }
+  ::close(fd);
+  if (base == MAP_FAILED) return false;
+  const auto* header = static_cast<const ShmHeader*>(base);
+  const bool ok = header->magic.load(std::memory_order_acquire) == kShmMagic;
+  pid = header->writer_pid;
+  ::munmap(base, sizeof(ShmHeader));
+  return ok;
+}
+
+bool process_alive(std::uint32_t pid) {
+  return pid != 0 && (::kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM);
+}
+
+}  // namespace
+
+ShmPublisher::ShmPublisher(ShmConfig cfg) : cfg_(cfg) {}
+
+ShmPublisher::~ShmPublisher() {
+  if (!base_) return;
+  ::munmap(base_, size_);
+  // The name may have been taken over after this process was thought dead; leave that alone.
+  std::uint32_t pid = 0;
+  if (segment_writer(cfg_.name, pid) && pid == static_cast<std::uint32_t>(::getpid())) {
+    (void)::shm_unlink(cfg_.name);
+  }
+}
+
+Status ShmPublisher::open() {
+  if (!cfg_.name || cfg_.name[0] != '/') return Status::InvalidArgument("shm name must start with '/'");
+  if (cfg_.history < 2) return Status::InvalidArgument("shm history must be at least 2");
+  if (base_) return Status::Ok();
+
+  // A segment whose writer is still running belongs to another agent. One left by a dead
+  // writer is replaced, never resized: that would fault a reader still mapping it.
+  std::uint32_t pid = 0;
+  if (segment_writer(cfg_.name, pid) && process_alive(pid)) {
+    return Status::IoError("shm segment in use by a live writer");
+  }
+  (void)::shm_unlink(cfg_.name);
+  const int fd = ::shm_open(cfg_.name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (fd < 0) return Status::IoError("shm_open failed");
+  const std::size_t size = shm_segment_size(cfg_.history);
+  if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    ::close(fd);
+    (void)::shm_unlink(cfg_.name);
+    return Status::IoError("ftruncate(shm) failed");
+  }
+  void* base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    (void)::shm_unlink(cfg_.name);
+    return Status::IoError("mmap(shm) failed");
+  }
+
+  // The fresh mapping is zero-filled; the atomics start life there.
+  base_ = base;
+  size_ = size;
+  header_ = new (base) ShmHeader{};
+  slots_ = reinterpret_cast<ShmSlot*>(static_cast<char*>(base) + sizeof(ShmHeader));
+  for (std::uint32_t i = 0; i < cfg_.history; ++i) new (&slots_[i]) ShmSlot{};
+  header_->version = kShmVersion;
+  header_->header_size = sizeof(ShmHeader);
+  header_->slot_size = sizeof(ShmSlot);
+  header_->capacity = cfg_.history;
+  header_->writer_pid = static_cast<std::uint32_t>(::getpid());
+  header_->magic.store(kShmMagic, std::memory_order_release);
+  return Status::Ok();
+}
+
+void ShmPublisher::on_snapshot(const MetricsSnapshot& snap, Status collect_status) {
+  if (!header_) return;
+  write_slot(slots_[published_ % cfg_.history], published_, snap, collect_status.code);
+  header_->published.store(++published_, std::memory_order_release);
+}
+
+}  // namespace telemetry::shm
+
+#endif  // !_WIN32
@@ -0,0 +1,317 @@
+#include "telemetry/storage/spool.h"
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "telemetry/codec/snapshot_codec.h"
+#include "telemetry/util/crc32.h"
+
+namespace telemetry::storage {
+
+namespace {
+
+constexpr const char* kSegmentSuffix = ".tlog";
+constexpr std::size_t kSegmentDigits = 20;
+constexpr std::uint32_t kMaxRecordPayload = 64U * 1024U;
+
+static void put_u32le(std::uint8_t* p, std::uint32_t v) {
+  p[0] = static_cast<std::uint8_t>(v);
+  p[1] = static_cast<std::uint8_t>(v >> 8);
+  p[2] = static_cast<std::uint8_t>(v >> 16);
+  p[3] = static_cast<std::uint8_t>(v >> 24);
+}
+
+static std::uint32_t get_u32le(const std::uint8_t* p) {
+  return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+         (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+static bool write_all(int fd, const std::uint8_t* data, std::size_t len) {
+  while (len > 0) {
+    const ssize_t n = ::write(fd, data, len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    data += n;
+    len -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+static bool pread_all(int fd, std::uint8_t* data, std::size_t len, std::uint64_t off) {
+  while (len > 0) {
+    const ssize_t n = ::pread(fd, data, len, static_cast<off_t>(off));
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    if (n == 0) return false;
+    data += n;
+    len -= static_cast<std::size_t>(n);
+    off += static_cast<std::uint64_t>(n);
+  }
+  return true;
+}
+
+// Offset of the first record boundary at or after `target` in a segment of `size` bytes,
+// found by walking the records from the start; `size` if there is none.
+static bool record_boundary(int fd, std::uint64_t size, std::uint64_t target, std::uint64_t& out) {
+  std::vector<std::uint8_t> buf(kSpoolRecordHeaderSize + kMaxRecordPayload);
+  std::uint64_t off = 0;
+  while (off < target && off < size) {
+    const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(buf.size(), size - off));
+    if (!pread_all(fd, buf.data(), n, off)) return false;
+    SpoolRecordReader reader(buf.data(), n);
+    const std::uint8_t* payload = nullptr;
+    std::uint32_t len = 0;
+    while (off + reader.offset() < target && reader.next(payload, len)) {
+    }
+    // A buffer holds at least one whole record, so no progress means a bad one.
+    if (reader.offset() == 0) break;
+    off += reader.offset();
+  }
+  out = off < target ? size : off;
+  return true;
+}
+
+}  // namespace
+
+bool parse_segment_name(const char* name, std::uint64_t& base) {
+  const std::size_t len = std::strlen(name);
+  if (len != kSegmentDigits + std::strlen(kSegmentSuffix)) return false;
+  if (std::strcmp(name + kSegmentDigits, kSegmentSuffix) != 0) return false;
+  std::uint64_t v = 0;
+  for (std::size_t i = 0; i < kSegmentDigits; ++i) {
+    if (name[i] < '0' || name[i] > '9') return false;
+    v = v * 10ULL + static_cast<std::uint64_t>(name[i] - '0');
+  }
+  base = v;
+  return true;
+}
+
+bool SpoolRecordReader::next(const std::uint8_t*& payload, std::uint32_t& len) {
+  if (size_ - off_ < kSpoolRecordHeaderSize) return false;
+  const std::uint32_t n = get_u32le(data_ + off_);
+  const std::uint32_t crc = get_u32le(data_ + off_ + 4);
+  if (n == 0 || n > kMaxRecordPayload || size_ - off_ - kSpoolRecordHeaderSize < n) return false;
+  const std::uint8_t* p = data_ + off_ + kSpoolRecordHeaderSize;
+  if (util::crc32(p, n) != crc) return false;
+  payload = p;
+  len = n;
+  off_ += kSpoolRecordHeaderSize + n;
+  return true;
+}
+
+Spool::Spool(SpoolConfig cfg) : cfg_(cfg), dir_(cfg.dir ? cfg.dir : "") {}
+
+Spool::~Spool() {
+  if (active_fd_ >= 0) {
+    (void)flush(true);
+    ::close(active_fd_);
+  }
+}
+
+std::string Spool::segment_path(std::uint64_t base) const {
+  char name[kSegmentDigits + 8];
+  std::snprintf(name, sizeof(name), "%020llu%s", static_cast<unsigned long long>(base), kSegmentSuffix);
+  return dir_ + "/" + name;
+}
+
+Status Spool::open() {
+  if (dir_.empty()) return Status::InvalidArgument("spool dir not set");
+  if (cfg_.segment_bytes < kSpoolRecordHeaderSize + codec::kMaxEncodedSnapshotSize) {
+    return Status::InvalidArgument("spool segment too small");
+  }
+  if (::mkdir(dir_.c_str(), 0755) != 0 && errno != EEXIST) return Status::IoError("mkdir(spool dir) failed");
+  pending_.reserve(cfg_.flush_bytes + kSpoolRecordHeaderSize + codec::kMaxEncodedSnapshotSize);
+
+  DIR* d = ::opendir(dir_.c_str());
+  if (!d) return Status::IoError("opendir(spool dir) failed");
+  segments_.clear();
+  disk_bytes_ = 0;
+  while (const dirent* e = ::readdir(d)) {
+    std::uint64_t base = 0;
+    if (!parse_segment_name(e->d_name, base)) continue;
+    struct stat st {};
+    if (::stat(segment_path(base).c_str(), &st) != 0) continue;
+    segments_.push_back(Segment{base, static_cast<std::uint64_t>(st.st_size)});
+  }
+  ::closedir(d);
+
+  std::sort(segments_.begin(), segments_.end(), [](const Segment& a, const Segment& b) { return a.base < b.base; });
+
+  if (segments_.empty()) return open_active(0, true);
+
+  const Status st = recover_tail(segments_.back());
+  if (!st.ok()) return st;
+  for (const auto& s : segments_) disk_bytes_ += s.size;
+  return open_active(segments_.back().base, false);
+}
+
+Status Spool::recover_tail(Segment& seg) {
+  const std::string path = segment_path(seg.base);
+  const int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+  if (fd < 0) return Status::IoError("open(spool segment) failed");
+
+  std::vector<std::uint8_t> data(static_cast<std::size_t>(seg.size));
+  if (!pread_all(fd, data.data(), data.size(), 0)) {
+    ::close(fd);
+    return Status::IoError("read(spool segment) failed");
+  }
+  SpoolRecordReader reader(data.data(), data.size());
+  const std::uint8_t* payload = nullptr;
+  std::uint32_t len = 0;
+  while (reader.next(payload, len)) {
+  }
+  const std::uint64_t off = reader.offset();
+
+  if (off != seg.size) {
+    std::fprintf(stderr, "spool: truncating %s from %llu to %llu bytes (torn tail)\n", path.c_str(),
+                 static_cast<unsigned long long>(seg.size), static_cast<unsigned long long>(off));
+    if (::ftruncate(fd, static_cast<off_t>(off)) != 0) {
+      ::close(fd);
+      return Status::IoError("ftruncate(spool segment) failed");
+    }
+    seg.size = off;
+  }
+  ::close(fd);
+  return Status::Ok();
+}
+
+Status Spool::open_active(std::uint64_t base, bool create) {
+  const std::string path = segment_path(base);
+  const int flags = O_WRONLY | O_APPEND | O_CLOEXEC | (create ? (O_CREAT | O_EXCL) : 0);
+  const int fd = ::open(path.c_str(), flags, 0644);
+  if (fd < 0) return Status::IoError("open(spool segment) failed");
+  if (active_fd_ >= 0) ::close(active_fd_);
+  active_fd_ = fd;
+  if (create) segments_.push_back(Segment{base, 0});
+  tail_cursor_ = segments_.back().base + segments_.back().size;
+  return Status::Ok();
+}
+
+Status Spool::rotate() {
+  Status st = flush(true);
+  if (!st.ok()) return st;
+  st = open_active(tail_cursor_, true);
+  if (!st.ok()) return st;
+  enforce_budget();
+  return Status::Ok();
+}
+
+void Spool::enforce_budget() {
+  while (segments_.size() > 1 && disk_bytes_ > cfg_.budget_bytes) {
+    const Segment oldest = segments_.front();
+    (void)::unlink(segment_path(oldest.base).c_str());
+    disk_bytes_ -= oldest.size;
+    segments_.erase(segments_.begin());
+  }
+}
+
+Status Spool::append(const MetricsSnapshot& snap, Status collect_status, std::uint64_t now_ms) {
+  if (active_fd_ < 0) return Status::Unavailable("spool not open");
+  if (last_flush_ms_ == 0) last_flush_ms_ = now_ms;
+
+  std::uint8_t payload[codec::kMaxEncodedSnapshotSize];
+  const std::size_t n = codec::encode_snapshot(snap, collect_status.code, payload, sizeof(payload));
+  if (n == 0) return Status::Internal("snapshot encode failed");
+  const std::uint64_t rec_size = kSpoolRecordHeaderSize + n;
+
+  const Segment& active = segments_.back();
+  const std::uint64_t active_bytes = active.size + pending_.size();
+  if (active_bytes > 0 && active_bytes + rec_size > cfg_.segment_bytes) {
+    const Status st = rotate();
+    if (!st.ok()) return st;
+  }
+
+  std::uint8_t hdr[kSpoolRecordHeaderSize];
+  put_u32le(hdr, static_cast<std::uint32_t>(n));
+  put_u32le(hdr + 4, util::crc32(payload, n));
+  pending_.insert(pending_.end(), hdr, hdr + sizeof(hdr));
+  pending_.insert(pending_.end(), payload, payload + n);
+  tail_cursor_ += rec_size;
+
+  if (pending_.size() >= cfg_.flush_bytes) return flush(false);
+  return Status::Ok();
+}
+
+Status Spool::flush(bool sync) {
+  if (active_fd_ < 0) return Status::Unavailable("spool not open");
+  if (!pending_.empty()) {
+    if (!write_all(active_fd_, pending_.data(), pending_.size())) return Status::IoError("write(spool) failed");
+    segments_.back().size += pending_.size();
+    disk_bytes_ += pending_.size();
+    pending_.clear();
+    dirty_ = true;
+  }
+  if (sync && dirty_) {
+    if (::fsync(active_fd_) != 0) return Status::IoError("fsync(spool) failed");
+    dirty_ = false;
+  }
+  return Status::Ok();
+}
+
+Status Spool::maybe_flush(std::uint64_t now_ms) {
+  if (pending_.empty() && !dirty_) return Status::Ok();
+  if (now_ms - last_flush_ms_ < cfg_.flush_interval_ms) return Status::Ok();
+  last_flush_ms_ = now_ms;
+  const Status st = flush(true);
+  enforce_budget();
+  return st;
+}
+
+std::uint32_t Spool::ms_until_flush(std::uint64_t now_ms) const {
+  if (pending_.empty() && !dirty_) return UINT32_MAX;
+  const std::uint64_t due = last_flush_ms_ + cfg_.flush_interval_ms;
+  return now_ms >= due ? 0U : static_cast<std::uint32_t>(due - now_ms);
+}
+
+std::uint64_t Spool::head_cursor() const { return segments_.empty() ? tail_cursor_ : segments_.front().base; }
+
+Status Spool::drain_range(std::uint64_t cursor, DrainRange& out) {
+  out = DrainRange{};
+  const Status st = flush(false);
+  if (!st.ok()) return st;
+
+  for (const auto& seg : segments_) {
+    if (seg.base + seg.size <= cursor) continue;
+    // Cursors that fell behind retention (or into a gap) restart at the next segment.
+    const std::uint64_t from = std::max(cursor, seg.base);
+    const int fd = ::open(segment_path(seg.base).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return Status::IoError("open(spool segment) failed");
+    // A cursor inside a record moves on to the next one so the stream stays decodable.
+    std::uint64_t off = from - seg.base;
+    if (off > 0 && !record_boundary(fd, seg.size, off, off)) {
+      ::close(fd);
+      return Status::IoError("read(spool segment) failed");
+    }
+    if (off == seg.size) {
+      ::close(fd);
+      continue;
+    }
+    out.fd = fd;
+    out.file_offset = off;
+    out.length = seg.size - out.file_offset;
+    out.from_cursor = seg.base + off;
+    out.next_cursor = seg.base + seg.size;
+    return Status::Ok();
+  }
+
+  out.from_cursor = tail_cursor_;
+  out.next_cursor = tail_cursor_;
+  return Status::Ok();
+}
+
+}  // namespace telemetry::storage
+
+#endif  // !_WIN32
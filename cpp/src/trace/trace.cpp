@@ -0,0 +1,264 @@
+#include "telemetry/trace/trace.h"
+
+#include <cstdio>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#endif
+
+namespace telemetry::trace {
+
+std::atomic<bool> g_enabled{false};
+
+namespace {
+
+static_assert((kRingEvents & (kRingEvents - 1)) == 0, "ring size must be a power of two");
+
+constexpr int kMaxRings = 32;
+
+// Fields are atomics so the dumper may read a slot the owner is rewriting; a torn slot is
+// detected by the head check in copy_ring() and discarded.
+struct Slot final {
+  std::atomic<std::uint64_t> start_ns{0};
+  std::atomic<std::uint64_t> dur_ns{0};
+  std::atomic<const char*> name{nullptr};
+  std::atomic<std::uint64_t> arg{0};
+};
+
+struct Ring final {
+  std::atomic<std::uint64_t> head{0};
+  std::atomic<bool> owned{false};
+  std::atomic<const char*> thread_name{nullptr};
+  // Guarded by Registry::mu.
+  std::uint64_t floor{0};
+  std::uint32_t tid{0};
+  std::array<Slot, kRingEvents> slots;
+};
+
+struct Registry final {
+  std::mutex mu;
+  std::array<std::unique_ptr<Ring>, kMaxRings> rings;
+  int count{0};
+  std::uint32_t next_tid{1};
+};
+
+Registry& registry() {
+  static Registry r;
+  return r;
+}
+
+// Hands the ring back for reuse when its thread exits.
+struct ThreadRing final {
+  Ring* ring{nullptr};
+  bool exhausted{false};
+  const char* name{nullptr};
+  ~ThreadRing() {
+    if (ring) ring->owned.store(false, std::memory_order_release);
+  }
+};
+
+thread_local ThreadRing t_ring;
+
+Ring* acquire_ring() {
+  Registry& reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mu);
+  Ring* ring = nullptr;
+  for (int i = 0; i < reg.count; ++i) {
+    if (!reg.rings[i]->owned.load(std::memory_order_acquire)) {
+      ring = reg.rings[i].get();
+      // The previous owner's events would be mislabelled with the new tid.
+      ring->floor = ring->head.load(std::memory_order_relaxed);
+      break;
+    }
+  }
+  if (!ring) {
+    if (reg.count == kMaxRings) return nullptr;
+    reg.rings[reg.count] = std::make_unique<Ring>();
+    ring = reg.rings[reg.count++].get();
+  }
+  ring->tid = reg.next_tid++;
+  ring->thread_name.store(t_ring.name, std::memory_order_relaxed);
+  ring->owned.store(true, std::memory_order_relaxed);
+  return ring;
+}
+
+struct Event final {
+  std::uint64_t start_ns;
+  std::uint64_t dur_ns;
+  const char* name;
+  std::uint64_t arg;
+};
+
+// Copies the ring's live window; slots the owner may have overwritten meanwhile are dropped.
+void copy_ring(const Ring& r, std::vector<Event>& out) {
+  out.clear();
+  const std::uint64_t head = r.head.load(std::memory_order_acquire);
+  std::uint64_t from = head > kRingEvents ? head - kRingEvents : 0;
+  if (from < r.floor) from = r.floor;
+  for (std::uint64_t i = from; i < head; ++i) {
+    const Slot& s = r.slots[i & (kRingEvents - 1)];
+    out.push_back(Event{s.start_ns.load(std::memory_order_relaxed), s.dur_ns.load(std::memory_order_relaxed),
+                        s.name.load(std::memory_order_relaxed), s.arg.load(std::memory_order_relaxed)});
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  // The owner may be writing index `now`, which reuses the slot of `now - kRingEvents`.
+  const std::uint64_t now = r.head.load(std::memory_order_relaxed);
+  const std::uint64_t first_valid = now >= kRingEvents ? now - kRingEvents + 1 : 0;
+  if (first_valid > from) {
+    const std::uint64_t drop = std::min<std::uint64_t>(first_valid - from, out.size());
+    out.erase(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(drop));
+  }
+}
+
+void append_event(std::string& out, bool& first, int pid, std::uint32_t tid, const Event& e) {
+  char buf[256];
+  const int n = std::snprintf(buf, sizeof(buf),
+                              "%s{\"name\":\"%s\",\"cat\":\"telemetryd\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                              "\"pid\":%d,\"tid\":%u,\"args\":{\"n\":%llu}}",
+                              first ? "" : ",\n", e.name ? e.name : "?", static_cast<double>(e.start_ns) / 1000.0,
+                              static_cast<double>(e.dur_ns) / 1000.0, pid, static_cast<unsigned>(tid),
+                              static_cast<unsigned long long>(e.arg));
+  if (n <= 0 || static_cast<std::size_t>(n) >= sizeof(buf)) return;
+  out.append(buf, static_cast<std::size_t>(n));
+  first = false;
+}
+
+#ifndef _WIN32
+volatile std::sig_atomic_t g_dump_requested = 0;
+const char* g_dump_path = nullptr;
+volatile std::sig_atomic_t g_dump_wake_fd = -1;
+
+extern "C" void on_dump_signal(int) {
+  g_dump_requested = 1;
+  // The signal may land on a thread other than the event loop's.
+  const int fd = g_dump_wake_fd;
+  if (fd >= 0) {
+    const int saved = errno;
+    const char b = 1;
+    (void)::write(fd, &b, 1);
+    errno = saved;
+  }
+}
+#endif
+
+}  // namespace
+
+void record(const char* name, std::uint64_t start_ns, std::uint64_t dur_ns, std::uint64_t arg) {
+  ThreadRing& t = t_ring;
+  if (!t.ring) {
+    if (t.exhausted) return;
+    t.ring = acquire_ring();
+    if (!t.ring) {
+      t.exhausted = true;
+      return;
+    }
+  }
+  Ring& r = *t.ring;
+  const std::uint64_t h = r.head.load(std::memory_order_relaxed);
+  // Orders the previous head publish before these slot writes (see copy_ring()).
+  std::atomic_thread_fence(std::memory_order_release);
+  Slot& s = r.slots[h & (kRingEvents - 1)];
+  s.start_ns.store(start_ns, std::memory_order_relaxed);
+  s.dur_ns.store(dur_ns, std::memory_order_relaxed);
+  s.name.store(name, std::memory_order_relaxed);
+  s.arg.store(arg, std::memory_order_relaxed);
+  r.head.store(h + 1, std::memory_order_release);
+}
+
+void set_thread_name(const char* name) {
+  t_ring.name = name;
+  if (t_ring.ring) t_ring.ring->thread_name.store(name, std::memory_order_relaxed);
+}
+
+void clear() {
+  Registry& reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mu);
+  for (int i = 0; i < reg.count; ++i) reg.rings[i]->floor = reg.rings[i]->head.load(std::memory_order_acquire);
+}
+
+std::size_t write_chrome_json(std::string& out) {
+#ifndef _WIN32
+  const int pid = static_cast<int>(::getpid());
+#else
+  const int pid = 1;
+#endif
+  out.assign("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  bool first = true;
+  std::size_t events = 0;
+  std::vector<Event> scratch;
+  scratch.reserve(kRingEvents);
+
+  Registry& reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mu);
+  for (int i = 0; i < reg.count; ++i) {
+    const Ring& r = *reg.rings[i];
+    copy_ring(r, scratch);
+    if (scratch.empty()) continue;
+    const char* tname = r.thread_name.load(std::memory_order_relaxed);
+    if (tname) {
+      char buf[160];
+      const int n = std::snprintf(buf, sizeof(buf),
+                                  "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,"
+                                  "\"args\":{\"name\":\"%s\"}}",
+                                  first ? "" : ",\n", pid, static_cast<unsigned>(r.tid), tname);
+      if (n > 0 && static_cast<std::size_t>(n) < sizeof(buf)) {
+        out.append(buf, static_cast<std::size_t>(n));
+        first = false;
+      }
+    }
+    for (const Event& e : scratch) append_event(out, first, pid, r.tid, e);
+    events += scratch.size();
+  }
+  out.append("\n]}\n");
+  return events;
+}
+
+Status dump_to_file(const char* path, std::size_t* events) {
+  std::string json;
+  const std::size_t n = write_chrome_json(json);
+  std::FILE* f = std::fopen(path, "wb");
+  if (!f) return Status::IoError("open trace file failed");
+  const bool ok = std::fwrite(json.data(), 1, json.size(), f) == json.size();
+  if (std::fclose(f) != 0 || !ok) return Status::IoError("write trace file failed");
+  if (events) *events = n;
+  return Status::Ok();
+}
+
+#ifndef _WIN32
+Status install_dump_signal(int signo, const char* path) {
+  g_dump_path = path;
+  struct sigaction sa {};
+  sa.sa_handler = on_dump_signal;
+  sigemptyset(&sa.sa_mask);
+  // No SA_RESTART: poll() returns EINTR so the loop services the request promptly.
+  sa.sa_flags = 0;
+  if (::sigaction(signo, &sa, nullptr) != 0) return Status::IoError("sigaction failed");
+  return Status::Ok();
+}
+
+void set_dump_wake_fd(int fd) { g_dump_wake_fd = fd; }
+
+void service_dump_signal() {
+  if (!g_dump_requested) return;
+  g_dump_requested = 0;
+  if (!g_dump_path) return;
+  std::size_t events = 0;
+  const Status st = dump_to_file(g_dump_path, &events);
+  if (st.ok()) {
+    std::fprintf(stderr, "telemetryd: wrote %llu trace events to %s\n", static_cast<unsigned long long>(events),
+                 g_dump_path);
+  } else {
+    std::fprintf(stderr, "telemetryd: trace dump failed: %s\n", st.message ? st.message : "(none)");
+  }
+}
+#endif
+
+}  // namespace telemetry::trace
@@ -10,6 +10,18 @@ std::uint64_t unix_time_ms() {
   return static_cast<std::uint64_t>(ms.count());
 }
 
+std::uint64_t monotonic_ns() {
+  const auto now = std::chrono::steady_clock::now();
+  const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch());
+  return static_cast<std::uint64_t>(ns.count());
+}
+
+std::uint64_t monotonic_ms() {
+  const auto now = std::chrono::steady_clock::now();
+  const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch());
+  return static_cast<std::uint64_t>(ms.count());
+}
+
 }  // namespace telemetry::util
 
 
@@ -0,0 +1,97 @@
+#include "alloc_hooks.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// glibc exports its allocator under __libc_* names, so malloc itself can be interposed
+// and forwarded; elsewhere only operator new is counted.
+#if defined(__GLIBC__)
+#define TELEMETRY_HOOK_MALLOC 1
+#else
+#define TELEMETRY_HOOK_MALLOC 0
+#endif
+
+namespace {
+
+std::atomic<std::uint64_t> g_allocations{0};
+
+void count_allocation() { g_allocations.fetch_add(1, std::memory_order_relaxed); }
+
+void* counted_new(std::size_t n) {
+#if !TELEMETRY_HOOK_MALLOC
+  count_allocation();
+#endif
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+
+void* counted_new_aligned(std::size_t n, std::align_val_t al) {
+  count_allocation();
+  const std::size_t align = static_cast<std::size_t>(al);
+  void* p = std::aligned_alloc(align, ((n ? n : 1) + align - 1) / align * align);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+}  // namespace
+
+namespace telemetry::tests {
+
+std::uint64_t allocation_count() { return g_allocations.load(std::memory_order_relaxed); }
+
+bool counts_malloc() { return TELEMETRY_HOOK_MALLOC != 0; }
+
+}  // namespace telemetry::tests
+
+#if TELEMETRY_HOOK_MALLOC
+extern "C" {
+void* __libc_malloc(std::size_t n);
+void* __libc_calloc(std::size_t count, std::size_t n);
+void* __libc_realloc(void* p, std::size_t n);
+
+void* malloc(std::size_t n) {
+  count_allocation();
+  return __libc_malloc(n);
+}
+
+void* calloc(std::size_t count, std::size_t n) {
+  count_allocation();
+  return __libc_calloc(count, n);
+}
+
+void* realloc(void* p, std::size_t n) {
+  count_allocation();
+  return __libc_realloc(p, n);
+}
+}
+#endif
+
+void* operator new(std::size_t n) { return counted_new(n); }
+void* operator new[](std::size_t n) { return counted_new(n); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept {
+  try {
+    return counted_new(n);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept {
+  try {
+    return counted_new(n);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void* operator new(std::size_t n, std::align_val_t al) { return counted_new_aligned(n, al); }
+void* operator new[](std::size_t n, std::align_val_t al) { return counted_new_aligned(n, al); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
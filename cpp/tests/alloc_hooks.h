@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+namespace telemetry::tests {
+
+// Heap allocations made by any thread since startup (operator new, plus malloc/calloc/realloc
+// where the C library lets us interpose them). Only linked into telemetry_alloc_tests.
+std::uint64_t allocation_count();
+
+// True when malloc-family calls are counted too, not just operator new.
+bool counts_malloc();
+
+}  // namespace telemetry::tests
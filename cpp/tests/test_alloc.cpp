@@ -0,0 +1,301 @@
+#include "minitest.h"
+
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "alloc_hooks.h"
+#include "telemetry/codec/batch_codec.h"
+#include "telemetry/codec/delta_stream.h"
+#include "telemetry/codec/snapshot_codec.h"
+#include "telemetry/metrics/collector.h"
+#include "telemetry/net/http.h"
+#include "telemetry/net/openmetrics.h"
+#include "telemetry/net/protocol.h"
+#include "telemetry/net/tcp_server.h"
+#include "telemetry/rules/rule_engine.h"
+#if defined(__linux__)
+#include "telemetry/metrics/linux_sources.h"
+#include "telemetry/metrics/process_source.h"
+#endif
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// The agent must not touch the heap per request or per sample once warmed up: buffers are
+// owned by long-lived objects and reused. Each case warms a path up, then asserts that
+// thousands more iterations allocate nothing (allocation_count() covers every thread).
+
+namespace {
+
+constexpr int kWarmup = 200;
+constexpr int kCycles = 5000;
+
+class WobbleSource final : public telemetry::metrics::MetricSource {
+ public:
+  const char* name() const override { return "wobble"; }
+  telemetry::Status collect(telemetry::MetricsSnapshot& out) override {
+    ++n_;
+    out.cpu_usage_pct = 50.0 + 45.0 * std::sin(n_ / 7.0);
+    out.mem_total_kb = 8000000;
+    out.mem_available_kb = 4000000 + (n_ % 97) * 3000;
+    out.temperature_c = 40.0 + (n_ % 13);
+    out.uptime_s = 1000 + n_ / 4;
+    return telemetry::Status::Ok();
+  }
+
+ private:
+  std::uint64_t n_{0};
+};
+
+telemetry::MetricsSnapshot snapshot_at(int i) {
+  telemetry::MetricsSnapshot s{};
+  s.ts_ms = 1700000000000ULL + static_cast<std::uint64_t>(i) * 250ULL;
+  s.cpu_usage_pct = 50.0 + 45.0 * std::sin(i / 7.0);
+  s.mem_total_kb = 8000000;
+  s.mem_available_kb = 4000000 + static_cast<std::uint64_t>(i % 97) * 3000;
+  s.temperature_c = 40.0 + (i % 13);
+  s.uptime_s = 1000 + static_cast<std::uint64_t>(i) / 4;
+  return s;
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("alloc hooks see heap allocations") {
+  // Stored through a volatile sink, so the optimizer cannot elide the allocations.
+  static void* volatile sink = nullptr;
+  const std::uint64_t before = telemetry::tests::allocation_count();
+  auto p = std::make_unique<int>(1);
+  sink = p.get();
+  REQUIRE(telemetry::tests::allocation_count() > before);
+  if (telemetry::tests::counts_malloc()) {
+    const std::uint64_t mark = telemetry::tests::allocation_count();
+    void* raw = std::malloc(16);
+    sink = raw;
+    REQUIRE(telemetry::tests::allocation_count() == mark + 1);
+    std::free(sink);
+  }
+}
+
+TELEMETRY_TEST_CASE("Collector::collect does not allocate after warmup") {
+  telemetry::metrics::Collector collector;
+  collector.add_source(std::make_unique<WobbleSource>());
+#if defined(__linux__)
+  telemetry::metrics::add_linux_sources(collector, TELEMETRY_FIXTURES_DIR "/linux");
+  // One process per collect, so passes over /proc start and finish inside the measured loop.
+  telemetry::metrics::ProcessSourceConfig process_cfg{};
+  process_cfg.root = TELEMETRY_FIXTURES_DIR "/linux";
+  process_cfg.max_per_tick = 1;
+  collector.add_source(std::make_unique<telemetry::metrics::ProcessSource>(process_cfg));
+#endif
+  telemetry::MetricsSnapshot snap{};
+  for (int i = 0; i < kWarmup; ++i) REQUIRE(collector.collect(snap).ok());
+
+  const std::uint64_t before = telemetry::tests::allocation_count();
+  for (int i = 0; i < kCycles; ++i) (void)collector.collect(snap);
+  REQUIRE(telemetry::tests::allocation_count() == before);
+  REQUIRE(snap.mem_total_kb != 0);
+}
+
+TELEMETRY_TEST_CASE("parsers and serializers do not allocate after warmup") {
+  char line[512];
+  std::string exposition;
+  std::string delta_line;
+  telemetry::codec::DeadbandConfig cfg{};
+  cfg.abs = 2.0;
+  cfg.rel = 0.01;
+  cfg.keyframe_every = 30;
+  telemetry::codec::DeltaStream stream(cfg);
+  std::uint8_t snap_buf[128];
+  std::vector<std::uint8_t> frame;
+  std::vector<telemetry::codec::BatchSample> batch(64);
+  std::vector<telemetry::codec::BatchSample> decoded;
+  telemetry::net::HttpRequestParser http;
+  const std::string_view request = "GET /metrics HTTP/1.1\r\nHost: x\r\nAccept: application/openmetrics-text\r\n\r\n";
+
+  auto cycle = [&](int i) {
+    const telemetry::MetricsSnapshot s = snapshot_at(i);
+    (void)telemetry::net::parse_command(i % 2 ? "GET" : "SUBSCRIBE DELTA 2 0.01 30");
+    (void)telemetry::net::format_metrics_json(line, sizeof(line), s, telemetry::Status::Ok(), 250);
+    (void)telemetry::net::render_openmetrics(s, telemetry::Status::Ok(), exposition);
+    (void)stream.update(s, telemetry::Status::Ok(), delta_line);
+    (void)telemetry::codec::encode_snapshot(s, telemetry::StatusCode::kOk, snap_buf, sizeof(snap_buf));
+    batch[static_cast<std::size_t>(i) % batch.size()].snap = s;
+    frame.clear();
+    const std::size_t n = telemetry::codec::encode_batch(static_cast<std::uint64_t>(i), "edge", batch.data(), batch.size(), frame);
+    std::uint64_t seq = 0;
+    std::string_view id;
+    (void)telemetry::codec::decode_batch(frame.data(), n, seq, id, decoded);
+    telemetry::net::HttpRequest req{};
+    http.reset();
+    (void)http.parse(request, req);
+  };
+
+  for (int i = 0; i < kWarmup; ++i) cycle(i);
+  const std::uint64_t before = telemetry::tests::allocation_count();
+  for (int i = kWarmup; i < kWarmup + kCycles; ++i) cycle(i);
+  REQUIRE(telemetry::tests::allocation_count() == before);
+}
+
+TELEMETRY_TEST_CASE("RuleEngine::evaluate does not allocate after warmup") {
+  telemetry::rules::RuleEngine rules;
+  REQUIRE(rules.add_rule("hot: cpu_usage_pct > 80 hysteresis 5").ok());
+  REQUIRE(rules.add_rule("low_mem: mem_available_kb / mem_total_kb < 0.51").ok());
+  REQUIRE(rules.add_rule("warm: temperature_c >= 50 for 1s").ok());
+  std::vector<telemetry::rules::AlertEvent> firing;
+
+  auto cycle = [&](int i) {
+    const telemetry::MetricsSnapshot s = snapshot_at(i);
+    rules.evaluate(s, s.ts_ms);
+    firing.clear();
+    rules.firing(firing);
+    rules.clear_events();
+  };
+
+  for (int i = 0; i < kWarmup; ++i) cycle(i);
+  const std::uint64_t before = telemetry::tests::allocation_count();
+  for (int i = kWarmup; i < kWarmup + kCycles; ++i) cycle(i);
+  REQUIRE(telemetry::tests::allocation_count() == before);
+}
+
+#ifndef _WIN32
+
+namespace {
+
+int connect_loopback(std::uint16_t port) {
+  for (int attempt = 0; attempt < 100; ++attempt) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+    ::close(fd);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return -1;
+}
+
+bool send_all(int fd, const char* s) {
+  const std::size_t len = std::strlen(s);
+  return ::send(fd, s, len, MSG_NOSIGNAL) == static_cast<ssize_t>(len);
+}
+
+// Reads until `lines` newlines have arrived; stack-only so the client side adds nothing to
+// the allocation count.
+bool read_lines(int fd, int lines) {
+  char buf[4096];
+  while (lines > 0) {
+    const ssize_t n = ::read(fd, buf, sizeof(buf));
+    if (n <= 0) return false;
+    for (ssize_t i = 0; i < n; ++i) lines -= buf[i] == '\n';
+  }
+  return true;
+}
+
+// Reads one OpenMetrics response (ends with "# EOF\n").
+bool read_exposition(int fd) {
+  char buf[8192];
+  std::size_t len = 0;
+  while (len < sizeof(buf)) {
+    const ssize_t n = ::read(fd, buf + len, sizeof(buf) - len);
+    if (n <= 0) return false;
+    len += static_cast<std::size_t>(n);
+    if (len >= 6 && std::memcmp(buf + len - 6, "# EOF\n", 6) == 0) return true;
+  }
+  return false;
+}
+
+// Consumes whatever pushed lines are already waiting without blocking; returns the bytes read.
+std::size_t drain_ready(int fd) {
+  char buf[4096];
+  std::size_t total = 0;
+  pollfd p{fd, POLLIN, 0};
+  while (::poll(&p, 1, 0) > 0 && (p.revents & POLLIN)) {
+    const ssize_t n = ::read(fd, buf, sizeof(buf));
+    if (n <= 0) break;
+    total += static_cast<std::size_t>(n);
+  }
+  return total;
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("TcpServer GET, SUBSCRIBE and scrape cycles do not allocate after warmup") {
+  // Pushes race the final close()s; telemetryd ignores SIGPIPE the same way.
+  (void)std::signal(SIGPIPE, SIG_IGN);
+  const std::uint16_t port = static_cast<std::uint16_t>(20000 + (::getpid() % 20000) + 90);
+  const std::uint16_t metrics_port = static_cast<std::uint16_t>(port + 1);
+  telemetry::metrics::Collector collector;
+  collector.add_source(std::make_unique<WobbleSource>());
+  telemetry::rules::RuleEngine rules;
+  REQUIRE(rules.add_rule("hot: cpu_usage_pct > 80 hysteresis 5").ok());
+
+  telemetry::net::TcpServerConfig cfg{};
+  cfg.host = "127.0.0.1";
+  cfg.port = port;
+  cfg.metrics_port = metrics_port;
+  cfg.throttle_ms = 0;  // every GET collects
+  cfg.run_for_ms = 6000;
+  std::thread srv([&collector, &rules, cfg] {
+    telemetry::net::TcpServer server(collector, cfg);
+    server.set_rules(&rules);
+    (void)server.run_forever();
+  });
+
+  const int get_fd = connect_loopback(port);
+  const int sub_fd = connect_loopback(port);
+  const int alerts_fd = connect_loopback(port);
+  const int http_fd = connect_loopback(metrics_port);
+  REQUIRE(get_fd >= 0);
+  REQUIRE(sub_fd >= 0);
+  REQUIRE(alerts_fd >= 0);
+  REQUIRE(http_fd >= 0);
+  REQUIRE(send_all(alerts_fd, "ALERTS\n"));
+  REQUIRE(send_all(sub_fd, "SUBSCRIBE DELTA 1 0 20\n"));
+
+  std::size_t pushed = 0;
+  auto cycle = [&](int i) {
+    if (!send_all(get_fd, "GET\n") || !read_lines(get_fd, 1)) return false;
+    if (i % 10 == 0) {
+      if (!send_all(http_fd, "GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n") || !read_exposition(http_fd)) return false;
+    }
+    if (i % 50 == 0) {
+      // Rejoin the same group: reply plus the group's keyframe.
+      if (!send_all(sub_fd, "UNSUBSCRIBE\nSUBSCRIBE DELTA 1 0 20\n")) return false;
+    }
+    pushed += drain_ready(sub_fd);
+    (void)drain_ready(alerts_fd);
+    return true;
+  };
+
+  for (int i = 0; i < kWarmup; ++i) REQUIRE(cycle(i));
+  const std::uint64_t before = telemetry::tests::allocation_count();
+  pushed = 0;
+  bool ok = true;
+  for (int i = 0; i < kCycles && ok; ++i) ok = cycle(i);
+  const std::uint64_t after = telemetry::tests::allocation_count();
+
+  ::close(get_fd);
+  ::close(sub_fd);
+  ::close(alerts_fd);
+  ::close(http_fd);
+  srv.join();
+  REQUIRE(ok);
+  REQUIRE(pushed > 0);
+  REQUIRE(after == before);
+}
+
+#endif  // !_WIN32
@@ -1,7 +1,9 @@
 #include "minitest.h"
 #include <memory>
+#include <string>
 
 #include "telemetry/metrics/collector.h"
+#include "telemetry/metrics/static_collector.h"
 
 namespace {
 
@@ -26,6 +28,24 @@ class IoErrorSource final : public telemetry::metrics::MetricSource {
   telemetry::Status collect(telemetry::MetricsSnapshot&) override { return telemetry::Status::IoError("bad"); }
 };
 
+class DetailSource final : public telemetry::metrics::MetricSource {
+ public:
+  explicit DetailSource(int v) : v_(v) {}
+  const char* name() const override { return "detail"; }
+  telemetry::Status collect(telemetry::MetricsSnapshot& out) override {
+    out.uptime_s += static_cast<std::uint64_t>(v_);
+    return telemetry::Status::Ok();
+  }
+  bool append_detail_json(std::string& out) const override {
+    out.append(std::to_string(v_));
+    return true;
+  }
+  void append_openmetrics(std::string& out) const override { out.append("telemetry_detail " + std::to_string(v_) + "\n"); }
+
+ private:
+  int v_;
+};
+
 }  // namespace
 
 TELEMETRY_TEST_CASE("Collector ignores Unavailable but returns hard errors") {
@@ -46,4 +66,1068 @@ TELEMETRY_TEST_CASE("Collector ignores Unavailable but returns hard errors") {
   REQUIRE(st.code == telemetry::StatusCode::kIoError);
 }
 
+TELEMETRY_TEST_CASE("StaticCollector matches Collector's error and detail semantics") {
+  telemetry::metrics::StaticCollector<OkSource, UnavailableSource, DetailSource> c(OkSource{}, UnavailableSource{}, 7);
+  static_assert(decltype(c)::size() == 3);
+  telemetry::MetricsSnapshot snap{};
+  REQUIRE(c.collect(snap).ok());
+  REQUIRE(snap.mem_total_kb == 123);
+  REQUIRE(snap.uptime_s == 7);
+  REQUIRE(c.source<2>().name() == std::string("detail"));
+
+  telemetry::metrics::StaticCollector<IoErrorSource, UnavailableSource, DetailSource> c2(IoErrorSource{},
+                                                                                           UnavailableSource{}, 1);
+  telemetry::MetricsSnapshot snap2{};
+  REQUIRE(c2.collect(snap2).code == telemetry::StatusCode::kIoError);
+  // Sources after the failing one still ran.
+  REQUIRE(snap2.uptime_s == 1);
+
+  // Detail and OpenMetrics output is what a Collector over the same sources writes.
+  telemetry::metrics::Collector dynamic;
+  dynamic.add_source(std::make_unique<OkSource>());
+  dynamic.add_source(std::make_unique<UnavailableSource>());
+  dynamic.add_source(std::make_unique<DetailSource>(7));
+  telemetry::metrics::SnapshotCollector* both[] = {&c, &dynamic};
+  std::string detail[2];
+  std::string families[2];
+  for (int i = 0; i < 2; ++i) {
+    REQUIRE(both[i]->append_detail_json(detail[i]) == 1);
+    REQUIRE(both[i]->append_detail_json(detail[i], "ok") == 0);
+    both[i]->append_openmetrics(families[i]);
+  }
+  REQUIRE(detail[0] == "\"detail\":7");
+  REQUIRE(detail[0] == detail[1]);
+  REQUIRE(families[0] == "telemetry_detail 7\n");
+  REQUIRE(families[0] == families[1]);
+}
+
+
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "telemetry/metrics/counter_scan.h"
+#include "telemetry/metrics/linux_cgroup_source.h"
+#include "telemetry/metrics/linux_declared_source.h"
+#include "telemetry/metrics/linux_filesystem_source.h"
+#include "telemetry/metrics/linux_interrupts_source.h"
+#include "telemetry/metrics/linux_io_sources.h"
+#include "telemetry/metrics/linux_numa_source.h"
+#include "telemetry/metrics/linux_pressure_source.h"
+#include "telemetry/metrics/linux_sources.h"
+#include "telemetry/metrics/process_source.h"
+
+TELEMETRY_TEST_CASE("Linux sources parse a fixture tree under a root prefix") {
+  telemetry::metrics::Collector c;
+  telemetry::metrics::add_linux_sources(c, TELEMETRY_FIXTURES_DIR "/linux");
+  telemetry::MetricsSnapshot snap{};
+  REQUIRE(c.collect(snap).ok());
+  REQUIRE(snap.mem_total_kb == 8041320);
+  REQUIRE(snap.mem_available_kb == 4302116);
+  REQUIRE(snap.uptime_s == 183245);
+  REQUIRE(snap.temperature_c > 47.24 && snap.temperature_c < 47.26);
+
+  // A missing tree degrades to Unavailable, which the collector tolerates.
+  telemetry::metrics::Collector missing;
+  telemetry::metrics::add_linux_sources(missing, TELEMETRY_FIXTURES_DIR "/does-not-exist");
+  telemetry::MetricsSnapshot empty{};
+  REQUIRE(missing.collect(empty).ok());
+  REQUIRE(empty.mem_total_kb == 0);
+
+  // I/O sources report per-device detail: whole disks only, every interface.
+  std::string detail;
+  REQUIRE(c.append_detail_json(detail) == 5);
+  REQUIRE(detail.find("\"linux_diskstats\":[{\"device\":\"sda\"") == 0);
+  REQUIRE(detail.find("\"nvme0n1\"") != std::string::npos);
+  REQUIRE(detail.find("\"dm-0\"") != std::string::npos);
+  REQUIRE(detail.find("sda1") == std::string::npos);
+  REQUIRE(detail.find("nvme0n1p") == std::string::npos);
+  REQUIRE(detail.find("loop0") == std::string::npos);
+  REQUIRE(detail.find("\"linux_net_dev\":[{\"device\":\"lo\"") != std::string::npos);
+  REQUIRE(detail.find("\"wlan0\"") != std::string::npos);
+  REQUIRE(detail.find("\"linux_pressure\":{\"cpu\":{\"some_avg10\":1.25,") != std::string::npos);
+  REQUIRE(detail.find("\"linux_numa\":{\"numa\":true,\"nodes\":[{\"node\":0,\"cpus\":2,\"cpu_pct\":0.00,"
+                      "\"mem_total_kb\":4020660,\"mem_free_kb\":512340,\"file_pages_kb\":1510000,") != std::string::npos);
+  REQUIRE(detail.find("\"linux_interrupts\":{\"irq_per_s\":0.00,\"untracked\":0,\"top\":[]") != std::string::npos);
+  detail.clear();
+  REQUIRE(c.append_detail_json(detail, "linux_net_dev") == 1);
+  REQUIRE(detail.find("diskstats") == std::string::npos);
+  REQUIRE(c.append_detail_json(detail, "linux_cpu") == 0);
+}
+
+namespace {
+
+struct FixtureRoot final {
+  FixtureRoot() {
+    char tmpl[] = "/tmp/telemetry_proc_XXXXXX";
+    if (!::mkdtemp(tmpl)) throw telemetry::tests::RequireFailure("mkdtemp failed");
+    path = tmpl;
+    (void)::mkdir((path + "/proc").c_str(), 0700);
+    (void)::mkdir((path + "/proc/net").c_str(), 0700);
+  }
+  ~FixtureRoot() {
+    std::error_code ec;
+    std::filesystem::remove_all(path, ec);
+  }
+  void mkdir(const char* rel) const { std::filesystem::create_directories(path + rel); }
+  void remove(const char* rel) const { std::filesystem::remove_all(path + rel); }
+  // Rewrites in place, as procfs content changes under an open descriptor.
+  void write(const char* rel, const std::string& text) const {
+    std::FILE* f = std::fopen((path + rel).c_str(), "w");
+    if (!f) throw telemetry::tests::RequireFailure("fixture write failed");
+    std::fputs(text.c_str(), f);
+    std::fclose(f);
+  }
+  std::string path;
+};
+
+std::string disk_line(const char* name, unsigned long long reads, unsigned long long rsect, unsigned long long writes,
+                      unsigned long long wsect, unsigned long long io_ms) {
+  char line[256];
+  std::snprintf(line, sizeof(line), "   8       0 %s %llu 0 %llu 0 %llu 0 %llu 0 0 %llu 0 0 0 0 0 0 0\n", name, reads, rsect,
+                writes, wsect, io_ms);
+  return line;
+}
+
+std::string net_table(unsigned long long rx_bytes, unsigned long long rx_drops, unsigned long long tx_bytes) {
+  char text[512];
+  std::snprintf(text, sizeof(text),
+                "Inter-|   Receive                                                |  Transmit\n"
+                " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n"
+                "  eth0: %llu 10 0 %llu 0 0 0 0 %llu 20 0 0 0 0 0 0\n",
+                rx_bytes, rx_drops, tx_bytes);
+  return text;
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("DiskStatsSource computes rates and follows hot-plugged disks") {
+  FixtureRoot root;
+  root.write("/proc/diskstats", disk_line("sda", 1000, 8000, 500, 4000, 10000) + disk_line("sda1", 1, 1, 1, 1, 1));
+  telemetry::metrics::DiskStatsSource src(root.path.c_str());
+  REQUIRE(src.sample(1'000'000'000ULL).ok());
+  REQUIRE(src.devices().size() == 1);
+  REQUIRE(src.devices()[0].reads_per_s == 0.0);
+
+  // Half a second later: +100 reads of 1 MiB total, +50 writes of 2 MiB, busy 250 ms.
+  root.write("/proc/diskstats", disk_line("sda", 1100, 10048, 550, 8096, 10250) + disk_line("sda1", 2, 2, 2, 2, 2));
+  REQUIRE(src.sample(1'500'000'000ULL).ok());
+  REQUIRE(src.devices().size() == 1);
+  const telemetry::metrics::DiskDeviceStats& d = src.devices()[0];
+  REQUIRE(std::string(d.name) == "sda");
+  REQUIRE(d.reads_per_s == 200.0);
+  REQUIRE(d.read_bytes_per_s == 2.0 * 1024 * 1024);
+  REQUIRE(d.writes_per_s == 100.0);
+  REQUIRE(d.write_bytes_per_s == 4.0 * 1024 * 1024);
+  REQUIRE(d.util_pct == 50.0);
+
+  // sda is pulled and sdb plugged in: sdb starts from zero, sda's slot is reused later.
+  root.write("/proc/diskstats", disk_line("sdb", 7, 7, 7, 7, 7));
+  REQUIRE(src.sample(2'000'000'000ULL).ok());
+  REQUIRE(src.devices().size() == 1);
+  REQUIRE(std::string(src.devices()[0].name) == "sdb");
+  REQUIRE(src.devices()[0].reads_per_s == 0.0);
+  root.write("/proc/diskstats", disk_line("sdb", 17, 7, 7, 7, 7) + disk_line("sda", 5, 5, 5, 5, 5));
+  REQUIRE(src.sample(3'000'000'000ULL).ok());
+  REQUIRE(src.devices().size() == 2);
+  REQUIRE(src.devices()[0].reads_per_s == 10.0);
+  REQUIRE(src.devices()[1].reads_per_s == 0.0);  // a new sda, not the old counters
+  REQUIRE(src.untracked() == 0);
+}
+
+TELEMETRY_TEST_CASE("NetDevSource handles 32-bit counter wrap and resets") {
+  FixtureRoot root;
+  root.write("/proc/net/dev", net_table(4294967000ULL, 5, 10000000000ULL));
+  telemetry::metrics::NetDevSource src(root.path.c_str());
+  REQUIRE(src.sample(1'000'000'000ULL).ok());
+
+  // rx wrapped at 2^32 (+496 bytes); tx dropped from a 64-bit value, i.e. a reset.
+  root.write("/proc/net/dev", net_table(200, 9, 300));
+  REQUIRE(src.sample(2'000'000'000ULL).ok());
+  REQUIRE(src.devices().size() == 1);
+  const telemetry::metrics::NetDeviceStats& d = src.devices()[0];
+  REQUIRE(std::string(d.name) == "eth0");
+  REQUIRE(d.rx_bytes_per_s == 496.0);
+  REQUIRE(d.rx_drops_per_s == 4.0);
+  REQUIRE(d.rx_packets_per_s == 0.0);
+  REQUIRE(d.tx_bytes_per_s == 0.0);
+
+  std::string om;
+  src.append_openmetrics(om);
+  REQUIRE(om.find("# TYPE telemetry_network_receive_bytes_per_second gauge\n") == 0);
+  REQUIRE(om.find("telemetry_network_receive_bytes_per_second{device=\"eth0\"} 496.00\n") != std::string::npos);
+
+  // Small values that drop were reset, not wrapped: no ~4 GiB spike.
+  root.write("/proc/net/dev", net_table(100, 2, 1000));
+  REQUIRE(src.sample(3'000'000'000ULL).ok());
+  REQUIRE(src.devices()[0].rx_bytes_per_s == 0.0);
+  REQUIRE(src.devices()[0].rx_drops_per_s == 0.0);
+  REQUIRE(src.devices()[0].tx_bytes_per_s == 700.0);
+}
+
+namespace {
+
+std::string cpu_stat(unsigned long long usage_usec, unsigned long long periods, unsigned long long throttled) {
+  char text[256];
+  std::snprintf(text, sizeof(text),
+                "usage_usec %llu\nuser_usec 0\nsystem_usec 0\nnr_periods %llu\nnr_throttled %llu\nthrottled_usec 0\n",
+                usage_usec, periods, throttled);
+  return text;
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("CgroupSource normalizes CPU to the quota and memory to memory.max") {
+  FixtureRoot root;
+  root.mkdir("/proc/self");
+  root.mkdir("/sys/fs/cgroup/docker/abc");
+  root.write("/sys/fs/cgroup/cgroup.controllers", "cpuset cpu io memory pids\n");
+  root.write("/proc/self/cgroup", "12:cpu,cpuacct:/docker/abc\n0::/docker/abc\n");
+  const char* dir = "/sys/fs/cgroup/docker/abc";
+  auto put = [&](const char* file, const std::string& text) { root.write((std::string(dir) + file).c_str(), text); };
+  put("/cpu.stat", cpu_stat(1000000, 10, 0));
+  put("/cpu.max", "150000 100000\n");
+  put("/memory.current", "629145600\n");
+  put("/memory.max", "1073741824\n");
+  put("/memory.stat", "anon 400000000\nfile 200000000\ninactive_file 104857600\nactive_file 1000\n");
+  put("/io.stat", "8:0 rbytes=1000 wbytes=0 rios=1 wios=0 dbytes=0 dios=0\n"
+                  "259:0 rbytes=5000 wbytes=100 rios=5 wios=1 dbytes=0 dios=0\n");
+
+  telemetry::metrics::CgroupConfig cfg{};
+  cfg.root = root.path.c_str();
+  telemetry::metrics::CgroupSource src(cfg);
+  REQUIRE(src.dir() == root.path + dir);
+  telemetry::MetricsSnapshot snap{};
+  snap.mem_total_kb = 16 * 1024 * 1024;  // the host, as /proc/meminfo reports it
+  snap.mem_available_kb = 8 * 1024 * 1024;
+  REQUIRE(src.sample(snap, 1'000'000'000ULL).ok());
+  REQUIRE(snap.cpu_usage_pct == 0.0);
+
+  // One second later: 0.75 s of CPU against a 1.5 CPU quota; throttled in 5 of 10 periods.
+  put("/cpu.stat", cpu_stat(1750000, 20, 5));
+  put("/io.stat", "8:0 rbytes=2000 wbytes=0 rios=2 wios=0 dbytes=0 dios=0\n"
+                  "259:0 rbytes=6000 wbytes=100 rios=6 wios=1 dbytes=0 dios=0\n");
+  REQUIRE(src.sample(snap, 2'000'000'000ULL).ok());
+  const telemetry::metrics::CgroupStats& s = src.stats();
+  REQUIRE(std::string(s.name) == "/docker/abc");
+  REQUIRE(s.cpu_limit_cores == 1.5);
+  REQUIRE(s.cpu_pct == 50.0);
+  REQUIRE(s.cpu_throttled_pct == 50.0);
+  REQUIRE(s.memory_working_set_bytes == 524288000);
+  REQUIRE(s.io_read_bytes_per_s == 2000.0);
+  REQUIRE(s.io_reads_per_s == 2.0);
+  REQUIRE(s.io_write_bytes_per_s == 0.0);
+  REQUIRE(snap.cpu_usage_pct == 50.0);
+  REQUIRE(snap.mem_total_kb == 1048576);
+  REQUIRE(snap.mem_available_kb == 1048576 - 512000);
+
+  std::string om;
+  src.append_openmetrics(om);
+  REQUIRE(om.find("telemetry_cgroup_cpu_usage_percent{cgroup=\"/docker/abc\"} 50.00\n") != std::string::npos);
+  REQUIRE(om.find("telemetry_cgroup_memory_max_bytes{cgroup=\"/docker/abc\"} 1073741824\n") != std::string::npos);
+
+  // A failed io.stat read leaves no baseline: the next good read primes instead of
+  // reporting the whole counter as one second's worth.
+  put("/io.stat", "");
+  REQUIRE(src.sample(snap, 3'000'000'000ULL).ok());
+  put("/io.stat", "8:0 rbytes=3000 wbytes=0 rios=3 wios=0 dbytes=0 dios=0\n"
+                  "259:0 rbytes=7000 wbytes=100 rios=7 wios=1 dbytes=0 dios=0\n");
+  REQUIRE(src.sample(snap, 4'000'000'000ULL).ok());
+  REQUIRE(src.stats().io_read_bytes_per_s == 0.0);
+  put("/io.stat", "8:0 rbytes=3500 wbytes=0 rios=4 wios=0 dbytes=0 dios=0\n"
+                  "259:0 rbytes=7000 wbytes=100 rios=7 wios=1 dbytes=0 dios=0\n");
+  REQUIRE(src.sample(snap, 5'000'000'000ULL).ok());
+  REQUIRE(src.stats().io_read_bytes_per_s == 500.0);
+  REQUIRE(src.stats().io_reads_per_s == 1.0);
+}
+
+TELEMETRY_TEST_CASE("CgroupSource follows child groups and leaves unlimited memory to the host") {
+  FixtureRoot root;
+  telemetry::metrics::CgroupConfig cfg{};
+  cfg.root = root.path.c_str();
+  cfg.path = "/system.slice/";
+  cfg.children = true;
+  {
+    // No cgroup2 mount (a v1-only host): Unavailable, which the collector tolerates.
+    telemetry::metrics::CgroupSource none(cfg);
+    telemetry::MetricsSnapshot snap{};
+    REQUIRE(none.dir().empty());
+    REQUIRE(none.collect(snap).code == telemetry::StatusCode::kUnavailable);
+  }
+
+  // Hybrid layout: cgroup2 under unified/.
+  const std::string base = "/sys/fs/cgroup/unified/system.slice";
+  root.mkdir((base + "/a.service").c_str());
+  root.mkdir((base + "/b.scope").c_str());
+  root.write("/sys/fs/cgroup/unified/cgroup.controllers", "cpu memory\n");
+  root.write((base + "/cgroup.procs").c_str(), "");
+  root.write((base + "/cpu.stat").c_str(), cpu_stat(0, 0, 0));
+  root.write((base + "/cpu.max").c_str(), "max 100000\n");
+  root.write((base + "/cpuset.cpus.effective").c_str(), "0-1,4\n");
+  root.write((base + "/memory.current").c_str(), "1000\n");
+  root.write((base + "/memory.max").c_str(), "max\n");
+  root.write((base + "/a.service/cpu.stat").c_str(), cpu_stat(0, 0, 0));
+  root.write((base + "/a.service/cpu.max").c_str(), "50000 100000\n");
+  root.write((base + "/a.service/memory.max").c_str(), "4096\n");
+  root.write((base + "/b.scope/cpu.stat").c_str(), cpu_stat(0, 0, 0));
+
+  telemetry::metrics::CgroupSource src(cfg);
+  REQUIRE(src.dir() == root.path + base);
+  telemetry::MetricsSnapshot snap{};
+  snap.mem_total_kb = 1000;
+  snap.mem_available_kb = 600;
+  REQUIRE(src.sample(snap, 1'000'000'000ULL).ok());
+  REQUIRE(src.children().size() == 2);
+
+  root.write((base + "/cpu.stat").c_str(), cpu_stat(1500000, 0, 0));
+  root.write((base + "/a.service/cpu.stat").c_str(), cpu_stat(250000, 0, 0));
+  root.remove((base + "/b.scope").c_str());
+  root.mkdir((base + "/c.scope").c_str());
+  root.write((base + "/c.scope/cpu.stat").c_str(), cpu_stat(99000000, 0, 0));
+  REQUIRE(src.sample(snap, 2'000'000'000ULL).ok());
+  REQUIRE(src.stats().cpu_limit_cores == 3.0);  // no quota: the cpuset
+  REQUIRE(src.stats().cpu_pct == 50.0);
+  REQUIRE(snap.cpu_usage_pct == 50.0);
+  REQUIRE(snap.mem_total_kb == 1000);
+  REQUIRE(snap.mem_available_kb == 600);
+
+  REQUIRE(src.children().size() == 2);
+  const telemetry::metrics::CgroupStats* a = nullptr;
+  const telemetry::metrics::CgroupStats* c = nullptr;
+  for (const auto& child : src.children()) {
+    if (std::string(child.name) == "/system.slice/a.service") a = &child;
+    if (std::string(child.name) == "/system.slice/c.scope") c = &child;
+  }
+  REQUIRE(a != nullptr);
+  REQUIRE(c != nullptr);
+  REQUIRE(a->cpu_limit_cores == 0.5);
+  REQUIRE(a->cpu_pct == 50.0);
+  REQUIRE(a->memory_max_bytes == 4096);
+  REQUIRE(c->cpu_pct == 0.0);  // first sample of a new group
+  REQUIRE(src.untracked_children() == 0);
+
+  std::string detail;
+  REQUIRE(src.append_detail_json(detail));
+  REQUIRE(detail.find("{\"cgroup\":\"/system.slice\",\"cpu_pct\":50.00,") == 0);
+  REQUIRE(detail.find("\"children\":[{\"cgroup\":\"/system.slice/") != std::string::npos);
+  REQUIRE(detail.find("b.scope") == std::string::npos);
+  REQUIRE(detail.back() == '}');
+  std::string om;
+  src.append_openmetrics(om);
+  REQUIRE(om.find("telemetry_cgroup_cpu_limit_cores{cgroup=\"/system.slice/a.service\"} 0.50\n") != std::string::npos);
+  // Only limited groups get a memory.max sample.
+  REQUIRE(om.find("telemetry_cgroup_memory_max_bytes{cgroup=\"/system.slice\"}") == std::string::npos);
+  REQUIRE(om.find("telemetry_cgroup_memory_max_bytes{cgroup=\"/system.slice/a.service\"} 4096\n") != std::string::npos);
+}
+
+TELEMETRY_TEST_CASE("PressureSource turns stall totals into interval percentages") {
+  FixtureRoot root;
+  root.mkdir("/proc/pressure");
+  root.write("/proc/pressure/io", "some avg10=3.10 avg60=2.45 avg300=1.90 total=1000000\n"
+                                  "full avg10=1.05 avg60=0.90 avg300=0.70 total=500000\n");
+  // Kernels before 5.13 have no "full" line for cpu.
+  root.write("/proc/pressure/cpu", "some avg10=0.50 avg60=0.25 avg300=0.10 total=0\n");
+  telemetry::metrics::PressureSource src(root.path.c_str());
+  REQUIRE(src.sample(1'000'000'000ULL).ok());
+
+  // Two seconds later: 300 ms of partial and 100 ms of full io stall.
+  root.write("/proc/pressure/io", "some avg10=9.00 avg60=3.00 avg300=2.00 total=1300000\n"
+                                  "full avg10=4.00 avg60=1.00 avg300=0.80 total=600000\n");
+  REQUIRE(src.sample(3'000'000'000ULL).ok());
+  using telemetry::metrics::PressureResource;
+  const telemetry::metrics::PressureStats& io = src.stats(PressureResource::kIo);
+  REQUIRE(io.available);
+  REQUIRE(io.some_avg10 == 9.0);
+  REQUIRE(io.some_stalled_pct == 15.0);
+  REQUIRE(io.full_stalled_pct == 5.0);
+  REQUIRE(src.stats(PressureResource::kCpu).available);
+  REQUIRE(src.stats(PressureResource::kCpu).full_avg10 == 0.0);
+  REQUIRE_FALSE(src.stats(PressureResource::kMemory).available);
+
+  std::string detail;
+  REQUIRE(src.append_detail_json(detail));
+  REQUIRE(detail.find("{\"cpu\":{") == 0);
+  REQUIRE(detail.find("\"memory\"") == std::string::npos);
+  std::string om;
+  src.append_openmetrics(om);
+  REQUIRE(om.find("telemetry_pressure_stalled_percent{resource=\"io\",kind=\"some\"} 15.00\n") != std::string::npos);
+
+  telemetry::metrics::PressureSource none((root.path + "/missing").c_str());
+  REQUIRE(none.sample(1'000'000'000ULL).code == telemetry::StatusCode::kUnavailable);
+  REQUIRE_FALSE(none.append_detail_json(detail));
+}
+
+TELEMETRY_TEST_CASE("PSI trigger specs are parsed and armed by writing the pressure file") {
+  telemetry::metrics::PressureTriggerConfig cfg{};
+  REQUIRE(telemetry::metrics::parse_pressure_trigger("io:full:250/2000", cfg).ok());
+  REQUIRE(cfg.resource == telemetry::metrics::PressureResource::kIo);
+  REQUIRE(cfg.full);
+  REQUIRE(cfg.stall_us == 250000);
+  REQUIRE(cfg.window_us == 2000000);
+  for (const char* bad : {"disk:some:1/1000", "cpu:most:1/1000", "cpu:some:1", "cpu:some:1/100", "cpu:some:0/1000",
+                          "cpu:some:2000/1000", "cpu:some:1/1000x", "cpu:some:/1000"}) {
+    REQUIRE(telemetry::metrics::parse_pressure_trigger(bad, cfg).code == telemetry::StatusCode::kInvalidArgument);
+  }
+
+  FixtureRoot root;
+  root.mkdir("/proc/pressure");
+  root.write("/proc/pressure/memory", "");
+  REQUIRE(telemetry::metrics::parse_pressure_trigger("memory:some:150/1000", cfg).ok());
+  telemetry::metrics::PressureTrigger trigger(cfg, root.path.c_str());
+  REQUIRE(trigger.fd() < 0);
+  REQUIRE(trigger.open().ok());
+  REQUIRE(trigger.fd() >= 0);
+  REQUIRE(std::string(trigger.name()) == "psi_memory_some");
+  char written[64] = {};
+  REQUIRE(::pread(trigger.fd(), written, sizeof(written) - 1, 0) > 0);
+  REQUIRE(std::string(written) == "some 150000 1000000");
+
+  REQUIRE_FALSE(trigger.on_ready(POLLIN));
+  REQUIRE(trigger.on_ready(POLLPRI));
+  REQUIRE(trigger.fired() == 1);
+  REQUIRE_FALSE(trigger.on_ready(POLLERR));
+  REQUIRE(trigger.fd() < 0);
+
+  telemetry::metrics::PressureTrigger missing(cfg, (root.path + "/missing").c_str());
+  REQUIRE(missing.open().code == telemetry::StatusCode::kUnavailable);
+}
+
+namespace {
+
+// /proc/<pid>/stat with the fields ProcessSource reads; tpgid is -1 as for daemons.
+void write_stat(const FixtureRoot& root, int pid, const char* comm, unsigned long long utime, unsigned long long stime,
+                unsigned long long start_time, unsigned long long rss_pages) {
+  char dir[64];
+  std::snprintf(dir, sizeof(dir), "/proc/%d", pid);
+  root.mkdir(dir);
+  char line[512];
+  std::snprintf(line, sizeof(line),
+                "%d (%s) S 1 %d %d 0 -1 4194560 100 0 0 0 %llu %llu 0 0 20 0 1 0 %llu 10485760 %llu "
+                "18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 0 17 0 0 0 0 0 0\n",
+                pid, comm, pid, pid, utime, stime, start_time, rss_pages);
+  root.write((std::string(dir) + "/stat").c_str(), line);
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("ProcessSource ranks processes by CPU and follows pid reuse and exits") {
+  FixtureRoot root;
+  root.mkdir("/proc/self");
+  const double hz = static_cast<double>(::sysconf(_SC_CLK_TCK));
+  const auto page = static_cast<unsigned long long>(::sysconf(_SC_PAGESIZE));
+  write_stat(root, 10, "idle", 0, 0, 100, 1000);
+  write_stat(root, 20, "busy worker", 100, 100, 200, 10);
+  write_stat(root, 30, "a) b", 5, 5, 300, 500);
+  write_stat(root, 40, "quiet", 0, 0, 400, 1);
+
+  telemetry::metrics::ProcessSourceConfig cfg{};
+  cfg.root = root.path.c_str();
+  cfg.top_n = 3;
+  telemetry::metrics::ProcessSource src(cfg);
+  REQUIRE(src.sample(1'000'000'000ULL).ok());
+  REQUIRE(src.passes() == 1);
+  REQUIRE(src.processes() == 4);
+  // No previous counters yet: ranked by memory alone.
+  REQUIRE(src.top().size() == 3);
+  REQUIRE(src.top()[0].pid == 10);
+  REQUIRE(src.top()[0].cpu_pct == 0.0);
+  REQUIRE(src.top()[0].rss_bytes == 1000 * page);
+  REQUIRE(src.top()[1].pid == 30);
+  REQUIRE(std::string(src.top()[1].comm) == "a) b");
+
+  // Two seconds later pid 20 used one core-second (50%) and pid 30 a fifth of that.
+  write_stat(root, 20, "busy worker", 100 + static_cast<unsigned long long>(hz / 2),
+             100 + static_cast<unsigned long long>(hz / 2), 200, 10);
+  write_stat(root, 30, "a) b", 5 + static_cast<unsigned long long>(hz / 5), 5, 300, 500);
+  REQUIRE(src.sample(3'000'000'000ULL).ok());
+  REQUIRE(src.top()[0].pid == 20);
+  REQUIRE(std::string(src.top()[0].comm) == "busy worker");
+  REQUIRE(src.top()[0].cpu_pct > 49.9);
+  REQUIRE(src.top()[0].cpu_pct < 50.1);
+  REQUIRE(src.top()[1].pid == 30);
+  REQUIRE(src.top()[1].cpu_pct > 9.9);
+  REQUIRE(src.top()[1].cpu_pct < 10.1);
+  REQUIRE(src.top()[2].pid == 10);
+
+  // pid 20 exits and its pid is reused by a new process with a lower tick count; pid 40 exits.
+  write_stat(root, 20, "new", 1, 0, 900, 10);
+  root.remove("/proc/40");
+  REQUIRE(src.sample(4'000'000'000ULL).ok());
+  REQUIRE(src.processes() == 3);
+  for (const telemetry::metrics::ProcessSample& p : src.top()) REQUIRE(p.cpu_pct == 0.0);
+  REQUIRE(std::string(src.top()[2].comm) == "new");
+
+  std::string detail;
+  REQUIRE(src.append_detail_json(detail));
+  REQUIRE(detail.find("{\"processes\":3,\"untracked\":0,\"top\":[{\"pid\":10,\"comm\":\"idle\",") == 0);
+  std::string om;
+  src.append_openmetrics(om);
+  REQUIRE(om.find("telemetry_process_resident_bytes{pid=\"30\",comm=\"a) b\"} ") != std::string::npos);
+
+  telemetry::metrics::ProcessSourceConfig missing_cfg{};
+  missing_cfg.root = "/nonexistent";
+  telemetry::metrics::ProcessSource missing(missing_cfg);
+  REQUIRE(missing.sample(1'000'000'000ULL).code == telemetry::StatusCode::kUnavailable);
+  REQUIRE_FALSE(missing.append_detail_json(detail));
+}
+
+TELEMETRY_TEST_CASE("ProcessSource spreads a pass over ticks and bounds its table") {
+  FixtureRoot root;
+  for (int pid = 1; pid <= 5; ++pid) write_stat(root, pid, "worker", 0, 0, 100, static_cast<unsigned long long>(pid));
+
+  telemetry::metrics::ProcessSourceConfig cfg{};
+  cfg.root = root.path.c_str();
+  cfg.max_per_tick = 2;
+  cfg.max_processes = 3;
+  telemetry::metrics::ProcessSource src(cfg);
+  REQUIRE(src.sample(1'000'000'000ULL).ok());
+  REQUIRE(src.passes() == 0);
+  REQUIRE(src.top().empty());
+  REQUIRE(src.sample(2'000'000'000ULL).ok());
+  REQUIRE(src.passes() == 0);
+  REQUIRE(src.sample(3'000'000'000ULL).ok());
+  REQUIRE(src.passes() == 1);
+  REQUIRE(src.processes() == 5);
+  REQUIRE(src.untracked() == 2);
+  REQUIRE(src.top().size() == 5);
+  REQUIRE(src.top()[0].pid == 5);
+
+  // Exits free table slots for the processes that had none.
+  root.remove("/proc/1");
+  root.remove("/proc/2");
+  root.remove("/proc/3");
+  for (int i = 0; i < 3 && src.passes() == 1; ++i) REQUIRE(src.sample(4'000'000'000ULL).ok());
+  REQUIRE(src.passes() == 2);
+  REQUIRE(src.processes() == 2);
+  for (int i = 0; i < 3 && src.passes() == 2; ++i) REQUIRE(src.sample(5'000'000'000ULL).ok());
+  REQUIRE(src.untracked() == 0);
+}
+
+TELEMETRY_TEST_CASE("NumaSource groups CPUs by node and turns numastat into rates") {
+  FixtureRoot root;
+  root.mkdir("/sys/devices/system/node/node0");
+  root.mkdir("/sys/devices/system/node/node2");
+  // Node ids need not be contiguous; cpu4 is listed by no node.
+  root.write("/sys/devices/system/node/online", "0,2\n");
+  root.write("/sys/devices/system/node/node0/cpulist", "0-1\n");
+  root.write("/sys/devices/system/node/node2/cpulist", "2-3\n");
+  root.write("/sys/devices/system/node/node0/meminfo", "Node 0 MemTotal:  1000 kB\nNode 0 MemFree:  100 kB\n"
+                                                       "Node 0 FilePages:  300 kB\nNode 0 AnonPages:  500 kB\n");
+  root.write("/sys/devices/system/node/node2/meminfo", "Node 2 MemTotal:  2000 kB\nNode 2 MemFree:  1900 kB\n");
+  const auto numastat = [&](const char* node, unsigned long long hit, unsigned long long other) {
+    char text[256];
+    std::snprintf(text, sizeof(text),
+                  "numa_hit %llu\nnuma_miss 0\nnuma_foreign 0\ninterleave_hit 0\nlocal_node %llu\nother_node %llu\n", hit,
+                  hit, other);
+    root.write((std::string("/sys/devices/system/node/") + node + "/numastat").c_str(), text);
+  };
+  numastat("node0", 1000, 10);
+  numastat("node2", 5000, 0);
+  root.write("/proc/stat", "cpu  0 0 0 0 0 0 0 0 0 0\ncpu0 0 0 0 100 0 0 0 0 0 0\ncpu1 0 0 0 100 0 0 0 0 0 0\n"
+                           "cpu2 0 0 0 100 0 0 0 0 0 0\ncpu3 0 0 0 100 0 0 0 0 0 0\ncpu4 0 0 0 100 0 0 0 0 0 0\n"
+                           "intr 1 2 3\n");
+
+  telemetry::metrics::NumaSource src(root.path.c_str());
+  REQUIRE(src.numa());
+  REQUIRE(src.nodes().size() == 2);
+  REQUIRE(src.cpu_node(1) == 0);
+  REQUIRE(src.cpu_node(3) == 2);
+  REQUIRE(src.cpu_node(4) == -1);
+  REQUIRE(src.sample(1'000'000'000ULL).ok());
+  REQUIRE(src.nodes()[0].cpus == 2);
+  REQUIRE(src.nodes()[0].mem_free_kb == 100);
+  REQUIRE(src.nodes()[0].file_pages_kb == 300);
+  REQUIRE(src.nodes()[0].anon_pages_kb == 500);
+  REQUIRE(src.nodes()[1].node == 2);
+  REQUIRE(src.nodes()[1].mem_total_kb == 2000);
+
+  // Two seconds later cpu0 was busy for 100 more ticks and every other CPU idle.
+  root.write("/proc/stat", "cpu  0 0 0 0 0 0 0 0 0 0\ncpu0 100 0 0 100 0 0 0 0 0 0\ncpu1 0 0 0 200 0 0 0 0 0 0\n"
+                           "cpu2 0 0 0 200 0 0 0 0 0 0\ncpu3 0 0 0 200 0 0 0 0 0 0\ncpu4 0 0 0 200 0 0 0 0 0 0\n");
+  numastat("node0", 1400, 210);
+  REQUIRE(src.sample(3'000'000'000ULL).ok());
+  REQUIRE(src.cpu_pct(0) == 100.0);
+  REQUIRE(src.cpu_pct(1) == 0.0);
+  REQUIRE(src.nodes()[0].cpu_pct == 50.0);
+  REQUIRE(src.nodes()[1].cpu_pct == 0.0);
+  REQUIRE(src.nodes()[0].has_numastat);
+  REQUIRE(src.nodes()[0].numa_hit_per_s == 200.0);
+  REQUIRE(src.nodes()[0].other_node_per_s == 100.0);
+
+  std::string detail;
+  REQUIRE(src.append_detail_json(detail));
+  REQUIRE(detail.find("\"cores\":[{\"cpu\":0,\"pct\":100.00},{\"cpu\":1,\"pct\":0.00}]") != std::string::npos);
+  REQUIRE(detail.find("{\"node\":2,\"cpus\":2,") != std::string::npos);
+  std::string om;
+  src.append_openmetrics(om);
+  REQUIRE(om.find("telemetry_numa_cpu_percent{node=\"0\"} 50.00\n") != std::string::npos);
+  REQUIRE(om.find("telemetry_numa_allocations_per_second{node=\"0\",kind=\"remote\"} 100.00\n") != std::string::npos);
+  REQUIRE(om.find("telemetry_cpu_core_percent{cpu=\"4\",node=\"-1\"} 0.00\n") != std::string::npos);
+}
+
+TELEMETRY_TEST_CASE("NumaSource degrades to one node without sysfs topology") {
+  FixtureRoot root;
+  root.write("/proc/stat", "cpu  0 0 0 0 0 0 0 0 0 0\ncpu0 0 0 0 100 0 0 0 0 0 0\ncpu1 0 0 0 100 0 0 0 0 0 0\n");
+  root.write("/proc/meminfo", "MemTotal:  8000 kB\nMemFree:  1000 kB\nMemAvailable:  4000 kB\nBuffers:  200 kB\n"
+                              "Cached:  1800 kB\nAnonPages:  3000 kB\n");
+  telemetry::metrics::NumaSource src(root.path.c_str());
+  REQUIRE_FALSE(src.numa());
+  REQUIRE(src.sample(1'000'000'000ULL).ok());
+  REQUIRE(src.nodes().size() == 1);
+  const telemetry::metrics::NumaNodeStats& node = src.nodes()[0];
+  REQUIRE(node.node == 0);
+  REQUIRE(node.cpus == 2);
+  REQUIRE(node.mem_total_kb == 8000);
+  REQUIRE(node.file_pages_kb == 2000);
+  REQUIRE(node.anon_pages_kb == 3000);
+  REQUIRE_FALSE(node.has_numastat);
+  std::string detail;
+  REQUIRE(src.append_detail_json(detail));
+  REQUIRE(detail.find("{\"numa\":false,") == 0);
+  REQUIRE(detail.find("numa_hit") == std::string::npos);
+
+  telemetry::metrics::NumaSource missing((root.path + "/missing").c_str());
+  REQUIRE(missing.sample(1'000'000'000ULL).code == telemetry::StatusCode::kUnavailable);
+  REQUIRE_FALSE(missing.append_detail_json(detail));
+}
+
+TELEMETRY_TEST_CASE("scan_counters agrees with the scalar scanner across block boundaries") {
+  std::uint32_t seed = 12345;
+  const auto next = [&]() {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+  };
+  for (int round = 0; round < 2000; ++round) {
+    std::string row;
+    const int fields = static_cast<int>(next() % 40);
+    for (int i = 0; i < fields; ++i) {
+      row.append(next() % 7 + 1, next() % 5 == 0 ? '\t' : ' ');
+      const unsigned digits = next() % 20 + 1;
+      for (unsigned d = 0; d < digits; ++d) row.push_back(static_cast<char>('0' + next() % 10));
+    }
+    if (next() % 2) row.append("   PCI-MSI 524288-edge      eth0-TxRx-0");
+    if (next() % 2) row.push_back('\n');
+    row.append(16, '\0');  // the slack scan_counters may read past the NUL
+    const std::size_t max = next() % 48;
+
+    std::uint64_t simd[48] = {};
+    std::uint64_t scalar[48] = {};
+    const char* p = row.c_str();
+    const char* q = row.c_str();
+    const std::size_t n = telemetry::metrics::scan_counters(p, simd, max);
+    REQUIRE(n == telemetry::metrics::scan_counters_scalar(q, scalar, max));
+    REQUIRE(p == q);
+    for (std::size_t i = 0; i < n; ++i) REQUIRE(simd[i] == scalar[i]);
+  }
+}
+
+TELEMETRY_TEST_CASE("InterruptsSource ranks hot IRQs and splits rates per CPU") {
+  FixtureRoot root;
+  const auto interrupts = [&](unsigned long long eth0, unsigned long long nvme, unsigned long long loc) {
+    char text[1024];
+    std::snprintf(text, sizeof(text),
+                  "           CPU0       CPU1       CPU2\n"
+                  "  0:         35          0          0   IO-APIC   2-edge      timer\n"
+                  " 26:   %8llu          0         10   PCI-MSI 524288-edge      eth0-TxRx-0\n"
+                  " 27:   %8llu   %8llu          0   PCI-MSI 65537-edge      nvme0q1\n"
+                  "LOC:   %8llu   %8llu   %8llu   Local timer interrupts\n"
+                  "ERR:          3\n",
+                  eth0, nvme, nvme, loc, loc, loc);
+    root.write("/proc/interrupts", text);
+  };
+  const auto softirqs = [&](unsigned long long net_rx) {
+    char text[512];
+    // One more possible CPU than online ones, as on hosts with offlined CPUs.
+    std::snprintf(text, sizeof(text),
+                  "                    CPU0       CPU1       CPU2       CPU3\n"
+                  "       TIMER:        100        100        100          0\n"
+                  "      NET_RX:   %8llu          0          0          0\n",
+                  net_rx);
+    root.write("/proc/softirqs", text);
+  };
+  interrupts(1000, 500, 100);
+  softirqs(50);
+
+  telemetry::metrics::InterruptsConfig cfg{};
+  cfg.root = root.path.c_str();
+  cfg.top_k = 2;
+  telemetry::metrics::InterruptsSource src(cfg);
+  REQUIRE(src.sample(1'000'000'000ULL).ok());
+  REQUIRE(src.top().empty());
+
+  // Two seconds later: eth0 took 20000 interrupts, all on CPU0; nvme 1000 per CPU on 0 and 1.
+  interrupts(21000, 1500, 300);
+  softirqs(4050);
+  REQUIRE(src.sample(3'000'000'000ULL).ok());
+  REQUIRE(src.top().size() == 2);
+  REQUIRE(std::string(src.top()[0].irq) == "26");
+  REQUIRE(std::string(src.top()[0].desc) == "PCI-MSI 524288-edge eth0-TxRx-0");
+  REQUIRE(src.top()[0].per_s == 10000.0);
+  REQUIRE(src.top()[0].top_cpu == 0);
+  REQUIRE(src.top()[0].top_cpu_pct == 100.0);
+  REQUIRE(std::string(src.top()[1].irq) == "27");
+  REQUIRE(src.top()[1].top_cpu_pct == 50.0);
+  REQUIRE(src.irq_per_s() == 10000.0 + 1000.0 + 300.0);
+  REQUIRE(src.cpus().size() == 3);
+  REQUIRE(src.cpus()[0].irq_per_s == 10000.0 + 500.0 + 100.0);
+  REQUIRE(src.cpus()[2].irq_per_s == 100.0);
+  REQUIRE(src.cpus()[0].net_rx_per_s == 2000.0);
+  REQUIRE(src.cpus()[0].softirq_per_s == 2000.0);
+  REQUIRE(src.softirqs().size() == 2);
+  REQUIRE(std::string(src.softirqs()[1].irq) == "NET_RX");
+  REQUIRE(src.softirqs()[1].per_s == 2000.0);
+
+  // CPU2 goes offline: its column disappears, so rates restart from the next sample.
+  root.write("/proc/interrupts", "           CPU0       CPU1\n"
+                                 " 26:   41000          0   PCI-MSI 524288-edge      eth0-TxRx-0\n");
+  REQUIRE(src.sample(4'000'000'000ULL).ok());
+  REQUIRE(src.top().empty());
+  REQUIRE(src.cpus().size() == 2);
+  root.write("/proc/interrupts", "           CPU0       CPU1\n"
+                                 " 26:   42000          0   PCI-MSI 524288-edge      eth0-TxRx-0\n");
+  REQUIRE(src.sample(5'000'000'000ULL).ok());
+  REQUIRE(src.top().size() == 1);
+  REQUIRE(src.top()[0].per_s == 1000.0);
+
+  std::string detail;
+  REQUIRE(src.append_detail_json(detail));
+  REQUIRE(detail.find("{\"irq_per_s\":1000.00,\"untracked\":0,\"top\":[{\"irq\":\"26\",") == 0);
+  std::string om;
+  src.append_openmetrics(om);
+  REQUIRE(om.find("telemetry_irq_top_cpu_percent{irq=\"26\",cpu=\"0\"} 100.00\n") != std::string::npos);
+  REQUIRE(om.find("telemetry_cpu_interrupts_per_second{cpu=\"1\",kind=\"hard\"} 0.00\n") != std::string::npos);
+
+  telemetry::metrics::InterruptsConfig missing_cfg{};
+  missing_cfg.root = "/nonexistent";
+  telemetry::metrics::InterruptsSource missing(missing_cfg);
+  REQUIRE(missing.sample(1'000'000'000ULL).code == telemetry::StatusCode::kUnavailable);
+  REQUIRE_FALSE(missing.append_detail_json(detail));
+}
+
+TELEMETRY_TEST_CASE("InterruptsSource rates match a full parse as rows change and move") {
+  FixtureRoot root;
+  root.write("/proc/softirqs", "");
+  constexpr int kCpus = 8;
+  struct Row {
+    int label;
+    bool present;
+    bool was_present;
+    int desc;
+    unsigned long long counts[kCpus];
+    unsigned long long prev[kCpus];
+  };
+  std::vector<Row> rows(12);
+  std::uint32_t seed = 777;
+  const auto next = [&]() {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+  };
+  for (std::size_t i = 0; i < rows.size(); ++i) {
+    rows[i] = Row{static_cast<int>(i * 3), true, false, 0, {}, {}};
+    for (auto& c : rows[i].counts) c = next() % 1000;
+  }
+  unsigned long long err = 0;
+  unsigned long long prev_err = 0;
+  const auto write = [&]() {
+    std::string text = "    ";
+    char cell[64];
+    for (int c = 0; c < kCpus; ++c) {
+      std::snprintf(cell, sizeof(cell), "       CPU%d", c);
+      text += cell;
+    }
+    text += '\n';
+    for (const Row& r : rows) {
+      if (!r.present) continue;
+      std::snprintf(cell, sizeof(cell), "%3d:", r.label);
+      text += cell;
+      for (unsigned long long c : r.counts) {
+        std::snprintf(cell, sizeof(cell), " %10llu", c);
+        text += cell;
+      }
+      std::snprintf(cell, sizeof(cell), "  PCI-MSI %d-edge      dev%d\n", r.label, r.desc);
+      text += cell;
+    }
+    std::snprintf(cell, sizeof(cell), "ERR: %10llu\n", err);
+    text += cell;
+    root.write("/proc/interrupts", text);
+  };
+
+  write();
+  telemetry::metrics::InterruptsConfig cfg{};
+  cfg.root = root.path.c_str();
+  telemetry::metrics::InterruptsSource src(cfg);
+  REQUIRE(src.sample(1'000'000'000ULL).ok());
+  for (int round = 2; round < 60; ++round) {
+    for (Row& r : rows) {
+      r.was_present = r.present;
+      for (int c = 0; c < kCpus; ++c) r.prev[c] = r.counts[c];
+      // Most cells stay put; some tick, some jump by digits, and rows come, go and get renamed.
+      for (auto& c : r.counts) {
+        const unsigned roll = next() % 16;
+        if (roll < 3) c += next() % 10;
+        if (roll == 3) c += next() % 100000000;
+      }
+      if (next() % 20 == 0) r.present = !r.present;
+      if (next() % 20 == 0) ++r.desc;
+    }
+    prev_err = err;
+    err += next() % 3;
+    write();
+    REQUIRE(src.sample(static_cast<std::uint64_t>(round) * 1'000'000'000ULL).ok());
+
+    // One-second intervals: rates are the deltas of rows present in both samples.
+    double cpu[kCpus] = {};
+    double all = static_cast<double>(err - prev_err);
+    for (const Row& r : rows) {
+      if (!r.present || !r.was_present) continue;
+      for (int c = 0; c < kCpus; ++c) {
+        cpu[c] += static_cast<double>(r.counts[c] - r.prev[c]);
+        all += static_cast<double>(r.counts[c] - r.prev[c]);
+      }
+    }
+    REQUIRE(src.cpus().size() == kCpus);
+    for (int c = 0; c < kCpus; ++c) REQUIRE(src.cpus()[c].irq_per_s == cpu[c]);
+    REQUIRE(src.irq_per_s() == all);
+  }
+}
+
+TELEMETRY_TEST_CASE("DeclaredSource reads every declared file once per sample") {
+  FixtureRoot root;
+  root.mkdir("/sys");
+  root.write("/proc/meminfo", "MemTotal:        4020660 kB\nDirty:              1200 kB\nWriteback:            16 kB\n");
+  root.write("/proc/vmstat", "pgfault 1000\npgmajfault 7\n");
+  root.write("/proc/net/dev", "Inter-|   Receive                            |  Transmit\n"
+                              " face |bytes    packets errs drop fifo frame|bytes    packets\n"
+                              "    lo:    5000      50    0    0    0     0     5000      50\n"
+                              "  eth0:123456789   900    0    0    0     0    64000     400\n");
+  root.write("/sys/entropy", "256\n");
+
+  telemetry::metrics::DeclaredSource src(root.path.c_str());
+  REQUIRE(src.add_metric("dirty_bytes /proc/meminfo key Dirty scale 1024").ok());
+  REQUIRE(src.add_metric("writeback_kb /proc/meminfo key Writeback").ok());
+  REQUIRE(src.add_metric("page_faults_per_second /proc/vmstat key pgfault rate").ok());
+  REQUIRE(src.add_metric("eth0_rx_bytes_per_second /proc/net/dev column 2 row eth0 rate").ok());
+  REQUIRE(src.add_metric("eth0_tx_packets /proc/net/dev column 9 row eth0").ok());
+  REQUIRE(src.add_metric("lo_rx_packets /proc/net/dev column 2 row 5000 keycol 1").ok());
+  REQUIRE(src.add_metric("entropy_bits /sys/entropy value\n").ok());
+  REQUIRE(src.add_metric("swap_bytes /proc/meminfo key SwapCached").ok());
+  REQUIRE(src.size() == 8);
+  REQUIRE(src.files() == 4);
+
+  REQUIRE(src.sample(1'000'000'000ULL).ok());
+  double v = 0.0;
+  REQUIRE(src.value(0, v));
+  REQUIRE(v == 1200.0 * 1024.0);
+  REQUIRE(src.value(1, v));
+  REQUIRE(v == 16.0);
+  REQUIRE_FALSE(src.value(2, v));  // rates need a second sample
+  REQUIRE(src.value(4, v));
+  REQUIRE(v == 400.0);
+  REQUIRE_FALSE(src.value(5, v));  // no line has "5000" as its first field
+  REQUIRE(src.value(6, v));
+  REQUIRE(v == 256.0);
+  REQUIRE_FALSE(src.value(7, v));
+
+  root.write("/proc/vmstat", "pgfault 3000\npgmajfault 7\n");
+  root.write("/proc/net/dev", "Inter-|   Receive                            |  Transmit\n"
+                              " face |bytes    packets errs drop fifo frame|bytes    packets\n"
+                              "  eth0:123556789   900    0    0    0     0    64000     410\n");
+  REQUIRE(src.sample(3'000'000'000ULL).ok());
+  REQUIRE(src.value(2, v));
+  REQUIRE(v == 1000.0);
+  REQUIRE(src.value(3, v));
+  REQUIRE(v == 50000.0);
+  REQUIRE(src.value(4, v));
+  REQUIRE(v == 410.0);
+
+  std::string detail;
+  REQUIRE(src.append_detail_json(detail));
+  REQUIRE(detail == "{\"dirty_bytes\":1228800,\"writeback_kb\":16,\"page_faults_per_second\":1000,"
+                    "\"eth0_rx_bytes_per_second\":50000,\"eth0_tx_packets\":410,\"lo_rx_packets\":null,"
+                    "\"entropy_bits\":256,\"swap_bytes\":null}");
+  std::string om;
+  src.append_openmetrics(om);
+  REQUIRE(om.find("# TYPE telemetry_dirty_bytes gauge\n") != std::string::npos);
+  REQUIRE(om.find("# HELP telemetry_page_faults_per_second Declared from /proc/vmstat (per second).\n") !=
+          std::string::npos);
+  REQUIRE(om.find("telemetry_eth0_rx_bytes_per_second 50000\n") != std::string::npos);
+  REQUIRE(om.find("swap_bytes") == std::string::npos);
+
+  // eth0 goes away, then comes back: its rate restarts instead of spanning the gap.
+  root.write("/proc/net/dev", "Inter-|\n face |\n");
+  REQUIRE(src.sample(4'000'000'000ULL).ok());
+  REQUIRE_FALSE(src.value(3, v));
+  root.write("/proc/net/dev", "Inter-|\n face |\n  eth0:      10     1    0    0    0     0       0       0\n");
+  REQUIRE(src.sample(5'000'000'000ULL).ok());
+  REQUIRE_FALSE(src.value(3, v));
+
+  telemetry::metrics::DeclaredSource missing("/nonexistent");
+  REQUIRE(missing.add_metric("x /proc/vmstat key pgfault").ok());
+  REQUIRE(missing.sample(1'000'000'000ULL).code == telemetry::StatusCode::kUnavailable);
+}
+
+TELEMETRY_TEST_CASE("DeclaredSource rejects malformed declarations with their line") {
+  telemetry::metrics::DeclaredSource src;
+  REQUIRE(src.add_metric("9lives /proc/vmstat key pgfault").code == telemetry::StatusCode::kInvalidArgument);
+  REQUIRE(src.add_metric("a-b /proc/vmstat key pgfault").code == telemetry::StatusCode::kInvalidArgument);
+  REQUIRE(src.add_metric("x proc/vmstat key pgfault").code == telemetry::StatusCode::kInvalidArgument);
+  REQUIRE(src.add_metric("x /proc/vmstat lines").code == telemetry::StatusCode::kInvalidArgument);
+  REQUIRE(src.add_metric("x /proc/vmstat key").code == telemetry::StatusCode::kInvalidArgument);
+  REQUIRE(src.add_metric("x /proc/net/dev column 0 row eth0").code == telemetry::StatusCode::kInvalidArgument);
+  REQUIRE(src.add_metric("x /proc/net/dev column 65 row eth0").code == telemetry::StatusCode::kInvalidArgument);
+  REQUIRE(src.add_metric("x /proc/net/dev column 2 eth0").code == telemetry::StatusCode::kInvalidArgument);
+  REQUIRE(src.add_metric("x /proc/net/dev column 3 row sda keycol 3").code == telemetry::StatusCode::kInvalidArgument);
+  REQUIRE(src.add_metric("x /proc/vmstat key pgfault scale fast").code == telemetry::StatusCode::kInvalidArgument);
+  REQUIRE(src.add_metric("x /proc/vmstat key pgfault keycol 2").code == telemetry::StatusCode::kInvalidArgument);
+  REQUIRE(src.size() == 0);
+  REQUIRE(src.add_metric("x /proc/vmstat key pgfault 1 rate").ok());
+  REQUIRE(src.add_metric("x /proc/stat key ctxt").code == telemetry::StatusCode::kInvalidArgument);
+
+  FixtureRoot root;
+  root.write("/metrics.conf", "# declared metrics\n\n"
+                              "ctxt_per_second /proc/stat key ctxt rate\n"
+                              "  procs_running /proc/stat key procs_running\n"
+                              "bad /proc/stat key ctxt scale\n");
+  telemetry::metrics::DeclaredSource loaded;
+  std::size_t line = 0;
+  REQUIRE(loaded.load_file((root.path + "/metrics.conf").c_str(), &line).code ==
+          telemetry::StatusCode::kInvalidArgument);
+  REQUIRE(line == 5);
+  REQUIRE(loaded.size() == 2);
+  REQUIRE(loaded.files() == 1);
+  REQUIRE(loaded.load_file((root.path + "/missing.conf").c_str()).code == telemetry::StatusCode::kIoError);
+
+  // A line the reader cannot hold whole is rejected, not split into two declarations.
+  root.write("/long.conf", "ctxt_per_second /proc/stat key ctxt rate\n"
+                           "procs_running /proc/stat key procs_running" + std::string(600, ' ') + "\n");
+  telemetry::metrics::DeclaredSource too_long;
+  REQUIRE(too_long.load_file((root.path + "/long.conf").c_str(), &line).code ==
+          telemetry::StatusCode::kInvalidArgument);
+  REQUIRE(line == 2);
+  REQUIRE(too_long.size() == 1);
+}
+
+TELEMETRY_TEST_CASE("FilesystemSource keeps real mounts and re-reads the table only on change") {
+  FixtureRoot root;
+  root.mkdir("/proc/self");
+  root.mkdir("/dev/shm");
+  root.mkdir("/mnt/my disk");
+  root.mkdir("/srv");
+  std::string table = "22 1 8:1 / / rw,relatime shared:1 - ext4 /dev/sda1 rw\n"
+                      "23 22 0:21 / /proc rw,nosuid shared:12 - proc proc rw\n"
+                      "24 22 0:22 / /sys rw,nosuid shared:7 - sysfs sysfs rw\n"
+                      "25 24 0:26 / /sys/fs/cgroup rw shared:9 - cgroup2 cgroup2 rw,nsdelegate\n"
+                      "26 22 0:5 / /dev/shm rw,nosuid,nodev shared:3 - tmpfs tmpfs rw\n"
+                      "27 22 0:50 / /var/lib/docker/overlay2/abc/merged rw - overlay overlay rw,lowerdir=/l\n"
+                      "28 22 0:51 / /mnt/nfs rw shared:40 - nfs4 server:/export rw,vers=4.2\n"
+                      "29 22 8:1 /srv /srv rw,relatime shared:1 - ext4 /dev/sda1 rw\n"
+                      "30 22 8:2 / /mnt/my\\040disk rw,relatime shared:41 master:2 - ext4 /dev/sdb\"1 rw\n"
+                      "31 22 8:3 / /missing rw,relatime - xfs /dev/sdc1 rw\n"
+                      "33 26 0:6 / /dev/shm rw,nosuid,nodev - tmpfs shm rw,size=65536k\n"
+                      "34 22 0:52 / /mnt/s3 rw - fuse.s3fs s3fs rw\n"
+                      "35 22 0:53 / /lustre rw - lustre 10.0.0.1@tcp:/fs rw\n"
+                      "36 22 0:54 / /gpfs rw - gpfs gpfs0 rw\n"
+                      "37 22 0:55 / /afs rw - afs AFS rw\n"
+                      "38 22 0:56 / /mnt/dav rw - davfs https://dav.example rw\n"
+                      "39 22 0:57 / /mnt/odd rw - somefs server:/vol rw\n"
+                      "40 22 0:58 / /mnt/share rw - unknownfs //host/share rw\n";
+  root.write("/proc/self/mountinfo", table);
+
+  telemetry::metrics::FilesystemSource src(root.path.c_str());
+  REQUIRE(src.mount_watch().fd() >= 0);
+  REQUIRE(src.mount_watch().events() == POLLPRI);
+  REQUIRE(src.sample(1'000'000'000ULL).ok());
+  REQUIRE(src.mount_table_parses() == 1);
+  const auto& fs = src.filesystems();
+  REQUIRE(fs.size() == 4);
+  REQUIRE(std::string(fs[0].mount) == "/");
+  REQUIRE(std::string(fs[0].fstype) == "ext4");
+  REQUIRE(std::string(fs[0].device) == "/dev/sda1");
+  REQUIRE(std::string(fs[1].mount) == "/dev/shm");
+  REQUIRE(std::string(fs[1].device) == "shm");  // the mount on top
+  REQUIRE(std::string(fs[2].mount) == "/mnt/my disk");
+  REQUIRE(std::string(fs[2].device) == "/dev/sdb_1");
+  REQUIRE(std::string(fs[3].mount) == "/missing");
+  for (int i = 0; i < 3; ++i) {
+    REQUIRE(fs[i].ok);
+    REQUIRE(fs[i].size_bytes > 0);
+    REQUIRE(fs[i].used_bytes + fs[i].avail_bytes <= fs[i].size_bytes);
+    REQUIRE(fs[i].used_pct >= 0.0);
+    REQUIRE(fs[i].used_pct <= 100.0);
+  }
+  REQUIRE_FALSE(fs[3].ok);  // statvfs() fails: left out of the output
+
+  std::string detail;
+  REQUIRE(src.append_detail_json(detail));
+  REQUIRE(detail.find("{\"mount_table_parses\":1,\"filesystems\":[{\"mount\":\"/\",\"fstype\":\"ext4\","
+                      "\"device\":\"/dev/sda1\",\"size_bytes\":") == 0);
+  REQUIRE(detail.find("/missing") == std::string::npos);
+  std::string om;
+  src.append_openmetrics(om);
+  REQUIRE(om.find("# TYPE telemetry_filesystem_avail_bytes gauge\n") != std::string::npos);
+  REQUIRE(om.find("telemetry_filesystem_used_percent{mount=\"/mnt/my disk\",fstype=\"ext4\"} ") != std::string::npos);
+
+  // A new mount is not picked up by sampling alone...
+  root.mkdir("/data");
+  table += "32 22 8:4 / /data rw,relatime - xfs /dev/sdd1 rw\n";
+  root.write("/proc/self/mountinfo", table);
+  REQUIRE(src.sample(2'000'000'000ULL).ok());
+  REQUIRE(src.mount_table_parses() == 1);
+  REQUIRE(src.filesystems().size() == 4);
+  // ...only once the kernel flags the change, which does not ask for a sample itself.
+  REQUIRE_FALSE(src.mount_watch().on_ready(POLLPRI | POLLERR));
+  REQUIRE(src.sample(3'000'000'000ULL).ok());
+  REQUIRE(src.mount_table_parses() == 2);
+  REQUIRE(src.filesystems().size() == 5);
+  REQUIRE(std::string(src.filesystems()[4].mount) == "/data");
+
+  // The live table polls quiet until something is mounted.
+  telemetry::metrics::FilesystemSource live;
+  REQUIRE(live.sample(1'000'000'000ULL).ok());
+  pollfd p{live.mount_watch().fd(), live.mount_watch().events(), 0};
+  REQUIRE(p.fd >= 0);
+  REQUIRE(::poll(&p, 1, 0) == 0);
+
+  telemetry::metrics::FilesystemSource missing("/nonexistent");
+  REQUIRE(missing.mount_watch().fd() == -1);
+  REQUIRE(missing.sample(1'000'000'000ULL).code == telemetry::StatusCode::kUnavailable);
+  REQUIRE_FALSE(missing.append_detail_json(detail));
+}
+
+TELEMETRY_TEST_CASE("FilesystemSource replaces an overmounted path before deduplicating devices") {
+  FixtureRoot root;
+  root.mkdir("/proc/self");
+  root.mkdir("/data");
+  root.mkdir("/srv");
+  root.mkdir("/scratch");
+  root.mkdir("/home");
+  // /data is mounted over, so sda2 is no longer listed and /srv keeps it; /scratch is
+  // covered by a bind of /home's sdc1, so it goes rather than shadowing sdc1 twice.
+  root.write("/proc/self/mountinfo", "22 1 8:1 / / rw,relatime - ext4 /dev/sda1 rw\n"
+                                     "23 22 8:2 / /data rw,relatime - ext4 /dev/sda2 rw\n"
+                                     "24 23 8:3 / /data rw,relatime - xfs /dev/sdb1 rw\n"
+                                     "25 22 8:2 / /srv rw,relatime - ext4 /dev/sda2 rw\n"
+                                     "26 22 8:4 / /scratch rw,relatime - ext4 /dev/sda3 rw\n"
+                                     "27 22 8:5 / /home rw,relatime - ext4 /dev/sdc1 rw\n"
+                                     "28 26 8:5 /user /scratch rw,relatime - ext4 /dev/sdc1 rw\n");
+
+  telemetry::metrics::FilesystemSource src(root.path.c_str());
+  REQUIRE(src.sample(1'000'000'000ULL).ok());
+  const auto& fs = src.filesystems();
+  REQUIRE(fs.size() == 4);
+  REQUIRE(std::string(fs[0].mount) == "/");
+  REQUIRE(std::string(fs[1].mount) == "/data");
+  REQUIRE(std::string(fs[1].device) == "/dev/sdb1");
+  REQUIRE(std::string(fs[2].mount) == "/srv");
+  REQUIRE(std::string(fs[2].device) == "/dev/sda2");
+  REQUIRE(std::string(fs[3].mount) == "/home");
+}
 
+#endif
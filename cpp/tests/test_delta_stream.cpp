@@ -0,0 +1,253 @@
+#include "minitest.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "telemetry/codec/delta_stream.h"
+#include "telemetry/net/protocol.h"
+#include "telemetry/net/tcp_server.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using telemetry::codec::DeadbandConfig;
+using telemetry::codec::DeltaStream;
+
+namespace {
+
+telemetry::MetricsSnapshot snap_at(std::uint64_t ts, double cpu, std::uint64_t avail_kb, double temp, std::uint64_t up) {
+  telemetry::MetricsSnapshot s{};
+  s.ts_ms = ts;
+  s.cpu_usage_pct = cpu;
+  s.mem_total_kb = 8000000;
+  s.mem_available_kb = avail_kb;
+  s.temperature_c = temp;
+  s.uptime_s = up;
+  return s;
+}
+
+bool has(const std::string& line, const char* needle) { return line.find(needle) != std::string::npos; }
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("DeltaStream sends keyframes then only fields past the deadband") {
+  DeadbandConfig cfg{};
+  cfg.abs = 1.0;
+  cfg.keyframe_every = 4;
+  DeltaStream ds(cfg);
+  std::string line;
+
+  REQUIRE(ds.update(snap_at(1000, 10.0, 4000, 40.0, 100), telemetry::Status::Ok(), line));
+  REQUIRE(line ==
+          "{\"key\":true,\"ts_ms\":1000,\"status_code\":0,\"cpu_usage_pct\":10.00,\"mem_total_kb\":8000000,"
+          "\"mem_available_kb\":4000,\"temperature_c\":40.00,\"uptime_s\":100}\n");
+
+  // Nothing moved by more than 1.0: no line at all.
+  REQUIRE_FALSE(ds.update(snap_at(1250, 10.9, 4000, 40.5, 101), telemetry::Status::Ok(), line));
+  REQUIRE(line.empty());
+
+  // Drift accumulates against the last sent value (10.0), not the last sample.
+  REQUIRE(ds.update(snap_at(1500, 11.5, 4000, 40.5, 101), telemetry::Status::Ok(), line));
+  REQUIRE(line == "{\"ts_ms\":1500,\"cpu_usage_pct\":11.50}\n");
+
+  // Status changes are always sent.
+  REQUIRE(ds.update(snap_at(1750, 11.5, 4000, 40.5, 101), telemetry::Status::Unavailable("x"), line));
+  REQUIRE(line == "{\"ts_ms\":1750,\"status_code\":1}\n");
+
+  // Fourth sample after the keyframe: full resync.
+  REQUIRE(ds.update(snap_at(2000, 11.5, 4000, 40.5, 102), telemetry::Status::Ok(), line));
+  REQUIRE(has(line, "\"key\":true"));
+  REQUIRE(has(line, "\"temperature_c\":40.50"));
+  REQUIRE(has(line, "\"uptime_s\":102"));
+}
+
+TELEMETRY_TEST_CASE("DeltaStream relative deadband scales with the last sent value") {
+  DeadbandConfig cfg{};
+  cfg.rel = 0.01;
+  cfg.keyframe_every = 1000;
+  DeltaStream ds(cfg);
+  std::string line;
+  REQUIRE(ds.update(snap_at(0, 50.0, 4000000, 40.0, 1), telemetry::Status::Ok(), line));
+  // 1% of 4,000,000 kB is 40,000 kB.
+  REQUIRE_FALSE(ds.update(snap_at(1, 50.0, 4030000, 40.0, 1), telemetry::Status::Ok(), line));
+  REQUIRE(ds.update(snap_at(2, 50.0, 4050000, 40.0, 1), telemetry::Status::Ok(), line));
+  REQUIRE(line == "{\"ts_ms\":2,\"mem_available_kb\":4050000}\n");
+}
+
+TELEMETRY_TEST_CASE("DeltaStream keyframe replays the reference state for joiners") {
+  DeadbandConfig cfg{};
+  cfg.abs = 5.0;
+  DeltaStream ds(cfg);
+  std::string line;
+  REQUIRE_FALSE(ds.keyframe(line));
+  REQUIRE(ds.update(snap_at(0, 10.0, 4000, 40.0, 1), telemetry::Status::Ok(), line));
+  REQUIRE_FALSE(ds.update(snap_at(1, 13.0, 4000, 40.0, 1), telemetry::Status::Ok(), line));
+  // The joiner sees what existing members hold (10.00), not the suppressed 13.0.
+  REQUIRE(ds.keyframe(line));
+  REQUIRE(has(line, "\"cpu_usage_pct\":10.00"));
+  REQUIRE(has(line, "\"key\":true"));
+}
+
+TELEMETRY_TEST_CASE("DeltaStream cuts bytes per sample on a realistic trace") {
+  // One hour at 250 ms: noisy CPU, slow memory churn, slow thermal drift, 1 Hz uptime.
+  DeadbandConfig full_cfg{};
+  full_cfg.keyframe_every = 1;
+  DeadbandConfig delta_cfg{};
+  delta_cfg.abs = 2.0;
+  delta_cfg.rel = 0.01;
+  delta_cfg.keyframe_every = 240;
+  DeltaStream full(full_cfg);
+  DeltaStream delta(delta_cfg);
+
+  std::uint64_t rng = 0x9E3779B97F4A7C15ULL;
+  auto noise = [&rng] {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return static_cast<double>(rng % 1000) / 1000.0 - 0.5;
+  };
+
+  constexpr int kSamples = 4 * 3600;
+  std::size_t full_bytes = 0;
+  std::size_t delta_bytes = 0;
+  std::string line;
+  double cpu = 20.0;
+  double avail = 4000000.0;
+  for (int i = 0; i < kSamples; ++i) {
+    cpu = std::fmin(100.0, std::fmax(0.0, cpu + noise() * 3.0));
+    avail += noise() * 2000.0;
+    const double temp = 45.0 + 5.0 * std::sin(i / 2000.0) + noise() * 0.2;
+    const telemetry::MetricsSnapshot s = snap_at(1700000000000ULL + static_cast<std::uint64_t>(i) * 250ULL, cpu,
+                                                 static_cast<std::uint64_t>(avail), temp,
+                                                 100000ULL + static_cast<std::uint64_t>(i) / 4ULL);
+    if (full.update(s, telemetry::Status::Ok(), line)) full_bytes += line.size();
+    if (delta.update(s, telemetry::Status::Ok(), line)) delta_bytes += line.size();
+  }
+
+  const double full_per_sample = static_cast<double>(full_bytes) / kSamples;
+  const double delta_per_sample = static_cast<double>(delta_bytes) / kSamples;
+  REQUIRE(full_per_sample > 150.0);
+  REQUIRE(delta_per_sample < full_per_sample * 0.35);
+}
+
+TELEMETRY_TEST_CASE("parse_command handles SUBSCRIBE") {
+  using telemetry::net::CommandType;
+  using telemetry::net::parse_command;
+
+  auto pc = parse_command("SUBSCRIBE");
+  REQUIRE(pc.type == CommandType::kSubscribe);
+  REQUIRE(pc.ok);
+  REQUIRE(pc.keyframe_every == 1);
+
+  pc = parse_command("SUBSCRIBE DELTA 0.5");
+  REQUIRE(pc.ok);
+  REQUIRE(pc.deadband_abs == 0.5);
+  REQUIRE(pc.deadband_rel == 0.0);
+  REQUIRE(pc.keyframe_every == 60);
+
+  pc = parse_command("SUBSCRIBE DELTA 1 0.02 120");
+  REQUIRE(pc.ok);
+  REQUIRE(pc.deadband_rel == 0.02);
+  REQUIRE(pc.keyframe_every == 120);
+
+  REQUIRE_FALSE(parse_command("SUBSCRIBE DELTA").ok);
+  REQUIRE_FALSE(parse_command("SUBSCRIBE DELTA x").ok);
+  REQUIRE_FALSE(parse_command("SUBSCRIBE DELTA 1 0.1 0").ok);
+  REQUIRE_FALSE(parse_command("SUBSCRIBE DELTA 1 0.1 10 9").ok);
+  REQUIRE(parse_command("UNSUBSCRIBE").type == CommandType::kUnsubscribe);
+}
+
+#ifndef _WIN32
+
+namespace {
+
+class RampSource final : public telemetry::metrics::MetricSource {
+ public:
+  const char* name() const override { return "ramp"; }
+  telemetry::Status collect(telemetry::MetricsSnapshot& out) override {
+    out.cpu_usage_pct = static_cast<double>(calls_++);
+    out.mem_total_kb = 1000;
+    return telemetry::Status::Ok();
+  }
+
+ private:
+  int calls_{0};
+};
+
+int connect_to(std::uint16_t port) {
+  for (int attempt = 0; attempt < 100; ++attempt) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+    ::close(fd);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return -1;
+}
+
+std::string read_lines(int fd, int lines) {
+  std::string got;
+  char tmp[1024];
+  while (lines > 0) {
+    const ssize_t n = ::read(fd, tmp, sizeof(tmp));
+    if (n <= 0) break;
+    for (ssize_t i = 0; i < n; ++i) lines -= tmp[i] == '\n' ? 1 : 0;
+    got.append(tmp, static_cast<std::size_t>(n));
+  }
+  return got;
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("TcpServer streams deadband deltas to SUBSCRIBE groups") {
+  const std::uint16_t port = static_cast<std::uint16_t>(20000 + (::getpid() % 20000) + 70);
+  telemetry::metrics::Collector collector;
+  collector.add_source(std::make_unique<RampSource>());
+  telemetry::net::TcpServerConfig cfg{};
+  cfg.host = "127.0.0.1";
+  cfg.port = port;
+  cfg.throttle_ms = 20;
+  cfg.run_for_ms = 1000;
+  std::thread srv([&collector, cfg] {
+    telemetry::net::TcpServer server(collector, cfg);
+    (void)server.run_forever();
+  });
+
+  const int a = connect_to(port);
+  REQUIRE(a >= 0);
+  REQUIRE(::write(a, "SUBSCRIBE DELTA 2.5 0 1000\n", 27) == 27);
+  // ok reply, keyframe, then deltas every third sample (cpu ramps by 1 per sample).
+  const std::string got_a = read_lines(a, 4);
+  REQUIRE(has(got_a, "\"message\":\"subscribed\""));
+  REQUIRE(has(got_a, "{\"key\":true,"));
+  REQUIRE(got_a.find("\"mem_total_kb\"", got_a.find("\n", got_a.find("\"key\"")) + 1) == std::string::npos);
+
+  // A second subscriber with the same settings joins the group from its reference state.
+  const int b = connect_to(port);
+  REQUIRE(b >= 0);
+  REQUIRE(::write(b, "SUBSCRIBE DELTA 2.5 0 1000\n", 27) == 27);
+  const std::string got_b = read_lines(b, 3);
+  REQUIRE(has(got_b, "{\"key\":true,"));
+  const std::size_t last_b = got_b.rfind("{\"ts_ms\"");
+  REQUIRE(last_b != std::string::npos);
+  const std::string shared = got_b.substr(last_b);
+  // Members of one group receive byte-identical lines.
+  REQUIRE(has(read_lines(a, 3) + got_a, shared.c_str()));
+
+  ::close(a);
+  ::close(b);
+  srv.join();
+}
+
+#endif  // !_WIN32
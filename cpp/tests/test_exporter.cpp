@@ -0,0 +1,180 @@
+#include "minitest.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "telemetry/codec/batch_codec.h"
+#include "telemetry/exporter/batch_receiver.h"
+#include "telemetry/exporter/push_exporter.h"
+#include "telemetry/util/spsc_queue.h"
+
+namespace {
+
+telemetry::MetricsSnapshot sample_at(std::uint64_t i) {
+  telemetry::MetricsSnapshot s{};
+  s.ts_ms = 1700000000000ULL + i * 250;
+  s.cpu_usage_pct = 20.0 + static_cast<double>(i % 7);
+  s.mem_total_kb = 8ULL * 1024 * 1024;
+  s.mem_available_kb = 4ULL * 1024 * 1024 - i * 3;
+  s.temperature_c = 41.5;
+  s.uptime_s = 1000 + i / 4;
+  return s;
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("SpscQueue is bounded and FIFO") {
+  telemetry::util::SpscQueue<int> q(3);
+  REQUIRE(q.capacity() == 4);
+  for (int i = 0; i < 4; ++i) REQUIRE(q.try_push(i));
+  REQUIRE_FALSE(q.try_push(99));
+  REQUIRE(q.size_approx() == 4);
+  int v = -1;
+  for (int i = 0; i < 4; ++i) {
+    REQUIRE(q.try_pop(v));
+    REQUIRE(v == i);
+  }
+  REQUIRE_FALSE(q.try_pop(v));
+}
+
+TELEMETRY_TEST_CASE("batch codec round-trips delta-encoded samples compactly") {
+  std::vector<telemetry::codec::BatchSample> in;
+  for (std::uint64_t i = 0; i < 64; ++i) in.push_back({sample_at(i), telemetry::StatusCode::kOk});
+  in[5].status = telemetry::StatusCode::kUnavailable;
+
+  std::vector<std::uint8_t> frame;
+  const std::size_t n = telemetry::codec::encode_batch(42, "edge-7", in.data(), in.size(), frame);
+  REQUIRE(n == frame.size());
+  // Steady signals should cost roughly one byte per field after the first sample.
+  REQUIRE(n / in.size() < 12);
+
+  std::size_t frame_len = 0;
+  REQUIRE(telemetry::codec::peek_batch_frame(frame.data(), frame.size() - 1, frame_len).code ==
+          telemetry::StatusCode::kUnavailable);
+  REQUIRE(telemetry::codec::peek_batch_frame(frame.data(), frame.size(), frame_len).ok());
+  REQUIRE(frame_len == frame.size());
+
+  std::uint64_t seq = 0;
+  std::string_view agent;
+  std::vector<telemetry::codec::BatchSample> out;
+  REQUIRE(telemetry::codec::decode_batch(frame.data(), frame_len, seq, agent, out).ok());
+  REQUIRE(seq == 42);
+  REQUIRE(agent == "edge-7");
+  REQUIRE(out.size() == in.size());
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    REQUIRE(out[i].snap.ts_ms == in[i].snap.ts_ms);
+    REQUIRE(out[i].snap.mem_available_kb == in[i].snap.mem_available_kb);
+    REQUIRE(out[i].status == in[i].status);
+  }
+
+  frame[frame.size() - 1] ^= 0x01;
+  REQUIRE_FALSE(telemetry::codec::decode_batch(frame.data(), frame_len, seq, agent, out).ok());
+}
+
+#ifndef _WIN32
+
+namespace {
+
+template <typename Pred>
+bool wait_for(Pred pred, int timeout_ms) {
+  for (int waited = 0; waited < timeout_ms; waited += 5) {
+    if (pred()) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return pred();
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("PushExporter counts drops when the queue is full") {
+  telemetry::exporter::ExporterConfig cfg{};
+  cfg.queue_capacity = 8;
+  cfg.batch_max_samples = 4;
+  telemetry::exporter::PushExporter ex(cfg);  // never started: nothing consumes
+
+  for (std::uint64_t i = 0; i < 20; ++i) ex.on_snapshot(sample_at(i), telemetry::Status::Ok());
+  const auto st = ex.stats();
+  REQUIRE(st.enqueued == 8);
+  REQUIRE(st.dropped_queue_full == 12);
+}
+
+TELEMETRY_TEST_CASE("PushExporter delivers batches to the stand-in receiver") {
+  telemetry::exporter::BatchReceiver rx;
+  REQUIRE(rx.start().ok());
+
+  telemetry::exporter::ExporterConfig cfg{};
+  cfg.host = "127.0.0.1";
+  cfg.port = rx.port();
+  cfg.agent_id = "unit";
+  cfg.batch_max_samples = 16;
+  cfg.batch_max_ms = 20;
+  telemetry::exporter::PushExporter ex(cfg);
+  REQUIRE(ex.start().ok());
+
+  for (std::uint64_t i = 0; i < 200; ++i) ex.on_snapshot(sample_at(i), telemetry::Status::Ok());
+  REQUIRE(wait_for([&] { return rx.samples() == 200; }, 2000));
+  REQUIRE(wait_for([&] { return ex.stats().batches_acked == ex.stats().batches_sealed; }, 2000));
+  ex.stop();
+  rx.stop();
+
+  const auto got = rx.take_samples();
+  REQUIRE(got.size() == 200);
+  for (std::size_t i = 0; i < got.size(); ++i) REQUIRE(got[i].snap.ts_ms == sample_at(i).ts_ms);
+  REQUIRE(rx.last_agent_id() == "unit");
+  REQUIRE(rx.bad_frames() == 0);
+  REQUIRE(ex.stats().dropped_queue_full == 0);
+}
+
+TELEMETRY_TEST_CASE("PushExporter buffers while the collector is down and resends") {
+  // Reserve a port, then leave it closed while the exporter starts.
+  std::uint16_t port = 0;
+  {
+    telemetry::exporter::BatchReceiver probe;
+    REQUIRE(probe.start().ok());
+    port = probe.port();
+  }
+
+  telemetry::exporter::ExporterConfig cfg{};
+  cfg.host = "127.0.0.1";
+  cfg.port = port;
+  cfg.batch_max_samples = 8;
+  cfg.batch_max_ms = 10;
+  cfg.backoff_min_ms = 10;
+  cfg.backoff_max_ms = 40;
+  telemetry::exporter::PushExporter ex(cfg);
+  REQUIRE(ex.start().ok());
+  for (std::uint64_t i = 0; i < 40; ++i) ex.on_snapshot(sample_at(i), telemetry::Status::Ok());
+  REQUIRE(wait_for([&] { return ex.stats().batches_sealed == 5; }, 1000));
+  REQUIRE(ex.stats().batches_acked == 0);
+
+  telemetry::exporter::BatchReceiver rx(port);
+  REQUIRE(rx.start().ok());
+  REQUIRE(wait_for([&] { return rx.samples() == 40; }, 3000));
+  REQUIRE(wait_for([&] { return ex.stats().batches_acked == 5; }, 1000));
+  ex.stop();
+  rx.stop();
+  REQUIRE(ex.stats().dropped_retry_overflow == 0);
+}
+
+TELEMETRY_TEST_CASE("PushExporter drops the oldest batches beyond the retry budget") {
+  telemetry::exporter::ExporterConfig cfg{};
+  cfg.host = "127.0.0.1";
+  cfg.port = 1;  // nothing listens on tcpmux
+  cfg.batch_max_samples = 8;
+  cfg.batch_max_ms = 5;
+  cfg.retry_buffer_bytes = 256;
+  cfg.backoff_min_ms = 1000;
+  telemetry::exporter::PushExporter ex(cfg);
+  REQUIRE(ex.start().ok());
+  for (std::uint64_t i = 0; i < 200; ++i) ex.on_snapshot(sample_at(i), telemetry::Status::Ok());
+  REQUIRE(wait_for([&] { return ex.stats().batches_sealed == 25; }, 1000));
+  ex.stop();
+
+  const auto st = ex.stats();
+  REQUIRE(st.dropped_retry_overflow > 0);
+  REQUIRE(st.dropped_retry_overflow % 8 == 0);
+  REQUIRE(st.dropped_retry_overflow < 200);
+}
+
+#endif  // !_WIN32
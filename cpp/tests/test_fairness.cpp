@@ -0,0 +1,296 @@
+#include "minitest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "telemetry/metrics/collector.h"
+#include "telemetry/net/tcp_server.h"
+#include "telemetry/storage/spool.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+class ConstSource final : public telemetry::metrics::MetricSource {
+ public:
+  const char* name() const override { return "const"; }
+  telemetry::Status collect(telemetry::MetricsSnapshot& out) override {
+    out.uptime_s = 42;
+    return telemetry::Status::Ok();
+  }
+};
+
+int connect_loopback(std::uint16_t port) {
+  for (int attempt = 0; attempt < 100; ++attempt) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+    ::close(fd);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return -1;
+}
+
+std::string request(int fd, const char* line) {
+  const std::size_t len = std::strlen(line);
+  if (::send(fd, line, len, MSG_NOSIGNAL) != static_cast<ssize_t>(len)) return {};
+  std::string got;
+  char tmp[4096];
+  while (got.find('\n') == std::string::npos) {
+    const ssize_t n = ::read(fd, tmp, sizeof(tmp));
+    if (n <= 0) break;
+    got.append(tmp, static_cast<std::size_t>(n));
+  }
+  return got;
+}
+
+std::uint64_t field_after(const std::string& s, std::size_t from, const char* key) {
+  const std::size_t at = s.find(key, from);
+  return at == std::string::npos ? 0 : std::strtoull(s.c_str() + at + std::strlen(key), nullptr, 10);
+}
+
+// Reads until `needle` shows up; false on EOF, error or after timeout_ms without it.
+bool read_until(int fd, const char* needle, int timeout_ms) {
+  std::string got;
+  char tmp[4096];
+  const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (got.find(needle) == std::string::npos) {
+    const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(until - std::chrono::steady_clock::now());
+    pollfd p{fd, POLLIN, 0};
+    if (left.count() <= 0 || ::poll(&p, 1, static_cast<int>(left.count())) <= 0) return false;
+    const ssize_t n = ::read(fd, tmp, sizeof(tmp));
+    if (n <= 0) return false;
+    got.append(tmp, static_cast<std::size_t>(n));
+  }
+  return true;
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("TcpServer budget keeps a flooding client from starving others") {
+  const std::uint16_t port = static_cast<std::uint16_t>(20000 + (::getpid() % 20000) + 100);
+  telemetry::metrics::Collector collector;
+  collector.add_source(std::make_unique<ConstSource>());
+
+  telemetry::net::TcpServerConfig cfg{};
+  cfg.host = "127.0.0.1";
+  cfg.port = port;
+  cfg.run_for_ms = 4000;
+  cfg.max_commands_per_pass = 8;
+  cfg.max_read_bytes_per_pass = 512;
+  std::thread srv([&collector, cfg] {
+    telemetry::net::TcpServer server(collector, cfg);
+    (void)server.run_forever();
+  });
+
+  // The flooder pipelines PINGs in large bursts and only reads to keep its replies moving.
+  const int flood_fd = connect_loopback(port);
+  REQUIRE(flood_fd >= 0);
+  std::atomic<bool> stop{false};
+  std::thread flooder([flood_fd, &stop] {
+    std::string burst;
+    for (int i = 0; i < 512; ++i) burst += "PING\n";
+    char tmp[64 * 1024];
+    while (!stop.load(std::memory_order_relaxed)) {
+      if (::send(flood_fd, burst.data(), burst.size(), MSG_NOSIGNAL | MSG_DONTWAIT) < 0 && errno != EAGAIN) break;
+      pollfd p{flood_fd, POLLIN, 0};
+      if (::poll(&p, 1, 5) > 0 && ::read(flood_fd, tmp, sizeof(tmp)) <= 0) break;
+    }
+  });
+
+  const int fd = connect_loopback(port);
+  REQUIRE(fd >= 0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  std::vector<double> latencies_ms;
+  for (int i = 0; i < 200; ++i) {
+    const auto t0 = std::chrono::steady_clock::now();
+    const std::string got = request(fd, "GET\n");
+    latencies_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+    REQUIRE(got.find("\"uptime_s\":42") != std::string::npos);
+  }
+  const std::string clients = request(fd, "CLIENTS\n");
+  stop.store(true);
+  flooder.join();
+  ::close(flood_fd);
+  ::close(fd);
+  srv.join();
+
+  std::sort(latencies_ms.begin(), latencies_ms.end());
+  const double p99 = latencies_ms[latencies_ms.size() * 99 / 100];
+  // Generous bound: without a budget the loop can stay in the flooder's read loop indefinitely.
+  REQUIRE(p99 < 100.0);
+
+  REQUIRE(clients.rfind("{\"ok\":true,\"max_commands_per_pass\":8,\"max_read_bytes_per_pass\":512,\"clients\":[", 0) == 0);
+  const std::size_t self = clients.find("\"self\":true");
+  const std::size_t other = clients.find("\"self\":false");
+  REQUIRE(self != std::string::npos);
+  REQUIRE(other != std::string::npos);
+  // CLIENTS itself is counted once it completes.
+  REQUIRE(field_after(clients, self, "\"commands\":") == 200);
+  REQUIRE(field_after(clients, self, "\"bytes_in\":") == 200 * 4 + 8);
+  // The flooder was cut short and carried input over.
+  REQUIRE(field_after(clients, other, "\"commands\":") > 200);
+  REQUIRE(field_after(clients, other, "\"deferred\":") > 0);
+}
+
+TELEMETRY_TEST_CASE("TcpServer closes idle connections but keeps subscribers") {
+  const std::uint16_t port = static_cast<std::uint16_t>(20000 + (::getpid() % 20000) + 101);
+  telemetry::metrics::Collector collector;
+  collector.add_source(std::make_unique<ConstSource>());
+
+  telemetry::net::TcpServerConfig cfg{};
+  cfg.host = "127.0.0.1";
+  cfg.port = port;
+  cfg.run_for_ms = 3000;
+  cfg.idle_timeout_ms = 300;
+  std::thread srv([&collector, cfg] {
+    telemetry::net::TcpServer server(collector, cfg);
+    (void)server.run_forever();
+  });
+
+  const int idle_fd = connect_loopback(port);
+  const int busy_fd = connect_loopback(port);
+  const int sub_fd = connect_loopback(port);
+  REQUIRE(idle_fd >= 0);
+  REQUIRE(busy_fd >= 0);
+  REQUIRE(sub_fd >= 0);
+  REQUIRE(request(idle_fd, "PING\n").find("pong") != std::string::npos);
+  REQUIRE(request(sub_fd, "SUBSCRIBE DELTA 1 0 1000\n").find("subscribed") != std::string::npos);
+
+  // The busy client keeps talking past several timeouts; the idle one goes quiet.
+  const auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < 8; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    REQUIRE(request(busy_fd, "PING\n").find("pong") != std::string::npos);
+  }
+  char tmp[64];
+  pollfd p{idle_fd, POLLIN, 0};
+  REQUIRE(::poll(&p, 1, 1000) == 1);
+  REQUIRE(::read(idle_fd, tmp, sizeof(tmp)) == 0);
+  const auto closed_after = std::chrono::steady_clock::now() - t0;
+  REQUIRE(closed_after >= std::chrono::milliseconds(250));
+
+  // The subscriber only listened, yet it is still served.
+  REQUIRE(::send(sub_fd, "PING\n", 5, MSG_NOSIGNAL) == 5);
+  REQUIRE(read_until(sub_fd, "pong", 1000));
+
+  ::close(idle_fd);
+  ::close(busy_fd);
+  ::close(sub_fd);
+  srv.join();
+}
+
+TELEMETRY_TEST_CASE("TcpServer keeps a slow reader of a long drain open") {
+  char tmpl[] = "/tmp/telemetry_idle_drain_XXXXXX";
+  REQUIRE(::mkdtemp(tmpl) != nullptr);
+  const std::string dir = tmpl;
+  const std::string path = dir + "/agent.sock";
+  {
+    telemetry::storage::SpoolConfig scfg{};
+    scfg.dir = dir.c_str();
+    telemetry::storage::Spool spool(scfg);
+    REQUIRE(spool.open().ok());
+    telemetry::MetricsSnapshot snap{};
+    for (std::uint64_t i = 1; spool.tail_cursor() < 2 * 1024 * 1024; ++i) {
+      snap.ts_ms = i;
+      REQUIRE(spool.append(snap, telemetry::Status::Ok(), 0).ok());
+    }
+
+    telemetry::metrics::Collector collector;
+    collector.add_source(std::make_unique<ConstSource>());
+    telemetry::net::TcpServerConfig cfg{};
+    cfg.host = "127.0.0.1";
+    cfg.port = static_cast<std::uint16_t>(20000 + (::getpid() % 20000) + 104);
+    cfg.unix_path = path.c_str();
+    cfg.run_for_ms = 5000;
+    cfg.idle_timeout_ms = 150;
+    telemetry::net::TcpServer server(collector, cfg);
+    server.set_spool(&spool);
+    std::thread srv([&server] { (void)server.run_forever(); });
+
+    // Unix socket buffers do not autotune, so most of the segment stays queued on the server.
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    int fd = -1;
+    for (int attempt = 0; attempt < 100 && fd < 0; ++attempt) {
+      fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+      if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        fd = -1;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      }
+    }
+    const std::string head = fd >= 0 ? request(fd, "DRAIN 0\n") : std::string();
+    const std::uint64_t want = field_after(head, 0, "\"bytes\":");
+
+    // Read slowly, sending nothing, for several idle timeouts.
+    const auto t0 = std::chrono::steady_clock::now();
+    std::uint64_t got = head.empty() ? 0 : head.size() - (head.find('\n') + 1);
+    char tmp[32 * 1024];
+    while (got < want) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      const ssize_t n = ::read(fd, tmp, sizeof(tmp));
+      if (n <= 0) break;
+      got += static_cast<std::uint64_t>(n);
+    }
+    const auto took = std::chrono::steady_clock::now() - t0;
+
+    if (fd >= 0) ::close(fd);
+    server.stop();
+    srv.join();
+    REQUIRE(want > 1024 * 1024);
+    REQUIRE(got == want);
+    REQUIRE(took > std::chrono::milliseconds(3 * cfg.idle_timeout_ms));
+  }
+  const std::string cmd = "rm -rf '" + dir + "'";
+  (void)std::system(cmd.c_str());
+}
+
+TELEMETRY_TEST_CASE("TcpServer stop() wakes a loop sleeping without timers") {
+  const std::uint16_t port = static_cast<std::uint16_t>(20000 + (::getpid() % 20000) + 102);
+  telemetry::metrics::Collector collector;
+  collector.add_source(std::make_unique<ConstSource>());
+
+  telemetry::net::TcpServerConfig cfg{};
+  cfg.host = "127.0.0.1";
+  cfg.port = port;
+  cfg.idle_timeout_ms = 0;
+  telemetry::net::TcpServer server(collector, cfg);
+  std::atomic<bool> done{false};
+  std::thread srv([&server, &done] {
+    (void)server.run_forever();
+    done.store(true);
+  });
+
+  const int fd = connect_loopback(port);
+  REQUIRE(fd >= 0);
+  REQUIRE(request(fd, "PING\n").find("pong") != std::string::npos);
+  // Nothing is armed now: no sampling, no deadline, no idle timers, so poll() has no timeout.
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  REQUIRE_FALSE(done.load());
+  const auto t0 = std::chrono::steady_clock::now();
+  server.stop();
+  srv.join();
+  REQUIRE(std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(200));
+  ::close(fd);
+}
+
+#endif  // !_WIN32
@@ -0,0 +1,181 @@
+#include "minitest.h"
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "telemetry/fleet/aggregator.h"
+#include "telemetry/fleet/fleet_table.h"
+#include "telemetry/net/protocol.h"
+#include "telemetry/net/tcp_server.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace {
+
+telemetry::MetricsSnapshot snap_with_cpu(double cpu) {
+  telemetry::MetricsSnapshot s{};
+  s.cpu_usage_pct = cpu;
+  s.mem_total_kb = 1000;
+  return s;
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("parse_command handles fleet queries") {
+  using telemetry::net::CommandType;
+  using telemetry::net::FleetQuery;
+  using telemetry::net::parse_command;
+
+  REQUIRE(parse_command("FLEET").fleet_query == FleetQuery::kAll);
+  REQUIRE(parse_command("FLEET ALL").type == CommandType::kFleet);
+  {
+    const auto pc = parse_command("FLEET TOP 5");
+    REQUIRE(pc.ok);
+    REQUIRE(pc.fleet_query == FleetQuery::kTopCpu);
+    REQUIRE(pc.count == 5);
+  }
+  {
+    const auto pc = parse_command("FLEET OVER 92.5");
+    REQUIRE(pc.ok);
+    REQUIRE(pc.fleet_query == FleetQuery::kOverCpu);
+    REQUIRE(pc.threshold > 92.49 && pc.threshold < 92.51);
+  }
+  REQUIRE_FALSE(parse_command("FLEET TOP 0").ok);
+  REQUIRE_FALSE(parse_command("FLEET OVER x").ok);
+}
+
+TELEMETRY_TEST_CASE("FleetTable orders live hosts by CPU") {
+  telemetry::fleet::FleetTable t;
+  const std::size_t a = t.add_host("a");
+  const std::size_t b = t.add_host("b");
+  const std::size_t c = t.add_host("c");
+  REQUIRE(t.add_host("b") == b);
+
+  t.update(a, snap_with_cpu(10.0), telemetry::StatusCode::kOk, 1);
+  t.update(b, snap_with_cpu(95.0), telemetry::StatusCode::kOk, 1);
+  t.update(c, snap_with_cpu(50.0), telemetry::StatusCode::kOk, 1);
+  REQUIRE(t.up_count() == 3);
+
+  std::vector<telemetry::fleet::FleetHost> rows;
+  t.top_cpu(2, rows);
+  REQUIRE(rows.size() == 2);
+  REQUIRE(std::string_view(rows[0].name) == "b");
+  REQUIRE(std::string_view(rows[1].name) == "c");
+
+  t.over_cpu(40.0, rows);
+  REQUIRE(rows.size() == 2);
+
+  // Down hosts drop out of the CPU index but stay in the table.
+  t.set_up(b, false);
+  t.top_cpu(10, rows);
+  REQUIRE(rows.size() == 2);
+  REQUIRE(std::string_view(rows[0].name) == "c");
+  t.all(rows);
+  REQUIRE(rows.size() == 3);
+  REQUIRE(rows[1].reconnects == 1);
+}
+
+#ifndef _WIN32
+
+namespace {
+
+class FixedCpuSource final : public telemetry::metrics::MetricSource {
+ public:
+  explicit FixedCpuSource(double cpu) : cpu_(cpu) {}
+  const char* name() const override { return "fixed_cpu"; }
+  telemetry::Status collect(telemetry::MetricsSnapshot& out) override {
+    out.cpu_usage_pct = cpu_;
+    out.mem_total_kb = 4096;
+    out.mem_available_kb = 2048;
+    return telemetry::Status::Ok();
+  }
+
+ private:
+  double cpu_;
+};
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("FleetAggregator merges many loopback agents") {
+  constexpr int kAgents = 24;
+  const std::uint16_t base_port = static_cast<std::uint16_t>(20000 + (::getpid() % 20000));
+
+  std::vector<std::unique_ptr<telemetry::metrics::Collector>> collectors;
+  std::vector<std::thread> agents;
+  for (int i = 0; i < kAgents; ++i) {
+    collectors.push_back(std::make_unique<telemetry::metrics::Collector>());
+    collectors.back()->add_source(std::make_unique<FixedCpuSource>(static_cast<double>(i) * 4.0));
+    telemetry::net::TcpServerConfig cfg{};
+    cfg.host = "127.0.0.1";
+    cfg.port = static_cast<std::uint16_t>(base_port + i);
+    cfg.run_for_ms = 2000;
+    telemetry::metrics::Collector* col = collectors.back().get();
+    agents.emplace_back([col, cfg] {
+      telemetry::net::TcpServer server(*col, cfg);
+      (void)server.run_forever();
+    });
+  }
+
+  telemetry::fleet::FleetTable table;
+  telemetry::fleet::AggregatorConfig acfg{};
+  acfg.interval_ms = 50;
+  acfg.backoff_min_ms = 20;
+  acfg.backoff_max_ms = 100;
+  telemetry::fleet::FleetAggregator agg(table, acfg);
+  for (int i = 0; i < kAgents; ++i) REQUIRE(agg.add_target("127.0.0.1", static_cast<std::uint16_t>(base_port + i)).ok());
+  // Nothing listens here; it must stay down without disturbing the others.
+  REQUIRE(agg.add_target("127.0.0.1", static_cast<std::uint16_t>(base_port + kAgents), "dead").ok());
+  REQUIRE(agg.start().ok());
+
+  bool all_up = false;
+  for (int i = 0; i < 150 && !all_up; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    all_up = table.up_count() == kAgents;
+  }
+  agg.stop();
+  for (auto& t : agents) t.join();
+
+  REQUIRE(all_up);
+  REQUIRE(table.size() == kAgents + 1);
+
+  std::vector<telemetry::fleet::FleetHost> rows;
+  table.top_cpu(3, rows);
+  REQUIRE(rows.size() == 3);
+  REQUIRE(rows[0].snap.cpu_usage_pct > 91.9 && rows[0].snap.cpu_usage_pct < 92.1);
+  REQUIRE(rows[2].snap.cpu_usage_pct > 83.9 && rows[2].snap.cpu_usage_pct < 84.1);
+
+  table.over_cpu(80.0, rows);
+  REQUIRE(rows.size() == 3);
+
+  telemetry::fleet::FleetHost dead{};
+  REQUIRE(table.find("dead", dead));
+  REQUIRE_FALSE(dead.up);
+  REQUIRE_FALSE(dead.has_snapshot);
+}
+
+TELEMETRY_TEST_CASE("FleetAggregator rejects duplicate target names") {
+  char path[] = "/tmp/telemetry_targets_XXXXXX";
+  const int fd = ::mkstemp(path);
+  REQUIRE(fd >= 0);
+  const char text[] = "# agents\n127.0.0.1:9001 edge-a\n127.0.0.1:9002 edge-b\n127.0.0.1:9003 edge-a\n";
+  REQUIRE(::write(fd, text, sizeof(text) - 1) == static_cast<ssize_t>(sizeof(text) - 1));
+  ::close(fd);
+
+  telemetry::fleet::FleetTable table;
+  telemetry::fleet::FleetAggregator agg(table, telemetry::fleet::AggregatorConfig{});
+  const telemetry::Status st = agg.load_targets_file(path);
+  ::unlink(path);
+  REQUIRE(st.code == telemetry::StatusCode::kInvalidArgument);
+  REQUIRE(agg.target_count() == 2);
+
+  // Unnamed targets default to <ipv4>:<port>, which an explicit name can collide with.
+  telemetry::fleet::FleetAggregator agg2(table, telemetry::fleet::AggregatorConfig{});
+  REQUIRE(agg2.add_target("127.0.0.1", 9004).ok());
+  REQUIRE_FALSE(agg2.add_target("127.0.0.1", 9005, "127.0.0.1:9004").ok());
+}
+
+#endif  // !_WIN32
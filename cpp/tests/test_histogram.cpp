@@ -0,0 +1,63 @@
+#include "minitest.h"
+
+#include <cstdint>
+
+#include "telemetry/util/latency_histogram.h"
+#include "telemetry/util/time.h"
+
+using telemetry::util::LatencyHistogram;
+
+TELEMETRY_TEST_CASE("LatencyHistogram is exact for small values") {
+  LatencyHistogram h;
+  for (std::uint64_t v = 1; v <= 100; ++v) h.record(v);
+  REQUIRE(h.count() == 100);
+  REQUIRE(h.min() == 1);
+  REQUIRE(h.max() == 100);
+  REQUIRE(h.value_at_percentile(50.0) == 50);
+  REQUIRE(h.value_at_percentile(99.0) == 99);
+  REQUIRE(h.value_at_percentile(100.0) == 100);
+  REQUIRE(h.mean() > 50.49 && h.mean() < 50.51);
+}
+
+TELEMETRY_TEST_CASE("LatencyHistogram keeps relative error under 1% across the range") {
+  const std::uint64_t probes[] = {257, 1000, 12345, 999999, 123456789, 987654321012ULL};
+  for (std::uint64_t v : probes) {
+    LatencyHistogram h;
+    h.record(v);
+    h.record(v * 2);
+    const std::uint64_t got = h.value_at_percentile(50.0);
+    REQUIRE(got >= v);
+    REQUIRE(static_cast<double>(got - v) <= static_cast<double>(v) * 0.008);
+  }
+
+  // Out-of-range values clamp instead of indexing past the buckets.
+  LatencyHistogram big;
+  big.record(UINT64_MAX);
+  REQUIRE(big.count() == 1);
+  REQUIRE(big.max() == UINT64_MAX);
+}
+
+TELEMETRY_TEST_CASE("LatencyHistogram merges and reports tail percentiles") {
+  LatencyHistogram a;
+  LatencyHistogram b;
+  for (int i = 0; i < 990; ++i) a.record(1000);
+  for (int i = 0; i < 10; ++i) b.record(1000000);
+  a.merge(b);
+  REQUIRE(a.count() == 1000);
+  REQUIRE(a.value_at_percentile(50.0) < 1010);
+  REQUIRE(a.value_at_percentile(99.0) < 1010);
+  REQUIRE(a.value_at_percentile(99.9) >= 1000000);
+  REQUIRE(a.max() == 1000000);
+  a.reset();
+  REQUIRE(a.count() == 0);
+  REQUIRE(a.value_at_percentile(99.0) == 0);
+}
+
+TELEMETRY_TEST_CASE("monotonic_ns does not go backwards") {
+  std::uint64_t prev = telemetry::util::monotonic_ns();
+  for (int i = 0; i < 1000; ++i) {
+    const std::uint64_t now = telemetry::util::monotonic_ns();
+    REQUIRE(now >= prev);
+    prev = now;
+  }
+}
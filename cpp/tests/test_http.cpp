@@ -0,0 +1,201 @@
+#include "minitest.h"
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "telemetry/net/http.h"
+#include "telemetry/net/openmetrics.h"
+#include "telemetry/net/tcp_server.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using telemetry::net::HttpParseResult;
+using telemetry::net::HttpRequest;
+using telemetry::net::HttpRequestParser;
+
+TELEMETRY_TEST_CASE("HttpRequestParser handles requests split across reads") {
+  const std::string req = "GET /metrics HTTP/1.1\r\nHost: x\r\nAccept: application/openmetrics-text;version=1.0.0\r\n\r\n";
+  HttpRequestParser p;
+  HttpRequest r{};
+  for (std::size_t n = 1; n < req.size(); ++n) {
+    REQUIRE(p.parse(std::string_view(req.data(), n), r) == HttpParseResult::kIncomplete);
+  }
+  REQUIRE(p.parse(req, r) == HttpParseResult::kComplete);
+  REQUIRE(r.method == "GET");
+  REQUIRE(r.target == "/metrics");
+  REQUIRE(r.keep_alive);
+  REQUIRE(r.wants_openmetrics);
+  REQUIRE(r.length == req.size());
+}
+
+TELEMETRY_TEST_CASE("HttpRequestParser applies keep-alive rules and skips bodies") {
+  HttpRequestParser p;
+  HttpRequest r{};
+
+  REQUIRE(p.parse("GET / HTTP/1.1\r\nConnection: Close\r\n\r\n", r) == HttpParseResult::kComplete);
+  REQUIRE_FALSE(r.keep_alive);
+  p.reset();
+  REQUIRE(p.parse("GET / HTTP/1.0\r\n\r\n", r) == HttpParseResult::kComplete);
+  REQUIRE_FALSE(r.keep_alive);
+  p.reset();
+  REQUIRE(p.parse("GET / HTTP/1.0\r\nconnection: keep-alive\r\n\r\n", r) == HttpParseResult::kComplete);
+  REQUIRE(r.keep_alive);
+  REQUIRE_FALSE(r.wants_openmetrics);
+  p.reset();
+
+  // Pipelined: the first request's length stops at the end of its body.
+  const std::string two = "POST /x HTTP/1.1\r\nContent-Length: 3\r\n\r\nabcGET /metrics HTTP/1.1\r\n\r\n";
+  REQUIRE(p.parse(std::string_view(two.data(), 40), r) == HttpParseResult::kIncomplete);
+  REQUIRE(p.parse(two, r) == HttpParseResult::kComplete);
+  REQUIRE(r.method == "POST");
+  REQUIRE(r.length == 42);
+  p.reset();
+  REQUIRE(p.parse(std::string_view(two).substr(r.length), r) == HttpParseResult::kComplete);
+  REQUIRE(r.target == "/metrics");
+}
+
+TELEMETRY_TEST_CASE("HttpRequestParser rejects malformed requests") {
+  HttpRequestParser p;
+  HttpRequest r{};
+  REQUIRE(p.parse("GARBAGE\r\n\r\n", r) == HttpParseResult::kError);
+  REQUIRE(r.error_status == 400);
+  p.reset();
+  REQUIRE(p.parse("GET / HTTP/2.0\r\n\r\n", r) == HttpParseResult::kError);
+  REQUIRE(r.error_status == 505);
+  p.reset();
+  REQUIRE(p.parse("GET / HTTP/1.1\r\nno-colon\r\n\r\n", r) == HttpParseResult::kError);
+  REQUIRE(r.error_status == 400);
+  p.reset();
+  REQUIRE(p.parse("GET / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n", r) == HttpParseResult::kError);
+  REQUIRE(r.error_status == 501);
+}
+
+TELEMETRY_TEST_CASE("render_openmetrics emits base units and EOF") {
+  telemetry::MetricsSnapshot s{};
+  s.ts_ms = 1700000000123ULL;
+  s.cpu_usage_pct = 12.5;
+  s.mem_total_kb = 2;
+  s.mem_available_kb = 1;
+  s.uptime_s = 42;
+
+  std::string out;
+  REQUIRE(telemetry::net::render_openmetrics(s, telemetry::Status::Ok(), out).ok());
+  REQUIRE(out.find("telemetry_collect_ok 1\n") != std::string::npos);
+  REQUIRE(out.find("telemetry_cpu_usage_percent 12.50\n") != std::string::npos);
+  REQUIRE(out.find("telemetry_memory_total_bytes 2048\n") != std::string::npos);
+  REQUIRE(out.find("telemetry_snapshot_timestamp_seconds 1700000000.123\n") != std::string::npos);
+  REQUIRE(out.find("telemetry_uptime_seconds 42\n") != std::string::npos);
+  REQUIRE(out.size() > 6 && out.compare(out.size() - 6, 6, "# EOF\n") == 0);
+
+  REQUIRE(telemetry::net::render_openmetrics(s, telemetry::Status::Unavailable("x"), out).ok());
+  REQUIRE(out.find("telemetry_collect_ok 0\n") != std::string::npos);
+}
+
+#ifndef _WIN32
+
+namespace {
+
+int connect_loopback(std::uint16_t port) {
+  for (int attempt = 0; attempt < 100; ++attempt) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+    ::close(fd);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return -1;
+}
+
+// Reads one response (head plus Content-Length body); returns false on EOF or a bad head.
+bool read_response(int fd, std::string& pending, std::string& head, std::string& body) {
+  char tmp[4096];
+  while (pending.find("\r\n\r\n") == std::string::npos) {
+    const ssize_t n = ::read(fd, tmp, sizeof(tmp));
+    if (n <= 0) return false;
+    pending.append(tmp, static_cast<std::size_t>(n));
+  }
+  const std::size_t head_len = pending.find("\r\n\r\n") + 4;
+  head = pending.substr(0, head_len);
+  const std::size_t cl = head.find("Content-Length: ");
+  if (cl == std::string::npos) return false;
+  const std::size_t body_len = std::strtoull(head.c_str() + cl + 16, nullptr, 10);
+  while (pending.size() < head_len + body_len) {
+    const ssize_t n = ::read(fd, tmp, sizeof(tmp));
+    if (n <= 0) return false;
+    pending.append(tmp, static_cast<std::size_t>(n));
+  }
+  body = pending.substr(head_len, body_len);
+  pending.erase(0, head_len + body_len);
+  return true;
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("TcpServer serves /metrics with keep-alive and pipelining") {
+  const std::uint16_t base_port = static_cast<std::uint16_t>(20000 + (::getpid() % 20000) + 50);
+  telemetry::metrics::Collector collector;
+  telemetry::net::TcpServerConfig cfg{};
+  cfg.host = "127.0.0.1";
+  cfg.port = base_port;
+  cfg.metrics_port = static_cast<std::uint16_t>(base_port + 1);
+  cfg.run_for_ms = 1500;
+  std::thread srv([&collector, cfg] {
+    telemetry::net::TcpServer server(collector, cfg);
+    (void)server.run_forever();
+  });
+
+  const int fd = connect_loopback(cfg.metrics_port);
+  REQUIRE(fd >= 0);
+
+  const std::string reqs =
+      "GET /metrics HTTP/1.1\r\nHost: t\r\n\r\n"
+      "GET /nope HTTP/1.1\r\nHost: t\r\n\r\n"
+      "GET /metrics HTTP/1.1\r\nAccept: application/openmetrics-text\r\nConnection: close\r\n\r\n";
+  REQUIRE(::write(fd, reqs.data(), reqs.size()) == static_cast<ssize_t>(reqs.size()));
+
+  std::string pending, head, body;
+  REQUIRE(read_response(fd, pending, head, body));
+  REQUIRE(head.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+  REQUIRE(head.find("Content-Type: text/plain; version=0.0.4") != std::string::npos);
+  REQUIRE(head.find("Connection: keep-alive") != std::string::npos);
+  REQUIRE(body.find("telemetry_cpu_usage_percent ") != std::string::npos);
+  const std::string first_body = body;
+
+  REQUIRE(read_response(fd, pending, head, body));
+  REQUIRE(head.rfind("HTTP/1.1 404 ", 0) == 0);
+
+  REQUIRE(read_response(fd, pending, head, body));
+  REQUIRE(head.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+  REQUIRE(head.find("Content-Type: application/openmetrics-text") != std::string::npos);
+  REQUIRE(head.find("Connection: close") != std::string::npos);
+  // Same snapshot generation inside the throttle window: the cached exposition is reused.
+  REQUIRE(body == first_body);
+
+  char tmp[16];
+  REQUIRE(::read(fd, tmp, sizeof(tmp)) == 0);
+  ::close(fd);
+
+  // The line protocol keeps working alongside.
+  const int lfd = connect_loopback(cfg.port);
+  REQUIRE(lfd >= 0);
+  REQUIRE(::write(lfd, "PING\n", 5) == 5);
+  char line[128] = {};
+  REQUIRE(::read(lfd, line, sizeof(line) - 1) > 0);
+  REQUIRE(std::strstr(line, "pong") != nullptr);
+  ::close(lfd);
+
+  srv.join();
+}
+
+#endif  // !_WIN32
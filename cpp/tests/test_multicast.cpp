@@ -0,0 +1,126 @@
+#include "minitest.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "telemetry/codec/datagram_codec.h"
+#include "telemetry/exporter/multicast_sender.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+telemetry::MetricsSnapshot sample(int i) {
+  telemetry::MetricsSnapshot s{};
+  s.ts_ms = 1700000000000ULL + static_cast<std::uint64_t>(i) * 1000ULL;
+  s.cpu_usage_pct = 12.5 + i;
+  s.mem_total_kb = 16000000;
+  s.mem_available_kb = 9000000 - static_cast<std::uint64_t>(i);
+  s.temperature_c = -3.25;
+  s.uptime_s = 4242 + static_cast<std::uint64_t>(i);
+  return s;
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("datagram codec round-trips a snapshot with seq and host id") {
+  std::uint8_t buf[telemetry::codec::kMaxDatagramSize];
+  const std::size_t n = telemetry::codec::encode_datagram(77, "rack3-node12", sample(1), telemetry::StatusCode::kUnavailable,
+                                                          buf, sizeof(buf));
+  REQUIRE(n > 0);
+  REQUIRE(n < 64);
+
+  telemetry::codec::SnapshotDatagram d{};
+  REQUIRE(telemetry::codec::decode_datagram(buf, n, d).ok());
+  REQUIRE(d.seq == 77);
+  REQUIRE(d.host_id == "rack3-node12");
+  REQUIRE(d.status == telemetry::StatusCode::kUnavailable);
+  REQUIRE(d.snap.ts_ms == sample(1).ts_ms);
+  REQUIRE(d.snap.cpu_usage_pct == 13.5);
+  REQUIRE(d.snap.mem_available_kb == 8999999);
+  REQUIRE(d.snap.temperature_c == -3.25);
+  REQUIRE(d.snap.uptime_s == 4243);
+
+  // Foreign traffic on the group, truncation and oversized host ids are rejected.
+  REQUIRE_FALSE(telemetry::codec::decode_datagram(reinterpret_cast<const std::uint8_t*>("hello world"), 11, d).ok());
+  for (std::size_t len = 0; len < n; ++len) REQUIRE_FALSE(telemetry::codec::decode_datagram(buf, len, d).ok());
+  const std::string long_id(200, 'h');
+  const std::size_t m = telemetry::codec::encode_datagram(1, long_id, sample(2), telemetry::StatusCode::kOk, buf, sizeof(buf));
+  REQUIRE(m > 0);
+  REQUIRE(telemetry::codec::decode_datagram(buf, m, d).ok());
+  REQUIRE(d.host_id.size() == telemetry::codec::kMaxDatagramHostId);
+  REQUIRE(telemetry::codec::encode_datagram(1, "x", sample(2), telemetry::StatusCode::kOk, buf, 8) == 0);
+}
+
+#ifndef _WIN32
+
+TELEMETRY_TEST_CASE("MulticastSender rejects unicast groups") {
+  telemetry::exporter::MulticastConfig cfg{};
+  cfg.group = "127.0.0.1";
+  cfg.port = 9200;
+  telemetry::exporter::MulticastSender sender(cfg);
+  REQUIRE(sender.open().code == telemetry::StatusCode::kInvalidArgument);
+}
+
+TELEMETRY_TEST_CASE("MulticastSender delivers sequenced datagrams over loopback multicast") {
+  const std::uint16_t port = static_cast<std::uint16_t>(20000 + (::getpid() % 20000) + 120);
+  const char* group = "239.255.70.77";
+
+  // Two receivers joined to the group on loopback, like two dashboards on one host.
+  int rx[2];
+  for (int& fd : rx) {
+    fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    REQUIRE(fd >= 0);
+    int yes = 1;
+    REQUIRE(::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes)) == 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    REQUIRE(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    ip_mreq mreq{};
+    REQUIRE(::inet_pton(AF_INET, group, &mreq.imr_multiaddr) == 1);
+    mreq.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+    REQUIRE(::setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) == 0);
+  }
+
+  telemetry::exporter::MulticastConfig cfg{};
+  cfg.group = group;
+  cfg.port = port;
+  cfg.interface = "127.0.0.1";
+  cfg.host_id = "loop-agent";
+  telemetry::exporter::MulticastSender sender(cfg);
+  REQUIRE(sender.open().ok());
+  constexpr int kSamples = 20;
+  for (int i = 0; i < kSamples; ++i) sender.on_snapshot(sample(i), telemetry::Status::Ok());
+  REQUIRE(sender.stats().sent == kSamples);
+  REQUIRE(sender.stats().send_errors == 0);
+
+  for (int fd : rx) {
+    std::uint64_t expect = 0;
+    std::uint8_t buf[2048];
+    while (expect < kSamples) {
+      pollfd p{fd, POLLIN, 0};
+      if (::poll(&p, 1, 2000) <= 0) break;
+      const ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+      REQUIRE(n > 0);
+      telemetry::codec::SnapshotDatagram d{};
+      REQUIRE(telemetry::codec::decode_datagram(buf, static_cast<std::size_t>(n), d).ok());
+      REQUIRE(d.seq == expect);
+      REQUIRE(d.host_id == "loop-agent");
+      REQUIRE(d.snap.uptime_s == sample(static_cast<int>(expect)).uptime_s);
+      ++expect;
+    }
+    REQUIRE(expect == kSamples);
+    ::close(fd);
+  }
+}
+
+#endif  // !_WIN32
@@ -8,6 +8,7 @@ TELEMETRY_TEST_CASE("parse_command handles basic commands") {
   REQUIRE(parse_command("PING").type == CommandType::kPing);
   REQUIRE(parse_command("GET").type == CommandType::kGet);
   REQUIRE(parse_command("RESTART").type == CommandType::kRestart);
+  REQUIRE(parse_command("CLIENTS").type == CommandType::kClients);
 }
 
 TELEMETRY_TEST_CASE("parse_command handles throttle") {
@@ -43,6 +44,33 @@ TELEMETRY_TEST_CASE("parse_command rejects invalid throttle") {
   }
 }
 
+TELEMETRY_TEST_CASE("parse_command handles DETAIL") {
+  const auto all = parse_command("DETAIL");
+  REQUIRE(all.type == CommandType::kDetail);
+  REQUIRE(all.ok);
+  REQUIRE(all.source.empty());
+  const auto one = parse_command("DETAIL linux_diskstats");
+  REQUIRE(one.ok);
+  REQUIRE(one.source == "linux_diskstats");
+  REQUIRE_FALSE(parse_command("DETAIL ").ok);
+  REQUIRE_FALSE(parse_command("DETAIL a b").ok);
+}
+
+TELEMETRY_TEST_CASE("parse_command handles TOP") {
+  const auto dflt = parse_command("TOP");
+  REQUIRE(dflt.type == CommandType::kTop);
+  REQUIRE(dflt.ok);
+  REQUIRE(dflt.count == 10);
+  const auto five = parse_command("TOP 5");
+  REQUIRE(five.ok);
+  REQUIRE(five.count == 5);
+  REQUIRE(parse_command("TOP 256").ok);
+  REQUIRE_FALSE(parse_command("TOP 257").ok);
+  REQUIRE_FALSE(parse_command("TOP 0").ok);
+  REQUIRE_FALSE(parse_command("TOP ").ok);
+  REQUIRE_FALSE(parse_command("TOP x").ok);
+}
+
 TELEMETRY_TEST_CASE("parse_command unknown") {
   REQUIRE(parse_command("HELLO").type == CommandType::kUnknown);
 }
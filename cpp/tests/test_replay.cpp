@@ -0,0 +1,186 @@
+#include "minitest.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "telemetry/metrics/replay_source.h"
+#include "telemetry/storage/spool.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+
+namespace {
+
+telemetry::MetricsSnapshot make_snapshot(std::uint64_t ts) {
+  telemetry::MetricsSnapshot s{};
+  s.ts_ms = ts;
+  s.cpu_usage_pct = 12.34;
+  s.mem_total_kb = 1024 * 1024;
+  s.mem_available_kb = 512 * 1024 + ts;
+  s.temperature_c = -5.25;
+  s.uptime_s = ts / 1000;
+  return s;
+}
+
+std::string make_temp_dir() {
+  char tmpl[] = "/tmp/telemetry_replay_XXXXXX";
+  const char* d = ::mkdtemp(tmpl);
+  if (!d) throw telemetry::tests::RequireFailure("mkdtemp failed");
+  return d;
+}
+
+void remove_dir(const std::string& dir) {
+  const std::string cmd = "rm -rf '" + dir + "'";
+  (void)std::system(cmd.c_str());
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("ReplaySource plays a spool back in order, across segments, and loops") {
+  const std::string dir = make_temp_dir();
+  {
+    telemetry::storage::SpoolConfig cfg{};
+    cfg.dir = dir.c_str();
+    cfg.segment_bytes = 256;
+    telemetry::storage::Spool spool(cfg);
+    REQUIRE(spool.open().ok());
+    for (std::uint64_t i = 1; i <= 40; ++i) {
+      const telemetry::Status collect_status = i == 5 ? telemetry::Status::IoError("x") : telemetry::Status::Ok();
+      REQUIRE(spool.append(make_snapshot(i * 1000), collect_status, i).ok());
+    }
+    REQUIRE(spool.flush(true).ok());
+  }
+  {
+    // Only files named as spool segments are read.
+    std::FILE* f = std::fopen((dir + "/notes.tlog").c_str(), "wb");
+    REQUIRE(f != nullptr);
+    REQUIRE(std::fputs("not a segment", f) >= 0);
+    std::fclose(f);
+  }
+
+  telemetry::metrics::ReplayConfig rcfg{};
+  rcfg.path = dir.c_str();
+  rcfg.speed = 0.0;
+  telemetry::metrics::ReplaySource replay(rcfg);
+  REQUIRE(replay.open().ok());
+  REQUIRE(replay.records() == 40);
+  REQUIRE(replay.segments() > 1);
+  REQUIRE(replay.duration_ms() == 39000);
+
+  // As fast as possible: one record per sample, then round again.
+  for (std::uint64_t n = 0; n < 45; ++n) {
+    telemetry::MetricsSnapshot s{};
+    s.ts_ms = 77;
+    const telemetry::Status st = replay.sample(s, 0);
+    const std::uint64_t i = n % 40 + 1;
+    REQUIRE(s.mem_available_kb == 512 * 1024 + i * 1000);
+    REQUIRE(s.ts_ms == 77);
+    REQUIRE(replay.trace_ts_ms() == i * 1000);
+    // The recorded collect failure is replayed with the record.
+    REQUIRE(st.code == (i == 5 ? telemetry::StatusCode::kIoError : telemetry::StatusCode::kOk));
+  }
+  REQUIRE(replay.loops() == 1);
+  std::string json;
+  REQUIRE(replay.append_detail_json(json));
+  REQUIRE(json.find("\"records\":40") != std::string::npos);
+
+  // A single segment replays on its own.
+  telemetry::metrics::ReplayConfig one = rcfg;
+  const std::string first = dir + "/00000000000000000000.tlog";
+  one.path = first.c_str();
+  telemetry::metrics::ReplaySource segment(one);
+  REQUIRE(segment.open().ok());
+  REQUIRE(segment.segments() == 1);
+  REQUIRE(segment.records() > 0);
+  REQUIRE(segment.records() < 40);
+  remove_dir(dir);
+
+  telemetry::metrics::ReplaySource missing(rcfg);
+  REQUIRE_FALSE(missing.open().ok());
+  telemetry::MetricsSnapshot s{};
+  REQUIRE(missing.sample(s, 0).code == telemetry::StatusCode::kUnavailable);
+}
+
+TELEMETRY_TEST_CASE("ReplaySource paces records by their timestamps at the chosen speed") {
+  const std::string dir = make_temp_dir();
+  {
+    telemetry::storage::SpoolConfig cfg{};
+    cfg.dir = dir.c_str();
+    telemetry::storage::Spool spool(cfg);
+    REQUIRE(spool.open().ok());
+    // Records 1 s apart, with a 10 s gap after the fifth.
+    for (std::uint64_t i = 1; i <= 10; ++i) {
+      REQUIRE(spool.append(make_snapshot(1'000'000 + i * 1000 + (i > 5 ? 10000 : 0)), telemetry::Status::Ok(), i).ok());
+    }
+    REQUIRE(spool.flush(true).ok());
+  }
+  const auto at = [](telemetry::metrics::ReplaySource& r, double wall_s) {
+    telemetry::MetricsSnapshot s{};
+    REQUIRE(r.sample(s, 5'000'000'000ULL + static_cast<std::uint64_t>(wall_s * 1e9)).ok());
+    return r.position();
+  };
+
+  telemetry::metrics::ReplayConfig rcfg{};
+  rcfg.path = dir.c_str();
+  rcfg.speed = 2.0;
+  telemetry::metrics::ReplaySource replay(rcfg);
+  REQUIRE(replay.open().ok());
+  REQUIRE(replay.duration_ms() == 19000);
+  REQUIRE(at(replay, 0.0) == 0);
+  REQUIRE(at(replay, 0.4) == 0);
+  REQUIRE(at(replay, 0.5) == 1);
+  REQUIRE(at(replay, 2.1) == 4);
+  // Inside the gap the last record before it holds.
+  REQUIRE(at(replay, 6.0) == 4);
+  REQUIRE(at(replay, 7.5) == 5);
+  REQUIRE(at(replay, 9.5) == 9);
+  // A pass is 19 s plus one mean interval (2.1 s) of trace time: about 10.56 s of wall time.
+  REQUIRE(at(replay, 10.6) == 0);
+  REQUIRE(replay.loops() == 1);
+  REQUIRE(at(replay, 10.55 + 2.1) == 4);
+
+  rcfg.loop = false;
+  telemetry::metrics::ReplaySource once(rcfg);
+  REQUIRE(once.open().ok());
+  REQUIRE(at(once, 0.0) == 0);
+  REQUIRE(at(once, 100.0) == 9);
+  REQUIRE(once.loops() == 0);
+  remove_dir(dir);
+}
+
+TELEMETRY_TEST_CASE("ReplaySource stops a segment at a corrupt record") {
+  const std::string dir = make_temp_dir();
+  {
+    telemetry::storage::SpoolConfig cfg{};
+    cfg.dir = dir.c_str();
+    telemetry::storage::Spool spool(cfg);
+    REQUIRE(spool.open().ok());
+    for (std::uint64_t i = 1; i <= 5; ++i) REQUIRE(spool.append(make_snapshot(i * 1000), telemetry::Status::Ok(), i).ok());
+    REQUIRE(spool.flush(true).ok());
+  }
+  {
+    // Flip one payload byte of the third record.
+    const std::string seg = dir + "/00000000000000000000.tlog";
+    std::FILE* f = std::fopen(seg.c_str(), "r+b");
+    REQUIRE(f != nullptr);
+    std::vector<std::uint8_t> data(4096);
+    data.resize(std::fread(data.data(), 1, data.size(), f));
+    std::size_t off = 0;
+    for (int r = 0; r < 2; ++r) off += telemetry::storage::kSpoolRecordHeaderSize + data[off];
+    data[off + telemetry::storage::kSpoolRecordHeaderSize + 2] ^= 0x40;
+    REQUIRE(std::fseek(f, 0, SEEK_SET) == 0);
+    REQUIRE(std::fwrite(data.data(), 1, data.size(), f) == data.size());
+    std::fclose(f);
+  }
+  telemetry::metrics::ReplayConfig rcfg{};
+  rcfg.path = dir.c_str();
+  telemetry::metrics::ReplaySource replay(rcfg);
+  REQUIRE(replay.open().ok());
+  REQUIRE(replay.records() == 2);
+  remove_dir(dir);
+}
+
+#endif  // !_WIN32
@@ -0,0 +1,232 @@
+#include "minitest.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "telemetry/net/protocol.h"
+#include "telemetry/net/tcp_server.h"
+#include "telemetry/rules/rule_engine.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+telemetry::MetricsSnapshot sample(double cpu, std::uint64_t total_kb = 1000, std::uint64_t avail_kb = 500,
+                                  std::uint64_t ts_ms = 0) {
+  telemetry::MetricsSnapshot s{};
+  s.ts_ms = ts_ms;
+  s.cpu_usage_pct = cpu;
+  s.mem_total_kb = total_kb;
+  s.mem_available_kb = avail_kb;
+  return s;
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("RuleEngine compiles rules and rejects bad ones") {
+  telemetry::rules::RuleEngine rules;
+  REQUIRE(rules.add_rule("high_cpu: cpu_usage_pct > 90 for 30s hysteresis 5").ok());
+  REQUIRE(rules.add_rule("mem_available_kb / mem_total_kb < 0.05").ok());
+  REQUIRE(rules.add_rule("hot: temperature_c * 9 / 5 + 32 >= -(-100 - 2 * 10)").ok());
+  REQUIRE(rules.size() == 3);
+  REQUIRE(std::strcmp(rules.rule_name(0), "high_cpu") == 0);
+  REQUIRE(std::strcmp(rules.rule_name(1), "rule1") == 0);
+
+  REQUIRE_FALSE(rules.add_rule("cpu_usage_pct 90").ok());
+  REQUIRE_FALSE(rules.add_rule("load_avg > 1").ok());
+  REQUIRE_FALSE(rules.add_rule("cpu_usage_pct > 90 for 30").ok());
+  REQUIRE_FALSE(rules.add_rule("cpu_usage_pct > (90").ok());
+  REQUIRE_FALSE(rules.add_rule("cpu_usage_pct > 90 extra").ok());
+  REQUIRE_FALSE(rules.add_rule("bad name: cpu_usage_pct > 90").ok());
+  std::string deep = "cpu_usage_pct";
+  for (int i = 0; i < 20; ++i) deep = "uptime_s + (" + deep + ")";
+  REQUIRE_FALSE(rules.add_rule(deep + " > 1").ok());
+  REQUIRE(rules.size() == 3);
+}
+
+TELEMETRY_TEST_CASE("RuleEngine evaluates precedence and ratios") {
+  telemetry::rules::RuleEngine rules;
+  REQUIRE(rules.add_rule("low_mem: mem_available_kb / mem_total_kb < 0.05").ok());
+  REQUIRE(rules.add_rule("prec: 2 + cpu_usage_pct * 3 > 31").ok());
+
+  rules.evaluate(sample(9.0, 1000, 500), 1000);
+  REQUIRE(rules.events().empty());
+
+  rules.evaluate(sample(10.0, 1000, 40), 2000);
+  REQUIRE(rules.events().size() == 2);
+  REQUIRE(rules.events()[0].rule == 0);
+  REQUIRE(rules.events()[0].firing);
+  REQUIRE(rules.events()[0].value > 0.0399 && rules.events()[0].value < 0.0401);
+  rules.clear_events();
+
+  // A zero total makes the ratio undefined: state is kept, no event.
+  rules.evaluate(sample(10.0, 0, 0), 3000);
+  REQUIRE(rules.events().empty());
+  REQUIRE(rules.is_firing(0));
+}
+
+TELEMETRY_TEST_CASE("RuleEngine honours for durations and hysteresis") {
+  telemetry::rules::RuleEngine rules;
+  REQUIRE(rules.add_rule("cpu: cpu_usage_pct > 90 for 30s hysteresis 5").ok());
+
+  rules.evaluate(sample(95.0), 0);
+  rules.evaluate(sample(95.0), 29999);
+  REQUIRE(rules.events().empty());
+  // A dip below the threshold restarts the pending window.
+  rules.evaluate(sample(80.0), 30000);
+  rules.evaluate(sample(95.0), 31000);
+  rules.evaluate(sample(95.0), 60000);
+  REQUIRE(rules.events().empty());
+  rules.evaluate(sample(95.0, 1000, 500, 1700000061000ULL), 61000);
+  REQUIRE(rules.events().size() == 1);
+  REQUIRE(rules.events()[0].firing);
+  REQUIRE(rules.events()[0].ts_ms == 1700000061000ULL);
+  REQUIRE(rules.firing_count() == 1);
+  rules.clear_events();
+
+  // Inside the hysteresis band: still firing.
+  rules.evaluate(sample(86.0), 62000);
+  REQUIRE(rules.events().empty());
+  rules.evaluate(sample(85.0), 63000);
+  REQUIRE(rules.events().size() == 1);
+  REQUIRE_FALSE(rules.events()[0].firing);
+  REQUIRE(rules.firing_count() == 0);
+}
+
+TELEMETRY_TEST_CASE("RuleEngine times for durations on the monotonic clock, not wall time") {
+  telemetry::rules::RuleEngine rules;
+  REQUIRE(rules.add_rule("cpu: cpu_usage_pct > 90 for 30s").ok());
+
+  // Wall time steps back an hour, then forward a day, while only 20s pass.
+  const std::uint64_t wall = 1700000000000ULL;
+  rules.evaluate(sample(95.0, 1000, 500, wall), 5000);
+  rules.evaluate(sample(95.0, 1000, 500, wall - 3600000), 15000);
+  rules.evaluate(sample(95.0, 1000, 500, wall + 86400000), 25000);
+  REQUIRE(rules.events().empty());
+
+  rules.evaluate(sample(95.0, 1000, 500, wall + 86410000), 35000);
+  REQUIRE(rules.events().size() == 1);
+  REQUIRE(rules.events()[0].firing);
+  REQUIRE(rules.events()[0].ts_ms == wall + 86410000);
+  std::vector<telemetry::rules::AlertEvent> firing;
+  rules.firing(firing);
+  REQUIRE(firing.size() == 1);
+  REQUIRE(firing[0].ts_ms == wall + 86410000);
+}
+
+TELEMETRY_TEST_CASE("RuleEngine loads rule files and reports the bad line") {
+  char path[] = "/tmp/telemetry_rules_XXXXXX";
+#ifndef _WIN32
+  const int fd = ::mkstemp(path);
+  REQUIRE(fd >= 0);
+  ::close(fd);
+#else
+  REQUIRE(std::tmpnam(path) != nullptr);
+#endif
+  std::FILE* f = std::fopen(path, "w");
+  REQUIRE(f != nullptr);
+  std::fputs("# comment\n\ncpu: cpu_usage_pct > 90\n  mem: mem_available_kb < 100\n", f);
+  std::fclose(f);
+
+  telemetry::rules::RuleEngine ok;
+  REQUIRE(ok.load_file(path).ok());
+  REQUIRE(ok.size() == 2);
+
+  f = std::fopen(path, "a");
+  std::fputs("cpu_usage_pct >> 1\n", f);
+  std::fclose(f);
+  telemetry::rules::RuleEngine bad;
+  std::size_t line = 0;
+  REQUIRE_FALSE(bad.load_file(path, &line).ok());
+  REQUIRE(line == 5);
+  std::remove(path);
+}
+
+TELEMETRY_TEST_CASE("parse_command handles ALERTS") {
+  REQUIRE(telemetry::net::parse_command("ALERTS").type == telemetry::net::CommandType::kAlerts);
+  REQUIRE(telemetry::net::parse_command("ALERTS x").type == telemetry::net::CommandType::kUnknown);
+}
+
+#ifndef _WIN32
+
+namespace {
+
+class StepCpuSource final : public telemetry::metrics::MetricSource {
+ public:
+  const char* name() const override { return "step_cpu"; }
+  telemetry::Status collect(telemetry::MetricsSnapshot& out) override {
+    // Low, then high long enough to fire, then low again to resolve.
+    const int n = calls_++;
+    out.cpu_usage_pct = (n >= 5 && n < 15) ? 99.0 : 10.0;
+    return telemetry::Status::Ok();
+  }
+
+ private:
+  int calls_{0};
+};
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("TcpServer streams alert transitions to ALERTS subscribers") {
+  const std::uint16_t port = static_cast<std::uint16_t>(20000 + (::getpid() % 20000) + 60);
+  telemetry::metrics::Collector collector;
+  collector.add_source(std::make_unique<StepCpuSource>());
+  telemetry::rules::RuleEngine rules;
+  REQUIRE(rules.add_rule("busy: cpu_usage_pct > 50").ok());
+
+  telemetry::net::TcpServerConfig cfg{};
+  cfg.host = "127.0.0.1";
+  cfg.port = port;
+  cfg.throttle_ms = 20;
+  cfg.run_for_ms = 1500;
+  std::thread srv([&collector, &rules, cfg] {
+    telemetry::net::TcpServer server(collector, cfg);
+    server.set_rules(&rules);
+    (void)server.run_forever();
+  });
+
+  int fd = -1;
+  for (int attempt = 0; attempt < 100 && fd < 0; ++attempt) {
+    fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+      ::close(fd);
+      fd = -1;
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+  }
+  REQUIRE(fd >= 0);
+  REQUIRE(::write(fd, "ALERTS\n", 7) == 7);
+
+  std::string got;
+  char tmp[512];
+  while (got.find("\"state\":\"resolved\"") == std::string::npos) {
+    const ssize_t n = ::read(fd, tmp, sizeof(tmp));
+    if (n <= 0) break;
+    got.append(tmp, static_cast<std::size_t>(n));
+  }
+  ::close(fd);
+  srv.join();
+
+  REQUIRE(got.find("\"message\":\"subscribed\",\"rules\":1") != std::string::npos);
+  const std::size_t firing = got.find("{\"event\":\"alert\",\"rule\":\"busy\",\"state\":\"firing\",\"value\":99,");
+  const std::size_t resolved = got.find("{\"event\":\"alert\",\"rule\":\"busy\",\"state\":\"resolved\",\"value\":10,");
+  REQUIRE(firing != std::string::npos);
+  REQUIRE(resolved != std::string::npos);
+  REQUIRE(firing < resolved);
+}
+
+#endif  // !_WIN32
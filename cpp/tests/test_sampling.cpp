@@ -0,0 +1,151 @@
+#include "minitest.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "telemetry/metrics/collector.h"
+#include "telemetry/metrics/static_collector.h"
+#include "telemetry/net/tcp_server.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+int connect_loopback(std::uint16_t port) {
+  for (int attempt = 0; attempt < 100; ++attempt) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+    ::close(fd);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return -1;
+}
+
+// Reads until `needle` shows up; false on EOF, error or after timeout_ms without it.
+bool read_until(int fd, const char* needle, int timeout_ms) {
+  std::string got;
+  char tmp[4096];
+  const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (got.find(needle) == std::string::npos) {
+    const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(until - std::chrono::steady_clock::now());
+    pollfd p{fd, POLLIN, 0};
+    if (left.count() <= 0 || ::poll(&p, 1, static_cast<int>(left.count())) <= 0) return false;
+    const ssize_t n = ::read(fd, tmp, sizeof(tmp));
+    if (n <= 0) return false;
+    got.append(tmp, static_cast<std::size_t>(n));
+  }
+  return true;
+}
+
+class ConstSource final : public telemetry::metrics::MetricSource {
+ public:
+  const char* name() const override { return "const"; }
+  telemetry::Status collect(telemetry::MetricsSnapshot& out) override {
+    out.uptime_s = 42;
+    return telemetry::Status::Ok();
+  }
+};
+
+// Uptime counts collections, so every sample differs from the last.
+class CountingSource final : public telemetry::metrics::MetricSource {
+ public:
+  const char* name() const override { return "counting"; }
+  telemetry::Status collect(telemetry::MetricsSnapshot& out) override {
+    out.uptime_s = ++collects;
+    return telemetry::Status::Ok();
+  }
+  std::atomic<std::uint64_t> collects{0};
+};
+
+// Fires when a byte is written to its pipe, like a PSI trigger reporting POLLPRI.
+class PipeTrigger final : public telemetry::metrics::SampleTrigger {
+ public:
+  PipeTrigger() {
+    if (::pipe(fds) != 0) fds[0] = fds[1] = -1;
+  }
+  ~PipeTrigger() override {
+    for (int fd : fds) ::close(fd);
+  }
+  const char* name() const override { return "pipe"; }
+  int fd() const override { return fds[0]; }
+  short events() const override { return POLLIN; }
+  bool on_ready(short revents) override {
+    char b[16];
+    if (revents & POLLIN) (void)::read(fds[0], b, sizeof(b));
+    return true;
+  }
+  int fds[2]{-1, -1};
+};
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("TcpServer samples out of band when a trigger fires") {
+  const std::uint16_t port = static_cast<std::uint16_t>(20000 + (::getpid() % 20000) + 103);
+  telemetry::metrics::Collector collector;
+  auto counting = std::make_unique<CountingSource>();
+  CountingSource* source = counting.get();
+  collector.add_source(std::move(counting));
+  PipeTrigger trigger;
+  REQUIRE(trigger.fd() >= 0);
+
+  telemetry::net::TcpServerConfig cfg{};
+  cfg.host = "127.0.0.1";
+  cfg.port = port;
+  cfg.run_for_ms = 3000;
+  cfg.throttle_ms = 60000;  // background sampling would not come round during the test
+  telemetry::net::TcpServer server(collector, cfg);
+  server.add_trigger(&trigger);
+  std::thread srv([&server] { (void)server.run_forever(); });
+
+  const int sub_fd = connect_loopback(port);
+  REQUIRE(sub_fd >= 0);
+  REQUIRE(::send(sub_fd, "SUBSCRIBE DELTA 0 0 60000\n", 26, MSG_NOSIGNAL) == 26);
+  REQUIRE(read_until(sub_fd, "\"key\":true", 1000));
+  const std::uint64_t before = source->collects.load();
+
+  const auto t0 = std::chrono::steady_clock::now();
+  REQUIRE(::write(trigger.fds[1], "x", 1) == 1);
+  REQUIRE(read_until(sub_fd, "uptime_s", 1000));
+  REQUIRE(std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(500));
+  REQUIRE(source->collects.load() == before + 1);
+
+  ::close(sub_fd);
+  server.stop();
+  srv.join();
+}
+
+TELEMETRY_TEST_CASE("TcpServer serves a StaticCollector like a Collector") {
+  telemetry::metrics::StaticCollector<ConstSource> collector;
+  telemetry::net::TcpServerConfig cfg{};
+  cfg.host = "127.0.0.1";
+  cfg.port = static_cast<std::uint16_t>(20000 + (::getpid() % 20000) + 112);
+  cfg.run_for_ms = 500;
+  telemetry::Status run_status = telemetry::Status::Internal("not run");
+  std::thread srv([&collector, &run_status, cfg] {
+    telemetry::net::TcpServer server(collector, cfg);
+    run_status = server.run_forever();
+  });
+
+  const int fd = connect_loopback(cfg.port);
+  REQUIRE(fd >= 0);
+  REQUIRE(::send(fd, "GET\n", 4, MSG_NOSIGNAL) == 4);
+  REQUIRE(read_until(fd, "\"uptime_s\":42", 1000));
+  ::close(fd);
+  srv.join();
+  REQUIRE(run_status.ok());
+}
+
+#endif  // !_WIN32
@@ -0,0 +1,192 @@
+#include "minitest.h"
+
+#ifndef _WIN32
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "telemetry/shm/shm_publisher.h"
+#include "telemetry/shm/shm_reader.h"
+
+namespace {
+
+// Every field is a function of i, so a sample assembled from two writes is detectable.
+telemetry::MetricsSnapshot sample(std::uint64_t i) {
+  telemetry::MetricsSnapshot s{};
+  s.ts_ms = 1000 + i;
+  s.cpu_usage_pct = static_cast<double>(i) * 0.5;
+  s.mem_total_kb = i * 3;
+  s.mem_available_kb = i * 7;
+  s.temperature_c = -static_cast<double>(i);
+  s.uptime_s = i * 11;
+  return s;
+}
+
+bool consistent(const telemetry::shm::ShmSample& s) {
+  const std::uint64_t i = s.index;
+  return s.snap.ts_ms == 1000 + i && s.snap.cpu_usage_pct == static_cast<double>(i) * 0.5 &&
+         s.snap.mem_total_kb == i * 3 && s.snap.mem_available_kb == i * 7 &&
+         s.snap.temperature_c == -static_cast<double>(i) && s.snap.uptime_s == i * 11;
+}
+
+struct ShmName final {
+  char buf[64];
+  explicit ShmName(const char* tag) {
+    std::snprintf(buf, sizeof(buf), "/telemetry_test_%s_%d", tag, static_cast<int>(::getpid()));
+  }
+};
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("ShmPublisher publishes latest and history to ShmReader") {
+  const ShmName name("basic");
+  telemetry::shm::ShmConfig cfg{};
+  cfg.name = name.buf;
+  cfg.history = 8;
+  telemetry::shm::ShmPublisher pub(cfg);
+  REQUIRE(pub.open().ok());
+
+  telemetry::shm::ShmReader reader;
+  REQUIRE(reader.open(name.buf).ok());
+  REQUIRE(reader.capacity() == 8);
+  REQUIRE(reader.writer_pid() == static_cast<std::uint32_t>(::getpid()));
+  telemetry::shm::ShmSample s{};
+  REQUIRE_FALSE(reader.latest(s));
+
+  pub.on_snapshot(sample(0), telemetry::Status::Unavailable("no sensor"));
+  REQUIRE(reader.latest(s));
+  REQUIRE(s.index == 0);
+  REQUIRE(s.status == telemetry::StatusCode::kUnavailable);
+  REQUIRE(consistent(s));
+
+  for (std::uint64_t i = 1; i < 20; ++i) pub.on_snapshot(sample(i), telemetry::Status::Ok());
+  REQUIRE(reader.published() == 20);
+  REQUIRE(reader.latest(s));
+  REQUIRE(s.index == 19);
+  REQUIRE(s.status == telemetry::StatusCode::kOk);
+  REQUIRE(consistent(s));
+
+  telemetry::shm::ShmSample hist[16];
+  REQUIRE(reader.history(hist, 3) == 3);
+  REQUIRE(hist[0].index == 17 && hist[2].index == 19);
+  REQUIRE(reader.history(hist, 16) == 7);
+  for (std::size_t k = 0; k < 7; ++k) {
+    REQUIRE(hist[k].index == 13 + k);
+    REQUIRE(consistent(hist[k]));
+  }
+}
+
+TELEMETRY_TEST_CASE("ShmReader rejects missing segments") {
+  const ShmName name("missing");
+  telemetry::shm::ShmReader reader;
+  REQUIRE_FALSE(reader.open(name.buf).ok());
+  REQUIRE_FALSE(reader.is_open());
+  telemetry::shm::ShmSample s{};
+  REQUIRE_FALSE(reader.latest(s));
+  REQUIRE(reader.history(&s, 1) == 0);
+
+  telemetry::shm::ShmConfig cfg{};
+  cfg.name = "no-leading-slash";
+  telemetry::shm::ShmPublisher pub(cfg);
+  REQUIRE_FALSE(pub.open().ok());
+}
+
+TELEMETRY_TEST_CASE("ShmPublisher leaves a live writer's segment alone and replaces a dead one's") {
+  const ShmName name("owner");
+  telemetry::shm::ShmConfig cfg{};
+  cfg.name = name.buf;
+  cfg.history = 4;
+  {
+    telemetry::shm::ShmPublisher first(cfg);
+    REQUIRE(first.open().ok());
+    first.on_snapshot(sample(1), telemetry::Status::Ok());
+    {
+      telemetry::shm::ShmPublisher second(cfg);
+      REQUIRE(second.open().code == telemetry::StatusCode::kIoError);
+    }
+    telemetry::shm::ShmReader reader;
+    REQUIRE(reader.open(name.buf).ok());
+    REQUIRE(reader.published() == 1);
+  }
+  telemetry::shm::ShmReader gone;
+  REQUIRE_FALSE(gone.open(name.buf).ok());
+
+  // A child publishes and exits without cleaning up, as a crashed agent would.
+  const pid_t child = ::fork();
+  REQUIRE(child >= 0);
+  if (child == 0) {
+    telemetry::shm::ShmPublisher crashed(cfg);
+    ::_exit(crashed.open().ok() ? 0 : 1);
+  }
+  int wstatus = 0;
+  REQUIRE(::waitpid(child, &wstatus, 0) == child);
+  REQUIRE(WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0);
+  telemetry::shm::ShmReader stale;
+  REQUIRE(stale.open(name.buf).ok());
+  REQUIRE(stale.writer_pid() == static_cast<std::uint32_t>(child));
+
+  telemetry::shm::ShmPublisher next(cfg);
+  REQUIRE(next.open().ok());
+  telemetry::shm::ShmReader reader;
+  REQUIRE(reader.open(name.buf).ok());
+  REQUIRE(reader.writer_pid() == static_cast<std::uint32_t>(::getpid()));
+}
+
+TELEMETRY_TEST_CASE("ShmReader never returns torn samples under concurrent publishing") {
+  const ShmName name("stress");
+  telemetry::shm::ShmConfig cfg{};
+  cfg.name = name.buf;
+  cfg.history = 4;  // small ring: history reads race the writer lapping them
+  telemetry::shm::ShmPublisher pub(cfg);
+  REQUIRE(pub.open().ok());
+
+  constexpr int kReaders = 3;
+  std::atomic<bool> stop{false};
+  std::atomic<std::uint64_t> torn{0};
+  std::atomic<std::uint64_t> backwards{0};
+  std::atomic<std::uint64_t> reads{0};
+  std::vector<std::thread> readers;
+  for (int r = 0; r < kReaders; ++r) {
+    readers.emplace_back([&] {
+      telemetry::shm::ShmReader reader;
+      if (!reader.open(name.buf).ok()) {
+        torn.fetch_add(1);
+        return;
+      }
+      std::uint64_t last = 0;
+      telemetry::shm::ShmSample s{};
+      telemetry::shm::ShmSample hist[4];
+      while (!stop.load(std::memory_order_relaxed)) {
+        if (reader.latest(s)) {
+          if (!consistent(s)) torn.fetch_add(1);
+          if (s.index < last) backwards.fetch_add(1);
+          last = s.index;
+          reads.fetch_add(1, std::memory_order_relaxed);
+        }
+        const std::size_t n = reader.history(hist, 4);
+        for (std::size_t k = 0; k < n; ++k) {
+          if (!consistent(hist[k]) || (k > 0 && hist[k].index <= hist[k - 1].index)) torn.fetch_add(1);
+        }
+      }
+    });
+  }
+
+  std::uint64_t i = 0;
+  while (i < 200000 || reads.load() < 10000) {
+    pub.on_snapshot(sample(i++), telemetry::Status::Ok());
+    if ((i & 255U) == 0) std::this_thread::yield();
+  }
+  stop.store(true);
+  for (auto& t : readers) t.join();
+
+  REQUIRE(torn.load() == 0);
+  REQUIRE(backwards.load() == 0);
+  REQUIRE(reads.load() >= 10000);
+}
+
+#endif  // !_WIN32
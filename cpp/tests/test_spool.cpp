@@ -0,0 +1,254 @@
+#include "minitest.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "telemetry/codec/snapshot_codec.h"
+#include "telemetry/net/protocol.h"
+#include "telemetry/storage/spool.h"
+#include "telemetry/util/crc32.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+telemetry::MetricsSnapshot make_snapshot(std::uint64_t ts) {
+  telemetry::MetricsSnapshot s{};
+  s.ts_ms = ts;
+  s.cpu_usage_pct = 12.34;
+  s.mem_total_kb = 1024 * 1024;
+  s.mem_available_kb = 512 * 1024 + ts;
+  s.temperature_c = -5.25;
+  s.uptime_s = ts / 1000;
+  return s;
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("crc32 matches the IEEE check value") {
+  REQUIRE(telemetry::util::crc32("123456789", 9) == 0xCBF43926U);
+}
+
+TELEMETRY_TEST_CASE("snapshot codec round-trips with two-decimal precision") {
+  const telemetry::MetricsSnapshot in = make_snapshot(1700000000123ULL);
+  std::uint8_t buf[telemetry::codec::kMaxEncodedSnapshotSize];
+  const std::size_t n = telemetry::codec::encode_snapshot(in, telemetry::StatusCode::kIoError, buf, sizeof(buf));
+  REQUIRE(n > 0);
+  REQUIRE(n < 32);
+
+  telemetry::MetricsSnapshot out{};
+  telemetry::StatusCode code{};
+  REQUIRE(telemetry::codec::decode_snapshot(buf, n, out, &code).ok());
+  REQUIRE(code == telemetry::StatusCode::kIoError);
+  REQUIRE(out.ts_ms == in.ts_ms);
+  REQUIRE(out.mem_available_kb == in.mem_available_kb);
+  REQUIRE(out.cpu_usage_pct > 12.339 && out.cpu_usage_pct < 12.341);
+  REQUIRE(out.temperature_c > -5.251 && out.temperature_c < -5.249);
+  REQUIRE_FALSE(telemetry::codec::decode_snapshot(buf, n - 1, out, nullptr).ok());
+}
+
+TELEMETRY_TEST_CASE("parse_command handles drain") {
+  using telemetry::net::CommandType;
+  using telemetry::net::parse_command;
+  {
+    const auto pc = parse_command("DRAIN 18446744073709551615");
+    REQUIRE(pc.type == CommandType::kDrain);
+    REQUIRE(pc.ok);
+    REQUIRE(pc.cursor == UINT64_MAX);
+  }
+  REQUIRE_FALSE(parse_command("DRAIN ").ok);
+  REQUIRE_FALSE(parse_command("DRAIN 1x").ok);
+  REQUIRE_FALSE(parse_command("DRAIN 18446744073709551616").ok);
+}
+
+#ifndef _WIN32
+
+namespace {
+
+std::string make_temp_dir() {
+  char tmpl[] = "/tmp/telemetry_spool_XXXXXX";
+  const char* d = ::mkdtemp(tmpl);
+  if (!d) throw telemetry::tests::RequireFailure("mkdtemp failed");
+  return d;
+}
+
+void remove_dir(const std::string& dir) {
+  const std::string cmd = "rm -rf '" + dir + "'";
+  (void)std::system(cmd.c_str());
+}
+
+// Reads every record of a drain range and returns the decoded timestamps.
+std::vector<std::uint64_t> read_records(const telemetry::storage::DrainRange& r) {
+  std::vector<std::uint8_t> data(static_cast<std::size_t>(r.length));
+  if (r.length > 0 && ::pread(r.fd, data.data(), data.size(), static_cast<off_t>(r.file_offset)) !=
+                          static_cast<ssize_t>(data.size())) {
+    throw telemetry::tests::RequireFailure("pread failed");
+  }
+  std::vector<std::uint64_t> ts;
+  std::size_t off = 0;
+  while (off + telemetry::storage::kSpoolRecordHeaderSize <= data.size()) {
+    const std::uint32_t len = data[off] | (data[off + 1] << 8) | (data[off + 2] << 16) |
+                              (static_cast<std::uint32_t>(data[off + 3]) << 24);
+    const std::uint32_t crc = data[off + 4] | (data[off + 5] << 8) | (data[off + 6] << 16) |
+                              (static_cast<std::uint32_t>(data[off + 7]) << 24);
+    const std::uint8_t* payload = data.data() + off + telemetry::storage::kSpoolRecordHeaderSize;
+    if (telemetry::util::crc32(payload, len) != crc) throw telemetry::tests::RequireFailure("crc mismatch");
+    telemetry::MetricsSnapshot s{};
+    if (!telemetry::codec::decode_snapshot(payload, len, s, nullptr).ok()) {
+      throw telemetry::tests::RequireFailure("decode failed");
+    }
+    ts.push_back(s.ts_ms);
+    off += telemetry::storage::kSpoolRecordHeaderSize + len;
+  }
+  if (off != data.size()) throw telemetry::tests::RequireFailure("partial record in drain range");
+  return ts;
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("Spool appends, rotates and drains by cursor") {
+  const std::string dir = make_temp_dir();
+  {
+    telemetry::storage::SpoolConfig cfg{};
+    cfg.dir = dir.c_str();
+    cfg.segment_bytes = 256;
+    cfg.budget_bytes = 1024 * 1024;
+    telemetry::storage::Spool spool(cfg);
+    REQUIRE(spool.open().ok());
+    for (std::uint64_t i = 1; i <= 40; ++i) REQUIRE(spool.append(make_snapshot(i * 1000), telemetry::Status::Ok(), i).ok());
+
+    std::vector<std::uint64_t> seen;
+    std::uint64_t cursor = 0;
+    int segments = 0;
+    while (true) {
+      telemetry::storage::DrainRange r{};
+      REQUIRE(spool.drain_range(cursor, r).ok());
+      if (r.length == 0) break;
+      REQUIRE(r.length <= cfg.segment_bytes);
+      const auto ts = read_records(r);
+      ::close(r.fd);
+      seen.insert(seen.end(), ts.begin(), ts.end());
+      cursor = r.next_cursor;
+      ++segments;
+    }
+    REQUIRE(segments > 1);
+    REQUIRE(cursor == spool.tail_cursor());
+    REQUIRE(seen.size() == 40);
+    for (std::size_t i = 0; i < seen.size(); ++i) REQUIRE(seen[i] == (i + 1) * 1000);
+  }
+  remove_dir(dir);
+}
+
+TELEMETRY_TEST_CASE("Spool drains from the next record for a cursor inside one") {
+  const std::string dir = make_temp_dir();
+  {
+    telemetry::storage::SpoolConfig cfg{};
+    cfg.dir = dir.c_str();
+    cfg.segment_bytes = 256;
+    cfg.budget_bytes = 1024 * 1024;
+    telemetry::storage::Spool spool(cfg);
+    REQUIRE(spool.open().ok());
+    for (std::uint64_t i = 1; i <= 40; ++i) REQUIRE(spool.append(make_snapshot(i * 1000), telemetry::Status::Ok(), i).ok());
+
+    telemetry::storage::DrainRange first{};
+    REQUIRE(spool.drain_range(0, first).ok());
+    const auto all = read_records(first);
+    ::close(first.fd);
+    REQUIRE(all.size() > 2);
+
+    // Three bytes into the second record: the stream starts at the third.
+    std::uint8_t hdr[telemetry::storage::kSpoolRecordHeaderSize];
+    const int fd = ::open((dir + "/00000000000000000000.tlog").c_str(), O_RDONLY);
+    REQUIRE(fd >= 0);
+    REQUIRE(::pread(fd, hdr, sizeof(hdr), 0) == static_cast<ssize_t>(sizeof(hdr)));
+    const std::uint64_t second = telemetry::storage::kSpoolRecordHeaderSize + hdr[0] + (hdr[1] << 8);
+    REQUIRE(::pread(fd, hdr, sizeof(hdr), static_cast<off_t>(second)) == static_cast<ssize_t>(sizeof(hdr)));
+    const std::uint64_t third = second + telemetry::storage::kSpoolRecordHeaderSize + hdr[0] + (hdr[1] << 8);
+    ::close(fd);
+
+    telemetry::storage::DrainRange r{};
+    REQUIRE(spool.drain_range(second + 3, r).ok());
+    REQUIRE(r.from_cursor == third);
+    REQUIRE(r.next_cursor == first.next_cursor);
+    const auto ts = read_records(r);
+    ::close(r.fd);
+    REQUIRE(ts.size() == all.size() - 2);
+    REQUIRE(ts.front() == all[2]);
+
+    // Inside the last record of a segment: the stream starts at the next segment.
+    telemetry::storage::DrainRange next{};
+    REQUIRE(spool.drain_range(first.next_cursor - 1, next).ok());
+    REQUIRE(next.from_cursor == first.next_cursor);
+    REQUIRE(read_records(next).front() == (all.size() + 1) * 1000);
+    ::close(next.fd);
+  }
+  remove_dir(dir);
+}
+
+TELEMETRY_TEST_CASE("Spool retention drops oldest segments over budget") {
+  const std::string dir = make_temp_dir();
+  {
+    telemetry::storage::SpoolConfig cfg{};
+    cfg.dir = dir.c_str();
+    cfg.segment_bytes = 256;
+    cfg.budget_bytes = 1024;
+    telemetry::storage::Spool spool(cfg);
+    REQUIRE(spool.open().ok());
+    for (std::uint64_t i = 1; i <= 200; ++i) REQUIRE(spool.append(make_snapshot(i), telemetry::Status::Ok(), i).ok());
+    REQUIRE(spool.flush(true).ok());
+    REQUIRE(spool.disk_bytes() <= cfg.budget_bytes + cfg.segment_bytes);
+    REQUIRE(spool.head_cursor() > 0);
+
+    // A cursor that fell behind retention restarts at the oldest retained record.
+    telemetry::storage::DrainRange r{};
+    REQUIRE(spool.drain_range(0, r).ok());
+    REQUIRE(r.from_cursor == spool.head_cursor());
+    REQUIRE(!read_records(r).empty());
+    ::close(r.fd);
+  }
+  remove_dir(dir);
+}
+
+TELEMETRY_TEST_CASE("Spool reopen truncates a torn tail record") {
+  const std::string dir = make_temp_dir();
+  std::uint64_t tail = 0;
+  {
+    telemetry::storage::SpoolConfig cfg{};
+    cfg.dir = dir.c_str();
+    telemetry::storage::Spool spool(cfg);
+    REQUIRE(spool.open().ok());
+    for (std::uint64_t i = 1; i <= 5; ++i) REQUIRE(spool.append(make_snapshot(i), telemetry::Status::Ok(), i).ok());
+    REQUIRE(spool.flush(true).ok());
+    tail = spool.tail_cursor();
+  }
+  {
+    // Simulate a crash in the middle of a write.
+    const std::string seg = dir + "/00000000000000000000.tlog";
+    std::FILE* f = std::fopen(seg.c_str(), "ab");
+    REQUIRE(f != nullptr);
+    const unsigned char junk[] = {20, 0, 0, 0, 1, 2, 3, 4, 9};
+    REQUIRE(std::fwrite(junk, 1, sizeof(junk), f) == sizeof(junk));
+    std::fclose(f);
+  }
+  {
+    telemetry::storage::SpoolConfig cfg{};
+    cfg.dir = dir.c_str();
+    telemetry::storage::Spool spool(cfg);
+    REQUIRE(spool.open().ok());
+    REQUIRE(spool.tail_cursor() == tail);
+    REQUIRE(spool.append(make_snapshot(6), telemetry::Status::Ok(), 6).ok());
+
+    telemetry::storage::DrainRange r{};
+    REQUIRE(spool.drain_range(0, r).ok());
+    REQUIRE(read_records(r).size() == 6);
+    ::close(r.fd);
+  }
+  remove_dir(dir);
+}
+
+#endif  // !_WIN32
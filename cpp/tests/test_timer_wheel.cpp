@@ -0,0 +1,174 @@
+#include "minitest.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "telemetry/util/timer_wheel.h"
+
+using telemetry::util::TimerWheel;
+using telemetry::util::WheelTimer;
+
+TELEMETRY_TEST_CASE("TimerWheel fires timers in due order across levels") {
+  TimerWheel wheel(1000);
+  WheelTimer t[5];
+  const std::uint64_t due[5] = {1000 + 70000, 1000 + 5, 1000 + 300, 1000 + 63, 1000 + 64};
+  for (int i = 0; i < 5; ++i) {
+    t[i].tag = static_cast<std::uint32_t>(i);
+    wheel.schedule(t[i], due[i]);
+  }
+  REQUIRE(wheel.size() == 5);
+
+  std::vector<std::pair<std::uint32_t, std::uint64_t>> fired;
+  auto record = [&](WheelTimer& w) { fired.emplace_back(w.tag, wheel.now_ms()); };
+  REQUIRE(wheel.advance(1004, record) == 0);
+  REQUIRE(wheel.advance(1064, record) == 3);
+  REQUIRE(wheel.advance(200000, record) == 2);
+  REQUIRE(fired.size() == 5);
+  const std::uint32_t order[5] = {1, 3, 4, 2, 0};
+  for (int i = 0; i < 5; ++i) {
+    REQUIRE(fired[static_cast<std::size_t>(i)].first == order[i]);
+    // Each fires with the clock at exactly its due time, not at the advance() target.
+    REQUIRE(fired[static_cast<std::size_t>(i)].second == due[order[i]]);
+  }
+  REQUIRE(wheel.size() == 0);
+  REQUIRE_FALSE(t[0].armed());
+  REQUIRE(wheel.now_ms() == 200000);
+}
+
+TELEMETRY_TEST_CASE("TimerWheel cancel, reschedule and poll timeout") {
+  TimerWheel wheel(0);
+  WheelTimer a;
+  WheelTimer b;
+  REQUIRE(wheel.poll_timeout_ms(0) == -1);
+  wheel.schedule(a, 40);
+  wheel.schedule(b, 5000);
+  REQUIRE(wheel.poll_timeout_ms(0) == 40);
+  REQUIRE(wheel.poll_timeout_ms(10) == 30);
+
+  wheel.cancel(a);
+  REQUIRE_FALSE(a.armed());
+  REQUIRE(wheel.size() == 1);
+  // Coarse levels report a lower bound: the start of b's slot, never later than b.
+  std::uint64_t next = 0;
+  REQUIRE(wheel.next_due_ms(next));
+  REQUIRE(next <= 5000);
+  REQUIRE(next > 40);
+
+  wheel.schedule(b, 7);  // re-arming moves it
+  REQUIRE(wheel.size() == 1);
+  REQUIRE(wheel.poll_timeout_ms(0) == 7);
+  int fired = 0;
+  wheel.advance(7, [&](WheelTimer&) { ++fired; });
+  REQUIRE(fired == 1);
+
+  // Past due times fire on the next advance.
+  wheel.schedule(a, 1);
+  REQUIRE(a.due_ms() == 7);
+  REQUIRE(wheel.poll_timeout_ms(7) == 0);
+  REQUIRE(wheel.advance(7, [](WheelTimer&) {}) == 1);
+
+  // Parked beyond the top level, then carried down as the clock gets there.
+  wheel.schedule(a, TimerWheel::kMaxDelayMs * 3);
+  REQUIRE(wheel.advance(TimerWheel::kMaxDelayMs * 3 - 1, [](WheelTimer&) {}) == 0);
+  REQUIRE(a.armed());
+  REQUIRE(wheel.advance(TimerWheel::kMaxDelayMs * 3, [](WheelTimer&) {}) == 1);
+}
+
+TELEMETRY_TEST_CASE("TimerWheel callbacks may re-arm and cancel timers") {
+  TimerWheel wheel(0);
+  WheelTimer tick;
+  WheelTimer victim;
+  wheel.schedule(tick, 10);
+  wheel.schedule(victim, 10);
+  int ticks = 0;
+  auto on_expire = [&](WheelTimer& t) {
+    if (&t != &tick) return;
+    ++ticks;
+    wheel.cancel(victim);
+    wheel.schedule(tick, wheel.now_ms() + 10);
+  };
+  REQUIRE(wheel.advance(95, on_expire) == 9);
+  REQUIRE(ticks == 9);
+  REQUIRE_FALSE(victim.armed());
+  REQUIRE(tick.due_ms() == 100);
+  wheel.reset(0);
+  REQUIRE_FALSE(tick.armed());
+  REQUIRE(wheel.size() == 0);
+}
+
+TELEMETRY_TEST_CASE("TimerWheel matches a reference model under random operations") {
+  constexpr int kTimers = 200;
+  std::vector<std::unique_ptr<WheelTimer>> timers;
+  for (int i = 0; i < kTimers; ++i) {
+    timers.push_back(std::make_unique<WheelTimer>());
+    timers.back()->tag = static_cast<std::uint32_t>(i);
+  }
+  std::map<std::uint32_t, std::uint64_t> model;  // tag -> due
+
+  std::uint64_t rng = 0x9E3779B97F4A7C15ULL;
+  auto next = [&rng] {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng;
+  };
+
+  TimerWheel wheel(123456);
+  std::uint64_t now = 123456;
+  for (int step = 0; step < 20000; ++step) {
+    const std::uint64_t r = next();
+    WheelTimer& t = *timers[r % kTimers];
+    switch ((r >> 8) % 4) {
+      case 0:
+      case 1: {
+        // Mostly short delays with the occasional long one, to exercise every level and the
+        // horizon beyond the top one.
+        std::uint64_t delay = (r >> 20) % 5000;
+        if ((r >> 16) % 8 == 0) delay = (r >> 20) % 50000000;
+        if ((r >> 16) % 256 == 1) delay = (r >> 20) % (3 * TimerWheel::kMaxDelayMs);
+        wheel.schedule(t, now + delay);
+        model[t.tag] = now + delay;
+        break;
+      }
+      case 2:
+        wheel.cancel(t);
+        model.erase(t.tag);
+        break;
+      default: {
+        if ((r >> 12) % 128 == 0) {
+          now += (r >> 16) % (2 * TimerWheel::kMaxDelayMs);
+        } else {
+          now += (r >> 16) % ((r >> 12) % 16 == 0 ? 10000000 : 3000);
+        }
+        std::vector<std::uint32_t> fired;
+        wheel.advance(now, [&](WheelTimer& w) {
+          REQUIRE(w.due_ms() == wheel.now_ms());
+          fired.push_back(w.tag);
+        });
+        std::uint64_t prev_due = 0;
+        for (std::uint32_t tag : fired) {
+          REQUIRE(model.count(tag) == 1);
+          REQUIRE(model[tag] <= now);
+          REQUIRE(model[tag] >= prev_due);
+          prev_due = model[tag];
+          model.erase(tag);
+        }
+        for (const auto& [tag, due] : model) REQUIRE(due > now);
+        break;
+      }
+    }
+    REQUIRE(wheel.size() == model.size());
+    std::uint64_t bound = 0;
+    if (!model.empty()) {
+      std::uint64_t earliest = UINT64_MAX;
+      for (const auto& [tag, due] : model) earliest = std::min(earliest, due);
+      REQUIRE(wheel.next_due_ms(bound));
+      REQUIRE(bound <= earliest);
+    } else {
+      REQUIRE_FALSE(wheel.next_due_ms(bound));
+    }
+  }
+}
@@ -0,0 +1,201 @@
+#include "minitest.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "telemetry/metrics/collector.h"
+#include "telemetry/net/protocol.h"
+#include "telemetry/net/tcp_server.h"
+#include "telemetry/trace/trace.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::size_t count_of(const std::string& s, const char* needle) {
+  std::size_t n = 0;
+  for (std::size_t pos = s.find(needle); pos != std::string::npos; pos = s.find(needle, pos + 1)) ++n;
+  return n;
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("trace records nothing while disabled") {
+  telemetry::trace::set_enabled(false);
+  telemetry::trace::clear();
+  { telemetry::trace::Span span("disabled_span"); }
+  std::string json;
+  REQUIRE(telemetry::trace::write_chrome_json(json) == 0);
+  REQUIRE(json.find("\"traceEvents\":[") != std::string::npos);
+  REQUIRE(json.find("disabled_span") == std::string::npos);
+}
+
+TELEMETRY_TEST_CASE("trace keeps per-thread rings and renders Chrome JSON") {
+  telemetry::trace::clear();
+  telemetry::trace::set_enabled(true);
+  { telemetry::trace::Span span("main_span", 7); }
+  std::thread t([] {
+    telemetry::trace::set_thread_name("worker");
+    for (int i = 0; i < 3; ++i) telemetry::trace::Span span("worker_span");
+  });
+  t.join();
+  telemetry::trace::set_enabled(false);
+
+  std::string json;
+  REQUIRE(telemetry::trace::write_chrome_json(json) == 4);
+  REQUIRE(count_of(json, "\"name\":\"worker_span\"") == 3);
+  REQUIRE(json.find("{\"name\":\"main_span\",\"cat\":\"telemetryd\",\"ph\":\"X\",") != std::string::npos);
+  REQUIRE(json.find("\"args\":{\"n\":7}") != std::string::npos);
+  REQUIRE(json.find("\"ph\":\"M\"") != std::string::npos);
+  REQUIRE(json.find("\"args\":{\"name\":\"worker\"}") != std::string::npos);
+  REQUIRE(json.compare(json.size() - 4, 4, "\n]}\n") == 0);
+  telemetry::trace::clear();
+}
+
+TELEMETRY_TEST_CASE("trace ring keeps the newest events and never shows torn slots") {
+  telemetry::trace::clear();
+  // Every span has dur == arg, so a slot mixing two writes shows up as a mismatch.
+  std::atomic<bool> stop{false};
+  std::atomic<std::uint64_t> written{0};
+  std::thread writer([&stop, &written] {
+    std::uint64_t i = 1;
+    while (!stop.load(std::memory_order_relaxed)) {
+      telemetry::trace::record("wrap", i * 1000, i * 1000, i);
+      written.store(i++, std::memory_order_relaxed);
+    }
+  });
+
+  std::string json;
+  std::size_t max_events = 0;
+  for (int round = 0; round < 50 || written.load() < 4 * telemetry::trace::kRingEvents; ++round) {
+    std::this_thread::yield();
+    max_events = std::max(max_events, telemetry::trace::write_chrome_json(json));
+    for (std::size_t pos = json.find("\"dur\":"); pos != std::string::npos; pos = json.find("\"dur\":", pos + 1)) {
+      const double dur_us = std::strtod(json.c_str() + pos + 6, nullptr);
+      const std::size_t arg = json.find("\"n\":", pos);
+      REQUIRE(arg != std::string::npos);
+      const double n = std::strtod(json.c_str() + arg + 4, nullptr);
+      REQUIRE(std::fabs(dur_us - n) < 0.5);
+    }
+  }
+  stop.store(true);
+  writer.join();
+
+  // The oldest slot of a wrapped ring is indistinguishable from one being rewritten.
+  REQUIRE(telemetry::trace::write_chrome_json(json) == telemetry::trace::kRingEvents - 1);
+  REQUIRE(max_events <= telemetry::trace::kRingEvents);
+  telemetry::trace::clear();
+}
+
+TELEMETRY_TEST_CASE("parse_command handles TRACE") {
+  using telemetry::net::CommandType;
+  using telemetry::net::TraceOp;
+  REQUIRE(telemetry::net::parse_command("TRACE DUMP").trace_op == TraceOp::kDump);
+  REQUIRE(telemetry::net::parse_command("TRACE ON").trace_op == TraceOp::kOn);
+  REQUIRE(telemetry::net::parse_command("TRACE OFF").trace_op == TraceOp::kOff);
+  REQUIRE(telemetry::net::parse_command("TRACE CLEAR").trace_op == TraceOp::kClear);
+  const telemetry::net::ParsedCommand bad = telemetry::net::parse_command("TRACE");
+  REQUIRE(bad.type == CommandType::kTrace);
+  REQUIRE_FALSE(bad.ok);
+  REQUIRE_FALSE(telemetry::net::parse_command("TRACE SOON").ok);
+}
+
+#ifndef _WIN32
+
+namespace {
+
+class NamedSource final : public telemetry::metrics::MetricSource {
+ public:
+  const char* name() const override { return "named_source"; }
+  telemetry::Status collect(telemetry::MetricsSnapshot& out) override {
+    out.uptime_s = 1;
+    return telemetry::Status::Ok();
+  }
+};
+
+std::string read_until(int fd, std::size_t want) {
+  std::string got;
+  char tmp[4096];
+  while (got.size() < want) {
+    const ssize_t n = ::read(fd, tmp, sizeof(tmp));
+    if (n <= 0) break;
+    got.append(tmp, static_cast<std::size_t>(n));
+  }
+  return got;
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("TcpServer traces the GET path and serves TRACE DUMP") {
+  const std::uint16_t port = static_cast<std::uint16_t>(20000 + (::getpid() % 20000) + 80);
+  telemetry::trace::clear();
+  telemetry::metrics::Collector collector;
+  collector.add_source(std::make_unique<NamedSource>());
+
+  telemetry::net::TcpServerConfig cfg{};
+  cfg.host = "127.0.0.1";
+  cfg.port = port;
+  cfg.run_for_ms = 1500;
+  std::thread srv([&collector, cfg] {
+    telemetry::net::TcpServer server(collector, cfg);
+    (void)server.run_forever();
+  });
+
+  int fd = -1;
+  for (int attempt = 0; attempt < 100 && fd < 0; ++attempt) {
+    fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+      ::close(fd);
+      fd = -1;
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+  }
+  REQUIRE(fd >= 0);
+
+  const char on[] = "TRACE ON\n";
+  REQUIRE(::write(fd, on, sizeof(on) - 1) == static_cast<ssize_t>(sizeof(on) - 1));
+  REQUIRE(read_until(fd, 1).find("tracing on") != std::string::npos);
+  REQUIRE(::write(fd, "GET\n", 4) == 4);
+  REQUIRE(read_until(fd, 1).find("\"uptime_s\":1") != std::string::npos);
+
+  const char dump[] = "TRACE DUMP\n";
+  REQUIRE(::write(fd, dump, sizeof(dump) - 1) == static_cast<ssize_t>(sizeof(dump) - 1));
+  std::string got = read_until(fd, 1);
+  const std::size_t nl = got.find('\n');
+  REQUIRE(nl != std::string::npos);
+  const std::size_t bytes_at = got.find("\"bytes\":");
+  REQUIRE(bytes_at != std::string::npos && bytes_at < nl);
+  const std::size_t bytes = static_cast<std::size_t>(std::strtoull(got.c_str() + bytes_at + 8, nullptr, 10));
+  if (got.size() < nl + 1 + bytes) got += read_until(fd, nl + 1 + bytes - got.size());
+  const char off[] = "TRACE OFF\n";
+  REQUIRE(::write(fd, off, sizeof(off) - 1) == static_cast<ssize_t>(sizeof(off) - 1));
+  ::close(fd);
+  srv.join();
+  telemetry::trace::set_enabled(false);
+
+  REQUIRE(got.rfind("{\"ok\":true,\"enabled\":true,\"events\":", 0) == 0);
+  REQUIRE(got.size() == nl + 1 + bytes);
+  const std::string body = got.substr(nl + 1);
+  for (const char* name : {"\"parse\"", "\"handle\"", "\"collect\"", "\"named_source\"", "\"write\"", "\"read\"",
+                           "\"event-loop\""}) {
+    REQUIRE(body.find(name) != std::string::npos);
+  }
+  telemetry::trace::clear();
+}
+
+#endif  // !_WIN32
@@ -0,0 +1,204 @@
+#include "minitest.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "telemetry/metrics/collector.h"
+#include "telemetry/net/tcp_server.h"
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+class ConstSource final : public telemetry::metrics::MetricSource {
+ public:
+  const char* name() const override { return "const"; }
+  telemetry::Status collect(telemetry::MetricsSnapshot& out) override {
+    out.uptime_s = 42;
+    return telemetry::Status::Ok();
+  }
+};
+
+bool fill_unix_addr(const std::string& path, sockaddr_un& addr) {
+  addr = sockaddr_un{};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) return false;
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+int connect_unix(const std::string& path) {
+  sockaddr_un addr{};
+  if (!fill_unix_addr(path, addr)) return -1;
+  for (int attempt = 0; attempt < 100; ++attempt) {
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+    ::close(fd);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return -1;
+}
+
+int connect_loopback(std::uint16_t port) {
+  for (int attempt = 0; attempt < 100; ++attempt) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+    ::close(fd);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return -1;
+}
+
+std::string request(int fd, const char* line) {
+  const std::size_t len = std::strlen(line);
+  if (::send(fd, line, len, MSG_NOSIGNAL) != static_cast<ssize_t>(len)) return {};
+  std::string got;
+  char tmp[4096];
+  while (got.find('\n') == std::string::npos) {
+    const ssize_t n = ::read(fd, tmp, sizeof(tmp));
+    if (n <= 0) break;
+    got.append(tmp, static_cast<std::size_t>(n));
+  }
+  return got;
+}
+
+bool exists(const std::string& path) {
+  struct stat st {};
+  return ::lstat(path.c_str(), &st) == 0;
+}
+
+}  // namespace
+
+TELEMETRY_TEST_CASE("TcpServer serves the line protocol on a unix socket next to TCP") {
+  const std::uint16_t port = static_cast<std::uint16_t>(20000 + (::getpid() % 20000) + 110);
+  const std::string path = "/tmp/telemetry_test_" + std::to_string(::getpid()) + ".sock";
+
+  // A socket file left behind by a crashed agent must not block the next start.
+  {
+    sockaddr_un addr{};
+    REQUIRE(fill_unix_addr(path, addr));
+    (void)::unlink(path.c_str());
+    const int stale = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    REQUIRE(::bind(stale, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    ::close(stale);
+    REQUIRE(exists(path));
+  }
+
+  telemetry::metrics::Collector collector;
+  collector.add_source(std::make_unique<ConstSource>());
+  telemetry::net::TcpServerConfig cfg{};
+  cfg.host = "127.0.0.1";
+  cfg.port = port;
+  cfg.unix_path = path.c_str();
+  cfg.run_for_ms = 1500;
+  telemetry::Status run_status = telemetry::Status::Internal("not run");
+  std::thread srv([&collector, &run_status, cfg] {
+    telemetry::net::TcpServer server(collector, cfg);
+    run_status = server.run_forever();
+  });
+
+  const int ufd = connect_unix(path);
+  const int tfd = connect_loopback(port);
+  REQUIRE(ufd >= 0);
+  REQUIRE(tfd >= 0);
+  REQUIRE(request(ufd, "GET\n").find("\"uptime_s\":42") != std::string::npos);
+  REQUIRE(request(tfd, "PING\n").find("pong") != std::string::npos);
+  const std::string clients = request(ufd, "CLIENTS\n");
+  REQUIRE(clients.find("\"transport\":\"unix\",\"self\":true") != std::string::npos);
+  REQUIRE(clients.find("\"transport\":\"tcp\",\"self\":false") != std::string::npos);
+  ::close(ufd);
+  ::close(tfd);
+  srv.join();
+
+  REQUIRE(run_status.ok());
+  REQUIRE_FALSE(exists(path));
+}
+
+TELEMETRY_TEST_CASE("TcpServer leaves a live agent's unix socket alone") {
+  const std::uint16_t port = static_cast<std::uint16_t>(20000 + (::getpid() % 20000) + 113);
+  const std::string path = "/tmp/telemetry_test_live_" + std::to_string(::getpid()) + ".sock";
+  (void)::unlink(path.c_str());
+  telemetry::metrics::Collector collector;
+  collector.add_source(std::make_unique<ConstSource>());
+  telemetry::net::TcpServerConfig cfg{};
+  cfg.host = "127.0.0.1";
+  cfg.port = port;
+  cfg.unix_path = path.c_str();
+  cfg.run_for_ms = 1000;
+  telemetry::Status run_status = telemetry::Status::Internal("not run");
+  std::thread srv([&collector, &run_status, cfg] {
+    telemetry::net::TcpServer server(collector, cfg);
+    run_status = server.run_forever();
+  });
+  int fd = connect_unix(path);
+  REQUIRE(fd >= 0);
+  ::close(fd);
+
+  // A second agent on the same path fails instead of taking the socket over.
+  telemetry::net::TcpServerConfig second = cfg;
+  second.port = static_cast<std::uint16_t>(port + 1);
+  second.run_for_ms = 100;
+  {
+    telemetry::net::TcpServer server(collector, second);
+    REQUIRE(server.run_forever().code == telemetry::StatusCode::kIoError);
+  }
+  fd = connect_unix(path);
+  REQUIRE(fd >= 0);
+  REQUIRE(request(fd, "GET\n").find("\"uptime_s\":42") != std::string::npos);
+  ::close(fd);
+
+  // A file that replaced the socket since is not the first agent's to remove on exit.
+  REQUIRE(::unlink(path.c_str()) == 0);
+  std::FILE* f = std::fopen(path.c_str(), "w");
+  REQUIRE(f != nullptr);
+  std::fclose(f);
+  srv.join();
+  REQUIRE(run_status.ok());
+  REQUIRE(exists(path));
+  (void)::unlink(path.c_str());
+}
+
+TELEMETRY_TEST_CASE("TcpServer refuses unix socket paths it cannot own") {
+  const std::uint16_t port = static_cast<std::uint16_t>(20000 + (::getpid() % 20000) + 111);
+  telemetry::metrics::Collector collector;
+  telemetry::net::TcpServerConfig cfg{};
+  cfg.host = "127.0.0.1";
+  cfg.port = port;
+  cfg.run_for_ms = 100;
+
+  const std::string too_long = "/tmp/" + std::string(200, 'x') + ".sock";
+  cfg.unix_path = too_long.c_str();
+  {
+    telemetry::net::TcpServer server(collector, cfg);
+    REQUIRE(server.run_forever().code == telemetry::StatusCode::kInvalidArgument);
+  }
+
+  // A regular file at the path is someone else's; it is neither replaced nor removed.
+  const std::string regular = "/tmp/telemetry_test_" + std::to_string(::getpid()) + ".notsock";
+  std::FILE* f = std::fopen(regular.c_str(), "w");
+  REQUIRE(f != nullptr);
+  std::fclose(f);
+  cfg.unix_path = regular.c_str();
+  {
+    telemetry::net::TcpServer server(collector, cfg);
+    REQUIRE(server.run_forever().code == telemetry::StatusCode::kIoError);
+  }
+  REQUIRE(exists(regular));
+  (void)::unlink(regular.c_str());
+}
+
+#endif  // !_WIN32
@@ -0,0 +1,23 @@
+#!/usr/bin/env sh
+# Spawns N telemetryd agents on consecutive loopback ports and writes a targets file for
+# `telemetryd --aggregate`. Stop them with: kill $(cat <targets-file>.pids)
+#
+# Usage: tools/spawn_agents.sh <telemetryd> <count> [base-port] [targets-file]
+set -eu
+
+BIN=${1:?telemetryd binary}
+COUNT=${2:?agent count}
+BASE=${3:-19000}
+TARGETS=${4:-targets.txt}
+
+: > "$TARGETS"
+: > "$TARGETS.pids"
+i=0
+while [ "$i" -lt "$COUNT" ]; do
+  port=$((BASE + i))
+  "$BIN" --host 127.0.0.1 --port "$port" 2>/dev/null &
+  echo $! >> "$TARGETS.pids"
+  echo "127.0.0.1:$port agent-$i" >> "$TARGETS"
+  i=$((i + 1))
+done
+echo "spawned $COUNT agents on ports $BASE..$((BASE + COUNT - 1)); targets in $TARGETS"
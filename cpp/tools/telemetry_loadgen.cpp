@@ -0,0 +1,535 @@
+// Open-loop load generator and latency recorder for telemetryd.
+//
+// Each connection sends on a fixed schedule regardless of how fast replies come back, and
+// latency is measured from the *intended* send time, so a stalled server shows up as the
+// queueing delay its clients would really see (no coordinated omission). POSIX only.
+//
+// --flood adds unmeasured connections that pipeline requests as fast as the agent answers,
+// to check that one greedy client does not inflate everyone else's latency.
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "telemetry/util/latency_histogram.h"
+#include "telemetry/util/time.h"
+
+namespace {
+
+enum class Mode : std::uint8_t {
+  kGet = 0,
+  kPing,
+  kHttp,  // GET /metrics on the OpenMetrics listener
+};
+
+struct LoadgenConfig final {
+  const char* host = "127.0.0.1";
+  std::uint16_t port = 9000;
+  const char* unix_path = nullptr;  // connect to the agent's AF_UNIX socket instead of host:port
+  std::uint32_t connections = 16;
+  std::uint32_t threads = 0;  // 0 = min(connections, hardware threads, 8)
+  std::uint32_t rate = 1000;  // requests per second across all connections
+  std::uint32_t duration_s = 10;
+  std::uint32_t warmup_s = 1;
+  std::uint32_t pipeline = 1;  // requests written back to back per schedule tick
+  std::uint32_t drain_ms = 2000;
+  Mode mode = Mode::kGet;
+  bool json = false;
+  std::uint32_t max_p99_us = 0;  // 0 = no gate
+  std::uint32_t flood = 0;       // extra closed-loop connections sending back to back
+};
+
+// A flood connection keeps up to this many requests in flight, written in bursts.
+constexpr std::uint32_t kFloodBurst = 256;
+constexpr std::uint32_t kFloodWindow = 4 * kFloodBurst;
+
+struct Conn final {
+  int fd{-1};
+  std::string out;
+  std::size_t out_off{0};
+  std::string in;
+  // Intended send times (ns) of requests still awaiting a reply, oldest first.
+  std::deque<std::uint64_t> inflight;
+  std::uint64_t next_send_ns{0};
+};
+
+struct WorkerResult final {
+  telemetry::util::LatencyHistogram hist;
+  std::uint64_t sent{0};
+  std::uint64_t completed{0};
+  std::uint64_t measured{0};
+  std::uint64_t errors{0};
+};
+
+struct FloodResult final {
+  std::uint64_t completed{0};
+  bool failed{false};
+};
+
+struct Schedule final {
+  std::uint64_t start_ns;
+  std::uint64_t measure_from_ns;
+  std::uint64_t stop_send_ns;
+  std::uint64_t deadline_ns;
+  std::uint64_t interval_ns;
+};
+
+const char* mode_name(Mode m) {
+  switch (m) {
+    case Mode::kGet: return "get";
+    case Mode::kPing: return "ping";
+    case Mode::kHttp: return "http";
+  }
+  return "?";
+}
+
+std::string_view request_for(Mode m) {
+  switch (m) {
+    case Mode::kGet: return "GET\n";
+    case Mode::kPing: return "PING\n";
+    case Mode::kHttp: return "GET /metrics HTTP/1.1\r\nHost: loadgen\r\n\r\n";
+  }
+  return "PING\n";
+}
+
+// Removes complete responses from the front of `in`; returns how many there were.
+std::size_t take_responses(Mode m, std::string& in) {
+  std::size_t n = 0;
+  std::size_t off = 0;
+  while (off < in.size()) {
+    if (m != Mode::kHttp) {
+      const std::size_t nl = in.find('\n', off);
+      if (nl == std::string::npos) break;
+      off = nl + 1;
+      ++n;
+      continue;
+    }
+    const std::size_t head_end = in.find("\r\n\r\n", off);
+    if (head_end == std::string::npos) break;
+    const std::size_t cl = in.find("Content-Length: ", off);
+    std::size_t body = 0;
+    if (cl != std::string::npos && cl < head_end) body = std::strtoull(in.c_str() + cl + 16, nullptr, 10);
+    if (in.size() < head_end + 4 + body) break;
+    off = head_end + 4 + body;
+    ++n;
+  }
+  in.erase(0, off);
+  return n;
+}
+
+bool flush(Conn& c) {
+  while (c.out_off < c.out.size()) {
+    const ssize_t w = ::write(c.fd, c.out.data() + c.out_off, c.out.size() - c.out_off);
+    if (w < 0) {
+      if (errno == EINTR) continue;
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    c.out_off += static_cast<std::size_t>(w);
+  }
+  c.out.clear();
+  c.out_off = 0;
+  return true;
+}
+
+void fail(Conn& c, WorkerResult& res) {
+  res.errors += c.inflight.size();
+  c.inflight.clear();
+  ::close(c.fd);
+  c.fd = -1;
+}
+
+void wait_for_events(std::vector<pollfd>& pfds, std::uint64_t timeout_ns) {
+#if defined(__linux__)
+  timespec ts{};
+  ts.tv_sec = static_cast<time_t>(timeout_ns / 1000000000ULL);
+  ts.tv_nsec = static_cast<long>(timeout_ns % 1000000000ULL);
+  (void)::ppoll(pfds.data(), pfds.size(), &ts, nullptr);
+#else
+  (void)::poll(pfds.data(), pfds.size(), static_cast<int>((timeout_ns + 999999ULL) / 1000000ULL));
+#endif
+}
+
+void run_worker(const LoadgenConfig& cfg, std::vector<Conn>& conns, const Schedule& sched, WorkerResult& res) {
+  const std::string_view req = request_for(cfg.mode);
+  std::vector<pollfd> pfds(conns.size());
+  char buf[64 * 1024];
+
+  while (true) {
+    std::uint64_t now = telemetry::util::monotonic_ns();
+    if (now >= sched.deadline_ns) break;
+
+    bool busy = false;
+    std::uint64_t wake = sched.deadline_ns;
+    for (Conn& c : conns) {
+      if (c.fd < 0) continue;
+      while (c.next_send_ns <= now && c.next_send_ns < sched.stop_send_ns) {
+        for (std::uint32_t p = 0; p < cfg.pipeline; ++p) {
+          c.out.append(req);
+          c.inflight.push_back(c.next_send_ns);
+        }
+        res.sent += cfg.pipeline;
+        c.next_send_ns += sched.interval_ns;
+      }
+      if (!flush(c)) {
+        fail(c, res);
+        continue;
+      }
+      if (c.next_send_ns < sched.stop_send_ns) wake = std::min(wake, c.next_send_ns);
+      busy = busy || !c.inflight.empty() || c.next_send_ns < sched.stop_send_ns;
+    }
+    if (!busy) break;
+
+    for (std::size_t i = 0; i < conns.size(); ++i) {
+      pfds[i].fd = conns[i].fd;
+      pfds[i].events = static_cast<short>(POLLIN | (conns[i].out.empty() ? 0 : POLLOUT));
+      pfds[i].revents = 0;
+    }
+    wait_for_events(pfds, wake > now ? wake - now : 0);
+
+    now = telemetry::util::monotonic_ns();
+    for (std::size_t i = 0; i < conns.size(); ++i) {
+      Conn& c = conns[i];
+      if (c.fd < 0 || pfds[i].revents == 0) continue;
+      if (pfds[i].revents & (POLLERR | POLLNVAL)) {
+        fail(c, res);
+        continue;
+      }
+      bool closed = false;
+      while (true) {
+        const ssize_t n = ::read(c.fd, buf, sizeof(buf));
+        if (n > 0) {
+          c.in.append(buf, static_cast<std::size_t>(n));
+          continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        closed = n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+        break;
+      }
+      for (std::size_t done = take_responses(cfg.mode, c.in); done > 0 && !c.inflight.empty(); --done) {
+        const std::uint64_t intended = c.inflight.front();
+        c.inflight.pop_front();
+        ++res.completed;
+        if (intended >= sched.measure_from_ns) {
+          res.hist.record(now - intended);
+          ++res.measured;
+        }
+      }
+      if (closed) fail(c, res);
+    }
+  }
+
+  // Whatever is still outstanding at the deadline counts as failed.
+  for (Conn& c : conns) {
+    if (c.fd >= 0) fail(c, res);
+  }
+}
+
+// Pipelines requests on one connection until sending stops, never waiting on the schedule.
+void run_flooder(const LoadgenConfig& cfg, Conn& c, const Schedule& sched, FloodResult& res) {
+  std::string burst;
+  for (std::uint32_t i = 0; i < kFloodBurst; ++i) burst.append(request_for(cfg.mode));
+  std::uint64_t in_flight = 0;
+  char buf[64 * 1024];
+  while (telemetry::util::monotonic_ns() < sched.stop_send_ns) {
+    if (c.out.empty() && in_flight + kFloodBurst <= kFloodWindow) {
+      c.out = burst;
+      in_flight += kFloodBurst;
+    }
+    if (!flush(c)) {
+      res.failed = true;
+      break;
+    }
+    pollfd p{c.fd, static_cast<short>(POLLIN | (c.out.empty() ? 0 : POLLOUT)), 0};
+    (void)::poll(&p, 1, 10);
+    while (true) {
+      const ssize_t n = ::read(c.fd, buf, sizeof(buf));
+      if (n > 0) {
+        c.in.append(buf, static_cast<std::size_t>(n));
+        continue;
+      }
+      if (n < 0 && errno == EINTR) continue;
+      res.failed = n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+      break;
+    }
+    if (res.failed) break;
+    const std::size_t done = take_responses(cfg.mode, c.in);
+    in_flight -= std::min<std::uint64_t>(in_flight, done);
+    res.completed += done;
+  }
+  ::close(c.fd);
+  c.fd = -1;
+}
+
+int connect_unix(const char* path) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (std::strlen(path) >= sizeof(addr.sun_path)) return -1;
+  std::memcpy(addr.sun_path, path, std::strlen(path) + 1);
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    ::close(fd);
+    return -1;
+  }
+  const int flags = ::fcntl(fd, F_GETFL, 0);
+  (void)::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+  return fd;
+}
+
+int connect_to(const LoadgenConfig& cfg) {
+  if (cfg.unix_path) return connect_unix(cfg.unix_path);
+  const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(cfg.port);
+  if (::inet_pton(AF_INET, cfg.host, &addr.sin_addr) != 1 ||
+      ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    ::close(fd);
+    return -1;
+  }
+  int one = 1;
+  (void)::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  const int flags = ::fcntl(fd, F_GETFL, 0);
+  (void)::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+  return fd;
+}
+
+void print_usage(const char* argv0) {
+  std::fprintf(stderr,
+               "Usage: %s [--host <ip>] [--port <port>] [--unix <path>] [--mode get|ping|http] [--connections <n>]\n"
+               "          [--threads <n>] [--rate <req/s>] [--duration-s <s>] [--warmup-s <s>]\n"
+               "          [--pipeline <n>] [--drain-ms <ms>] [--flood <n>] [--json] [--max-p99-us <us>]\n"
+               "Defaults: --host 127.0.0.1 --port 9000 --mode get --connections 16 --rate 1000\n"
+               "          --duration-s 10 --warmup-s 1 --pipeline 1 --drain-ms 2000\n"
+               "Human-readable results go to stderr; --json also writes one JSON document to stdout.\n"
+               "--max-p99-us exits with status 3 when p99 latency exceeds the bound (release gate).\n"
+               "--flood adds <n> unmeasured connections that pipeline requests back to back.\n"
+               "--unix connects to telemetryd's --unix-socket instead of --host/--port (not with --mode http).\n",
+               argv0);
+}
+
+bool parse_u32(const char* s, std::uint32_t& out) {
+  if (!s || !*s) return false;
+  unsigned long v = 0;
+  for (const char* p = s; *p; ++p) {
+    if (*p < '0' || *p > '9') return false;
+    v = v * 10UL + static_cast<unsigned long>(*p - '0');
+    if (v > 0xFFFFFFFFUL) return false;
+  }
+  out = static_cast<std::uint32_t>(v);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  LoadgenConfig cfg{};
+  for (int i = 1; i < argc; ++i) {
+    const char* a = argv[i];
+    const bool has_value = i + 1 < argc;
+    std::uint32_t v = 0;
+    if (std::strcmp(a, "--help") == 0 || std::strcmp(a, "-h") == 0) {
+      print_usage(argv[0]);
+      return 0;
+    } else if (std::strcmp(a, "--unix") == 0 && has_value) {
+      cfg.unix_path = argv[++i];
+    } else if (std::strcmp(a, "--host") == 0 && has_value) {
+      cfg.host = argv[++i];
+    } else if (std::strcmp(a, "--port") == 0 && has_value && parse_u32(argv[++i], v) && v > 0 && v <= 65535) {
+      cfg.port = static_cast<std::uint16_t>(v);
+    } else if (std::strcmp(a, "--mode") == 0 && has_value) {
+      const char* m = argv[++i];
+      if (std::strcmp(m, "get") == 0) {
+        cfg.mode = Mode::kGet;
+      } else if (std::strcmp(m, "ping") == 0) {
+        cfg.mode = Mode::kPing;
+      } else if (std::strcmp(m, "http") == 0) {
+        cfg.mode = Mode::kHttp;
+      } else {
+        std::fprintf(stderr, "Invalid --mode\n");
+        return 2;
+      }
+    } else if (std::strcmp(a, "--connections") == 0 && has_value && parse_u32(argv[++i], v) && v > 0) {
+      cfg.connections = v;
+    } else if (std::strcmp(a, "--threads") == 0 && has_value && parse_u32(argv[++i], v) && v > 0) {
+      cfg.threads = v;
+    } else if (std::strcmp(a, "--rate") == 0 && has_value && parse_u32(argv[++i], v) && v > 0) {
+      cfg.rate = v;
+    } else if (std::strcmp(a, "--duration-s") == 0 && has_value && parse_u32(argv[++i], v) && v > 0) {
+      cfg.duration_s = v;
+    } else if (std::strcmp(a, "--warmup-s") == 0 && has_value && parse_u32(argv[++i], v)) {
+      cfg.warmup_s = v;
+    } else if (std::strcmp(a, "--pipeline") == 0 && has_value && parse_u32(argv[++i], v) && v > 0 && v <= 1024) {
+      cfg.pipeline = v;
+    } else if (std::strcmp(a, "--drain-ms") == 0 && has_value && parse_u32(argv[++i], v)) {
+      cfg.drain_ms = v;
+    } else if (std::strcmp(a, "--flood") == 0 && has_value && parse_u32(argv[++i], v) && v <= 64) {
+      cfg.flood = v;
+    } else if (std::strcmp(a, "--max-p99-us") == 0 && has_value && parse_u32(argv[++i], v)) {
+      cfg.max_p99_us = v;
+    } else if (std::strcmp(a, "--json") == 0) {
+      cfg.json = true;
+    } else {
+      std::fprintf(stderr, "Invalid or unknown arg: %s\n", a);
+      print_usage(argv[0]);
+      return 2;
+    }
+  }
+
+  if (cfg.threads == 0) {
+    const unsigned hw = std::thread::hardware_concurrency();
+    cfg.threads = std::min<std::uint32_t>({cfg.connections, hw ? hw : 1U, 8U});
+  }
+  cfg.threads = std::min(cfg.threads, cfg.connections);
+  if (cfg.unix_path && cfg.mode == Mode::kHttp) {
+    std::fprintf(stderr, "--unix serves the line protocol only; use --mode get or ping\n");
+    return 2;
+  }
+  char target[128];
+  if (cfg.unix_path) {
+    std::snprintf(target, sizeof(target), "unix:%s", cfg.unix_path);
+  } else {
+    std::snprintf(target, sizeof(target), "%s:%u", cfg.host, static_cast<unsigned>(cfg.port));
+  }
+
+  // Connections are round-robined over threads; each thread owns its slice outright.
+  std::vector<std::vector<Conn>> slices(cfg.threads);
+  for (std::uint32_t i = 0; i < cfg.connections; ++i) {
+    Conn c{};
+    c.fd = connect_to(cfg);
+    if (c.fd < 0) {
+      std::fprintf(stderr, "telemetry_loadgen: connect to %s failed\n", target);
+      return 1;
+    }
+    slices[i % cfg.threads].push_back(std::move(c));
+  }
+  std::vector<Conn> flooders(cfg.flood);
+  for (Conn& c : flooders) {
+    c.fd = connect_to(cfg);
+    if (c.fd < 0) {
+      std::fprintf(stderr, "telemetry_loadgen: connect to %s failed\n", target);
+      return 1;
+    }
+  }
+
+  // Each connection sends `pipeline` requests every interval; start times are staggered so
+  // the aggregate arrival process is smooth.
+  const double per_conn_rate = static_cast<double>(cfg.rate) / (static_cast<double>(cfg.connections) * cfg.pipeline);
+  Schedule sched{};
+  sched.interval_ns = static_cast<std::uint64_t>(1e9 / per_conn_rate);
+  if (sched.interval_ns == 0) sched.interval_ns = 1;
+  sched.start_ns = telemetry::util::monotonic_ns() + 10000000ULL;
+  sched.measure_from_ns = sched.start_ns + static_cast<std::uint64_t>(cfg.warmup_s) * 1000000000ULL;
+  sched.stop_send_ns = sched.measure_from_ns + static_cast<std::uint64_t>(cfg.duration_s) * 1000000000ULL;
+  sched.deadline_ns = sched.stop_send_ns + static_cast<std::uint64_t>(cfg.drain_ms) * 1000000ULL;
+  std::uint32_t k = 0;
+  std::uint64_t scheduled = 0;
+  for (auto& slice : slices) {
+    for (Conn& c : slice) {
+      c.next_send_ns = sched.start_ns + sched.interval_ns * (k++) / cfg.connections;
+      scheduled += ((sched.stop_send_ns - c.next_send_ns - 1) / sched.interval_ns + 1) * cfg.pipeline;
+    }
+  }
+
+  std::vector<WorkerResult> results(cfg.threads);
+  std::vector<std::thread> workers;
+  for (std::uint32_t t = 0; t < cfg.threads; ++t) {
+    workers.emplace_back([&cfg, &slices, &sched, &results, t] { run_worker(cfg, slices[t], sched, results[t]); });
+  }
+  std::vector<FloodResult> flood_results(cfg.flood);
+  for (std::uint32_t f = 0; f < cfg.flood; ++f) {
+    workers.emplace_back([&cfg, &flooders, &sched, &flood_results, f] {
+      run_flooder(cfg, flooders[f], sched, flood_results[f]);
+    });
+  }
+  for (auto& w : workers) w.join();
+  FloodResult flood{};
+  for (const FloodResult& r : flood_results) {
+    flood.completed += r.completed;
+    flood.failed = flood.failed || r.failed;
+  }
+
+  WorkerResult total{};
+  for (const WorkerResult& r : results) {
+    total.hist.merge(r.hist);
+    total.sent += r.sent;
+    total.completed += r.completed;
+    total.measured += r.measured;
+    total.errors += r.errors;
+  }
+
+  const auto& h = total.hist;
+  const double us = 1000.0;
+  const double throughput = static_cast<double>(total.measured) / static_cast<double>(cfg.duration_s);
+  const double p50 = static_cast<double>(h.value_at_percentile(50.0)) / us;
+  const double p90 = static_cast<double>(h.value_at_percentile(90.0)) / us;
+  const double p99 = static_cast<double>(h.value_at_percentile(99.0)) / us;
+  const double p999 = static_cast<double>(h.value_at_percentile(99.9)) / us;
+  const double max = static_cast<double>(h.max()) / us;
+
+  std::fprintf(stderr,
+               "telemetry_loadgen: mode=%s target=%s connections=%u threads=%u rate=%u/s pipeline=%u "
+               "duration=%us warmup=%us\n"
+               "  requests: sent=%llu completed=%llu errors=%llu\n"
+               "  throughput: %.1f req/s (target %u)\n"
+               "  latency us: min=%.1f mean=%.1f p50=%.1f p90=%.1f p99=%.1f p99.9=%.1f max=%.1f\n",
+               mode_name(cfg.mode), target, static_cast<unsigned>(cfg.connections),
+               static_cast<unsigned>(cfg.threads), static_cast<unsigned>(cfg.rate), static_cast<unsigned>(cfg.pipeline),
+               static_cast<unsigned>(cfg.duration_s), static_cast<unsigned>(cfg.warmup_s),
+               static_cast<unsigned long long>(total.sent), static_cast<unsigned long long>(total.completed),
+               static_cast<unsigned long long>(total.errors), throughput, static_cast<unsigned>(cfg.rate),
+               static_cast<double>(h.min()) / us, h.mean() / us, p50, p90, p99, p999, max);
+  if (cfg.flood != 0) {
+    std::fprintf(stderr, "  flood: connections=%u completed=%llu (%.1f req/s)%s\n", static_cast<unsigned>(cfg.flood),
+                 static_cast<unsigned long long>(flood.completed),
+                 static_cast<double>(flood.completed) / static_cast<double>(cfg.warmup_s + cfg.duration_s),
+                 flood.failed ? " [connection lost]" : "");
+  }
+
+  // Sends are caught up in bursts when the generator lags, which still charges the delay to
+  // latency, but a generator that never caught up measured itself, not the server.
+  if (total.sent + total.sent / 100 < scheduled) {
+    std::fprintf(stderr, "  warning: generator fell behind (sent %llu of %llu scheduled); add --threads or lower --rate\n",
+                 static_cast<unsigned long long>(total.sent), static_cast<unsigned long long>(scheduled));
+  }
+
+  if (cfg.json) {
+    std::printf(
+        "{\"mode\":\"%s\",\"connections\":%u,\"threads\":%u,\"target_rate\":%u,\"pipeline\":%u,\"duration_s\":%u,"
+        "\"scheduled\":%llu,\"sent\":%llu,\"completed\":%llu,\"errors\":%llu,\"throughput_rps\":%.1f,"
+        "\"flood\":%u,\"flood_completed\":%llu,"
+        "\"latency_us\":{\"min\":%.1f,\"mean\":%.1f,\"p50\":%.1f,\"p90\":%.1f,\"p99\":%.1f,\"p999\":%.1f,\"max\":%.1f}}\n",
+        mode_name(cfg.mode), static_cast<unsigned>(cfg.connections), static_cast<unsigned>(cfg.threads),
+        static_cast<unsigned>(cfg.rate), static_cast<unsigned>(cfg.pipeline), static_cast<unsigned>(cfg.duration_s),
+        static_cast<unsigned long long>(scheduled), static_cast<unsigned long long>(total.sent), static_cast<unsigned long long>(total.completed),
+        static_cast<unsigned long long>(total.errors), throughput, static_cast<unsigned>(cfg.flood),
+        static_cast<unsigned long long>(flood.completed), static_cast<double>(h.min()) / us, h.mean() / us, p50, p90, p99,
+        p999, max);
+  }
+
+  if (cfg.max_p99_us != 0 && p99 > static_cast<double>(cfg.max_p99_us)) {
+    std::fprintf(stderr, "telemetry_loadgen: p99 %.1f us exceeds --max-p99-us %u\n", p99,
+                 static_cast<unsigned>(cfg.max_p99_us));
+    return 3;
+  }
+  return total.errors == 0 ? 0 : 1;
+}
@@ -9,6 +9,7 @@ from rich.live import Live
 from rich.table import Table
 
 from .client import TelemetryClient, TelemetryClientConfig
+from .multicast import MulticastReceiver
 
 
 def _metrics_table(m: dict[str, Any]) -> Table:
@@ -35,11 +36,37 @@ def _metrics_table(m: dict[str, Any]) -> Table:
     return t
 
 
+def _multicast_table(rx: MulticastReceiver, latest: dict[str, dict[str, Any]]) -> Table:
+    t = Table(title="Multicast")
+    for col in ("host", "cpu_usage_pct", "mem_available_kb", "temperature_c", "seq", "received", "lost", "restarts"):
+        t.add_column(col)
+    for host in sorted(latest):
+        m = latest[host]
+        st = rx.stats[host]
+        t.add_row(host, f"{m['cpu_usage_pct']:.2f}", str(m["mem_available_kb"]), f"{m['temperature_c']:.2f}",
+                  str(st.last_seq), str(st.received), str(st.lost), str(st.restarts))
+    return t
+
+
+def _watch_multicast(console: Console, group: str, port: int, interface: str) -> int:
+    latest: dict[str, dict[str, Any]] = {}
+    with MulticastReceiver(group, port, interface) as rx:
+        with Live(_multicast_table(rx, latest), refresh_per_second=4, console=console) as live:
+            try:
+                for d, _lost in rx:
+                    latest[d.host_id] = d.metrics
+                    live.update(_multicast_table(rx, latest))
+            except KeyboardInterrupt:
+                return 0
+    return 0
+
+
 def main(argv: list[str] | None = None) -> int:
     p = argparse.ArgumentParser(prog="telemetry_client")
     p.add_argument("--host", default="127.0.0.1")
     p.add_argument("--port", default=9000, type=int)
     p.add_argument("--timeout", default=1.0, type=float)
+    p.add_argument("--unix", default=None, help="Connect to the agent's --unix-socket path instead")
 
     sub = p.add_subparsers(dest="cmd", required=True)
     sub.add_parser("once", help="Fetch metrics once")
@@ -52,10 +79,21 @@ def main(argv: list[str] | None = None) -> int:
     throttle = sub.add_parser("throttle", help="Set agent throttle (ms)")
     throttle.add_argument("--ms", required=True, type=int)
 
+    sub.add_parser("clients", help="Show per-connection counters")
+
+    mcast = sub.add_parser("multicast", help="Watch agents broadcasting with --multicast")
+    mcast.add_argument("--group", default="239.255.70.1")
+    mcast.add_argument("--mport", default=9200, type=int, help="Multicast UDP port")
+    mcast.add_argument("--interface", default="0.0.0.0", help="Local IPv4 of the interface to join on")
+
+    trace = sub.add_parser("trace", help="Control agent tracing or save a Chrome/Perfetto trace")
+    trace.add_argument("op", choices=["on", "off", "clear", "dump"])
+    trace.add_argument("--out", default="telemetryd-trace.json", help="File for `dump`")
+
     args = p.parse_args(argv)
     console = Console()
 
-    client = TelemetryClient(TelemetryClientConfig(host=args.host, port=args.port, timeout_s=args.timeout))
+    client = TelemetryClient(TelemetryClientConfig(host=args.host, port=args.port, timeout_s=args.timeout, unix_path=args.unix))
 
     if args.cmd == "once":
         m = client.get_metrics()
@@ -83,6 +121,37 @@ def main(argv: list[str] | None = None) -> int:
         console.print(r)
         return 0 if r.get("ok", True) else 1
 
+    if args.cmd == "clients":
+        r = client.clients()
+        if not r.get("ok", False):
+            console.print(r)
+            return 1
+        t = Table(title="Clients")
+        cols = ("id", "kind", "transport", "commands", "bytes_in", "bytes_out", "deferred")
+        for col in cols:
+            t.add_column(col)
+        for c in r.get("clients", []):
+            t.add_row(*(str(c.get(col)) for col in cols))
+        console.print(t)
+        return 0
+
+    if args.cmd == "multicast":
+        return _watch_multicast(console, args.group, args.mport, args.interface)
+
+    if args.cmd == "trace":
+        if args.op != "dump":
+            r = client.trace(args.op)
+            console.print(r)
+            return 0 if r.get("ok", True) else 1
+        header, body = client.trace_dump()
+        if not header.get("ok", False):
+            console.print(header)
+            return 1
+        with open(args.out, "wb") as f:
+            f.write(body)
+        console.print(f"{header.get('events', 0)} events -> {args.out} (open in ui.perfetto.dev)")
+        return 0
+
     console.print("[red]Unknown command[/red]")
     return 2
 
@@ -3,7 +3,7 @@ from __future__ import annotations
 import json
 import socket
 from dataclasses import dataclass
-from typing import Any
+from typing import Any, Iterator
 
 
 @dataclass(frozen=True)
@@ -12,17 +12,31 @@ class TelemetryClientConfig:
     port: int
     timeout_s: float = 1.0
     max_line_bytes: int = 8192
+    # Path of the agent's --unix-socket; when set, host and port are ignored.
+    unix_path: str | None = None
 
 
 class TelemetryClient:
     def __init__(self, cfg: TelemetryClientConfig):
         self._cfg = cfg
 
+    def _connect(self) -> socket.socket:
+        if self._cfg.unix_path is None:
+            return socket.create_connection((self._cfg.host, self._cfg.port), timeout=self._cfg.timeout_s)
+        s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            s.settimeout(self._cfg.timeout_s)
+            s.connect(self._cfg.unix_path)
+        except OSError:
+            s.close()
+            raise
+        return s
+
     def _request(self, line: str) -> dict[str, Any]:
         if not line.endswith("\n"):
             line = line + "\n"
 
-        with socket.create_connection((self._cfg.host, self._cfg.port), timeout=self._cfg.timeout_s) as s:
+        with self._connect() as s:
             s.settimeout(self._cfg.timeout_s)
             s.sendall(line.encode("utf-8"))
             raw = self._read_line(s)
@@ -32,6 +46,14 @@ class TelemetryClient:
         except json.JSONDecodeError as e:
             raise RuntimeError(f"Invalid JSON from agent: {e}: {raw!r}") from e
 
+    def _read_exact(self, s: socket.socket, buf: bytearray, n: int) -> bytes:
+        while len(buf) < n:
+            chunk = s.recv(max(65536, n - len(buf)))
+            if not chunk:
+                raise RuntimeError("Connection closed mid-response")
+            buf += chunk
+        return bytes(buf[:n])
+
     def _read_line(self, s: socket.socket) -> str:
         buf = bytearray()
         while True:
@@ -56,6 +78,111 @@ class TelemetryClient:
     def restart(self) -> dict[str, Any]:
         return self._request("RESTART")
 
+    def drain(self, cursor: int) -> tuple[dict[str, Any], bytes]:
+        """Fetches spooled records starting at `cursor`.
+
+        Returns the header (with `next`, the cursor to continue from) and the raw spool
+        records. Call again with `next` until `bytes` is 0.
+        """
+        if cursor < 0:
+            raise ValueError("cursor must be >= 0")
+        return self._framed(f"DRAIN {cursor}")
+
+    def trace(self, op: str) -> dict[str, Any]:
+        """Turns agent tracing on or off, or clears it (`op` is "on", "off" or "clear")."""
+        if op not in ("on", "off", "clear"):
+            raise ValueError("op must be on, off or clear")
+        return self._request(f"TRACE {op.upper()}")
+
+    def trace_dump(self) -> tuple[dict[str, Any], bytes]:
+        """Returns the trace header and the Chrome/Perfetto JSON recorded so far."""
+        return self._framed("TRACE DUMP")
+
+    def clients(self) -> dict[str, Any]:
+        """Returns the agent's per-connection counters and scheduling budget."""
+        return self._request("CLIENTS")
+
+    def detail(self, source: str | None = None) -> dict[str, Any]:
+        """Returns per-device detail (disks, interfaces, ...) from every source, or one."""
+        return self._request(f"DETAIL {source}" if source else "DETAIL")
+
+    def top(self, n: int = 10) -> dict[str, Any]:
+        """Returns the agent's `n` busiest processes by CPU (the agent needs `--top`)."""
+        if not 1 <= n <= 256:
+            raise ValueError("n must be 1..256")
+        return self._request(f"TOP {n}")
+
+    def _framed(self, line: str) -> tuple[dict[str, Any], bytes]:
+        # One JSON header line carrying `bytes`, then exactly that many body bytes.
+        with self._connect() as s:
+            s.settimeout(self._cfg.timeout_s)
+            s.sendall(f"{line}\n".encode("utf-8"))
+            buf = bytearray()
+            while b"\n" not in buf:
+                chunk = s.recv(1024)
+                if not chunk:
+                    raise RuntimeError("Connection closed mid-response")
+                buf += chunk
+                if len(buf) > self._cfg.max_line_bytes:
+                    raise RuntimeError("Response too large")
+            head, rest = bytes(buf).split(b"\n", 1)
+            header = json.loads(head.decode("utf-8", errors="replace"))
+            if not header.get("ok", False):
+                return header, b""
+            body = self._read_exact(s, bytearray(rest), int(header.get("bytes", 0)))
+        return header, body
+
+    def _stream(self, line: str) -> Iterator[dict[str, Any]]:
+        with self._connect() as s:
+            s.sendall(f"{line}\n".encode("utf-8"))
+            s.settimeout(None)
+            buf = bytearray()
+            while True:
+                while b"\n" not in buf:
+                    chunk = s.recv(4096)
+                    if not chunk:
+                        return
+                    buf += chunk
+                    if len(buf) > self._cfg.max_line_bytes:
+                        raise RuntimeError("Response too large")
+                raw, _, rest = bytes(buf).partition(b"\n")
+                buf = bytearray(rest)
+                yield json.loads(raw.decode("utf-8", errors="replace"))
+
+    def alerts(self) -> Iterator[dict[str, Any]]:
+        """Subscribes to rule transitions and yields each event as it arrives.
+
+        The first item is the subscription reply; currently firing rules follow, then live
+        firing/resolved events. Blocks without a timeout between events.
+        """
+        return self._stream("ALERTS")
+
+    def subscribe(
+        self, deadband_abs: float | None = None, deadband_rel: float = 0.0, keyframe_every: int = 60
+    ) -> Iterator[dict[str, Any]]:
+        """Streams snapshots as the agent samples them, yielding the merged current state.
+
+        With `deadband_abs` set, the agent only sends fields that moved past the deadband
+        (plus periodic keyframes); the deltas are applied here so every yielded dict is
+        complete. Blocks without a timeout between samples.
+        """
+        if deadband_abs is None:
+            line = "SUBSCRIBE"
+        else:
+            if deadband_abs < 0 or deadband_rel < 0 or keyframe_every <= 0:
+                raise ValueError("deadbands must be >= 0 and keyframe_every > 0")
+            line = f"SUBSCRIBE DELTA {deadband_abs:g} {deadband_rel:g} {keyframe_every}"
+        stream = self._stream(line)
+        reply = next(stream, None)
+        if reply is None or not reply.get("ok", False):
+            raise RuntimeError(f"Subscribe failed: {reply!r}")
+        state: dict[str, Any] = {}
+        for update in stream:
+            if update.pop("key", False):
+                state = {}
+            state.update(update)
+            yield dict(state)
+
     def throttle(self, ms: int) -> dict[str, Any]:
         if ms < 0:
             raise ValueError("ms must be >= 0")
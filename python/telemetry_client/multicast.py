@@ -0,0 +1,133 @@
+from __future__ import annotations
+
+import socket
+import struct
+from dataclasses import dataclass
+from typing import Any, Iterator
+
+# Mirrors cpp/include/telemetry/codec/datagram_codec.h and snapshot_codec.h (v1).
+DATAGRAM_MAGIC = 0x444D4C54  # "TLMD"
+DATAGRAM_VERSION = 1
+SNAPSHOT_VERSION = 1
+MAX_HOST_ID = 64
+
+
+def _varint(buf: bytes, off: int) -> tuple[int, int]:
+    v = 0
+    shift = 0
+    while shift < 64:
+        if off >= len(buf):
+            raise ValueError("datagram truncated")
+        b = buf[off]
+        off += 1
+        v |= (b & 0x7F) << shift
+        if not b & 0x80:
+            return v, off
+        shift += 7
+    raise ValueError("varint too long")
+
+
+def _zigzag(v: int) -> int:
+    return (v >> 1) ^ -(v & 1)
+
+
+@dataclass(frozen=True)
+class SnapshotDatagram:
+    seq: int
+    host_id: str
+    status_code: int
+    metrics: dict[str, Any]
+
+
+def decode_datagram(buf: bytes) -> SnapshotDatagram:
+    """Decodes one multicast datagram; raises ValueError for anything else on the group."""
+    if len(buf) < 5 or struct.unpack_from("<I", buf)[0] != DATAGRAM_MAGIC:
+        raise ValueError("not a telemetry datagram")
+    if buf[4] != DATAGRAM_VERSION:
+        raise ValueError("unsupported datagram version")
+    seq, off = _varint(buf, 5)
+    id_len, off = _varint(buf, off)
+    if id_len > MAX_HOST_ID or off + id_len > len(buf):
+        raise ValueError("bad host id")
+    host_id = buf[off : off + id_len].decode("utf-8", errors="replace")
+    off += id_len
+
+    if off + 2 > len(buf) or buf[off] != SNAPSHOT_VERSION:
+        raise ValueError("unsupported snapshot version")
+    status_code = buf[off + 1]
+    off += 2
+    fields = []
+    for _ in range(6):
+        v, off = _varint(buf, off)
+        fields.append(v)
+    if off != len(buf):
+        raise ValueError("trailing datagram bytes")
+
+    metrics = {
+        "ok": status_code == 0,
+        "status_code": status_code,
+        "ts_ms": fields[0],
+        "cpu_usage_pct": fields[1] / 100.0,
+        "mem_total_kb": fields[2],
+        "mem_available_kb": fields[3],
+        "temperature_c": _zigzag(fields[4]) / 100.0,
+        "uptime_s": fields[5],
+    }
+    return SnapshotDatagram(seq=seq, host_id=host_id, status_code=status_code, metrics=metrics)
+
+
+@dataclass
+class HostStats:
+    received: int = 0
+    lost: int = 0
+    restarts: int = 0
+    last_seq: int = -1
+
+
+class MulticastReceiver:
+    """Joins the agent's --multicast group and yields decoded snapshots.
+
+    Loss is tracked per host id from gaps in the sequence number; a sequence number going
+    backwards is counted as an agent restart, not as loss.
+    """
+
+    def __init__(self, group: str, port: int, interface: str = "0.0.0.0", timeout_s: float | None = None):
+        self.stats: dict[str, HostStats] = {}
+        self._sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+        self._sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self._sock.bind(("", port))
+        mreq = socket.inet_aton(group) + socket.inet_aton(interface)
+        self._sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+        self._sock.settimeout(timeout_s)
+
+    def close(self) -> None:
+        self._sock.close()
+
+    def __enter__(self) -> MulticastReceiver:
+        return self
+
+    def __exit__(self, *exc: object) -> None:
+        self.close()
+
+    def _account(self, d: SnapshotDatagram) -> int:
+        st = self.stats.setdefault(d.host_id, HostStats())
+        gap = 0
+        if st.last_seq >= 0:
+            if d.seq > st.last_seq:
+                gap = d.seq - st.last_seq - 1
+            else:
+                st.restarts += 1
+        st.lost += gap
+        st.received += 1
+        st.last_seq = d.seq
+        return gap
+
+    def __iter__(self) -> Iterator[tuple[SnapshotDatagram, int]]:
+        """Yields (datagram, datagrams lost just before it from the same host)."""
+        while True:
+            buf = self._sock.recv(2048)
+            try:
+                d = decode_datagram(buf)
+            except ValueError:
+                continue
+            yield d, self._account(d)